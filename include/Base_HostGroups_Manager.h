@@ -334,6 +334,7 @@ class BaseHGC {	// MySQL Host Group Container
 		int8_t autocommit;
 		int8_t free_connections_pct;
 		int8_t handle_warnings;
+		int8_t load_balancing_algorithm; // 0: weighted random, 1: power-of-two-choices. See MyHGC::get_random_MySrvC()
 		bool multiplex;
 		bool connection_warming;
 		bool configured; // this variable controls if attributes are configured or not. If not configured, they do not apply
@@ -354,6 +355,10 @@ class BaseHGC {	// MySQL Host Group Container
 	int32_t get_monitor_slave_lag_when_null() const {
 		return attributes.configured == true && attributes.monitor_slave_lag_when_null != -1 ? attributes.monitor_slave_lag_when_null : mysql_thread___monitor_slave_lag_when_null;
 	}
+	inline
+	int8_t get_load_balancing_algorithm() const {
+		return attributes.configured == true && attributes.load_balancing_algorithm != -1 ? attributes.load_balancing_algorithm : 0;
+	}
 	BaseHGC(int);
 	virtual ~BaseHGC();
 	using TypeSrvC = typename std::conditional<
@@ -6,6 +6,7 @@ template<typename S, typename DSi, typename B, typename T> class Base_Session;
 
 #include "proxysql.h"
 #include "cpp.h"
+#include "QP_firewall_whitelist.h"
 
 #ifndef CLASS_BASE_SESSION_H
 #define CLASS_BASE_SESSION_H
@@ -102,6 +103,8 @@ class Base_Session {
 	bool use_ssl;
 	MySQL_STMTs_meta *sess_STMTs_meta;
 	StmtLongDataHandler *SLDH;
+	// firewall whitelist entries resolved for this session by the Query Processor
+	QP_firewall_session_cache firewall_cache;
 
 
 
@@ -46,6 +46,8 @@ class Base_Thread {
 	int shutdown;
 	PtrArray *mysql_sessions;
 	Session_Regex **match_regexes;
+	// last firewall whitelist version the sessions caches were checked against
+	unsigned int firewall_whitelist_version;
 	Base_Thread();
 	~Base_Thread();
 	template<typename T, typename S>
@@ -76,6 +78,13 @@ class Base_Thread {
 	template<typename T, typename S> unsigned int find_session_idx_in_mysql_sessions(S * sess);
 	template<typename T> void ProcessAllMyDS_BeforePoll();
 	template<typename T, typename S> void run_SetAllSession_ToProcess0();
+	/**
+	 * @brief Drops the firewall whitelist cached by the sessions of the thread, if whitelist 'version' was
+	 *   loaded since the last call.
+	 * @details Idle sessions don't resolve the new whitelist until their next query: without this, they would
+	 *   keep the previous whitelists alive.
+	 */
+	template<typename S> void release_stale_firewall_caches(unsigned int version);
 
 
 #if ENABLE_TIMER
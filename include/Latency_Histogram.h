@@ -0,0 +1,107 @@
+#ifndef __CLASS_LATENCY_HISTOGRAM_H
+#define __CLASS_LATENCY_HISTOGRAM_H
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Log-linear latency histogram, in the style of HdrHistogram.
+ * @details Each power of two range of values is split in 'SUB_BUCKETS' linear buckets, which bounds the
+ *   relative error of the reported percentiles to 1/SUB_BUCKETS, with a fixed footprint and no allocations.
+ *   Values lower than 'SUB_BUCKETS' are tracked exactly, values from 2^MAX_BITS onwards are accounted in the
+ *   last bucket.
+ *
+ *   Recording isn't thread safe: a histogram is meant to be updated by a single thread, or under a lock, and
+ *   read by others with the same tolerance used for the threads status variables.
+ *
+ * @tparam SUB_BUCKET_BITS Number of bits of precision of each power of two range.
+ * @tparam MAX_BITS Number of bits of the largest value tracked in its own bucket.
+ * @tparam counter_t Type of the buckets counters.
+ */
+template <int SUB_BUCKET_BITS, int MAX_BITS, typename counter_t>
+class Log_Linear_Histogram {
+public:
+	static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static constexpr int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	Log_Linear_Histogram() : _counts{}, _count(0), _sum(0), _max(0) {}
+
+	void add(uint64_t v) {
+		_counts[bucket_idx(v)]++;
+		_count++;
+		_sum += v;
+		if (v > _max) _max = v;
+	}
+	/**
+	 * @brief Adds to this histogram the values recorded in 'h'.
+	 */
+	void merge(const Log_Linear_Histogram& h) {
+		for (int i = 0; i < BUCKETS; i++) {
+			_counts[i] += h._counts[i];
+		}
+		_count += h._count;
+		_sum += h._sum;
+		if (h._max > _max) _max = h._max;
+	}
+	void reset() {
+		for (int i = 0; i < BUCKETS; i++) {
+			_counts[i] = 0;
+		}
+		_count = 0;
+		_sum = 0;
+		_max = 0;
+	}
+	uint64_t count() const { return _count; }
+	uint64_t sum() const { return _sum; }
+	uint64_t max() const { return _max; }
+	uint64_t bucket_count(int idx) const { return _counts[idx]; }
+	/**
+	 * @brief Returns the value at percentile 'p' (0-100): the upper bound of the bucket holding it, capped to
+	 *   the max recorded value. Returns 0 for an empty histogram.
+	 */
+	uint64_t percentile(double p) const {
+		if (_count == 0) return 0;
+		uint64_t target = std::ceil(_count * p / 100.0);
+		if (target == 0) target = 1;
+		uint64_t cumulative = 0;
+		for (int i = 0; i < BUCKETS; i++) {
+			cumulative += _counts[i];
+			if (cumulative >= target) {
+				const uint64_t upper = bucket_upper_bound(i);
+				return upper < _max ? upper : _max;
+			}
+		}
+		return _max;
+	}
+
+	static int bucket_idx(uint64_t v) {
+		if (v < SUB_BUCKETS) return v;
+		const int msb = 63 - __builtin_clzll(v);
+		if (msb >= MAX_BITS) return BUCKETS - 1;
+		return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + ((v >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+	}
+	static uint64_t bucket_upper_bound(int idx) {
+		if (idx < SUB_BUCKETS) return idx;
+		const int shift = idx / SUB_BUCKETS - 1;
+		const uint64_t sub = idx % SUB_BUCKETS;
+		return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+	}
+
+private:
+	counter_t _counts[BUCKETS];
+	uint64_t _count;
+	uint64_t _sum;
+	uint64_t _max;
+};
+
+/**
+ * @brief Histogram for the per stage query latencies, in nanoseconds: up to ~18 minutes, 6% error, 4.7KB.
+ */
+typedef Log_Linear_Histogram<4, 40, uint64_t> Latency_Histogram;
+/**
+ * @brief Compact histogram for the per digest latencies, in microseconds: up to ~4.5 minutes, 12.5% error,
+ *   less than 1KB.
+ */
+typedef Log_Linear_Histogram<3, 28, uint32_t> Digest_Latency_Histogram;
+
+#endif /* __CLASS_LATENCY_HISTOGRAM_H */
@@ -107,6 +107,12 @@ class MySQL_Authentication {
 	 * @return The computed hash for the provided resultset.
 	 */
 	uint64_t get_runtime_checksum(MYSQL_RES* resultset, unique_ptr<SQLite3_result>& mysql_users);
+	/**
+	 * @brief Computes the checksum of the users held by a resultset, as 'get_runtime_checksum(MYSQL_RES*)'.
+	 * @param resultset Resultset with the format of 'runtime_mysql_users', i.e. 'get_current_mysql_users()'.
+	 * @return The computed hash for the provided resultset.
+	 */
+	uint64_t get_runtime_checksum(const SQLite3_result* resultset);
 	/**
 	 * @brief Takes ownership of the supplied resultset and stores it in 'mysql_users_resultset' field.
 	 * @param users Holds the current value for 'runtime_mysql_users'.
@@ -0,0 +1,62 @@
+#ifndef __CLASS_MYSQL_CONCURRENCY_LIMITER_H
+#define __CLASS_MYSQL_CONCURRENCY_LIMITER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Counters of the queries running concurrently against a hostgroup, for the limits set by the query
+ *   rules (attribute 'max_concurrency') and by the users (attribute 'max_concurrent_queries').
+ * @details Each limited (rule or user, hostgroup) pair owns a slot of a fixed size open addressing table,
+ *   claimed on first use and never released:
+ *   - 'running' counts the admitted queries, incremented with a CAS only while below the limit.
+ *   - 'waiting' holds the tickets of the queries waiting for the slot, in arrival order, protected by 'mutex'.
+ *     Only the query holding the first ticket can be admitted, and a query not yet queued is never admitted
+ *     while other queries are queued: the waiting queries are admitted in FIFO order.
+ *   - 'queued' is the size of 'waiting', so that the slots without waiting queries are accessed without locks.
+ *
+ *   If the table is full, no limit is enforced for the new pairs.
+ */
+class MySQL_Concurrency_Limiter {
+	private:
+	static const unsigned int SLOTS = 4096;
+	struct slot_t {
+		// 0 if the slot is free
+		std::atomic<uint64_t> key;
+		std::atomic<int> running;
+		std::atomic<int> queued;
+		pthread_mutex_t mutex;
+		uint64_t next_ticket;
+		std::vector<uint64_t> waiting;
+	} slots[SLOTS];
+	public:
+	MySQL_Concurrency_Limiter();
+	~MySQL_Concurrency_Limiter();
+	static uint64_t rule_key(int rule_id, int hid);
+	static uint64_t user_key(const char *username, int hid);
+	/**
+	 * @brief Returns the slot of 'key', claiming a free one if needed. Returns -1 if the table is full.
+	 */
+	int get_slot(uint64_t key);
+	/**
+	 * @brief Admits a query in 'slot' if less than 'limit' queries are running.
+	 * @param ticket The ticket returned by 'enqueue()' if the query is waiting in the queue of the slot, 0
+	 *   otherwise. The ticket is removed from the queue if the query is admitted.
+	 */
+	bool try_acquire(int slot, int limit, uint64_t ticket);
+	void release(int slot);
+	/**
+	 * @brief Appends a query to the queue of 'slot'.
+	 * @return The ticket of the query, never 0.
+	 */
+	uint64_t enqueue(int slot);
+	/**
+	 * @brief Removes the ticket of a query that stops waiting without being admitted.
+	 */
+	void dequeue(int slot, uint64_t ticket);
+	int get_running(int slot);
+};
+
+#endif /* __CLASS_MYSQL_CONCURRENCY_LIMITER_H */
@@ -29,6 +29,9 @@ typedef struct P_st_ma_pvio_tls {
 
 #define QUEUE_T_DEFAULT_SIZE	32768
 #define MY_SSL_BUFFER	8192
+// limits of a single write of 'write_to_net_writev()'
+#define MYDS_WRITEV_MAX_IOV	64
+#define MYDS_WRITEV_MAX_BYTES	(QUEUE_T_DEFAULT_SIZE*8)
 
 typedef struct _queue_t {
 	void *buffer;
@@ -79,6 +82,10 @@ class MySQL_Data_Stream
 	private:
 	int array2buffer();
 	int buffer2array();
+	bool writev_enabled();
+	int write_to_net_writev();
+	bool proxy_protocol_accepted();
+	void apply_proxy_protocol_info(const ProxyProtocolInfo& ppi);
 	void generate_compressed_packet();
 	enum sslstatus do_ssl_handshake();
 	void queue_encrypted_bytes(const char *buf, size_t len);
@@ -90,6 +97,7 @@ class MySQL_Data_Stream
 	uint64_t pkts_recv; // counter of received packets
 	queue_t queueOUT;
 	uint64_t pkts_sent; // counter of sent packets
+	unsigned int writev_partial; // bytes of the first packet of 'PSarrayOUT' already sent by 'write_to_net_writev()'
 
 	struct {
 		PtrSize_t pkt;
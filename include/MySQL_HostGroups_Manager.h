@@ -37,6 +37,8 @@
 
 
 #include "Base_HostGroups_Manager.h"
+#include "MySQL_Multiplex_Affinity.h"
+#include "MySQL_Concurrency_Limiter.h"
 
 // we have 2 versions of the same tables: with (debug) and without (no debug) checks
 #ifdef DEBUG
@@ -223,6 +225,9 @@ class MySrvC {	// MySQL Server Container
 	unsigned long long queries_gtid_sync;
 	unsigned long long bytes_sent;
 	unsigned long long bytes_recv;
+	// tracked only for hostgroups with 'load_balancing_algorithm=1', see MyHGC::get_random_MySrvC()
+	unsigned int queries_in_flight; // queries sent and not yet completed, updated atomically
+	unsigned int query_latency_ewma_us; // moving average of the backend query time observed by ProxySQL
 	bool shunned_automatic;
 	bool shunned_and_kill_all_connections; // if a serious failure is detected, this will cause all connections to die even if the server is just shunned
 	int32_t use_ssl;
@@ -448,6 +453,8 @@ struct p_hg_counter {
 		myhgm_myconnpool_reset,
 		myhgm_myconnpool_destroy,
 		auto_increment_delay_multiplex,
+		multiplex_affinity_released,
+		multiplex_affinity_repinned,
 		__size
 	};
 };
@@ -806,6 +813,15 @@ class MySQL_HostGroups_Manager : public Base_HostGroups_Manager<MyHGC> {
 
 	pthread_rwlock_t gtid_rwlock;
 	std::unordered_map <string, GTID_Server_Data *> gtid_map;
+	/**
+	 * @brief State used by 'mysql-gtid_read_your_writes', protected by 'gtid_ryw_rwlock'.
+	 * @details 'gtid_ryw_pairs' holds the (writer, reader) hostgroup pairs, rebuilt by commit().
+	 *   'gtid_tracked_hostgroups' holds the hostgroups with at least a server with GTID tracking, rebuilt by
+	 *   generate_mysql_gtid_executed_tables(). 'gtid_ryw_rwlock' is never held while acquiring another lock.
+	 */
+	pthread_rwlock_t gtid_ryw_rwlock;
+	std::set<std::pair<int,int>> gtid_ryw_pairs;
+	std::unordered_set<unsigned int> gtid_tracked_hostgroups;
 	struct ev_async * gtid_ev_async;
 	struct ev_loop * gtid_ev_loop;
 	struct ev_timer * gtid_ev_timer;
@@ -847,6 +863,8 @@ class MySQL_HostGroups_Manager : public Base_HostGroups_Manager<MyHGC> {
 		unsigned long long access_denied_max_user_connections;
 		unsigned long long select_for_update_or_equivalent;
 		unsigned long long auto_increment_delay_multiplex;
+		unsigned long long multiplex_affinity_released;
+		unsigned long long multiplex_affinity_repinned;
 
 		//////////////////////////////////////////////////////
 		///              Prometheus Metrics                ///
@@ -879,6 +897,14 @@ class MySQL_HostGroups_Manager : public Base_HostGroups_Manager<MyHGC> {
 
 		//////////////////////////////////////////////////////
 	} status;
+	/**
+	 * @brief Digests learned to never need the connection pinned, see 'mysql-multiplex_affinity_learning'.
+	 */
+	MySQL_Multiplex_Affinity multiplex_affinity;
+	/**
+	 * @brief Queries running per limited query rule and user, see 'MySQL_Session::concurrency_limit_admit()'.
+	 */
+	MySQL_Concurrency_Limiter concurrency_limiter;
 	/**
 	 * @brief Update the module prometheus metrics.
 	 */
@@ -1163,6 +1189,8 @@ class MySQL_HostGroups_Manager : public Base_HostGroups_Manager<MyHGC> {
 	SQLite3_result * get_stats_mysql_gtid_executed();
 	void generate_mysql_gtid_executed_tables();
 	bool gtid_exists(MySrvC *mysrvc, char * gtid_uuid, uint64_t gtid_trxid);
+	bool gtid_read_your_writes_pair(int writer_hid, int reader_hid, bool *tracked);
+	void update_gtid_read_your_writes_pairs();
 
 	SQLite3_result *SQL3_Get_ConnPool_Stats();
 	void increase_reset_counter();
@@ -3,8 +3,14 @@
 #include "proxysql.h"
 #include "cpp.h"
 
+#include <atomic>
+
 #define PROXYSQL_LOGGER_PTHREAD_MUTEX
 
+namespace eventslog_columnar {
+	class Writer;
+}
+
 class MySQL_Event {
 	private:
 	uint32_t thread_id;
@@ -39,6 +45,7 @@ class MySQL_Event {
 	uint64_t write(std::fstream *f, MySQL_Session *sess);
 	uint64_t write_query_format_1(std::fstream *f);
 	uint64_t write_query_format_2_json(std::fstream *f);
+	void write_query_format_3_columnar(eventslog_columnar::Writer *w);
 	void write_auth(std::fstream *f, MySQL_Session *sess);
 	void set_client_stmt_id(uint32_t client_stmt_id);
 	void set_query(const char *ptr, int len);
@@ -49,6 +56,27 @@ class MySQL_Event {
 	void set_gtid(MySQL_Session *sess);
 };
 
+/**
+ * @brief Per digest token buckets capping the query events logged per second ('mysql-eventslog_digest_rate_limit').
+ * @details Lock free: each bucket is a single 64 bits word updated with CAS, packing the top 16 bits of the
+ *   digest (tag), the available tokens (16 bits), and the time of the last refill in milliseconds (32 bits).
+ *   Digests are mapped to a fixed number of buckets: a digest finding a bucket tagged by a different digest
+ *   takes it over with a full bucket, so collisions can only let more events through, never fewer.
+ */
+class MySQL_Logger_Digest_Rate_Limiter {
+	private:
+	static const unsigned int SLOTS = 4096;
+	std::atomic<uint64_t> slots[SLOTS];
+	public:
+	MySQL_Logger_Digest_Rate_Limiter();
+	/**
+	 * @brief Takes a token from the bucket of 'digest', refilled at 'rate' tokens per second up to 'rate'.
+	 * @param now_us Monotonic time in microseconds.
+	 * @return True if the event can be logged.
+	 */
+	bool consume(uint64_t digest, uint64_t now_us, unsigned int rate);
+};
+
 class MySQL_Logger {
 	private:
 	struct {
@@ -58,6 +86,7 @@ class MySQL_Logger {
 		unsigned int log_file_id;
 		unsigned int max_log_file_size;
 		std::fstream *logfile;
+		eventslog_columnar::Writer *columnar; // pending block of 'eventslog_format=3', NULL for the other formats
 	} events;
 	struct {
 		bool enabled;
@@ -74,6 +103,8 @@ class MySQL_Logger {
 #endif
 	void events_close_log_unlocked();
 	void events_open_log_unlocked();
+	void events_write_columnar_unlocked(MySQL_Event& me);
+	void events_columnar_flush_block_unlocked();
 	void audit_close_log_unlocked();
 	void audit_open_log_unlocked();
 	unsigned int events_find_next_id();
@@ -90,6 +121,7 @@ class MySQL_Logger {
 	void audit_set_datadir(char *);
 	void audit_set_base_filename();
 	void log_request(MySQL_Session *, MySQL_Data_Stream *);
+	MySQL_Logger_Digest_Rate_Limiter digest_rate_limiter;
 	void log_audit_entry(log_event_type, MySQL_Session *, MySQL_Data_Stream *, char *e = NULL);
 	void flush();
 	void wrlock();
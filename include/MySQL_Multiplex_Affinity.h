@@ -0,0 +1,67 @@
+#ifndef __CLASS_MYSQL_MULTIPLEX_AFFINITY_H
+#define __CLASS_MYSQL_MULTIPLEX_AFFINITY_H
+
+#include <stdint.h>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief Connection state that keeps a backend connection pinned to a session after a statement.
+ */
+enum MUX_AFFINITY_kind {
+	/// An INSERT generating an auto increment id, pinned for 'mysql-auto_increment_delay_multiplex' statements
+	MUX_AFFINITY_LAST_INSERT_ID = 0,
+	/// A 'SQL_CALC_FOUND_ROWS' query, disabling multiplexing for the rest of the session
+	MUX_AFFINITY_FOUND_ROWS = 1,
+};
+
+/**
+ * @brief Per digest statistics of the statements that pin a backend connection, learning which digests are
+ *   never followed by a statement actually depending on the connection state ('mysql-multiplex_affinity_learning').
+ * @details While a connection is pinned after a statement, the session observes the following
+ *   'mysql-auto_increment_delay_multiplex' statements (a window):
+ *   - 'MUX_AFFINITY_LAST_INSERT_ID': a statement using 'LAST_INSERT_ID()' or '@@IDENTITY' executed on the
+ *     backend depends on the connection. The simple forms answered by ProxySQL itself do not.
+ *   - 'MUX_AFFINITY_FOUND_ROWS': a statement using 'FOUND_ROWS()' depends on the connection.
+ *
+ *   Once a digest completed 'mysql-multiplex_affinity_min_samples' windows without any dependent statement,
+ *   the connection is no longer pinned after it. If a dependent statement still follows a released
+ *   statement, the release is counted as a forced re-pin and the digest goes back to being pinned.
+ *
+ *   Statements are identified by their digest: with 'mysql-query_digests' disabled nothing is learned, and
+ *   connections stay pinned as with 'mysql-multiplex_affinity_learning' disabled.
+ *
+ *   Thread safe: digests are spread over mutex protected shards.
+ */
+class MySQL_Multiplex_Affinity {
+	private:
+	struct digest_stats_t {
+		uint32_t windows;
+		uint32_t dependent;
+	};
+	static const unsigned int SHARDS = 16;
+	// bounds the memory used: digests beyond this limit are always pinned
+	static const size_t MAX_DIGESTS_PER_SHARD = 65536;
+	struct shard_t {
+		std::mutex mu;
+		std::unordered_map<uint64_t, digest_stats_t> digests;
+	} shards[SHARDS];
+	static uint64_t key(uint64_t digest, MUX_AFFINITY_kind kind);
+	shard_t& get_shard(uint64_t k) { return shards[(k ^ (k >> 32)) % SHARDS]; }
+	public:
+	/**
+	 * @brief Returns true if the connection doesn't need to be pinned after a statement with 'digest'.
+	 */
+	bool releasable(uint64_t digest, MUX_AFFINITY_kind kind, unsigned int min_samples);
+	/**
+	 * @brief Records a completed window of a statement with 'digest'.
+	 * @param dependent True if a statement of the window depended on the connection state.
+	 */
+	void record_window(uint64_t digest, MUX_AFFINITY_kind kind, bool dependent);
+	/**
+	 * @brief Returns the number of digests tracked.
+	 */
+	size_t size();
+};
+
+#endif /* __CLASS_MYSQL_MULTIPLEX_AFFINITY_H */
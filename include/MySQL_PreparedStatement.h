@@ -52,8 +52,8 @@ class MySQL_STMT_Global_info {
 	char *query;
 	unsigned int query_length;
 //	unsigned int hostgroup_id;
-	int ref_count_client;
-	int ref_count_server;
+	int ref_count_client; // always modified atomically
+	int ref_count_server; // always modified atomically
 	uint64_t statement_id;
 	uint16_t num_columns;
 	uint16_t num_params;
@@ -234,14 +234,41 @@ class MySQL_STMTs_local_v14 {
 	}
 };
 
+// number of shards used by MySQL_STMT_Manager_v14 to store MySQL_STMT_Global_info
+// statements are sharded by hash in map_stmt_hash_to_info, and by statement id in map_stmt_id_to_info
+#define STMT_MANAGER_NUM_SHARDS 32
+// maximum number of statements removed by a single call of purge_unused_statements()
+#define STMT_MANAGER_PURGE_BATCH 1024
+
+/*
+Locking in MySQL_STMT_Manager_v14:
+* rwlock_ is a purge barrier: every thread accessing the statements (lookup,
+  insert, reference count change) holds it in read mode, while only
+  purge_unused_statements() acquires it in write mode. This guarantees that a
+  MySQL_STMT_Global_info found with a reference count of zero cannot be freed
+  before the caller increases its reference count
+* each shard has two rwlocks, hash_rwlock_ protecting map_stmt_hash_to_info and
+  id_rwlock_ protecting map_stmt_id_to_info. The hash shard and the id shard of
+  a statement can be different shards: a hash_rwlock_ is always acquired before
+  an id_rwlock_, and never while holding an id_rwlock_
+* reference counts in MySQL_STMT_Global_info are updated with atomic operations
+*/
 class MySQL_STMT_Manager_v14 {
 	private:
+	typedef struct _stmt_shard_t {
+		pthread_rwlock_t hash_rwlock_;
+		pthread_rwlock_t id_rwlock_;
+		std::unordered_map<uint64_t, MySQL_STMT_Global_info *> map_stmt_id_to_info;	// map using statement id
+		std::unordered_map<uint64_t, MySQL_STMT_Global_info *> map_stmt_hash_to_info;	// map using hashes
+	} stmt_shard_t;
 	uint64_t next_statement_id;
 	uint64_t num_stmt_with_ref_client_count_zero;
 	uint64_t num_stmt_with_ref_server_count_zero;
+	uint64_t num_stmts;
 	pthread_rwlock_t rwlock_;
-	std::map<uint64_t, MySQL_STMT_Global_info *> map_stmt_id_to_info;	// map using statement id
-	std::map<uint64_t, MySQL_STMT_Global_info *> map_stmt_hash_to_info;	// map using hashes
+	pthread_mutex_t ids_mutex; // protects next_statement_id and free_stmt_ids
+	pthread_mutex_t purge_mutex;
+	stmt_shard_t shards[STMT_MANAGER_NUM_SHARDS];
 	std::stack<uint64_t> free_stmt_ids;
 	struct {
 		uint64_t c_unique;
@@ -250,21 +277,37 @@ class MySQL_STMT_Manager_v14 {
 		uint64_t cached;
 		uint64_t s_unique;
 		uint64_t s_total;
+		uint64_t purged;
 	} statuses;
 	time_t last_purge_time;
+	unsigned int purge_next_shard;
+	stmt_shard_t& shard_by_hash(uint64_t hash) { return shards[(hash >> 32) % STMT_MANAGER_NUM_SHARDS]; }
+	stmt_shard_t& shard_by_id(uint64_t id) { return shards[id % STMT_MANAGER_NUM_SHARDS]; }
+	uint64_t get_next_statement_id();
+	unsigned int purge_shard(stmt_shard_t& shard, unsigned int max_purge);
 	public:
 	MySQL_STMT_Manager_v14();
 	~MySQL_STMT_Manager_v14();
 	//MySQL_STMT_Global_info * find_prepared_statement_by_hash(uint64_t hash, bool lock=true); // removed in 2.3
+	// the caller must hold rdlock()
 	MySQL_STMT_Global_info * find_prepared_statement_by_hash(uint64_t hash);
 	MySQL_STMT_Global_info * find_prepared_statement_by_stmt_id(uint64_t id, bool lock=true);
 	void rdlock() { pthread_rwlock_rdlock(&rwlock_); }
 	void wrlock() { pthread_rwlock_wrlock(&rwlock_); }
 	void unlock() { pthread_rwlock_unlock(&rwlock_); }
+	// if lock==true , rwlock_ is acquired in read mode
 	void ref_count_client(uint64_t _stmt, int _v, bool lock=true);
 	void ref_count_server(uint64_t _stmt, int _v, bool lock=true);
 	MySQL_STMT_Global_info * add_prepared_statement(char *u, char *s, char *q, unsigned int ql, char *fc, MYSQL_STMT *stmt, bool lock=true);
+	/**
+	 * @brief Removes statements not referenced by any client or backend connection.
+	 * @details Called periodically by the MySQL threads during their maintenance loop.
+	 *   Only one thread at the time performs the purge, and at most STMT_MANAGER_PURGE_BATCH
+	 *   statements are removed per call, releasing rwlock_ after each shard.
+	 */
+	void purge_unused_statements();
 	void get_metrics(uint64_t *c_unique, uint64_t *c_total, uint64_t *stmt_max_stmt_id, uint64_t *cached, uint64_t *s_unique, uint64_t *s_total);
+	uint64_t get_num_purged() { return __sync_add_and_fetch(&statuses.purged, 0); }
 	SQLite3_result * get_prepared_statements_global_infos();
 	void get_memory_usage(uint64_t& prep_stmt_metadata_mem_usage, uint64_t& prep_stmt_backend_mem_usage);
 };
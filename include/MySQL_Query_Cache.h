@@ -17,7 +17,8 @@ public:
 	~MySQL_Query_Cache() = default;
 
 	bool set(uint64_t user_hash, const unsigned char* kp, uint32_t kl, unsigned char* vp, uint32_t vl, 
-		uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms, bool deprecate_eof_active);
+		uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms, bool deprecate_eof_active,
+		const std::vector<std::pair<uint64_t,uint64_t>>* tables = NULL);
 	unsigned char* get(uint64_t user_hash, const unsigned char* kp, const uint32_t kl, uint32_t* lv, 
 		uint64_t curtime_ms, uint64_t cache_ttl, bool deprecate_eof_active);
 	//void* purgeHash_thread(void*);
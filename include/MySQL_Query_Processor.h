@@ -8,6 +8,8 @@
 class Command_Counter;
 typedef struct _MySQL_Query_processor_Rule_t : public QP_rule_t { 
 	int gtid_from_hostgroup;
+	// from the attribute 'max_concurrency', -1 if not set
+	int max_concurrency;
 } MySQL_Query_Processor_Rule_t;
 
 class MySQL_Query_Processor_Output : public Query_Processor_Output {
@@ -19,6 +21,8 @@ public:
 		Query_Processor_Output::init();
 		min_gtid = NULL;
 		gtid_from_hostgroup = -1;
+		max_concurrency = -1;
+		max_concurrency_rule_id = -1;
 	}
 	void destroy() {
 		Query_Processor_Output::destroy();
@@ -30,6 +34,9 @@ public:
 
 	char* min_gtid;
 	int gtid_from_hostgroup;
+	// maximum number of queries of the rule 'max_concurrency_rule_id' running concurrently in a hostgroup
+	int max_concurrency;
+	int max_concurrency_rule_id;
 };
 
 class MySQL_Rule_Text : public QP_rule_text {
@@ -70,6 +77,11 @@ private:
 			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 5, "query rule %d has set gtid from hostgroup: %d. A new session will be created\n", mqr->rule_id, mqr->gtid_from_hostgroup);
 			ret->gtid_from_hostgroup = mqr->gtid_from_hostgroup;
 		}
+		if (mqr->max_concurrency > 0) {
+			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 5, "query rule %d has set max_concurrency: %d\n", mqr->rule_id, mqr->max_concurrency);
+			ret->max_concurrency = mqr->max_concurrency;
+			ret->max_concurrency_rule_id = mqr->rule_id;
+		}
 	}
 
 	inline
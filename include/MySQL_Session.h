@@ -14,6 +14,8 @@
 #include "cpp.h"
 #include "MySQL_Variables.h"
 #include "Base_Session.h"
+#include "Timer_Wheel.h"
+#include "MySQL_Multiplex_Affinity.h"
 
 #ifndef PROXYJSON
 #define PROXYJSON
@@ -84,6 +86,16 @@ class Query_Info {
 	uint64_t rows_sent;
 	uint64_t waiting_since;
 	std::string show_warnings_prev_query_digest;
+	/**
+	 * @brief Per stage timings of the query, see 'mysql-stats_time_query_stages'.
+	 * @details Timestamps are 'ticks_time()' values. 'start' is zero when the query isn't being timed.
+	 */
+	struct {
+		uint64_t start;
+		uint64_t mark;
+		uint64_t elapsed[query_stage___END];
+		uint32_t marked;
+	} stages;
 
 	Query_Info();
 	~Query_Info();
@@ -94,6 +106,22 @@ class Query_Info {
 	unsigned long long query_parser_update_counters();
 	void begin(unsigned char *_p, int len, bool mysql_header=false);
 	void end();
+	/**
+	 * @brief Starts timing the stages of a new query, if 'mysql-stats_time_query_stages' is enabled.
+	 */
+	void stages_begin();
+	/**
+	 * @brief Closes 'stage', which is accounted the time elapsed since the previous closed stage.
+	 * @details Stages are closed in the order of 'MySQL_Query_Stage', and only once per query: retries and
+	 *   further calls for an already closed stage are ignored. Stages a query never goes through (e.g. queries
+	 *   served by the Query Cache) are not recorded. The time since the last closed stage is accounted to
+	 *   'query_stage_result' when the query ends.
+	 */
+	void stage_mark(enum MySQL_Query_Stage stage);
+	/**
+	 * @brief Records the stages timings of the query into the histograms of the thread.
+	 */
+	void stages_end();
 	char *get_digest_text();
 	bool is_select_NOT_for_update();
 };
@@ -187,6 +215,62 @@ class MySQL_Session: public Base_Session<MySQL_Session, MySQL_Data_Stream, MySQL
 	 */
 	void RequestEnd(MySQL_Data_Stream *) override;
 	void LogQuery(MySQL_Data_Stream *);
+	/**
+	 * @brief Decides if a query selected for logging is actually logged, before building its event.
+	 * @details Queries slower than 'mysql-eventslog_slow_query_threshold' milliseconds are always logged. The
+	 *   others are sampled 1-in-'mysql-eventslog_sample_rate', and then capped to
+	 *   'mysql-eventslog_digest_rate_limit' events per second per digest.
+	 */
+	bool LogQuery_sampled();
+	/**
+	 * @brief Called after a statement that pins the backend connection, opens a window observing the
+	 *   following statements.
+	 * @param skip_current True if the window is opened before 'RequestEnd()' of the current statement.
+	 * @return True if the connection doesn't need to be pinned, learned from the digest of the statement
+	 *   ('mysql-multiplex_affinity_learning').
+	 */
+	bool multiplex_affinity_release(MUX_AFFINITY_kind kind, bool skip_current);
+	/**
+	 * @brief Records that the current statement depends on the state of the connection pinned by the open
+	 *   window of 'kind', closing it. If the connection wasn't pinned, a re-pin is counted.
+	 */
+	void multiplex_affinity_dependent(MUX_AFFINITY_kind kind);
+	/**
+	 * @brief Counts the current statement in the open window, closing it when complete.
+	 */
+	void multiplex_affinity_track(const char *qdt);
+	/**
+	 * @brief Admission control of the current query, before getting a backend connection. The query is limited
+	 *   by the attribute 'max_concurrency' of its query rule and by the attribute 'max_concurrent_queries' of
+	 *   the user, counted per hostgroup.
+	 * @details Queries over a limit are queued without holding a backend connection, for up to
+	 *   'mysql-concurrency_limit_queue_timeout_ms'. A query waits only in the queue of the limit it hit, and
+	 *   the queued queries are admitted in arrival order. Queries running on a connection already attached to the
+	 *   session (e.g. in a transaction) are not limited.
+	 * @return 0 if the query can run, 1 if it has to wait, -1 if it's rejected.
+	 */
+	int concurrency_limit_admit();
+	/**
+	 * @brief Releases the concurrency limits admitting, or queueing, the current query.
+	 */
+	void concurrency_limit_release();
+	/**
+	 * @brief Returns the limit set by the attribute 'max_concurrent_queries' of the user, -1 if not set.
+	 */
+	int get_user_max_concurrency();
+	/**
+	 * @brief Tags the current query with the tables it reads from, and their invalidation versions, before
+	 *   the Query Cache lookup. See 'mysql-query_cache_table_invalidation'.
+	 * @return False if the tables can't be reliably extracted from the digest text, in which case the
+	 *   resultset isn't cached.
+	 */
+	bool query_cache_track_tables();
+	/**
+	 * @brief Invalidates the Query Cache entries read from the tables written by the current query.
+	 * @details Tables written inside a transaction are invalidated again when the transaction ends, as the
+	 *   changes aren't visible to other sessions before the commit.
+	 */
+	void query_cache_invalidate_tables(const char *qdt);
 
 	void handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_QUERY___create_mirror_session();
 	int handler_again___status_PINGING_SERVER();
@@ -370,6 +454,36 @@ class MySQL_Session: public Base_Session<MySQL_Session, MySQL_Data_Stream, MySQL
 	char gtid_buf[128];
 	//uint64_t gtid_trxid;
 	int gtid_hid;
+	// last GTID written by the session and the hostgroup of the write, see 'mysql-gtid_read_your_writes'
+	char last_write_gtid[128];
+	int last_write_gtid_hid;
+	/**
+	 * @brief Concurrency limits of the current query, see 'concurrency_limit_admit()'.
+	 */
+	struct {
+		// slots in 'MyHGM->concurrency_limiter' of the query rule and of the user limits, -1 if not limited
+		int slots[2];
+		int limits[2];
+		bool admitted;
+		bool queued;
+		// index in 'slots' of the slot the query is queued on, -1 if none, and the ticket of the query
+		int queue;
+		uint64_t ticket;
+		unsigned long long waiting_since;
+		// 'user_attributes' the user limit was parsed from, and the limit, -1 if not set
+		std::string user_attributes;
+		int user_limit;
+	} concurrency_limit;
+	/**
+	 * @brief State of the Query Cache invalidation by table, see 'query_cache_track_tables()'.
+	 */
+	struct {
+		// tables read by the current query and their versions when it started, only valid if 'tracked'
+		std::vector<std::pair<uint64_t,uint64_t>> tables;
+		bool tracked;
+		// tables written in the open transaction
+		std::vector<uint64_t> pending;
+	} qc_invalidation;
 
 //	MySQL_STMTs_meta *sess_STMTs_meta;
 //	StmtLongDataHandler *SLDH;
@@ -382,6 +496,27 @@ class MySQL_Session: public Base_Session<MySQL_Session, MySQL_Data_Stream, MySQL
 	// this variable is relevant only if status == SETTING_VARIABLE
 	enum mysql_variable_name changing_variable_idx;
 
+	// position of the session in 'MySQL_Thread::mysql_sessions'
+	unsigned int thread_session_idx;
+	// the session is in the ready list of its thread, see 'mysql-sessions_ready_list'
+	bool in_ready_list;
+	// next deadline of the session timeouts, in the timer wheel of its thread
+	Timer_Wheel_Entry timeout_timer;
+	/**
+	 * @brief Window of statements observed after a statement pinning the backend connection, see
+	 *   'MySQL_Multiplex_Affinity'. No window is open if 'digest' is 0.
+	 */
+	struct {
+		uint64_t digest;
+		MUX_AFFINITY_kind kind;
+		int remaining;
+		// the connection wasn't pinned, the digest was learned to never need it
+		bool released;
+		bool dependent;
+		// the statement that opened the window isn't counted
+		bool skip_current;
+	} mux_affinity;
+
 	MySQL_Session();
 	~MySQL_Session();
 
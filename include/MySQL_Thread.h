@@ -3,6 +3,7 @@
 #define ____CLASS_STANDARD_MYSQL_THREAD_H
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
+#include "prometheus/histogram.h"
 
 #include "proxysql.h"
 #include "cpp.h"
@@ -15,6 +16,9 @@
 #include "prometheus_helpers.h"
 
 #include "set_parser.h"
+#include "Latency_Histogram.h"
+#include "Timer_Wheel.h"
+#include "proxy_protocol_info.h"
 
 /*
 #define MIN_POLL_LEN 8
@@ -71,6 +75,11 @@ enum MySQL_Thread_status_variable {
 	st_var_ConnPool_get_conn_latency_awareness,
 	st_var_gtid_binlog_collected,
 	st_var_gtid_session_collected,
+	st_var_gtid_read_your_writes_delayed,
+	st_var_gtid_read_your_writes_fallback,
+	st_var_concurrency_limit_queued,
+	st_var_concurrency_limit_rejected,
+	st_var_concurrency_limit_wait_time_us,
 	st_var_generated_pkt_err,
 	st_var_max_connect_timeout_err,
 	st_var_backend_lagging_during_query,
@@ -86,9 +95,27 @@ enum MySQL_Thread_status_variable {
 	st_var_automatic_detected_sqli,
 	st_var_mysql_whitelisted_sqli_fingerprint,
 	st_var_client_host_error_killed_connections,
+	st_var_send_buffer_copied_bytes,
+	st_var_writev_bytes_sent,
 	MY_st_var_END
 };
 
+/**
+ * @brief Stages of a query timed by 'mysql-stats_time_query_stages'. See 'Query_Info::stage_mark()'.
+ */
+enum MySQL_Query_Stage {
+	query_stage_digest,          // query parsing and digest computation
+	query_stage_query_processor, // query rules processing
+	query_stage_connpool,        // wait for a backend connection, including the creation of new ones
+	query_stage_backend_sync,    // sync of the backend connection state: schema, user, session variables
+	query_stage_backend,         // query execution on the backend
+	query_stage_result,          // result processing, until the end of the request
+	query_stage_total,           // the whole request
+	query_stage___END
+};
+
+extern const char* mysql_query_stage_names[query_stage___END];
+
 class __attribute__((aligned(64))) MySQL_Thread : public Base_Thread
 {
 	friend class PgSQL_Thread;
@@ -103,6 +130,13 @@ class __attribute__((aligned(64))) MySQL_Thread : public Base_Thread
 
 	PtrArray *cached_connections;
 
+	// scheduling of the sessions through a ready list, see 'mysql-sessions_ready_list'
+	bool ready_list_active;
+	bool reschedule_session_timers; // the deadlines of all the sessions need to be recomputed
+	std::vector<MySQL_Session *> ready_sessions;
+	std::vector<MySQL_Session *> processed_sessions;
+	Timer_Wheel sessions_timers; // deadlines of the sessions timeouts, in milliseconds
+
 #ifdef IDLE_THREADS
 	struct epoll_event events[MY_EPOLL_THREAD_MAXEVENTS];
 	int efd;
@@ -141,6 +175,12 @@ class __attribute__((aligned(64))) MySQL_Thread : public Base_Thread
 	void run_StopListener();
 	//void run_SetAllSession_ToProcess0();
 
+	void set_ready_list_active(bool active);
+	void run_SetReadySessions_ToProcess0();
+	void schedule_session_timeout(MySQL_Session *sess);
+	void session_timeout_expired(MySQL_Session *sess);
+	void process_ready_sessions();
+
 
 	protected:
 	int nfds;
@@ -181,11 +221,18 @@ class __attribute__((aligned(64))) MySQL_Thread : public Base_Thread
 		unsigned int active_transactions;
 	} status_variables;
 
+	// per stage latency of the queries processed by this thread, in nanoseconds
+	Latency_Histogram query_stages[query_stage___END];
+
+	// 'mysql-proxy_protocol_networks', compiled on every refresh of the variables
+	ProxyProtocol_Networks proxy_protocol_networks;
+
 	struct {
 		int min_num_servers_lantency_awareness;
 		int aurora_max_lag_ms_only_read_from_replicas;
 		bool stats_time_backend_query;
 		bool stats_time_query_processor;
+		bool stats_time_query_stages;
 		bool query_cache_stores_empty_result;
 	} variables;
 
@@ -212,8 +259,14 @@ class __attribute__((aligned(64))) MySQL_Thread : public Base_Thread
 	//void ProcessAllSessions_SortingSessions();
 	void ProcessAllSessions_CompletedMirrorSession(unsigned int& n, MySQL_Session *sess);
 	void ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned long long sess_time, unsigned int& total_active_transactions_);
+	void ProcessAllSessions_CheckConnectTimeout(MySQL_Session *sess);
+	void ProcessAllSessions_CheckTimeouts(MySQL_Session *sess, unsigned long long sess_time);
+	void ProcessAllSessions_CheckBackends(MySQL_Session *sess);
 	void ProcessAllSessions_Healthy0(MySQL_Session *sess, unsigned int& n);
+	bool ProcessAllSessions_Session(MySQL_Session *sess, unsigned int& n);
 	void process_all_sessions();
+	void push_ready_session(MySQL_Session *sess);
+	void push_ready_session_if_pending(MySQL_Session *sess);
   void refresh_variables();
   void register_session_connection_handler(MySQL_Session *_sess, bool _new=false);
   void unregister_session_connection_handler(int idx, bool _new=false);
@@ -283,6 +336,13 @@ struct p_th_counter {
 		mysql_killed_backend_connections,
 		mysql_killed_backend_queries,
 		client_host_error_killed_connections,
+		send_buffer_copied_bytes,
+		writev_bytes_sent,
+		gtid_read_your_writes_delayed,
+		gtid_read_your_writes_fallback,
+		concurrency_limit_queued,
+		concurrency_limit_rejected,
+		concurrency_limit_wait_time_us,
 		__size
 	};
 };
@@ -447,6 +507,7 @@ class MySQL_Threads_Handler
 		bool session_idle_show_processlist;
 #endif // IDLE_THREADS
 		bool sessions_sort;
+		bool sessions_ready_list;
 		char *default_schema;
 		char *interfaces;
 		char *server_version;
@@ -465,8 +526,10 @@ class MySQL_Threads_Handler
 		bool query_digests_normalize_digest_text;
 		bool query_digests_track_hostname;
 		bool query_digests_keep_comment;
+		bool query_digests_stop_at_max_digest_length;
 		int query_digests_grouping_limit;
 		int query_digests_groups_grouping_limit;
+		int query_digests_cache_size;
 		bool parse_failure_logs_digest;
 		bool default_reconnect;
 		bool have_compress;
@@ -491,6 +554,7 @@ class MySQL_Threads_Handler
 		int threshold_resultset_size;
 		int query_digests_max_digest_length;
 		int query_digests_max_query_length;
+		int query_digests_histograms_max;
 		int query_rules_fast_routing_algorithm;
 		int wait_timeout;
 		int throttle_max_bytes_per_second_to_client;
@@ -510,6 +574,9 @@ class MySQL_Threads_Handler
 		int reset_connection_algorithm;
 		int auto_increment_delay_multiplex;
 		int auto_increment_delay_multiplex_timeout_ms;
+		bool multiplex_affinity_learning; // learning is per digest, it requires 'mysql-query_digests'
+		int multiplex_affinity_min_samples;
+		int concurrency_limit_queue_timeout_ms;
 		int long_query_time;
 		int hostgroup_manager_verbose;
 		int binlog_reader_connect_retry_msec;
@@ -530,6 +597,9 @@ class MySQL_Threads_Handler
 		int eventslog_filesize;
 		int eventslog_default_log;
 		int eventslog_format;
+		int eventslog_sample_rate;
+		int eventslog_slow_query_threshold;
+		int eventslog_digest_rate_limit;
 		char *auditlog_filename;
 		int auditlog_filesize;
 		// SSL related, proxy to server
@@ -547,12 +617,17 @@ class MySQL_Threads_Handler
 		int aurora_max_lag_ms_only_read_from_replicas;
 		bool stats_time_backend_query;
 		bool stats_time_query_processor;
+		bool stats_time_query_stages;
 		bool query_cache_stores_empty_result;
+		bool query_cache_table_invalidation;
 		bool kill_backend_connection_when_disconnect;
 		bool client_session_track_gtid;
+		bool gtid_read_your_writes;
+		int gtid_read_your_writes_timeout_ms;
 		bool enable_client_deprecate_eof;
 		bool enable_server_deprecate_eof;
 		bool enable_load_data_local_infile;
+		bool use_writev;
 		bool log_mysql_warnings_enabled;
 		int data_packets_history_size;
 		int handle_warnings;
@@ -564,6 +639,9 @@ class MySQL_Threads_Handler
 		/// Prometheus metrics arrays
 		std::array<prometheus::Counter*, p_th_counter::__size> p_counter_array {};
 		std::array<prometheus::Gauge*, p_th_gauge::__size> p_gauge_array {};
+		std::array<prometheus::Histogram*, query_stage___END> p_query_stages_array {};
+		/// Per stage counts of the 'p_query_stages_array' buckets already exported, followed by the sum
+		std::array<std::vector<uint64_t>, query_stage___END> p_query_stages_exported {};
 	} status_variables;
 
 	std::atomic<bool> bootstrapping_listeners;
@@ -681,6 +759,20 @@ class MySQL_Threads_Handler
 	unsigned long long get_status_variable(enum MySQL_Thread_status_variable v_idx, p_th_counter::metric m_idx, unsigned long long conv = 0);
 	unsigned long long get_status_variable(enum MySQL_Thread_status_variable v_idx, p_th_gauge::metric m_idx, unsigned long long conv = 0);
 	unsigned int get_active_transations();
+	/**
+	 * @brief Merges the per stage latency histograms of all the worker threads.
+	 * @param hists Array of 'query_stage___END' histograms the threads histograms are merged into.
+	 */
+	void get_query_stages(Latency_Histogram* hists);
+	/**
+	 * @brief Returns the resultset for 'stats_mysql_query_stages', see 'mysql-stats_time_query_stages'.
+	 */
+	SQLite3_result* SQL3_Query_Stages();
+	/**
+	 * @brief Updates the 'proxysql_mysql_query_stage_seconds' histograms with the latencies recorded since the
+	 *   previous update.
+	 */
+	void p_update_query_stages();
 #ifdef IDLE_THREADS
 	unsigned int get_non_idle_client_connections();
 #endif // IDLE_THREADS
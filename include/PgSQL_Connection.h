@@ -653,6 +653,7 @@ public:
 	uint8_t result_type;
 	PGresult* pgsql_result;
 	PSresult  ps_result;
+	int       ps_result_rows; // number of DataRow messages in 'ps_result'
 	PgSQL_Query_Result* query_result;
 	PgSQL_Query_Result* query_result_reuse;
 	bool new_result;
@@ -666,6 +667,10 @@ private:
 	// Handles the COPY OUT response from the server.
 	// Returns true if it consumes all buffer data, or false if the threshold for result size is reached
 	bool handle_copy_out(const PGresult* result, uint64_t* processed_bytes);
+	// Consumes the DataRow messages available in libpq input buffer into 'ps_result'.
+	// With 'pgsql-bulk_data_rows' all the consecutive complete messages are consumed at once, up to the free
+	// space in the resultset buffer. Returns the same values of 'PShandleRowData()'.
+	int handle_row_data();
 	static void notice_handler_cb(void* arg, const PGresult* result);
 	static void unhandled_notice_cb(void* arg, const PGresult* result);
 };
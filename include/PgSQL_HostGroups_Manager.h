@@ -633,6 +633,9 @@ class PgSQL_HostGroups_Manager : public Base_HostGroups_Manager<PgSQL_HGC> {
 		unsigned long long access_denied_max_user_connections;
 		unsigned long long select_for_update_or_equivalent;
 		unsigned long long auto_increment_delay_multiplex;
+		unsigned long long copy_in_commands;
+		unsigned long long copy_in_bytes;
+		unsigned long long copy_in_rows;
 
 		//////////////////////////////////////////////////////
 		///              Prometheus Metrics                ///
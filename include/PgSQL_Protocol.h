@@ -357,10 +357,12 @@ public:
 	 *
 	 * @param result A pointer to a `PSresult` object containing the row data
 	 *               to add.
+	 * @param rows The number of consecutive DataRow messages in `result`, as
+	 *             returned by `PShandleRowDataBulk`.
 	 *
 	 * @return The number of bytes added to the query result.
 	 */
-	unsigned int add_row(const PSresult* result);
+	unsigned int add_row(const PSresult* result, unsigned int rows = 1);
 
 	/**
 	 * @brief Adds a command completion message to the query result.
@@ -904,10 +906,11 @@ public:
 	 *                       buffer will be copied.
 	 * @param result A pointer to the `PSresult` object containing the buffer to
 	 *              be copied.
+	 * @param rows The number of messages contained in the buffer.
 	 *
 	 * @return The number of bytes copied to the `PgSQL_Query_Result` object.
 	 */
-	unsigned int copy_buffer_to_PgSQL_Query_Result(bool send, PgSQL_Query_Result* pg_query_result, const PSresult* result);
+	unsigned int copy_buffer_to_PgSQL_Query_Result(bool send, PgSQL_Query_Result* pg_query_result, const PSresult* result, unsigned int rows = 1);
 
     /**
      * @brief Copies the start of a response to a PgSQL_Query_Result.
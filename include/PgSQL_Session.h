@@ -279,7 +279,44 @@ private:
 	 */
 	void switch_fast_forward_to_normal_mode();
 
+	/**
+	 * @brief State of the 'COPY ... FROM STDIN' being streamed to the backend.
+	 * @details Client messages are coalesced into 'batch' before being queued into the backend
+	 *   'PSarrayOUT', so that a load made of many small 'CopyData' messages is sent in buffers of
+	 *   'PGSQL_RESULTSET_BUFLEN' bytes. 'bytes' and 'rows' are accounted in 'PgHGM->status' when the
+	 *   session switches back to normal mode.
+	 */
+	struct {
+		PtrSize_t batch;
+		unsigned int batch_capacity;
+		unsigned long long bytes;
+		unsigned long long rows;
+	} copy_in;
+
+	/**
+	 * @brief Appends a client message to the current 'COPY FROM STDIN' batch.
+	 * @details Messages bigger than the batch capacity are queued as they are, after the pending batch.
+	 *   Ownership of the packet is taken in both cases.
+	 */
+	void copy_in_add_to_batch(PtrSize_t& pkt);
+
+	/**
+	 * @brief Queues the pending 'COPY FROM STDIN' batch, if any, into the backend 'PSarrayOUT'.
+	 */
+	void copy_in_flush_batch();
+
+	/**
+	 * @brief Inspects a backend message received during 'COPY FROM STDIN', collecting the number of
+	 *   rows reported by 'CommandComplete'.
+	 */
+	void copy_in_process_backend_msg(const PtrSize_t& pkt);
+
 public:
+	/**
+	 * @brief Returns true if the backend of a 'COPY FROM STDIN' has enough pending data that no more data
+	 *   should be read from the client.
+	 */
+	bool copy_in_backend_is_slow() const;
 	bool handler_again___status_SETTING_GENERIC_VARIABLE(int* _rc, const char* var_name, const char* var_value, bool no_quote = false, bool set_transaction = false);
 #if 0
 	bool handler_again___status_SETTING_SQL_LOG_BIN(int*);
@@ -910,13 +910,16 @@ public:
 		bool query_digests_normalize_digest_text;
 		bool query_digests_track_hostname;
 		bool query_digests_keep_comment;
+		bool query_digests_stop_at_max_digest_length;
 		int query_digests_grouping_limit;
 		int query_digests_groups_grouping_limit;
+		int query_digests_cache_size;
 		bool parse_failure_logs_digest;
 		bool default_reconnect;
 		bool have_compress;
 		bool have_ssl;
 		bool multiplexing;
+		bool bulk_data_rows;
 		//		bool stmt_multiplexing;
 		bool log_unhealthy_connections;
 		bool enforce_autocommit_on_reads;
@@ -5,10 +5,14 @@
 #include "thread.h"
 #include "wqueue.h"
 #include <vector>
+#include <mutex>
+#include <condition_variable>
 
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
 
+#include "ProxySQL_Cluster_Changelog.hpp"
+
 #define PROXYSQL_NODE_METRICS_LEN	5
 
 /**
@@ -61,6 +65,24 @@
 /* @brief Query to be intercepted by 'ProxySQL_Admin' for 'runtime_mysql_query_rules_fast_routing'. See top comment for details. */
 #define CLUSTER_QUERY_MYSQL_QUERY_RULES_FAST_ROUTING "PROXY_SELECT username, schemaname, flagIN, destination_hostgroup, comment FROM runtime_mysql_query_rules_fast_routing ORDER BY username, schemaname, flagIN"
 
+/**
+ * @brief Queries to be intercepted by 'ProxySQL_Admin' to fetch the changes performed to a module since the
+ *   module had the checksum that follows the query, quoted. See 'ProxySQL_Cluster_Changelog' for details.
+ * @details Tables are identified by their position in the module: for 'mysql_query_rules', 0 is
+ *   'runtime_mysql_query_rules' and 1 is 'runtime_mysql_query_rules_fast_routing'. The query fails if the
+ *   checksum isn't present in the changelog of the peer, in which case the whole tables need to be fetched.
+ */
+#define CLUSTER_QUERY_MYSQL_QUERY_RULES_CHANGES "PROXY_SELECT CHANGES FROM mysql_query_rules SINCE "
+#define CLUSTER_QUERY_MYSQL_USERS_CHANGES "PROXY_SELECT CHANGES FROM mysql_users SINCE "
+
+/**
+ * @brief Command sent by a node to a peer, on the connection of its monitor thread, when its configuration
+ *   changes and 'admin-cluster_push_notifications' is enabled. The peer checks the node immediately, instead
+ *   of waiting for 'admin-cluster_check_interval_ms', and syncs the change without waiting for
+ *   'admin-cluster_*_diffs_before_sync' checks.
+ */
+#define CLUSTER_QUERY_PUSH_NOTIFICATION "PROXYSQL CLUSTER_NOTIFY"
+
 class ProxySQL_Checksum_Value_2: public ProxySQL_Checksum_Value {
 	public:
 	time_t last_updated;
@@ -163,6 +185,24 @@ class ProxySQL_Node_Entry {
 		ProxySQL_Checksum_Value_2 mysql_servers_v2;
 	} checksums_values;
 	uint64_t global_checksum;
+	/**
+	 * @brief Push notifications exchanged with the peer, see 'admin-cluster_push_notifications'. Accessed with
+	 *   the mutex of 'ProxySQL_Cluster_Nodes' held.
+	 */
+	struct {
+		/** @brief Local global checksum for which the peer was last considered as a notification target. */
+		uint64_t checksum;
+		/** @brief The peer notified a configuration change, and its checksums haven't been fetched yet. */
+		bool received;
+		unsigned long long sent_cnt;
+		unsigned long long received_cnt;
+	} push;
+	/** @brief Time ('monotonic_time()') at which the last new global checksum of the peer was detected. */
+	unsigned long long global_checksum_changed_at;
+	/** @brief Time between the detection of the last configuration synced from the peer and the end of the sync. */
+	unsigned long long last_sync_lag_us;
+	/** @brief Time between the epoch of the last configuration synced from the peer and the end of the sync. */
+	time_t last_sync_age_s;
 };
 
 struct p_cluster_nodes_counter {
@@ -259,6 +299,30 @@ class ProxySQL_Cluster_Nodes {
 	void get_peer_to_sync_admin_variables(char **host, uint16_t* port, char** ip_address);
 	void get_peer_to_sync_ldap_variables(char **host, uint16_t *port, char** ip_address);
 	void get_peer_to_sync_proxysql_servers(char **host, uint16_t *port, char ** ip_address);
+	/**
+	 * @brief Records a push notification received from a peer.
+	 * @details The peer is identified by the address of the connection and by the admin interfaces it
+	 *   reported with 'PROXYSQL CLUSTER_NODE_UUID'.
+	 * @return True if the peer is present in 'proxysql_servers', false otherwise.
+	 */
+	bool Receive_Push_Notification(const char* addr, const char* admin_mysql_ifaces);
+	/**
+	 * @brief Called by the monitor thread of a peer to know if a push notification should be sent to the peer,
+	 *   or if one was received from it.
+	 * @details For every new local global checksum, the 'fanout' peers whose hash mixed with the checksum is
+	 *   lowest are notified. Changing the targets at every change spreads the notifications through the
+	 *   cluster as a gossip: the peers syncing the change notify in turn other peers.
+	 * @param send Set to true if the local configuration changed and the peer is a notification target.
+	 * @param received Set to true if the peer notified a change not yet fetched.
+	 * @return False if the node doesn't exist anymore.
+	 */
+	bool Fetch_Push_State(char* _h, uint16_t _p, unsigned int fanout, bool& send, bool& received);
+	/**
+	 * @brief Records the convergence time of a configuration pulled from a peer.
+	 * @details Must be called with the mutex held, like all the pull functions.
+	 * @param epoch Epoch of the pulled configuration, i.e. the time it was loaded in the original node.
+	 */
+	void Record_Sync(const char* _h, uint16_t _p, time_t epoch);
 };
 
 struct p_cluster_counter {
@@ -301,6 +365,22 @@ struct p_cluster_counter {
 		pulled_mysql_ldap_mapping_success,
 		pulled_mysql_ldap_mapping_failure,
 
+		pulled_changes_mysql_query_rules_success,
+		pulled_changes_mysql_query_rules_failure,
+		pulled_changes_mysql_users_success,
+		pulled_changes_mysql_users_failure,
+
+		pulled_bytes_mysql_query_rules,
+		pulled_bytes_mysql_servers,
+		pulled_bytes_mysql_users,
+
+		pull_time_mysql_query_rules,
+		pull_time_mysql_servers,
+		pull_time_mysql_users,
+
+		push_notifications_sent,
+		push_notifications_received,
+
 		sync_conflict_mysql_query_rules_share_epoch,
 		sync_conflict_mysql_servers_share_epoch,
 		sync_conflict_proxysql_servers_share_epoch,
@@ -389,6 +469,9 @@ private:
 	pthread_mutex_t mutex;
 	std::vector<pthread_t> term_threads;
 	ProxySQL_Cluster_Nodes nodes;
+	std::mutex wake_up_mutex;
+	std::condition_variable wake_up_cond;
+	uint64_t wake_up_seq;
 	char* cluster_username;
 	char* cluster_password;
 	struct {
@@ -396,6 +479,20 @@ private:
 		std::array<prometheus::Gauge*, p_cluster_gauge::__size> p_gauge_array{};
 	} metrics;
 	int fetch_and_store(MYSQL* conn, const fetch_query& f_query, MYSQL_RES** result);
+	/**
+	 * @brief Fetches from the peer the changes performed to the query rules since the local checksum, and
+	 *   loads them to runtime.
+	 * @return True if the query rules were loaded, false if the whole tables need to be fetched.
+	 */
+	bool pull_mysql_query_rules_changes_from_peer(MYSQL* conn, const char* hostname, uint16_t port,
+		const std::string& expected_checksum, const time_t epoch, uint64_t& bytes);
+	/**
+	 * @brief Fetches from the peer the changes performed to the users since the local checksum, and loads them
+	 *   to runtime.
+	 * @return True if the users were loaded, false if the whole table needs to be fetched.
+	 */
+	bool pull_mysql_users_changes_from_peer(MYSQL* conn, const char* hostname, uint16_t port,
+		const std::string& expected_checksum, const time_t epoch, uint64_t& bytes);
 	friend class ProxySQL_Node_Entry;
 public:
 	pthread_mutex_t update_mysql_query_rules_mutex;
@@ -426,6 +523,9 @@ public:
 	int cluster_ldap_variables_diffs_before_sync;
 	int cluster_admin_variables_diffs_before_sync;
 	int cluster_mysql_servers_sync_algorithm;
+	int cluster_changelog_max_rows;
+	bool cluster_push_notifications;
+	int cluster_push_fanout;
 	bool cluster_mysql_query_rules_save_to_disk;
 	bool cluster_mysql_servers_save_to_disk;
 	bool cluster_mysql_users_save_to_disk;
@@ -433,6 +533,27 @@ public:
 	bool cluster_mysql_variables_save_to_disk;
 	bool cluster_ldap_variables_save_to_disk;
 	bool cluster_admin_variables_save_to_disk;
+	/**
+	 * @brief Changes performed to 'runtime_mysql_query_rules' and 'runtime_mysql_query_rules_fast_routing',
+	 *   recorded by 'ProxySQL_Admin::load_mysql_query_rules_to_runtime()'.
+	 */
+	ProxySQL_Cluster_Changelog mysql_query_rules_changelog;
+	/**
+	 * @brief Changes performed to 'runtime_mysql_users', recorded by 'ProxySQL_Admin::__refresh_users()'.
+	 */
+	ProxySQL_Cluster_Changelog mysql_users_changelog;
+	/**
+	 * @brief Wakes up the monitor threads waiting for the next check, due to a change of the local global
+	 *   checksum or to a push notification received from a peer.
+	 */
+	void wake_monitor_threads();
+	/**
+	 * @brief Waits until 'wake_monitor_threads()' is called, or for 'timeout_us'.
+	 * @param seq Number of wake ups already seen by the caller, updated on return.
+	 */
+	void wait_monitor_wake_up(unsigned long long timeout_us, uint64_t& seq);
+	bool Receive_Push_Notification(const char* addr, const char* admin_mysql_ifaces);
+	bool Fetch_Push_State(char* _h, uint16_t _p, unsigned int fanout, bool& send, bool& received);
 	ProxySQL_Cluster();
 	~ProxySQL_Cluster();
 	void init() {};
@@ -0,0 +1,88 @@
+#ifndef CLASS_PROXYSQL_CLUSTER_CHANGELOG_H
+#define CLASS_PROXYSQL_CLUSTER_CHANGELOG_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SQLite3_result;
+
+/**
+ * @brief Bounded log of the row changes applied to the runtime configuration of a Cluster module.
+ * @details Every time a module is loaded to runtime, its previous and new runtime resultsets are compared row
+ *   by row ('diff()'), and the deleted and inserted rows are recorded as one entry ('add()'), identified by
+ *   the module checksums before and after the load. A peer holding one of the recorded checksums can fetch
+ *   the changes performed since then ('get_changes()') and apply them on top of its own runtime resultsets
+ *   ('apply_changes()'), instead of fetching the whole tables.
+ *
+ *   Changes are stored in the same format used to send them to peers: a resultset with the columns 'op'
+ *   ('D' for deleted rows, 'I' for inserted rows), 'tbl' (index of the table in the module) and the fields
+ *   of the row, padded with NULLs up to the widest table of the module. Within an entry deleted rows come
+ *   first, so a row updated in place is a 'D' of the old content followed by an 'I' of the new one.
+ *
+ *   Rows are identified by their content, so no knowledge of the primary keys of the tables is required.
+ *   Peers must always verify the checksum of the resultsets produced by 'apply_changes()', and fall back to
+ *   fetch the whole tables in case of mismatch, or if their checksum isn't present in the log.
+ */
+class ProxySQL_Cluster_Changelog {
+	public:
+	/**
+	 * @brief Defines the order of the rows of a table, matching the 'ORDER BY' of the query used to build its
+	 *   runtime resultset. NULL for tables whose checksum doesn't depend on the order of the rows.
+	 */
+	typedef bool (*row_cmp_t)(char **a, char **b);
+	/**
+	 * @param _table_columns Number of columns of each of the tables of the module.
+	 * @param _row_cmps Order of the rows of each of the tables of the module.
+	 */
+	ProxySQL_Cluster_Changelog(const std::vector<int>& _table_columns, const std::vector<row_cmp_t>& _row_cmps);
+	~ProxySQL_Cluster_Changelog();
+	/**
+	 * @brief Computes the rows deleted and inserted between two versions of the resultsets of the module.
+	 * @param prev The previous runtime resultsets, one per table.
+	 * @param cur The new runtime resultsets, one per table.
+	 * @return A new resultset holding the changes, NULL if any of the resultsets is missing.
+	 */
+	SQLite3_result* diff(const std::vector<SQLite3_result*>& prev, const std::vector<SQLite3_result*>& cur) const;
+	/**
+	 * @brief Records the changes performed to move the module from checksum 'from' to checksum 'to'.
+	 * @details The log takes ownership of 'changes'. Oldest entries are discarded until the total number of
+	 *   rows is within 'max_rows'; if 'changes' alone exceeds it, the whole log is discarded. The log is also
+	 *   discarded if 'from' doesn't match the checksum of the last entry, as the chain of changes is broken,
+	 *   or if 'changes' is NULL: the changes couldn't be computed.
+	 */
+	void add(const std::string& from, const std::string& to, SQLite3_result* changes, unsigned int max_rows);
+	/**
+	 * @brief Returns all the changes recorded since the module had checksum 'checksum'.
+	 * @return A new resultset to be freed by the caller, or NULL if 'checksum' isn't present in the log.
+	 */
+	SQLite3_result* get_changes(const std::string& checksum);
+	/**
+	 * @brief Applies 'changes' to a copy of the resultsets 'base'.
+	 * @param base The current runtime resultsets of the module, one per table. They are not modified.
+	 * @param changes The changes, as returned by 'get_changes()'.
+	 * @return The new resultsets, one per table, to be freed by the caller. Empty if the changes can't be
+	 *   applied: a deleted row not found, or an inserted row already present.
+	 */
+	std::vector<SQLite3_result*> apply_changes(
+		const std::vector<SQLite3_result*>& base, const SQLite3_result* changes
+	) const;
+	void reset();
+	private:
+	typedef struct _entry_t {
+		std::string from;
+		std::string to;
+		SQLite3_result* changes;
+	} entry_t;
+	std::vector<int> table_columns;
+	std::vector<row_cmp_t> row_cmps;
+	int columns;
+	std::mutex mutex;
+	std::deque<entry_t> entries;
+	unsigned long long num_rows;
+	SQLite3_result* new_changes_resultset() const;
+	void _reset();
+};
+
+#endif // CLASS_PROXYSQL_CLUSTER_CHANGELOG_H
@@ -0,0 +1,65 @@
+#ifndef CLASS_PROXYSQL_SNAPSHOT_H
+#define CLASS_PROXYSQL_SNAPSHOT_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+class SQLite3_result;
+
+/**
+ * @brief Binary snapshot of the runtime resultsets of the modules, used to speed up startup.
+ * @details A snapshot holds one section per module ('mysql_users', 'mysql_query_rules', ...). Each section
+ *   holds the runtime checksum and epoch of the module, and the resultsets it was built from, in the same
+ *   format used by Cluster to supply them to 'ProxySQL_Admin' (see 'init_users()' and
+ *   'load_mysql_query_rules_to_runtime()'). At startup, these resultsets can be loaded to runtime without
+ *   running any query against the Admin database.
+ *
+ *   File layout, all integers in host byte order:
+ *   - Header: the magic 'PSQLSNAP', the format version and the number of sections ('uint32_t').
+ *   - For each section: name, checksum, epoch ('int64_t'), number of resultsets, and for each resultset the
+ *     number of columns and rows, the columns definitions, and all the fields of all the rows.
+ *   - Trailer: a SpookyHash of everything preceding it.
+ *
+ *   Strings are stored as their length ('uint32_t') followed by their bytes and a NUL terminator, so that
+ *   fields can be referenced directly in the mapped file. NULL fields are stored with length 'UINT32_MAX'.
+ *   Snapshots are written to a temporary file which is then renamed, so a snapshot file is never partially
+ *   written; files with an unknown version or a mismatching trailer are rejected as a whole.
+ *
+ *   A snapshot is only a cache of the runtime: callers are responsible for verifying the checksum of the
+ *   loaded resultsets, and to validate them against the Admin database.
+ */
+class ProxySQL_Snapshot {
+	public:
+	typedef struct _section_t {
+		std::string name;
+		std::string checksum;
+		time_t epoch;
+		std::vector<SQLite3_result*> resultsets;
+	} section_t;
+	/**
+	 * @brief Serializes the supplied sections in the snapshot format. The resultsets are not modified.
+	 * @details Kept apart from 'write()' so that callers can serialize the runtime resultsets while holding
+	 *   the locks protecting them, and write the file after releasing them.
+	 */
+	static std::string serialize(const std::vector<section_t>& sections);
+	/**
+	 * @brief Writes a serialized snapshot to 'path', replacing the previous one atomically.
+	 * @return 'true' on success, otherwise 'false' and 'err' is filled with the reason.
+	 */
+	static bool write(const std::string& path, const std::string& buf, std::string& err);
+	/**
+	 * @brief Reads the snapshot in 'path', mapping the file in memory.
+	 * @param sections Filled with the sections found in the snapshot. The resultsets are to be freed by the
+	 *   caller.
+	 * @return 'true' on success, otherwise 'false', 'err' is filled with the reason and 'sections' is left
+	 *   empty.
+	 */
+	static bool read(const std::string& path, std::vector<section_t>& sections, std::string& err);
+	/**
+	 * @brief Frees the resultsets of the supplied sections, and clears them.
+	 */
+	static void free_sections(std::vector<section_t>& sections);
+};
+
+#endif /* CLASS_PROXYSQL_SNAPSHOT_H */
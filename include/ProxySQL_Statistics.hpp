@@ -7,6 +7,7 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include "ProxySQL_TimeSeries.hpp"
 
 #define STATSDB_SQLITE_TABLE_MYSQL_CONNECTIONS_V1_4 "CREATE TABLE mysql_connections (timestamp INT NOT NULL, Client_Connections_aborted INT NOT NULL, Client_Connections_connected INT NOT NULL, Client_Connections_created INT NOT NULL, Server_Connections_aborted INT NOT NULL, Server_Connections_connected INT NOT NULL, Server_Connections_created INT NOT NULL, ConnPool_get_conn_failure INT NOT NULL, ConnPool_get_conn_immediate INT NOT NULL, ConnPool_get_conn_success INT NOT NULL, Questions INT NOT NULL, Slow_queries INT NOT NULL, PRIMARY KEY (timestamp))"
 
@@ -109,6 +110,19 @@ class ProxySQL_Statistics {
 	void MySQL_Threads_Handler_sets_v2(SQLite3_result *);
 	void MyHGM_Handler_sets_v1(SQLite3_result *);
 	void MyHGM_Handler_sets_connection_pool(SQLite3_result *);
+	ProxySQL_TimeSeries *timeseries;
+	std::mutex timeseries_mutex;
+	// per table, the timestamp of the last sample copied by 'timeseries_materialize()'
+	std::map<std::string, int64_t> timeseries_materialized_to;
+	/**
+	 * @brief Returns the time series store, creating it in '<datadir>/stats_history_ts' on first use.
+	 */
+	ProxySQL_TimeSeries * get_timeseries();
+	/**
+	 * @brief Appends a sample to the table 'name' of the time series store, 'values[0]' being the timestamp.
+	 */
+	void timeseries_append(const char *name, const uint64_t *values);
+	SQLite3_result * get_timeseries_metrics(const char *name, int interval);
 	public:
 	struct {
 		int stats_mysql_connection_pool;
@@ -119,6 +133,7 @@ class ProxySQL_Statistics {
 #ifndef NOJEM
 		int stats_system_memory;
 #endif
+		bool stats_history_timeseries;
 	} variables;
 	ProxySQL_Statistics();
 	~ProxySQL_Statistics();
@@ -148,6 +163,16 @@ class ProxySQL_Statistics {
 #endif
 	SQLite3_result * get_MySQL_Query_Cache_metrics(int interval);
 	void disk_upgrade_mysql_connections();
+	/**
+	 * @brief Rewrites the 'stats_history' tables referenced by 'query' from the time series store.
+	 * @details Used when 'admin-stats_history_timeseries' is enabled: the samples of 'system_cpu',
+	 *   'system_memory', 'mysql_connections', 'myhgm_connections', 'mysql_query_cache' and of their '_hour'
+	 *   tables are only kept in the time series store, and copied into the SQLite tables right before these
+	 *   are queried. Only a table whose name is referenced by 'query' is copied, and only the samples not
+	 *   copied yet: rows written before the store was enabled are kept. The retention of the SQLite tables is
+	 *   applied at the same time, as the periodic inserts are skipped.
+	 */
+	void timeseries_materialize(const char *query);
 
 	/** 
 	 * @brief Retreives the variable id mapped to the provided variable name associated in the history_mysql_variables_lookup table.
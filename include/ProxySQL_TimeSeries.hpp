@@ -0,0 +1,158 @@
+#ifndef CLASS_PROXYSQL_TIMESERIES_H
+#define CLASS_PROXYSQL_TIMESERIES_H
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SQLite3_result;
+
+/**
+ * @brief Aggregation applied to a column when a block is downsampled into the next resolution.
+ */
+enum TS_aggregation {
+	TS_AGG_MAX,
+	TS_AGG_AVG,
+	TS_AGG_SUM,
+};
+
+/**
+ * @brief Encoding and decoding of the immutable blocks of a 'TS_Table'.
+ * @details A block holds all the samples of a table within 'block_span' seconds, stored by column:
+ *   - The timestamps are encoded as delta-of-delta: samples taken at a fixed interval take a single bit.
+ *   - Each value column is encoded XOR-ing every value with the previous one, storing only the meaningful
+ *     bits of the result: counters that don't change take a single bit, slowly growing ones a few bits.
+ *
+ *   Block layout (little endian):
+ *   @code
+ *   "PXTS" | version (4) | ncols (4) | count (4) | block_start (8) | stream_len (4) x (1+ncols) | streams
+ *   @endcode
+ *   The first stream holds the timestamps, the following ones a value column each.
+ */
+namespace TS_Block {
+	/**
+	 * @brief Encodes 'count' samples of 'ncols' values, 'samples' holding (1+ncols) integers per sample, the
+	 *   timestamp first.
+	 */
+	std::string encode(int64_t block_start, uint32_t ncols, const std::vector<int64_t>& samples);
+	/**
+	 * @brief Decodes a block, appending its samples to 'samples' in the same layout used by 'encode()'.
+	 * @return False if the block is malformed or doesn't have 'ncols' columns.
+	 */
+	bool decode(const unsigned char *buf, size_t len, uint32_t ncols, std::vector<int64_t>& samples);
+}
+
+/**
+ * @brief A table of samples with fixed integer columns, stored as a sequence of time blocks.
+ * @details Every table is a directory holding one file per block:
+ *   - '<block_start>.blk', immutable encoded blocks, read through 'mmap()'.
+ *   - '<block_start>.open', the block being filled, an append only journal of raw samples. The journal is
+ *     replayed at startup, and sealed into a '.blk' file (written aside and renamed) once a sample belonging
+ *     to a later block arrives.
+ *
+ *   When a block is sealed its samples are aggregated in a single sample, appended to the 'downsample' table.
+ *   When a new block is opened, the blocks older than 'retention' seconds are removed.
+ *   'TS_Table' isn't thread safe, the access is serialized by 'ProxySQL_TimeSeries'.
+ */
+class TS_Table {
+	private:
+	std::string name;
+	std::string dir;
+	std::vector<std::string> columns;
+	std::vector<TS_aggregation> aggregations;
+	TS_Table *downsample;
+	int64_t block_span;
+	int64_t retention;
+	int64_t open_block_start; // -1 if there is no open block
+	std::vector<int64_t> open_samples;
+	int open_fd;
+
+	std::string block_path(int64_t block_start, const char *ext) const;
+	std::vector<int64_t> list_blocks(const char *ext) const;
+	void load_journal(int64_t block_start);
+	void open_block(int64_t block_start);
+	void seal_open_block();
+	void purge(int64_t now);
+	bool read_block(int64_t block_start, std::vector<int64_t>& samples) const;
+	public:
+	TS_Table(const std::string& _name, const std::string& _dir, const std::vector<std::string>& _columns,
+		const std::vector<TS_aggregation>& _aggregations, int64_t _block_span, int64_t _retention, TS_Table *_downsample);
+	~TS_Table();
+	TS_Table(const TS_Table&) = delete;
+	TS_Table& operator=(const TS_Table&) = delete;
+	/**
+	 * @brief Replays the journals left by a previous run. Journals older than the last one are sealed.
+	 */
+	void recover();
+	/**
+	 * @brief Appends a sample of 'columns.size()' values taken at 'ts'.
+	 */
+	void append(int64_t ts, const int64_t *values);
+	/**
+	 * @brief Appends to 'samples' the samples with timestamp in ['from','to'], ordered by timestamp.
+	 */
+	void read(int64_t from, int64_t to, std::vector<int64_t>& samples) const;
+	const std::string& get_name() const { return name; }
+	const std::vector<std::string>& get_columns() const { return columns; }
+};
+
+/**
+ * @brief Time series store for the fixed column tables of 'stats_history'.
+ * @details Replaces the SQLite row tables when 'admin-stats_history_timeseries' is enabled: samples are
+ *   appended to per table column stores, downsampled into the '_hour' tables when an hour completes, and
+ *   expired by removing whole blocks, instead of the periodic 'INSERT ... SELECT' and 'DELETE' statements.
+ *   The store is the source of truth, and the rows of the SQLite tables in the range it covers are rewritten
+ *   from it on demand (see 'ProxySQL_Statistics::timeseries_materialize()'), so the tables keep their names
+ *   and schemas, and the rows written before the store was enabled.
+ */
+class ProxySQL_TimeSeries {
+	private:
+	std::string base_dir;
+	std::map<std::string, TS_Table*> tables;
+	mutable std::mutex mu;
+	public:
+	ProxySQL_TimeSeries(const std::string& _base_dir);
+	~ProxySQL_TimeSeries();
+	ProxySQL_TimeSeries(const ProxySQL_TimeSeries&) = delete;
+	ProxySQL_TimeSeries& operator=(const ProxySQL_TimeSeries&) = delete;
+	/**
+	 * @brief Adds a table, stored in '<base_dir>/<name>', recovering its open journal.
+	 * @param downsample Name of the table receiving the aggregated blocks, already added, or NULL.
+	 */
+	void add_table(const char *name, const std::vector<std::string>& columns,
+		const std::vector<TS_aggregation>& aggregations, int64_t block_span, int64_t retention, const char *downsample);
+	bool has_table(const char *name) const;
+	void append(const char *name, int64_t ts, const int64_t *values);
+	/**
+	 * @brief Returns the samples of table 'name' in ['from','to'] in the format of the 'get_*_metrics()'
+	 *   functions of 'ProxySQL_Statistics': 'ts' as 'YYYY-MM-DD HH:MM:SS' (UTC), 'timestamp', then the columns.
+	 * @return The resultset, or NULL if the table doesn't exist.
+	 */
+	SQLite3_result * get_metrics(const char *name, int64_t from, int64_t to) const;
+	/**
+	 * @brief Calls 'row_cb(ts, values)' for every sample of table 'name' in ['from','to'].
+	 */
+	template <typename F>
+	void for_each(const char *name, int64_t from, int64_t to, F&& row_cb) const {
+		std::vector<int64_t> samples {};
+		size_t ncols = 0;
+		{
+			std::lock_guard<std::mutex> lock(mu);
+			auto it = tables.find(name);
+			if (it == tables.end()) {
+				return;
+			}
+			ncols = it->second->get_columns().size();
+			it->second->read(from, to, samples);
+		}
+		for (size_t i = 0; i + ncols < samples.size(); i += ncols + 1) {
+			row_cb(samples[i], &samples[i+1]);
+		}
+	}
+	std::vector<std::string> get_columns(const char *name) const;
+	std::vector<std::string> get_table_names() const;
+};
+
+#endif /* CLASS_PROXYSQL_TIMESERIES_H */
@@ -0,0 +1,96 @@
+#ifndef CLASS_QC_TABLE_INDEX_H
+#define CLASS_QC_TABLE_INDEX_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define QUERY_CACHE_TABLE_INDEX_SHARDS 32
+// epoch slots of each shard, for the tables not in the index
+#define QUERY_CACHE_TABLE_EPOCH_SLOTS 256
+
+/**
+ * @brief Index from tables to the keys of the Query Cache entries read from them, used by
+ *  'query_cache_table_invalidation'.
+ * @details Invalidations are ordered by a global epoch: a query takes the epoch when it starts, and its
+ *  resultset is only cached if none of its tables was invalidated at a later epoch.
+ *
+ *  Only the tables with cached entries are indexed, with the epoch of their last invalidation. The
+ *  invalidations of the tables not in the index (never read, or erased once all their entries expired)
+ *  are kept in a fixed number of epoch slots per shard, selected by the table hash: a write only delays the
+ *  caching of the tables sharing its slot, and the memory used doesn't depend on the number of tables.
+ *  All the methods are thread safe.
+ */
+class QC_table_index {
+	public:
+	/**
+	 * @param _entry_exists Returns true if the entry with the supplied key is still cached. Used to drop the
+	 *  keys of the expired entries, and the tables left without entries.
+	 */
+	QC_table_index(std::function<bool(uint64_t)> _entry_exists);
+	~QC_table_index();
+	QC_table_index(const QC_table_index&) = delete;
+	QC_table_index& operator=(const QC_table_index&) = delete;
+	/**
+	 * @brief Returns the current invalidation epoch.
+	 */
+	uint64_t get_epoch();
+	/**
+	 * @brief Indexes 'key' under each table of 'tables', pairs of table hash and the epoch taken when the
+	 *  query started.
+	 * @return False if any of the tables was invalidated after its epoch: the entry must not be cached. Tables
+	 *  processed before the failing one may already hold the key, which is harmless.
+	 */
+	bool track(uint64_t key, const std::vector<std::pair<uint64_t,uint64_t>>& tables);
+	/**
+	 * @brief Bumps the epoch and marks 'table' as invalidated at the new value.
+	 * @param keys Filled with the keys of the entries read from the table, to be dropped by the caller.
+	 */
+	void invalidate(uint64_t table, std::vector<uint64_t>& keys);
+	/**
+	 * @brief Empties the index, keeping the last invalidations for the queries still running.
+	 */
+	void clear();
+	/**
+	 * @brief Returns the number of indexed tables.
+	 */
+	size_t size();
+
+	private:
+	/**
+	 * @brief 'keys' may contain entries that already expired, and is compacted once it grows past
+	 *  'compact_at'.
+	 */
+	struct table_t {
+		uint64_t invalidated_at = 0;
+		size_t compact_at = 1024;
+		std::vector<uint64_t> keys;
+	};
+	/**
+	 * @brief 'tables' is swept once it grows past 'sweep_at'.
+	 */
+	struct shard_t {
+		pthread_mutex_t mutex;
+		std::unordered_map<uint64_t, table_t> tables;
+		uint64_t invalidated_at[QUERY_CACHE_TABLE_EPOCH_SLOTS] = {};
+		size_t sweep_at = 1024;
+	};
+	shard_t& get_shard(uint64_t table) { return shards[table % QUERY_CACHE_TABLE_INDEX_SHARDS]; }
+	static uint64_t& get_slot(shard_t& shard, uint64_t table) {
+		return shard.invalidated_at[(table / QUERY_CACHE_TABLE_INDEX_SHARDS) % QUERY_CACHE_TABLE_EPOCH_SLOTS];
+	}
+	/**
+	 * @brief Erases the tables whose entries all expired, keeping their last invalidation in their slot.
+	 *  Called with the shard mutex held.
+	 */
+	void sweep(shard_t& shard);
+	std::function<bool(uint64_t)> entry_exists;
+	shard_t shards[QUERY_CACHE_TABLE_INDEX_SHARDS];
+	// incremented by every invalidation
+	uint64_t epoch;
+};
+
+#endif /* CLASS_QC_TABLE_INDEX_H */
@@ -0,0 +1,58 @@
+#ifndef CLASS_QP_DIGEST_CACHE_H
+#define CLASS_QP_DIGEST_CACHE_H
+
+#include <stdint.h>
+
+// queries longer than this are never cached: they are rarely byte-identical
+// (bulk INSERT, long IN lists) and would make the cache memory unbounded
+#define QP_DIGEST_CACHE_MAX_QUERY_LENGTH 8192
+
+/**
+ * @brief Per-thread cache of query digests, indexed by the raw query text.
+ * @details Most of the traffic is made of byte-identical query strings. This cache stores the result of
+ *   'query_digest_and_first_comment_2()' and of the digest hash, so that the tokenizer runs only for query
+ *   texts not seen recently.
+ *   The cache is direct mapped: each query is assigned to a single slot using a 128 bit hash of its text
+ *   and of the digest options in use, and a new query evicts the previous occupant of the slot.
+ *   It is not thread safe: each worker thread owns its own instance.
+ */
+class QP_digest_cache {
+	public:
+	typedef struct _entry_t {
+		uint64_t key1;
+		uint64_t key2;
+		uint64_t digest;
+		char *digest_text;
+		unsigned int digest_text_length;
+		char *first_comment; // NULL if the query has no comment
+	} entry_t;
+	private:
+	entry_t *entries;
+	unsigned int num_entries; // always a power of 2
+	public:
+	unsigned long long hits;
+	unsigned long long misses;
+	/**
+	 * @brief Creates a cache with at least '_num_entries' slots, rounded up to a power of 2.
+	 */
+	QP_digest_cache(unsigned int _num_entries);
+	~QP_digest_cache();
+	unsigned int size() { return num_entries; }
+	/**
+	 * @brief Computes the cache key for a query.
+	 * @param opts_seed A value identifying the digest options used, mixed into the key.
+	 */
+	static void compute_key(const char *query, int query_length, uint64_t opts_seed, uint64_t *key1, uint64_t *key2);
+	/**
+	 * @brief Returns the entry matching the key, or NULL. Updates 'hits' and 'misses'.
+	 */
+	const entry_t * lookup(uint64_t key1, uint64_t key2);
+	/**
+	 * @brief Stores a copy of the digest text and of the first comment, evicting the current entry in the slot.
+	 */
+	void insert(uint64_t key1, uint64_t key2, uint64_t digest, const char *digest_text, const char *first_comment);
+	void reset();
+	unsigned long long get_memory_usage();
+};
+
+#endif // CLASS_QP_DIGEST_CACHE_H
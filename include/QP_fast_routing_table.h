@@ -0,0 +1,46 @@
+#ifndef CLASS_QP_FAST_ROUTING_TABLE_H
+#define CLASS_QP_FAST_ROUTING_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Read-only hash table for 'query_rules_fast_routing', shared by all the worker threads.
+ * @details The table is built once from the 'keys_values' buffer generated by
+ *   'Query_Processor::create_fast_routing_hashmap()': a sequence of pairs of NULL terminated strings,
+ *   the key ("username<rand_del>schemaname---flagIN") followed by the destination hostgroup.
+ *   Keys are copied into a single buffer owned by the table, and indexed with open addressing and linear
+ *   probing in a power of 2 array of slots, kept at most half full.
+ *   Once built the table is never modified, so lookups don't require any locking.
+ *   If the same key is present more than once, the last value wins, like for 'kh_put()'.
+ */
+class QP_fast_routing_table {
+	private:
+	typedef struct _slot_t {
+		uint64_t hash;
+		const char *key; // NULL for empty slots
+		int destination_hostgroup;
+	} slot_t;
+	slot_t *slots;
+	uint64_t mask; // number of slots - 1
+	char *keys;
+	size_t keys_size;
+	unsigned int num_entries;
+	static uint64_t hash_key(const char *key, size_t len);
+	public:
+	/**
+	 * @brief Builds the table from a copy of 'keys_values'.
+	 * @param keys_values Buffer of pairs of NULL terminated strings: key and destination hostgroup.
+	 * @param keys_values_size Size of 'keys_values' in bytes.
+	 */
+	QP_fast_routing_table(const char *keys_values, size_t keys_values_size);
+	~QP_fast_routing_table();
+	/**
+	 * @brief Returns the destination hostgroup for the key, or -1 if the key is not present.
+	 */
+	int lookup(const char *key) const;
+	unsigned int size() const { return num_entries; }
+	unsigned long long get_memory_usage() const;
+};
+
+#endif // CLASS_QP_FAST_ROUTING_TABLE_H
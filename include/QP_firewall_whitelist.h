@@ -0,0 +1,128 @@
+#ifndef CLASS_QP_FIREWALL_WHITELIST_H
+#define CLASS_QP_FIREWALL_WHITELIST_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class SQLite3_result;
+
+/**
+ * @brief Immutable set of digests, a sorted array with a Bloom filter in front.
+ * @details Digests are already hashes, so the two probes of the filter are taken from the digest bits
+ *   instead of hashing it again. The filter uses 16 bits per digest, rounded to a power of 2, which keeps
+ *   the false positive rate below 1.5%: most of the digests not in the set never reach the binary search.
+ */
+class QP_firewall_digest_set {
+	private:
+	uint64_t *digests;
+	uint64_t *bloom;
+	uint64_t bloom_mask; // number of bits of the filter - 1
+	unsigned int len;
+	public:
+	QP_firewall_digest_set(std::vector<uint64_t>& _digests);
+	~QP_firewall_digest_set();
+	QP_firewall_digest_set(const QP_firewall_digest_set&) = delete;
+	QP_firewall_digest_set& operator=(const QP_firewall_digest_set&) = delete;
+	bool contains(uint64_t digest) const;
+	unsigned int size() const { return len; }
+	unsigned long long get_memory_usage() const;
+};
+
+/**
+ * @brief Whitelisted digests of a 'username','client_address','schemaname' tuple, one set for each flagIN.
+ */
+class QP_firewall_whitelist_rules {
+	private:
+	// there are rarely more than a couple of distinct flagIN, a linear scan is the fastest search
+	std::vector<std::pair<int, QP_firewall_digest_set*>> sets;
+	public:
+	QP_firewall_whitelist_rules(std::unordered_map<int, std::vector<uint64_t>>& digests);
+	~QP_firewall_whitelist_rules();
+	QP_firewall_whitelist_rules(const QP_firewall_whitelist_rules&) = delete;
+	QP_firewall_whitelist_rules& operator=(const QP_firewall_whitelist_rules&) = delete;
+	bool allowed(int flagIN, uint64_t digest) const;
+	unsigned long long get_memory_usage() const;
+};
+
+/**
+ * @brief Compiled firewall whitelist, built once per 'Query_Processor::load_firewall()'.
+ * @details Holds the users modes and the whitelisted digests from the runtime resultsets of
+ *   'firewall_whitelist_users' and 'firewall_whitelist_rules'. Once built it is never modified, and it is
+ *   shared by the sessions taking a reference: the whitelist is freed when the last reference is released.
+ *   Sessions resolve their entries once through a 'QP_firewall_session_cache', and not for every query.
+ */
+class QP_firewall_whitelist {
+	private:
+	std::unordered_map<std::string, int> users;
+	std::unordered_map<std::string, QP_firewall_whitelist_rules*> rules;
+	unsigned long long users_memory;
+	unsigned long long rules_memory;
+	static std::string users_key(const char *username, const char *client_address);
+	static std::string rules_key(const char *username, const char *client_address, const char *schemaname);
+	public:
+	unsigned int version;
+	unsigned int refcnt;
+	/**
+	 * @brief Builds the whitelist from the runtime resultsets. Either resultset can be NULL.
+	 */
+	QP_firewall_whitelist(SQLite3_result *users_resultset, SQLite3_result *rules_resultset);
+	~QP_firewall_whitelist();
+	QP_firewall_whitelist(const QP_firewall_whitelist&) = delete;
+	QP_firewall_whitelist& operator=(const QP_firewall_whitelist&) = delete;
+	/**
+	 * @brief Returns the mode ('WUS_*') of the user, or 'WUS_NOT_FOUND'.
+	 */
+	int find_user(const char *username, const char *client_address) const;
+	/**
+	 * @brief Returns the whitelisted digests of the tuple, or NULL if there are none.
+	 */
+	const QP_firewall_whitelist_rules * find_rules(const char *username, const char *client_address, const char *schemaname) const;
+	void acquire() { __sync_fetch_and_add(&refcnt, 1); }
+	void release();
+	unsigned long long get_users_memory_usage() const { return users_memory; }
+	unsigned long long get_rules_memory_usage() const { return rules_memory; }
+};
+
+/**
+ * @brief Whitelist entries resolved for a session, embedded in the session.
+ * @details The user mode and the whitelisted digests depend only on username, client address and schema,
+ *   so they are resolved once and reused for all the queries of the session, until any of them changes or a
+ *   new whitelist is loaded. The cache holds a reference to the whitelist it was resolved against.
+ *   It is used only by the thread owning the session.
+ */
+class QP_firewall_session_cache {
+	public:
+	QP_firewall_whitelist *whitelist;
+	const QP_firewall_whitelist_rules *rules;
+	int mode;
+	// client address used in the rules lookup: either the client address or '', see 'resolve()'
+	const char *rules_client_address;
+	std::string username;
+	std::string client_address;
+	std::string schemaname;
+
+	QP_firewall_session_cache() : whitelist(NULL), rules(NULL), mode(0), rules_client_address("") {}
+	~QP_firewall_session_cache() { reset(); }
+	QP_firewall_session_cache(const QP_firewall_session_cache&) = delete;
+	QP_firewall_session_cache& operator=(const QP_firewall_session_cache&) = delete;
+	/**
+	 * @brief Returns true if the cache was resolved against whitelist version 'version' with the same
+	 *   username, client address and schema.
+	 */
+	bool valid(unsigned int version, const char *_username, const char *_client_address, const char *_schemaname) const {
+		return whitelist != NULL && whitelist->version == version && username == _username
+			&& client_address == _client_address && schemaname == _schemaname;
+	}
+	/**
+	 * @brief Resolves the entries from '_whitelist', already acquired by the caller and adopted by the cache.
+	 * @details Like for the per query lookup it replaces, the user is searched by client address first, and
+	 *   then with an empty client address. The rules are searched with the client address the user matched.
+	 */
+	void resolve(QP_firewall_whitelist *_whitelist, const char *_username, const char *_client_address, const char *_schemaname);
+	void reset();
+};
+
+#endif // CLASS_QP_FIREWALL_WHITELIST_H
@@ -0,0 +1,155 @@
+#ifndef __CLASS_TIMER_WHEEL_H
+#define __CLASS_TIMER_WHEEL_H
+
+#include <cstdint>
+
+/**
+ * @brief Entry of a 'Timer_Wheel', meant to be embedded in the object owning the deadline.
+ * @details Entries are linked in the slots of the wheel through an intrusive doubly linked list, so that
+ *   scheduling and canceling them doesn't require any allocation. An entry unlinks itself when destroyed.
+ */
+class Timer_Wheel_Entry {
+public:
+	Timer_Wheel_Entry* prev;
+	Timer_Wheel_Entry* next;
+	uint64_t deadline; // in ticks
+	void* data;        // object owning the entry
+
+	Timer_Wheel_Entry(void* _data = nullptr) : prev(nullptr), next(nullptr), deadline(0), data(_data) {}
+	~Timer_Wheel_Entry() { cancel(); }
+	Timer_Wheel_Entry(const Timer_Wheel_Entry&) = delete;
+	Timer_Wheel_Entry& operator=(const Timer_Wheel_Entry&) = delete;
+
+	bool scheduled() const { return next != nullptr; }
+	void cancel() {
+		if (next != nullptr) {
+			prev->next = next;
+			next->prev = prev;
+			prev = nullptr;
+			next = nullptr;
+		}
+	}
+};
+
+/**
+ * @brief Hierarchical timer wheel, with 'LEVELS' levels of 64 slots each.
+ * @details Entries are placed in the level matching the distance from their deadline, and moved to the lower
+ *   levels ('cascaded') as the time advances, so that scheduling, canceling and expiring an entry are O(1), and
+ *   advancing the wheel only visits the slots of the elapsed ticks. Deadlines further than 'MAX_DELAY' ticks
+ *   are clamped to it: the owner of the entry is expected to re-evaluate its deadline when the entry expires.
+ *
+ *   The wheel isn't thread safe, and it is meant to be used by the thread owning the entries.
+ */
+class Timer_Wheel {
+public:
+	static constexpr int SLOT_BITS = 6;
+	static constexpr int SLOTS = 1 << SLOT_BITS;
+	static constexpr int LEVELS = 4;
+	static constexpr uint64_t MAX_DELAY = (1ULL << (SLOT_BITS * LEVELS)) - 1;
+
+	Timer_Wheel() : _now(0), _started(false) {
+		for (int l = 0; l < LEVELS; l++) {
+			for (int s = 0; s < SLOTS; s++) {
+				_slots[l][s].prev = &_slots[l][s];
+				_slots[l][s].next = &_slots[l][s];
+			}
+		}
+	}
+	~Timer_Wheel() {
+		// the entries outlive the wheel, detach them from the slots
+		for (int l = 0; l < LEVELS; l++) {
+			for (int s = 0; s < SLOTS; s++) {
+				Timer_Wheel_Entry* head = &_slots[l][s];
+				while (head->next != head) {
+					head->next->cancel();
+				}
+				head->prev = nullptr;
+				head->next = nullptr;
+			}
+		}
+	}
+	Timer_Wheel(const Timer_Wheel&) = delete;
+	Timer_Wheel& operator=(const Timer_Wheel&) = delete;
+
+	uint64_t now() const { return _now; }
+	bool started() const { return _started; }
+
+	/**
+	 * @brief Schedules (or reschedules) 'e' to expire at tick 'deadline'.
+	 * @details Deadlines not in the future expire at the next tick. The wheel must have been started by
+	 *   'advance()' before scheduling entries.
+	 */
+	void schedule(Timer_Wheel_Entry* e, uint64_t deadline) {
+		e->cancel();
+		if (deadline <= _now) {
+			deadline = _now + 1;
+		} else if (deadline - _now > MAX_DELAY) {
+			deadline = _now + MAX_DELAY;
+		}
+		e->deadline = deadline;
+		link(e);
+	}
+
+	/**
+	 * @brief Advances the wheel up to tick 'now', calling 'expired(Timer_Wheel_Entry*)' for each expired entry.
+	 * @details Expired entries are unlinked before 'expired' is called, which is free to schedule them again, or
+	 *   to schedule and cancel other entries. The first call only sets the current tick.
+	 */
+	template <typename F>
+	void advance(uint64_t now, F&& expired) {
+		if (_started == false) {
+			_now = now;
+			_started = true;
+			return;
+		}
+		while (_now < now) {
+			_now++;
+			// higher levels first, an entry can be cascaded more than one level down in the same tick
+			for (int l = LEVELS - 1; l > 0; l--) {
+				if ((_now & ((1ULL << (SLOT_BITS * l)) - 1)) == 0) {
+					cascade(l, (_now >> (SLOT_BITS * l)) & (SLOTS - 1));
+				}
+			}
+			Timer_Wheel_Entry* head = &_slots[0][_now & (SLOTS - 1)];
+			while (head->next != head) {
+				Timer_Wheel_Entry* e = head->next;
+				e->cancel();
+				expired(e);
+			}
+		}
+	}
+
+private:
+	Timer_Wheel_Entry _slots[LEVELS][SLOTS];
+	uint64_t _now;
+	bool _started;
+
+	void link(Timer_Wheel_Entry* e) {
+		const uint64_t delta = e->deadline - _now;
+		int level = 0;
+		while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) {
+			level++;
+		}
+		Timer_Wheel_Entry* head = &_slots[level][(e->deadline >> (SLOT_BITS * level)) & (SLOTS - 1)];
+		e->prev = head->prev;
+		e->next = head;
+		head->prev->next = e;
+		head->prev = e;
+	}
+	void cascade(int level, uint64_t slot) {
+		Timer_Wheel_Entry* head = &_slots[level][slot];
+		if (head->next == head) return;
+		// detach the whole list first, the entries can be linked back into the same slot
+		Timer_Wheel_Entry* e = head->next;
+		head->prev->next = nullptr;
+		head->prev = head;
+		head->next = head;
+		while (e != nullptr) {
+			Timer_Wheel_Entry* next = e->next;
+			link(e);
+			e = next;
+		}
+	}
+};
+
+#endif /* __CLASS_TIMER_WHEEL_H */
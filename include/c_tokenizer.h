@@ -36,6 +36,15 @@ typedef struct _options {
 	int max_query_length;
 } options;
 
+/**
+ * @brief Implementations available for the vectorized pre-scan performed during digest computation.
+ */
+enum tokenizer_simd_level {
+	TOKENIZER_SIMD_NONE = 0,
+	TOKENIZER_SIMD_SSE42 = 1,
+	TOKENIZER_SIMD_AVX2 = 2,
+};
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +60,12 @@ char * mysql_query_digest_and_first_comment_one_it(char *s , int len , char **fi
 void c_split_2(const char *in, const char *del, char **out1, char **out2);
 char * query_strip_comments(char* s, int len, bool lowercase);
 char * query_digest_and_first_comment_2(const char* const q, int q_len, char** const fst_cmnt, char* const buf, const options* opts);
+/**
+ * @brief Selects the implementation used by the digest pre-scan. Digests are identical for all of them.
+ * @param level One of 'tokenizer_simd_level'. Negative or unsupported values select the best one available.
+ * @return The level in use after the call.
+ */
+int query_digest_set_simd_level(int level);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,448 @@
+#ifndef __EVENTSLOG_COLUMNAR_H
+#define __EVENTSLOG_COLUMNAR_H
+
+/**
+ * @file eventslog_columnar.h
+ * @brief Columnar format of the events log ('mysql-eventslog_format=3'), writer and reader.
+ * @details Header only, and depending only on the standard library and LZ4, so that it is shared by
+ *   'MySQL_Logger' and by the standalone reader in 'tools/'.
+ *
+ *   Layout of a file:
+ *   @code
+ *   file header  : "PXEVLOG3"
+ *   block        : "PXEB" | header_len (u32) | payload_len (u32) | header | payload
+ *     header     : rows (u32) | min_start_time (u64) | max_start_time (u64) | ncols (u16)
+ *                  ncols x ( name_len (u8) | name | type (u8) | raw_len (u32) | comp_len (u32) )
+ *     payload    : the LZ4 compressed columns, in the order of the header
+ *   ...
+ *   block index  : "PXEI" | nblocks (u32) | nblocks x ( offset (u64) | rows (u32) | min (u64) | max (u64) )
+ *   trailer      : index_offset (u64) | "PXEIEND0"
+ *   @endcode
+ *   All integers are little endian. Times are in microseconds since epoch. Columns are described by name and
+ *   type, readers ignore the columns they don't know. Before compression, integer columns are encoded as
+ *   the zigzag varint of the delta from the previous row, and string columns as varint length plus bytes.
+ *
+ *   The block index is written only when the file is closed: readers of files without it (still open, or
+ *   not closed cleanly) walk the block headers, skipping the payloads.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+
+#include "lz4.h"
+
+namespace eventslog_columnar {
+
+const char FILE_MAGIC[] = "PXEVLOG3";
+const char BLOCK_MAGIC[] = "PXEB";
+const char INDEX_MAGIC[] = "PXEI";
+const char TRAILER_MAGIC[] = "PXEIEND0";
+const size_t FILE_MAGIC_LEN = 8;
+const size_t TRAILER_LEN = 16;
+
+enum column_type : uint8_t {
+	COL_TYPE_INT = 1,
+	COL_TYPE_STR = 2,
+};
+
+/**
+ * @brief Columns written for every query event, named after the keys of the JSON format.
+ */
+enum column_id {
+	COL_EVENT,
+	COL_THREAD_ID,
+	COL_USERNAME,
+	COL_SCHEMANAME,
+	COL_CLIENT,
+	COL_HOSTGROUP_ID,
+	COL_SERVER,
+	COL_START_TIME,
+	COL_END_TIME,
+	COL_CLIENT_STMT_ID,
+	COL_ROWS_AFFECTED,
+	COL_LAST_INSERT_ID,
+	COL_ROWS_SENT,
+	COL_DIGEST,
+	COL_QUERY,
+	COL_FLAGS,
+	COL_LAST_GTID,
+	COL__END,
+};
+
+// bits of 'COL_FLAGS', the optional fields present in the row
+enum row_flags {
+	ROW_HAVE_ROWS_AFFECTED = 1,
+	ROW_HAVE_ROWS_SENT = 2,
+	ROW_HAVE_GTID = 4,
+	ROW_HAVE_SERVER = 8,
+};
+
+struct column_def_t {
+	const char *name;
+	column_type type;
+};
+
+const column_def_t columns_defs[COL__END] = {
+	{ "event", COL_TYPE_INT },
+	{ "thread_id", COL_TYPE_INT },
+	{ "username", COL_TYPE_STR },
+	{ "schemaname", COL_TYPE_STR },
+	{ "client", COL_TYPE_STR },
+	{ "hostgroup_id", COL_TYPE_INT },
+	{ "server", COL_TYPE_STR },
+	{ "starttime_timestamp_us", COL_TYPE_INT },
+	{ "endtime_timestamp_us", COL_TYPE_INT },
+	{ "client_stmt_id", COL_TYPE_INT },
+	{ "rows_affected", COL_TYPE_INT },
+	{ "last_insert_id", COL_TYPE_INT },
+	{ "rows_sent", COL_TYPE_INT },
+	{ "digest", COL_TYPE_INT },
+	{ "query", COL_TYPE_STR },
+	{ "flags", COL_TYPE_INT },
+	{ "last_gtid", COL_TYPE_STR },
+};
+
+inline void put_u8(std::string& s, uint8_t v) { s.push_back((char)v); }
+inline void put_u16(std::string& s, uint16_t v) { for (int i = 0; i < 2; i++) s.push_back((char)(v >> (8 * i))); }
+inline void put_u32(std::string& s, uint32_t v) { for (int i = 0; i < 4; i++) s.push_back((char)(v >> (8 * i))); }
+inline void put_u64(std::string& s, uint64_t v) { for (int i = 0; i < 8; i++) s.push_back((char)(v >> (8 * i))); }
+
+inline uint64_t get_le(const unsigned char *p, int len) {
+	uint64_t v = 0;
+	for (int i = 0; i < len; i++) {
+		v |= (uint64_t)p[i] << (8 * i);
+	}
+	return v;
+}
+
+inline void put_varint(std::string& s, uint64_t v) {
+	while (v >= 0x80) {
+		s.push_back((char)(v | 0x80));
+		v >>= 7;
+	}
+	s.push_back((char)v);
+}
+
+inline bool get_varint(const unsigned char *& p, const unsigned char *end, uint64_t& v) {
+	v = 0;
+	for (int shift = 0; shift < 64 && p < end; shift += 7) {
+		const unsigned char c = *p++;
+		v |= (uint64_t)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline uint64_t zigzag(uint64_t delta) { return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63); }
+inline uint64_t unzigzag(uint64_t v) { return (v >> 1) ^ (~(v & 1) + 1); }
+
+struct block_info_t {
+	uint64_t offset;
+	uint32_t rows;
+	uint64_t min_start_time;
+	uint64_t max_start_time;
+};
+
+/**
+ * @brief Builds the blocks of a file, one row at a time.
+ * @details A row is added calling 'put_int()' / 'put_str()' once for every column in 'column_id' order, and
+ *   then 'end_row()'. The writer doesn't do any I/O: the caller writes 'file_header()', the blocks returned
+ *   by 'flush_block()', and 'index()' when closing the file. It isn't thread safe.
+ */
+class Writer {
+	std::vector<std::string> cols;
+	std::vector<uint64_t> prev;
+	std::vector<block_info_t> blocks;
+	size_t raw_bytes;
+	uint32_t nrows;
+	uint64_t min_start_time;
+	uint64_t max_start_time;
+	public:
+	static const uint32_t MAX_BLOCK_ROWS = 8192;
+	static const size_t MAX_BLOCK_BYTES = 4*1024*1024;
+
+	Writer() : cols(COL__END), prev(COL__END, 0), raw_bytes(0), nrows(0), min_start_time(0), max_start_time(0) {}
+	static std::string file_header() { return std::string(FILE_MAGIC, FILE_MAGIC_LEN); }
+
+	void put_int(column_id c, uint64_t v) {
+		const size_t l = cols[c].size();
+		put_varint(cols[c], zigzag(v - prev[c]));
+		raw_bytes += cols[c].size() - l;
+		prev[c] = v;
+		if (c == COL_START_TIME) {
+			if (nrows == 0 || v < min_start_time) min_start_time = v;
+			if (nrows == 0 || v > max_start_time) max_start_time = v;
+		}
+	}
+	void put_str(column_id c, const char *s, size_t len) {
+		const size_t l = cols[c].size();
+		put_varint(cols[c], len);
+		cols[c].append(s, len);
+		raw_bytes += cols[c].size() - l;
+	}
+	void end_row() { nrows++; }
+	uint32_t rows() const { return nrows; }
+	uint64_t get_min_start_time() const { return min_start_time; }
+	bool full() const { return nrows >= MAX_BLOCK_ROWS || raw_bytes >= MAX_BLOCK_BYTES; }
+
+	/**
+	 * @brief Returns the serialized block of the rows added so far, to be written at 'offset' of the file,
+	 *   and starts a new block. Returns an empty string if there are no rows.
+	 */
+	std::string flush_block(uint64_t offset) {
+		if (nrows == 0) {
+			return std::string {};
+		}
+		std::string header {};
+		std::string payload {};
+		put_u32(header, nrows);
+		put_u64(header, min_start_time);
+		put_u64(header, max_start_time);
+		put_u16(header, COL__END);
+		std::vector<char> cbuf {};
+		for (int c = 0; c < COL__END; c++) {
+			const std::string& raw = cols[c];
+			cbuf.resize(LZ4_compressBound(raw.size()));
+			const int clen = raw.size() ? LZ4_compress_default(raw.data(), cbuf.data(), raw.size(), cbuf.size()) : 0;
+			const size_t nlen = strlen(columns_defs[c].name);
+			put_u8(header, nlen);
+			header.append(columns_defs[c].name, nlen);
+			put_u8(header, columns_defs[c].type);
+			put_u32(header, raw.size());
+			put_u32(header, clen);
+			payload.append(cbuf.data(), clen);
+		}
+		std::string blk { BLOCK_MAGIC, 4 };
+		put_u32(blk, header.size());
+		put_u32(blk, payload.size());
+		blk += header;
+		blk += payload;
+		blocks.push_back({ offset, nrows, min_start_time, max_start_time });
+		for (int c = 0; c < COL__END; c++) {
+			cols[c].clear();
+			prev[c] = 0;
+		}
+		raw_bytes = 0;
+		nrows = 0;
+		return blk;
+	}
+
+	/**
+	 * @brief Returns the block index and the trailer, to be written at 'offset', at the end of the file.
+	 */
+	std::string index(uint64_t offset) const {
+		std::string idx { INDEX_MAGIC, 4 };
+		put_u32(idx, blocks.size());
+		for (const block_info_t& b : blocks) {
+			put_u64(idx, b.offset);
+			put_u32(idx, b.rows);
+			put_u64(idx, b.min_start_time);
+			put_u64(idx, b.max_start_time);
+		}
+		put_u64(idx, offset);
+		idx.append(TRAILER_MAGIC, 8);
+		return idx;
+	}
+};
+
+/**
+ * @brief Decoded column of a block.
+ */
+struct column_data_t {
+	column_type type;
+	std::vector<uint64_t> ints;
+	std::vector<std::string> strs;
+};
+
+/**
+ * @brief A block read from a file. Columns are decompressed only when requested through 'column()'.
+ */
+class Block {
+	struct column_desc_t {
+		std::string name;
+		column_type type;
+		uint32_t raw_len;
+		uint32_t comp_len;
+		size_t payload_offset;
+	};
+	std::vector<column_desc_t> descs;
+	std::string payload;
+	public:
+	block_info_t info;
+
+	/**
+	 * @brief Parses the block header 'hdr', 'payload' holding the compressed columns.
+	 */
+	bool parse(const std::string& hdr, std::string&& _payload) {
+		const unsigned char *p = (const unsigned char *)hdr.data();
+		const unsigned char *end = p + hdr.size();
+		if (hdr.size() < 22) return false;
+		info.rows = get_le(p, 4);
+		info.min_start_time = get_le(p + 4, 8);
+		info.max_start_time = get_le(p + 12, 8);
+		const uint16_t ncols = get_le(p + 20, 2);
+		p += 22;
+		payload = std::move(_payload);
+		descs.clear();
+		size_t off = 0;
+		for (uint16_t i = 0; i < ncols; i++) {
+			if (p >= end || p + 1 + *p + 9 > end) return false;
+			column_desc_t d {};
+			d.name.assign((const char *)p + 1, *p);
+			p += 1 + *p;
+			d.type = (column_type)*p;
+			d.raw_len = get_le(p + 1, 4);
+			d.comp_len = get_le(p + 5, 4);
+			p += 9;
+			d.payload_offset = off;
+			off += d.comp_len;
+			descs.push_back(d);
+		}
+		return off <= payload.size();
+	}
+
+	/**
+	 * @brief Decompresses and decodes the column 'name' into 'out'.
+	 * @return False if the block doesn't have the column, or if the column is malformed.
+	 */
+	bool column(const char *name, column_data_t& out) const {
+		for (const column_desc_t& d : descs) {
+			if (d.name != name) {
+				continue;
+			}
+			std::string raw(d.raw_len, '\0');
+			if (d.raw_len) {
+				const int rc = LZ4_decompress_safe(payload.data() + d.payload_offset, &raw[0], d.comp_len, d.raw_len);
+				if (rc != (int)d.raw_len) return false;
+			}
+			out.type = d.type;
+			out.ints.clear();
+			out.strs.clear();
+			const unsigned char *p = (const unsigned char *)raw.data();
+			const unsigned char *end = p + raw.size();
+			uint64_t prev = 0;
+			for (uint32_t r = 0; r < info.rows; r++) {
+				uint64_t v = 0;
+				if (get_varint(p, end, v) == false) return false;
+				if (d.type == COL_TYPE_INT) {
+					prev += unzigzag(v);
+					out.ints.push_back(prev);
+				} else if (d.type == COL_TYPE_STR) {
+					if (v > (uint64_t)(end - p)) return false;
+					out.strs.emplace_back((const char *)p, v);
+					p += v;
+				} else {
+					return false;
+				}
+			}
+			return true;
+		}
+		return false;
+	}
+};
+
+/**
+ * @brief Reads the blocks of a file, using the block index when present.
+ */
+class Reader {
+	FILE *f;
+	std::vector<block_info_t> blocks;
+	bool read_at(uint64_t offset, void *buf, size_t len) {
+		return fseeko(f, offset, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+	}
+	bool load_index(uint64_t file_size) {
+		unsigned char trailer[TRAILER_LEN];
+		if (file_size < FILE_MAGIC_LEN + TRAILER_LEN || read_at(file_size - TRAILER_LEN, trailer, TRAILER_LEN) == false) {
+			return false;
+		}
+		if (memcmp(trailer + 8, TRAILER_MAGIC, 8) != 0) {
+			return false;
+		}
+		const uint64_t idx_offset = get_le(trailer, 8);
+		unsigned char hdr[8];
+		if (idx_offset + 8 > file_size || read_at(idx_offset, hdr, 8) == false || memcmp(hdr, INDEX_MAGIC, 4) != 0) {
+			return false;
+		}
+		const uint32_t n = get_le(hdr + 4, 4);
+		if (idx_offset + 8 + (uint64_t)n * 28 + TRAILER_LEN != file_size) {
+			return false;
+		}
+		std::string buf((size_t)n * 28, '\0');
+		if (n && fread(&buf[0], 1, buf.size(), f) != buf.size()) {
+			return false;
+		}
+		const unsigned char *p = (const unsigned char *)buf.data();
+		for (uint32_t i = 0; i < n; i++, p += 28) {
+			blocks.push_back({ get_le(p, 8), (uint32_t)get_le(p + 8, 4), get_le(p + 12, 8), get_le(p + 20, 8) });
+		}
+		return true;
+	}
+	void scan_blocks(uint64_t file_size) {
+		uint64_t offset = FILE_MAGIC_LEN;
+		unsigned char hdr[12 + 20];
+		while (offset + sizeof(hdr) <= file_size && read_at(offset, hdr, sizeof(hdr)) && memcmp(hdr, BLOCK_MAGIC, 4) == 0) {
+			const uint64_t hlen = get_le(hdr + 4, 4);
+			const uint64_t plen = get_le(hdr + 8, 4);
+			if (offset + 12 + hlen + plen > file_size) {
+				break; // last block partially written
+			}
+			blocks.push_back({ offset, (uint32_t)get_le(hdr + 12, 4), get_le(hdr + 16, 8), get_le(hdr + 24, 8) });
+			offset += 12 + hlen + plen;
+		}
+	}
+	public:
+	bool indexed;
+	Reader() : f(NULL), indexed(false) {}
+	~Reader() { if (f) fclose(f); }
+	Reader(const Reader&) = delete;
+	Reader& operator=(const Reader&) = delete;
+
+	bool open(const char *path, std::string& err) {
+		f = fopen(path, "rb");
+		if (f == NULL) {
+			err = std::string("unable to open ") + path + ": " + strerror(errno);
+			return false;
+		}
+		char magic[FILE_MAGIC_LEN];
+		if (fread(magic, 1, FILE_MAGIC_LEN, f) != FILE_MAGIC_LEN || memcmp(magic, FILE_MAGIC, FILE_MAGIC_LEN) != 0) {
+			err = std::string(path) + " is not a columnar events log";
+			return false;
+		}
+		fseeko(f, 0, SEEK_END);
+		const uint64_t file_size = ftello(f);
+		indexed = load_index(file_size);
+		if (indexed == false) {
+			blocks.clear();
+			scan_blocks(file_size);
+		}
+		return true;
+	}
+	const std::vector<block_info_t>& get_blocks() const { return blocks; }
+
+	/**
+	 * @brief Reads the block at 'info.offset', without decompressing any column.
+	 */
+	bool read_block(const block_info_t& info, Block& blk) {
+		unsigned char hdr[12];
+		if (read_at(info.offset, hdr, 12) == false || memcmp(hdr, BLOCK_MAGIC, 4) != 0) {
+			return false;
+		}
+		std::string header(get_le(hdr + 4, 4), '\0');
+		std::string payload(get_le(hdr + 8, 4), '\0');
+		if (fread(&header[0], 1, header.size(), f) != header.size() || fread(&payload[0], 1, payload.size(), f) != payload.size()) {
+			return false;
+		}
+		blk.info.offset = info.offset;
+		return blk.parse(header, std::move(payload));
+	}
+};
+
+} // namespace eventslog_columnar
+
+#endif // __EVENTSLOG_COLUMNAR_H
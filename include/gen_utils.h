@@ -314,6 +314,40 @@ inline unsigned long long realtime_time() {
   return (((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
 }
 
+extern bool ticks_use_tsc;
+extern double ticks_ns_per_tick;
+
+/**
+ * @brief Cheap timestamp, in ticks, meant for fine grained latency measurements. See 'ticks_to_ns()'.
+ * @details Reads the TSC when 'ticks_calibrate()' found it to be invariant, otherwise falls back to
+ *   'CLOCK_MONOTONIC', in nanoseconds. Ticks are only meaningful as differences within the same process.
+ */
+inline unsigned long long ticks_time() {
+#if defined(__x86_64__) || defined(__i386__)
+	if (ticks_use_tsc) {
+		return __builtin_ia32_rdtsc();
+	}
+#endif
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((unsigned long long) ts.tv_sec) * 1000000000) + ts.tv_nsec;
+}
+
+inline unsigned long long ticks_to_ns(unsigned long long ticks) {
+	return ticks * ticks_ns_per_tick;
+}
+
+/**
+ * @brief Detects if the TSC can be used by 'ticks_time()' and measures its frequency. Only the first call has
+ *   effect, and it takes a couple of milliseconds.
+ */
+void ticks_calibrate();
+
+/**
+ * @brief Returns the cost of a single 'ticks_time()' call in nanoseconds, as measured by 'ticks_calibrate()'.
+ */
+unsigned long long ticks_overhead_ns();
+
 template<int FACTOR, typename T>
 inline T overflow_safe_multiply(T val) {
 	static_assert(std::is_integral<T>::value, "T must be an integer type.");
@@ -115,6 +115,7 @@ class MySQL_Connection {
 	char scramble_buff[40];
 	unsigned long long creation_time;
 	unsigned long long last_time_used;
+	unsigned long long backend_query_start; // non-zero while the query is counted in 'parent->queries_in_flight'
 	unsigned long long timeout;
 	int auto_increment_delay_token;
 	int fd;
@@ -167,6 +168,17 @@ class MySQL_Connection {
 	bool multiplex_delayed;
 	bool unknown_transaction_status;
 	void compute_unknown_transaction_status();
+	/**
+	 * @brief Accounts a query sent to the backend in 'parent->queries_in_flight'.
+	 * @details Only for hostgroups with 'load_balancing_algorithm=1'. No-op if the current query is already
+	 *  accounted, e.g. when it is retried.
+	 */
+	void backend_query_started();
+	/**
+	 * @brief Removes the query from 'parent->queries_in_flight' and updates 'parent->query_latency_ewma_us'.
+	 * @details No-op if 'backend_query_started()' didn't account the query.
+	 */
+	void backend_query_ended();
 	char gtid_uuid[128];
 
 	MySQLServers_SslParams * ssl_params = NULL;
@@ -4,8 +4,15 @@
 #include <string.h>
 #include <netinet/in.h>
 #include <string>
+#include <vector>
 #include <arpa/inet.h>
 
+// signature of the binary PROXY protocol header (v2)
+#define PROXY_PROTOCOL_V2_SIG "\r\n\r\n\0\r\nQUIT\n"
+#define PROXY_PROTOCOL_V2_SIG_LEN 12
+// signature, version/command, family/transport and length of the address block
+#define PROXY_PROTOCOL_V2_HDR_LEN 16
+
 
 class ProxyProtocolInfo {
 public:
@@ -15,6 +22,7 @@ public:
 	uint16_t source_port;
 	uint16_t destination_port;
 	uint16_t proxy_port;
+	uint8_t version; // version of the parsed header, 1 (text) or 2 (binary)
 
 	// Constructor (initializes to zeros)
 	ProxyProtocolInfo() {
@@ -28,6 +36,18 @@ public:
 
 	// Function to parse the PROXY protocol header (declared)
 	bool parseProxyProtocolHeader(const char* packet, size_t packet_length);
+	/**
+	 * @brief Parses a binary PROXY protocol header (v2), skipping the TLVs following the addresses.
+	 * @details A 'LOCAL' command (e.g. health checks from the proxy itself) is valid, but carries no address:
+	 *   'source_address' is left empty, and the connection should keep its own.
+	 * @return True if the header is valid, false otherwise.
+	 */
+	bool parseProxyProtocolV2Header(const unsigned char* packet, size_t packet_length);
+	/**
+	 * @brief Returns the total length of the binary PROXY protocol header (v2) starting at 'packet', or 0 if
+	 *   'packet' doesn't start with the v2 signature. At least 'PROXY_PROTOCOL_V2_HDR_LEN' bytes are required.
+	 */
+	static size_t getProxyProtocolV2HeaderLength(const unsigned char* packet, size_t packet_length);
 
 	bool is_in_network(const struct sockaddr* client_addr, const std::string& subnet_mask);
 	bool is_client_in_any_subnet(const struct sockaddr* client_addr, const char* subnet_list);
@@ -48,4 +68,30 @@ public:
 	bool is_valid_subnet(const char* subnet);
 };
 
+/**
+ * @brief Set of networks, compiled from a list of subnets in CIDR notation (e.g.
+ *   'mysql-proxy_protocol_networks') into sorted and merged address ranges.
+ * @details Matching an address is a binary search over the ranges of its family, without any parsing or
+ *   allocation. As for 'ProxyProtocolInfo::is_client_in_any_subnet()', IPv4 addresses only match IPv4 subnets,
+ *   and IPv6 addresses only match IPv6 subnets.
+ */
+class ProxyProtocol_Networks {
+public:
+	ProxyProtocol_Networks() : match_all(false) {}
+	/**
+	 * @brief Replaces the networks with the ones in 'subnet_list': a comma separated list of subnets, or '*'
+	 *   for all the networks. Invalid subnets are ignored.
+	 * @return False if any of the subnets is invalid.
+	 */
+	bool compile(const char* subnet_list);
+	bool match(const struct sockaddr* addr) const;
+	bool empty() const { return match_all == false && ranges_v4.empty() && ranges_v6.empty(); }
+
+private:
+	typedef unsigned __int128 uint128_t;
+	bool match_all;
+	std::vector<std::pair<uint32_t, uint32_t>> ranges_v4;
+	std::vector<std::pair<uint128_t, uint128_t>> ranges_v6;
+};
+
 #endif // PROXY_PROTOCOL_INFO_H
@@ -14,6 +14,7 @@
 #include <array>
 
 #include "ProxySQL_RESTAPI_Server.hpp"
+#include "ProxySQL_Snapshot.hpp"
 
 #include "proxysql_typedefs.h"
 
@@ -290,6 +291,7 @@ class ProxySQL_Admin {
 		bool admin_read_only;
 //		bool hash_passwords;
 		bool vacuum_stats;
+		bool runtime_snapshot;
 		char * admin_version;
 		char * cluster_username;
 		char * cluster_password;
@@ -303,6 +305,9 @@ class ProxySQL_Admin {
 		int cluster_admin_variables_diffs_before_sync;
 		int cluster_ldap_variables_diffs_before_sync;
 		int cluster_mysql_servers_sync_algorithm;
+		int cluster_changelog_max_rows;
+		bool cluster_push_notifications;
+		int cluster_push_fanout;
 		bool cluster_mysql_query_rules_save_to_disk;
 		bool cluster_mysql_servers_save_to_disk;
 		bool cluster_mysql_users_save_to_disk;
@@ -316,6 +321,7 @@ class ProxySQL_Admin {
 		int stats_mysql_query_digest_to_disk;
 		int stats_system_cpu;
 		int stats_system_memory;
+		bool stats_history_timeseries;
 		int mysql_show_processlist_extended;
 		int pgsql_show_processlist_extended;
 		bool restapi_enabled;
@@ -400,6 +406,19 @@ class ProxySQL_Admin {
 	void __refresh_users(std::unique_ptr<SQLite3_result>&& all_users = nullptr, const std::string& checksum = "", const time_t epoch = 0);
 	void __add_active_users_ldap();
 
+	// Sections read from the runtime snapshot at startup, see 'load_mysql_users_from_snapshot()'
+	std::vector<ProxySQL_Snapshot::section_t> snapshot_sections;
+	// Names of the sections loaded to runtime from the snapshot, pending validation
+	std::vector<std::string> snapshot_loaded;
+	bool snapshot_read;
+	std::string get_snapshot_path();
+	/**
+	 * @brief Returns the section 'name' of the runtime snapshot, reading the snapshot on first use.
+	 * @details Only at startup, with 'admin-runtime_snapshot' enabled and without '--initial' or '--reload'.
+	 * @return The section, or 'nullptr' if not present, or if the snapshot can't be used.
+	 */
+	ProxySQL_Snapshot::section_t* get_snapshot_section(const std::string& name);
+
 	void flush_mysql_variables___runtime_to_database(SQLite3DB *db, bool replace, bool del, bool onlyifempty, bool runtime=false, bool use_lock=true);
 	void flush_mysql_variables___database_to_runtime(SQLite3DB *db, bool replace, const std::string& checksum = "", const time_t epoch = 0);
 
@@ -528,6 +547,33 @@ class ProxySQL_Admin {
 	void init_mysql_query_rules();
 	void init_mysql_firewall();
 	void init_proxysql_servers();
+	/**
+	 * @brief Writes the runtime snapshot ('proxysql_runtime.snapshot' in the datadir) if
+	 *   'admin-runtime_snapshot' is enabled. Called on 'SAVE MYSQL USERS|QUERY RULES TO DISK' and at shutdown.
+	 * @details The snapshot holds the runtime resultsets of 'mysql_users', 'mysql_query_rules' and
+	 *   'mysql_query_rules_fast_routing', with their checksums and epochs. See 'ProxySQL_Snapshot'.
+	 */
+	void save_runtime_snapshot();
+	/**
+	 * @brief Loads the MySQL users to runtime from the runtime snapshot, replacing 'init_users()' at startup.
+	 * @details The resultset is loaded only if its checksum matches the one stored in the snapshot. Not used
+	 *   when LDAP authentication is enabled, as LDAP mappings are part of the users checksum.
+	 * @return 'true' if the users were loaded, 'false' if 'init_users()' is required.
+	 */
+	bool load_mysql_users_from_snapshot();
+	/**
+	 * @brief Loads the MySQL query rules to runtime from the runtime snapshot, replacing
+	 *   'init_mysql_query_rules()' at startup.
+	 * @return 'true' if the query rules were loaded, 'false' if 'init_mysql_query_rules()' is required.
+	 */
+	bool load_mysql_query_rules_from_snapshot();
+	/**
+	 * @brief Validates the modules loaded from the runtime snapshot against the Admin database, once
+	 *   ProxySQL is accepting traffic, reloading them from the database in case of mismatch.
+	 * @details The checksums of the resultsets that 'LOAD ... TO RUNTIME' would use are compared with the
+	 *   runtime checksums. Releases the remaining snapshot sections.
+	 */
+	void validate_runtime_snapshot();
 	void save_mysql_users_runtime_to_database(bool _runtime);
 	/**
 	 * @brief Save the current MySQL servers reported by 'MySQL_HostGroups_Manager', scanning the
@@ -643,6 +689,7 @@ class ProxySQL_Admin {
 	int stats___pgsql_query_digests_v2(bool reset, bool copy, bool use_resultset);
 	//void stats___mysql_query_digests_reset();
 	void stats___mysql_commands_counters();
+	void stats___mysql_query_stages();
 	void stats___mysql_processlist();
 	void stats___mysql_free_connections();
 	void stats___mysql_connection_pool(bool _reset);
@@ -1008,6 +1008,7 @@ __thread int pgsql_thread___client_host_error_counts;
 __thread int pgsql_thread___connect_retries_on_failure;
 __thread int pgsql_thread___connect_retries_delay;
 __thread bool pgsql_thread___multiplexing;
+__thread bool pgsql_thread___bulk_data_rows;
 __thread int pgsql_thread___connection_delay_multiplex_ms;
 __thread int pgsql_thread___connection_max_age_ms;
 __thread int pgsql_thread___connect_timeout_client;
@@ -1067,10 +1068,12 @@ __thread bool pgsql_thread___query_digests_replace_null;
 __thread bool pgsql_thread___query_digests_normalize_digest_text;
 __thread bool pgsql_thread___query_digests_track_hostname;
 __thread bool pgsql_thread___query_digests_keep_comment;
+__thread bool pgsql_thread___query_digests_stop_at_max_digest_length;
 __thread int  pgsql_thread___query_digests_max_digest_length;
 __thread int  pgsql_thread___query_digests_max_query_length;
 __thread int  pgsql_thread___query_digests_grouping_limit;
 __thread int  pgsql_thread___query_digests_groups_grouping_limit;
+__thread int  pgsql_thread___query_digests_cache_size;
 
 __thread bool pgsql_thread___enable_load_data_local_infile;
 __thread char* pgsql_thread___auditlog_filename;
@@ -1163,6 +1166,9 @@ __thread int mysql_thread___reset_connection_algorithm;
 __thread uint32_t mysql_thread___server_capabilities;
 __thread int mysql_thread___auto_increment_delay_multiplex;
 __thread int mysql_thread___auto_increment_delay_multiplex_timeout_ms;
+__thread bool mysql_thread___multiplex_affinity_learning;
+__thread int mysql_thread___multiplex_affinity_min_samples;
+__thread int mysql_thread___concurrency_limit_queue_timeout_ms;
 __thread int mysql_thread___handle_unknown_charset;
 __thread int mysql_thread___poll_timeout;
 __thread int mysql_thread___poll_timeout_on_failure;
@@ -1185,8 +1191,10 @@ __thread bool mysql_thread___query_digests_no_digits;
 __thread bool mysql_thread___query_digests_normalize_digest_text;
 __thread bool mysql_thread___query_digests_track_hostname;
 __thread bool mysql_thread___query_digests_keep_comment;
+__thread bool mysql_thread___query_digests_stop_at_max_digest_length;
 __thread int mysql_thread___query_digests_max_digest_length;
 __thread int mysql_thread___query_digests_max_query_length;
+__thread int mysql_thread___query_digests_histograms_max;
 __thread bool mysql_thread___parse_failure_logs_digest;
 __thread int mysql_thread___show_processlist_extended;
 __thread int mysql_thread___session_idle_ms;
@@ -1194,15 +1202,20 @@ __thread int mysql_thread___hostgroup_manager_verbose;
 __thread bool mysql_thread___default_reconnect;
 __thread bool mysql_thread___session_idle_show_processlist;
 __thread bool mysql_thread___sessions_sort;
+__thread bool mysql_thread___sessions_ready_list;
 __thread bool mysql_thread___kill_backend_connection_when_disconnect;
 __thread bool mysql_thread___client_session_track_gtid;
+__thread bool mysql_thread___gtid_read_your_writes;
+__thread int mysql_thread___gtid_read_your_writes_timeout_ms;
 __thread char * mysql_thread___default_variables[SQL_NAME_LAST_LOW_WM];
 __thread int mysql_thread___query_digests_grouping_limit;
 __thread int mysql_thread___query_digests_groups_grouping_limit;
+__thread int mysql_thread___query_digests_cache_size;
 __thread bool mysql_thread___enable_client_deprecate_eof;
 __thread bool mysql_thread___enable_server_deprecate_eof;
 __thread bool mysql_thread___log_mysql_warnings_enabled;
 __thread bool mysql_thread___enable_load_data_local_infile;
+__thread bool mysql_thread___use_writev;
 __thread int mysql_thread___client_host_cache_size;
 __thread int mysql_thread___client_host_error_counts;
 __thread int mysql_thread___handle_warnings;
@@ -1212,6 +1225,7 @@ __thread int mysql_thread___evaluate_replication_lag_on_servers_load;
 __thread int mysql_thread___query_cache_size_MB;
 __thread int mysql_thread___query_cache_soft_ttl_pct;
 __thread int mysql_thread___query_cache_handle_warnings;
+__thread bool mysql_thread___query_cache_table_invalidation;
 
 /* variables used for SSL , from proxy to server (p2s) */
 __thread char * mysql_thread___ssl_p2s_ca;
@@ -1227,6 +1241,9 @@ __thread char * mysql_thread___eventslog_filename;
 __thread int mysql_thread___eventslog_filesize;
 __thread int mysql_thread___eventslog_default_log;
 __thread int mysql_thread___eventslog_format;
+__thread int mysql_thread___eventslog_sample_rate;
+__thread int mysql_thread___eventslog_slow_query_threshold;
+__thread int mysql_thread___eventslog_digest_rate_limit;
 
 /* variables used by audit log */
 __thread char * mysql_thread___auditlog_filename;
@@ -1307,6 +1324,7 @@ extern __thread int pgsql_thread___client_host_error_counts;
 extern __thread int pgsql_thread___connect_retries_on_failure;
 extern __thread int pgsql_thread___connect_retries_delay;
 extern __thread bool pgsql_thread___multiplexing;
+extern __thread bool pgsql_thread___bulk_data_rows;
 extern __thread int pgsql_thread___connection_delay_multiplex_ms;
 extern __thread int pgsql_thread___connection_max_age_ms;
 extern __thread int pgsql_thread___connect_timeout_client;
@@ -1364,10 +1382,12 @@ extern __thread bool pgsql_thread___query_digests_replace_null;
 extern __thread bool pgsql_thread___query_digests_normalize_digest_text;
 extern __thread bool pgsql_thread___query_digests_track_hostname;
 extern __thread bool pgsql_thread___query_digests_keep_comment;
+extern __thread bool pgsql_thread___query_digests_stop_at_max_digest_length;
 extern __thread int  pgsql_thread___query_digests_max_digest_length;
 extern __thread int  pgsql_thread___query_digests_max_query_length;
 extern __thread int  pgsql_thread___query_digests_grouping_limit;
 extern __thread int  pgsql_thread___query_digests_groups_grouping_limit;
+extern __thread int  pgsql_thread___query_digests_cache_size;
 
 extern __thread bool pgsql_thread___enable_load_data_local_infile;
 extern __thread char* pgsql_thread___auditlog_filename;
@@ -1460,6 +1480,9 @@ extern __thread int mysql_thread___reset_connection_algorithm;
 extern __thread uint32_t mysql_thread___server_capabilities;
 extern __thread int mysql_thread___auto_increment_delay_multiplex;
 extern __thread int mysql_thread___auto_increment_delay_multiplex_timeout_ms;
+extern __thread bool mysql_thread___multiplex_affinity_learning;
+extern __thread int mysql_thread___multiplex_affinity_min_samples;
+extern __thread int mysql_thread___concurrency_limit_queue_timeout_ms;
 extern __thread int mysql_thread___handle_unknown_charset;
 extern __thread int mysql_thread___poll_timeout;
 extern __thread int mysql_thread___poll_timeout_on_failure;
@@ -1482,8 +1505,10 @@ extern __thread bool mysql_thread___query_digests_replace_null;
 extern __thread bool mysql_thread___query_digests_normalize_digest_text;
 extern __thread bool mysql_thread___query_digests_track_hostname;
 extern __thread bool mysql_thread___query_digests_keep_comment;
+extern __thread bool mysql_thread___query_digests_stop_at_max_digest_length;
 extern __thread int mysql_thread___query_digests_max_digest_length;
 extern __thread int mysql_thread___query_digests_max_query_length;
+extern __thread int mysql_thread___query_digests_histograms_max;
 extern __thread bool mysql_thread___parse_failure_logs_digest;
 extern __thread int mysql_thread___show_processlist_extended;
 extern __thread int mysql_thread___session_idle_ms;
@@ -1491,15 +1516,20 @@ extern __thread int mysql_thread___hostgroup_manager_verbose;
 extern __thread bool mysql_thread___default_reconnect;
 extern __thread bool mysql_thread___session_idle_show_processlist;
 extern __thread bool mysql_thread___sessions_sort;
+extern __thread bool mysql_thread___sessions_ready_list;
 extern __thread bool mysql_thread___kill_backend_connection_when_disconnect;
 extern __thread bool mysql_thread___client_session_track_gtid;
+extern __thread bool mysql_thread___gtid_read_your_writes;
+extern __thread int mysql_thread___gtid_read_your_writes_timeout_ms;
 extern __thread char * mysql_thread___default_variables[SQL_NAME_LAST_LOW_WM];
 extern __thread int mysql_thread___query_digests_grouping_limit;
 extern __thread int mysql_thread___query_digests_groups_grouping_limit;
+extern __thread int mysql_thread___query_digests_cache_size;
 extern __thread bool mysql_thread___enable_client_deprecate_eof;
 extern __thread bool mysql_thread___enable_server_deprecate_eof;
 extern __thread bool mysql_thread___log_mysql_warnings_enabled;
 extern __thread bool mysql_thread___enable_load_data_local_infile;
+extern __thread bool mysql_thread___use_writev;
 extern __thread int mysql_thread___client_host_cache_size;
 extern __thread int mysql_thread___client_host_error_counts;
 extern __thread int mysql_thread___handle_warnings;
@@ -1509,6 +1539,7 @@ extern __thread int mysql_thread___evaluate_replication_lag_on_servers_load;
 extern __thread int mysql_thread___query_cache_size_MB;
 extern __thread int mysql_thread___query_cache_soft_ttl_pct;
 extern __thread int mysql_thread___query_cache_handle_warnings;
+extern __thread bool mysql_thread___query_cache_table_invalidation;
 
 /* variables used for SSL , from proxy to server (p2s) */
 extern __thread char * mysql_thread___ssl_p2s_ca;
@@ -1524,6 +1555,9 @@ extern __thread char * mysql_thread___eventslog_filename;
 extern __thread int mysql_thread___eventslog_filesize;
 extern __thread int mysql_thread___eventslog_default_log;
 extern __thread int mysql_thread___eventslog_format;
+extern __thread int mysql_thread___eventslog_sample_rate;
+extern __thread int mysql_thread___eventslog_slow_query_threshold;
+extern __thread int mysql_thread___eventslog_digest_rate_limit;
 
 /* variables used by audit log */
 extern __thread char * mysql_thread___auditlog_filename;
@@ -4,6 +4,7 @@
 #include "cpp.h"
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
+#include "QC_table_index.h"
 
 #define EXPIRE_DROPIT   0
 #define SHARED_QUERY_CACHE_HASH_TABLES  32
@@ -22,6 +23,7 @@ struct p_qc_counter {
 		query_cache_bytes_out,
 		query_cache_purged,
 		query_cache_entries,
+		query_cache_invalidated,
 		__size
 	};
 };
@@ -61,6 +63,22 @@ typedef struct _QC_entry {
 	//struct _QC_entry* self; // pointer to itself
 } QC_entry_t;
 
+/**
+ * @brief Extracts the tables referenced by a query from its digest text.
+ * @details Table names are taken after FROM/JOIN, the target of INSERT/REPLACE/UPDATE/DELETE, and
+ *  TABLE in TRUNCATE/ALTER/DROP/RENAME statements. Unqualified names are qualified with 'schemaname',
+ *  and each 'schema.table' is lowercased and hashed. For statements that modify data all the tables
+ *  they reference are reported as written, which can only over-invalidate.
+ *
+ * @param digest_text The digest text of the query.
+ * @param schemaname The default schema of the session.
+ * @param read_tables If not NULL, filled with the hashes of all the referenced tables.
+ * @param write_tables If not NULL, filled with the hashes of the tables referenced by writing statements.
+ *  When 'read_tables' is NULL, digests that can't contain a writing statement return immediately.
+ */
+void qc_extract_tables(const char* digest_text, const char* schemaname, std::vector<uint64_t>* read_tables,
+	std::vector<uint64_t>* write_tables);
+
 template <typename QC_DERIVED>
 class Query_Cache {
 	static_assert(std::is_same_v<QC_DERIVED,MySQL_Query_Cache> || std::is_same_v<QC_DERIVED,PgSQL_Query_Cache>,
@@ -77,13 +95,29 @@ public:
 	void p_update_metrics();
 	SQLite3_result* SQL3_getStats();
 	void purgeHash(uint64_t max_memory_size);
+
+	/**
+	 * @brief Sets the version of each table in 'tables', pairs of table hash and version, to the current
+	 *  invalidation epoch.
+	 * @details Used when 'query_cache_table_invalidation' is enabled: the epoch is taken when a query starts,
+	 *  and its resultset is only cached if none of its tables was invalidated meanwhile.
+	 */
+	void get_tables_version(std::vector<std::pair<uint64_t,uint64_t>>& tables);
+
+	/**
+	 * @brief Bumps the invalidation epoch, marks the supplied tables as invalidated at the new epoch and drops
+	 *  all the entries read from them.
+	 * @return The number of entries that were dropped.
+	 */
+	uint64_t invalidate_tables(const std::vector<uint64_t>& tables);
 	
 protected:
 	Query_Cache();
 	~Query_Cache();
 
 	bool set(QC_entry_t* entry, uint64_t user_hash, const unsigned char *kp, uint32_t kl, unsigned char *vp,
-		uint32_t vl, uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms);
+		uint32_t vl, uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms,
+		const std::vector<std::pair<uint64_t,uint64_t>>* tables = NULL);
 	std::shared_ptr<QC_entry_t> get(uint64_t user_hash, const unsigned char* kp, const uint32_t kl, 
 		uint64_t curtime_ms, uint64_t cache_ttl);
 	
@@ -97,6 +131,8 @@ private:
 	uint64_t get_data_size_total();
 	unsigned int current_used_memory_pct(uint64_t max_memory_size);
 	void purgeHash(uint64_t QCnow_ms, unsigned int curr_pct);
+	// tables read by the cached entries, see 'get_tables_version()'
+	QC_table_index table_index;
 
 	struct {
 		std::array<prometheus::Counter*, p_qc_counter::__size> p_counter_array{};
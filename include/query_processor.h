@@ -2,14 +2,20 @@
 #define __CLASS_QUERY_PROCESSOR_H
 #include <type_traits>
 #include <set>
+#include <atomic>
 #include "proxysql.h"
 #include "cpp.h"
+#include "Latency_Histogram.h"
 
 // Optimization introduced in 2.0.6
 // to avoid a lot of unnecessary copy
 #define DIGEST_STATS_FAST_MINSIZE   100000
 #define DIGEST_STATS_FAST_THREADS   4
 
+// Number of columns of the rows of query digests: the last three are the latency percentiles, which are
+// NULL for digests without a histogram
+#define DIGEST_STATS_COLUMNS   17
+
 //#include "../deps/json/json.hpp"
 
 #ifndef PROXYJSON
@@ -42,7 +48,7 @@ KHASH_MAP_INIT_STR(khStrInt, int)
 					};
 
 typedef struct _query_digest_stats_pointers_t {
-	char *pta[14];
+	char *pta[DIGEST_STATS_COLUMNS];
 	char digest[24];
 	char count_star[24];
 	char first_seen[24];
@@ -53,6 +59,9 @@ typedef struct _query_digest_stats_pointers_t {
 	char hid[24];
 	char rows_affected[24];
 	char rows_sent[24];
+	char p50_time[24];
+	char p95_time[24];
+	char p99_time[24];
 } query_digest_stats_pointers_t;
 
 class QP_query_digest_stats {
@@ -74,12 +83,38 @@ class QP_query_digest_stats {
 	unsigned long long rows_affected;
 	unsigned long long rows_sent;
 	int hid;
+	/**
+	 * @brief Latency distribution of the digest, in microseconds. NULL when the digest isn't tracked, see
+	 *   'mysql-query_digests_histograms_max'.
+	 */
+	Digest_Latency_Histogram *histogram;
+	/**
+	 * @brief Number of digest histograms currently allocated, used to enforce their maximum number.
+	 */
+	static std::atomic<int> histograms_count;
 	QP_query_digest_stats(const char* _user, const char* _schema, uint64_t _digest, const char* _digest_text,
 		int _hid, const char* _client_addr, int query_digests_max_digest_length);
+	/**
+	 * @brief Updates the counters of the digest. The latency histogram is updated by the caller, for single
+	 *   executions, or by 'merge()'.
+	 */
 	void add_time(
 		unsigned long long t, unsigned long long n, unsigned long long ra, unsigned long long rs,
 		unsigned long long cnt = 1
 	);
+	/**
+	 * @brief Merges into this entry the counters and the latency histogram of 'qds', an entry of the same digest.
+	 */
+	void merge(QP_query_digest_stats *qds);
+	/**
+	 * @brief Allocates the latency histogram of the digest, unless already present or 'max_histograms'
+	 *   histograms are already allocated.
+	 */
+	void init_histogram(int max_histograms);
+	/**
+	 * @brief Merges into this entry the latency histogram of 'qds', taking its ownership when possible.
+	 */
+	void merge_histogram(QP_query_digest_stats *qds);
 	~QP_query_digest_stats();
 	char *get_digest_text(const umap_query_digest_text *digest_text_umap);
 	char **get_row(umap_query_digest_text *digest_text_umap, query_digest_stats_pointers_t *qdsp);
@@ -241,6 +276,23 @@ struct rules_mem_sts_t {
 	khash_t(khStrInt)* rules_fast_routing;
 };
 
+class QP_fast_routing_table;
+class QP_firewall_whitelist;
+
+/**
+ * @brief Immutable set of compiled query rules, shared by all the worker threads.
+ * @details Built once per 'Query_Processor::commit()': copies of the active rules with their regexes
+ *   already compiled, and the read-only 'rules_fast_routing' table when 'query_rules_fast_routing_algorithm'
+ *   is 1. Worker threads adopt the current set taking a reference, and the set is freed when the last
+ *   reference is released. Hits are not stored in the shared rules, each thread counts them separately.
+ */
+struct QP_compiled_rules_t {
+	unsigned int version;
+	std::vector<QP_rule_t*> rules;
+	QP_fast_routing_table* rules_fast_routing;
+	unsigned int refcnt;
+};
+
 class MySQL_Query_Processor;
 class PgSQL_Query_Processor;
 class MySQL_Connection_userinfo;
@@ -294,6 +346,9 @@ public:
 	unsigned long long get_query_digests_total_size();
 	unsigned long long get_rules_mem_used();
 	unsigned long long get_new_req_conns_count();
+	unsigned long long get_query_digests_cache_hits();
+	unsigned long long get_query_digests_cache_misses();
+	unsigned long long get_query_digests_truncated();
 
 	SQLite3_result* get_current_query_rules_inner();
 	SQLite3_result* get_stats_query_rules();
@@ -329,8 +384,6 @@ public:
 
 	// firewall
 	void load_firewall(SQLite3_result* u, SQLite3_result* r, SQLite3_result* sf);
-	void load_firewall_users(SQLite3_result*);
-	void load_firewall_rules(SQLite3_result*);
 	void load_firewall_sqli_fingerprints(SQLite3_result*);
 
 	unsigned long long get_firewall_memory_users_table();
@@ -338,8 +391,8 @@ public:
 	unsigned long long get_firewall_memory_rules_table();
 	unsigned long long get_firewall_memory_rules_config();
 	void get_current_firewall_whitelist(SQLite3_result** u, SQLite3_result** r, SQLite3_result** sf);
-	int find_firewall_whitelist_user(char* username, char* client);
-	bool find_firewall_whitelist_rule(char* username, char* client_address, char* schemaname, int flagIN, uint64_t digest);
+	// version of the compiled whitelist, incremented by every 'load_firewall()'
+	unsigned int get_firewall_whitelist_version() { return __sync_add_and_fetch(&firewall_whitelist_version, 0); }
 
 	SQLite3_result* get_firewall_whitelist_users();
 	SQLite3_result* get_firewall_whitelist_rules();
@@ -369,11 +422,14 @@ private:
 	char* rules_fast_routing___keys_values;
 	unsigned long long rules_fast_routing___keys_values___size;
 	unsigned long long rules_fast_routing___number;
+	// rules adopted by the worker threads, replaced by commit()
+	QP_compiled_rules_t* compiled_rules;
 	
 	// firewall
 	pthread_mutex_t global_firewall_whitelist_mutex;
-	std::unordered_map<std::string, int> global_firewall_whitelist_users;
-	std::unordered_map<std::string, void*> global_firewall_whitelist_rules;
+	// compiled users and rules, replaced by load_firewall(). Sessions resolve their entries from it
+	QP_firewall_whitelist* firewall_whitelist;
+	unsigned int firewall_whitelist_version;
 	std::vector<std::string> global_firewall_whitelist_sqli_fingerprints;
 	SQLite3_result* global_firewall_whitelist_users_runtime;
 	SQLite3_result* global_firewall_whitelist_rules_runtime;
@@ -386,6 +442,11 @@ private:
 
 	unsigned long long rules_mem_used;
 	unsigned long long new_req_conns_count;
+	// hits and misses of the per-thread digest caches, flushed by update_query_processor_stats()
+	unsigned long long query_digests_cache_hits;
+	unsigned long long query_digests_cache_misses;
+	// digests computed without consuming the whole query, because the digest reached its maximum length
+	unsigned long long query_digests_truncated;
 	
 	SQLite3_result* query_rules_resultset; // here we save a copy of resultset for query rules
 	// fast routing
@@ -394,6 +455,12 @@ private:
 	DEFINE_HAS_METHOD_STRUCT(query_parser_first_comment_extended);
 	DEFINE_HAS_METHOD_STRUCT(process_query_extended);
 
+	/**
+	 * @brief Creates the compiled rules from the current 'rules' and 'rules_fast_routing___keys_values'.
+	 * @details Caller must hold the write lock.
+	 */
+	QP_compiled_rules_t* compile_rules();
+
 	unsigned long long purge_query_digests_async(char** msg);
 	unsigned long long purge_query_digests_sync(bool parallel);
 
@@ -413,7 +480,16 @@ private:
 	int search_rules_fast_routing_dest_hg(
 		khash_t(khStrInt)** __rules_fast_routing, const char* u, const char* s, int flagIN, bool lock
 	);
-	
+
+	/**
+	 * @brief Searches for a matching rule in the read-only table of a 'QP_compiled_rules_t'.
+	 * @details The table is immutable, no locking is required.
+	 * @return If a matching rule is found, the target destination hostgroup, -1 otherwise.
+	 */
+	int search_rules_fast_routing_dest_hg(
+		const QP_fast_routing_table* _rules_fast_routing, const char* u, const char* s, int flagIN
+	);
+
 	friend Web_Interface_plugin;
 };
 
@@ -446,6 +446,18 @@ bool admin_handler_command_proxysql(char *query_no_space, unsigned int query_no_
 			return false;
 		}
 	}
+	if (query_no_space_length==strlen(CLUSTER_QUERY_PUSH_NOTIFICATION) && !strncasecmp(CLUSTER_QUERY_PUSH_NOTIFICATION, query_no_space, query_no_space_length)) {
+		// the peer is identified by the address and the interfaces it sent with 'PROXYSQL CLUSTER_NODE_UUID'
+		if (sess->proxysql_node_address == NULL || sess->proxysql_node_address->admin_mysql_ifaces == NULL) {
+			SPA->send_error_msg_to_client(sess, (char *)"Received PROXYSQL CLUSTER_NOTIFY before PROXYSQL CLUSTER_NODE_UUID");
+			return false;
+		}
+		if (GloProxyCluster->Receive_Push_Notification(sess->client_myds->addr.addr, sess->proxysql_node_address->admin_mysql_ifaces) == false) {
+			proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Received PROXYSQL CLUSTER_NOTIFY from %s:%d , not matching any peer in proxysql_servers\n", sess->client_myds->addr.addr, sess->client_myds->addr.port);
+		}
+		SPA->send_ok_msg_to_client(sess, NULL, 0, query_no_space);
+		return false;
+	}
 	if (query_no_space_length==strlen("PROXYSQL READONLY") && !strncasecmp("PROXYSQL READONLY",query_no_space, query_no_space_length)) {
 		// this command enables admin_read_only , so the admin module is in read_only mode
 		proxy_info("Received PROXYSQL READONLY command\n");
@@ -2413,6 +2425,32 @@ void admin_session_handler(S* sess, void *_pa, PtrSize_t *pkt) {
 				goto __run_query;
 			}
 		}
+		ProxySQL_Cluster_Changelog* changelog = NULL;
+		const char* changes_query = NULL;
+		if (!strncasecmp(CLUSTER_QUERY_MYSQL_QUERY_RULES_CHANGES, query_no_space, strlen(CLUSTER_QUERY_MYSQL_QUERY_RULES_CHANGES))) {
+			changelog = &GloProxyCluster->mysql_query_rules_changelog;
+			changes_query = CLUSTER_QUERY_MYSQL_QUERY_RULES_CHANGES;
+		} else if (!strncasecmp(CLUSTER_QUERY_MYSQL_USERS_CHANGES, query_no_space, strlen(CLUSTER_QUERY_MYSQL_USERS_CHANGES))) {
+			changelog = &GloProxyCluster->mysql_users_changelog;
+			changes_query = CLUSTER_QUERY_MYSQL_USERS_CHANGES;
+		}
+		if (changelog) {
+			// the checksum follows the query, quoted
+			string checksum { query_no_space + strlen(changes_query) };
+			if (checksum.size() >= 2 && checksum.front() == '\'' && checksum.back() == '\'') {
+				checksum = checksum.substr(1, checksum.size() - 2);
+			}
+			resultset = changelog->get_changes(checksum);
+			if (resultset) {
+				sess->SQLite3_to_MySQL(resultset, error, affected_rows, &sess->client_myds->myprot);
+				delete resultset;
+			} else {
+				const string err_msg { "Changes since checksum " + checksum + " not available" };
+				SPA->send_error_msg_to_client(sess, const_cast<char*>(err_msg.c_str()));
+			}
+			run_query=false;
+			goto __run_query;
+		}
 	}
 
 	// if the client simply executes:
@@ -21,8 +21,11 @@ template void Base_Thread::register_session(MySQL_Thread*, MySQL_Session*, bool)
 template void Base_Thread::register_session(PgSQL_Thread*, PgSQL_Session*, bool);
 template void Base_Thread::run_SetAllSession_ToProcess0<MySQL_Thread, MySQL_Session>();
 template void Base_Thread::run_SetAllSession_ToProcess0<PgSQL_Thread, PgSQL_Session>();
+template void Base_Thread::release_stale_firewall_caches<MySQL_Session>(unsigned int);
+template void Base_Thread::release_stale_firewall_caches<PgSQL_Session>(unsigned int);
 
 Base_Thread::Base_Thread() {
+	firewall_whitelist_version = 0;
 };
 
 Base_Thread::~Base_Thread() {
@@ -45,6 +48,10 @@ void Base_Thread::register_session(T thr, S _sess, bool up_start) {
 	if constexpr (std::is_same_v<T, PgSQL_Thread*>) {
 		_sess->copy_cmd_matcher = (static_cast<PgSQL_Thread*>(this))->copy_cmd_matcher;
 	}
+	if constexpr (std::is_same_v<T, MySQL_Thread*>) {
+		_sess->thread_session_idx = mysql_sessions->len - 1;
+		thr->push_ready_session(_sess);
+	}
 
 	if (up_start)
 		_sess->start_time=curtime;
@@ -268,10 +275,14 @@ void Base_Thread::ProcessAllMyDS_AfterPoll() {
 			read_one_byte_from_pipe<T>(n);
 			continue;
 		}
+		auto * sess = myds->sess;
 		if (thr->mypolls.fds[n].revents==0) {
 			if (thr->poll_timeout_bool) {
 				check_timing_out_session<T>(n);
 			}
+			if constexpr (std::is_same_v<T, MySQL_Thread>) {
+				thr->push_ready_session_if_pending(sess);
+			}
 		} else {
 			check_for_invalid_fd<T>(n); // this is designed to assert in case of failure
 			switch(myds->myds_type) {
@@ -289,6 +300,9 @@ void Base_Thread::ProcessAllMyDS_AfterPoll() {
 			if (rc==false) {
 				n--;
 			}
+			if constexpr (std::is_same_v<T, MySQL_Thread>) {
+				thr->push_ready_session_if_pending(sess);
+			}
 		}
 	}
 }
@@ -371,6 +385,12 @@ void Base_Thread::configure_pollout(DS * myds, unsigned int n) {
 	if (myds->myds_type==MYDS_BACKEND) {
 		set_backend_to_be_skipped_if_frontend_is_slow<T>(myds, n);
 	}
+	if constexpr (std::is_same_v<T, PgSQL_Thread>) {
+		// during 'COPY FROM STDIN' stop reading from the client while the backend is not keeping up
+		if (myds->myds_type==MYDS_FRONTEND && myds->sess->copy_in_backend_is_slow()) {
+			thr->mypolls.fds[n].events &= ~POLLIN;
+		}
+	}
 }
 
 template<typename T, typename DS>
@@ -539,3 +559,18 @@ void Base_Thread::run_SetAllSession_ToProcess0() {
 	}
 #endif // IDLE_THREADS
 }
+
+template<typename S>
+void Base_Thread::release_stale_firewall_caches(unsigned int version) {
+	if (version == firewall_whitelist_version || mysql_sessions == NULL) {
+		return;
+	}
+	firewall_whitelist_version = version;
+	for (unsigned int n = 0; n < mysql_sessions->len; n++) {
+		S *sess = (S *)mysql_sessions->index(n);
+		QP_firewall_session_cache& fw_cache = sess->firewall_cache;
+		if (fw_cache.whitelist && fw_cache.whitelist->version != version) {
+			fw_cache.reset();
+		}
+	}
+}
@@ -11,6 +11,53 @@ static unsigned long long array_mysrvc_cands = 0;
 
 extern MySQL_Threads_Handler *GloMTH;
 
+// returns the index of a candidate picked at random according to its weight.
+// 'sum' is the sum of the weights of the first 'num_candidates' candidates, and must be greater than 0
+static unsigned int pick_weighted_candidate(MySrvC **mysrvcCandidates, unsigned int num_candidates, unsigned int sum) {
+	unsigned int k;
+	if (sum > 32768) {
+		k=rand()%sum;
+	} else {
+		k=fastrand()%sum;
+	}
+	k++;
+	unsigned int New_sum=0;
+	for (unsigned int j=0; j<num_candidates; j++) {
+		New_sum+=mysrvcCandidates[j]->weight;
+		if (k<=New_sum) {
+			return j;
+		}
+	}
+	return num_candidates-1;
+}
+
+// load of a server relative to its weight: queries in flight, including the new one, times the observed query
+// latency. The ping latency is used until some query completes
+static double get_weighted_load(MySrvC *mysrvc) {
+	unsigned int latency_us = mysrvc->query_latency_ewma_us;
+	if (latency_us == 0) {
+		latency_us = (mysrvc->current_latency_us ? mysrvc->current_latency_us : 1);
+	}
+	return (double)(__sync_fetch_and_add(&mysrvc->queries_in_flight,0) + 1) * latency_us / mysrvc->weight;
+}
+
+// power-of-two-choices: two distinct candidates are picked at random according to their weight, and the one
+// with the lowest weighted load is returned. Candidates order is modified
+static MySrvC * get_least_loaded_of_two(MySrvC **mysrvcCandidates, unsigned int num_candidates, unsigned int sum) {
+	unsigned int a = pick_weighted_candidate(mysrvcCandidates, num_candidates, sum);
+	MySrvC *first = mysrvcCandidates[a];
+	unsigned int sum2 = sum - first->weight;
+	if (sum2 == 0) {
+		// all the other candidates have weight 0
+		return first;
+	}
+	// move the first choice to the end, and exclude it from the second pick
+	mysrvcCandidates[a] = mysrvcCandidates[num_candidates-1];
+	mysrvcCandidates[num_candidates-1] = first;
+	MySrvC *second = mysrvcCandidates[pick_weighted_candidate(mysrvcCandidates, num_candidates-1, sum2)];
+	return (get_weighted_load(second) < get_weighted_load(first) ? second : first);
+}
+
 MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_lag_ms, MySQL_Session *sess) {
 	MySrvC *mysrvc=NULL;
 	unsigned int j;
@@ -311,6 +358,17 @@ MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_
 			}
 		}
 
+		if (num_candidates > 1 && get_load_balancing_algorithm() == 1) {
+			mysrvc = get_least_loaded_of_two(mysrvcCandidates, num_candidates, New_sum);
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySrvC %p, server %s:%d , queries in flight %u , latency %uus\n", mysrvc, mysrvc->address, mysrvc->port, mysrvc->queries_in_flight, mysrvc->query_latency_ewma_us);
+			if (l>32) {
+				free(mysrvcCandidates);
+			}
+#ifdef TEST_AURORA
+			array_mysrvc_cands += num_candidates;
+#endif // TEST_AURORA
+			return mysrvc;
+		}
 
 		unsigned int k;
 		if (New_sum > 32768) {
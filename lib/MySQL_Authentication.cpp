@@ -796,26 +796,15 @@ uint64_t MySQL_Authentication::get_runtime_checksum() {
 	return hashB+hashF;
 }
 
-static pair<umap_auth, umap_auth> extract_accounts_details(MYSQL_RES* resultset, unique_ptr<SQLite3_result>& all_users) {
-	if (resultset == nullptr) { return { umap_auth {}, umap_auth {} }; }
-
-	// The following order is assumed for the resulset received fields:
-	//  - username, password, active, use_ssl, default_hostgroup, default_schema, schema_locked, 
-	// 	  transaction_persistent, fast_forward, backend, frontend, max_connections, attributes, comment.
-	umap_auth f_accs_map {};
-	umap_auth b_accs_map {};
-
-	// Create the SQLite3 resultsets for 'frontend' and 'backend' users
-	uint32_t num_fields = mysql_num_fields(resultset);
-	MYSQL_FIELD* fields = mysql_fetch_fields(resultset);
-
-	SQLite3_result* _all_users { new SQLite3_result(num_fields) };
-
-	for (uint32_t i = 0; i < num_fields; i++) {
-		_all_users->add_column_definition(SQLITE_TEXT, fields[i].name);
-	}
-
-	const auto create_account_details = [] (MYSQL_ROW row) -> account_details_t* {
+/**
+ * @brief Adds the account described by 'row' to the 'backend' and/or 'frontend' accounts maps.
+ * @details The following order is assumed for the row fields:
+ *  - username, password, use_ssl, default_hostgroup, default_schema, schema_locked, transaction_persistent,
+ *    fast_forward, backend, frontend, max_connections, attributes, comment.
+ *  The account details point to the fields of 'row', which must outlive the maps.
+ */
+static void add_account_details(char** row, umap_auth& b_accs_map, umap_auth& f_accs_map) {
+	const auto create_account_details = [] (char** row) -> account_details_t* {
 		account_details_t* acc_details { new account_details_t {} };
 
 		acc_details->username = row[0];
@@ -836,25 +825,47 @@ static pair<umap_auth, umap_auth> extract_accounts_details(MYSQL_RES* resultset,
 		return acc_details;
 	};
 
+	// compute the 'username' hash for the map
+	uint64_t u_hash = 0, _u_hash2 = 0;
+	SpookyHash myhash {};
+	myhash.Init(1,2);
+	myhash.Update(row[0], strlen(row[0]));
+	myhash.Final(&u_hash, &_u_hash2);
+
+	// is backend
+	if (strcmp(row[8], "1") == 0) {
+		account_details_t* acc_details = create_account_details(row);
+		b_accs_map.insert({u_hash, acc_details});
+	}
+	// is frontend
+	if (strcmp(row[9], "1") == 0) {
+		account_details_t* acc_details = create_account_details(row);
+		f_accs_map.insert({u_hash, acc_details});
+	}
+}
+
+static pair<umap_auth, umap_auth> extract_accounts_details(MYSQL_RES* resultset, unique_ptr<SQLite3_result>& all_users) {
+	if (resultset == nullptr) { return { umap_auth {}, umap_auth {} }; }
+
+	// The following order is assumed for the resulset received fields:
+	//  - username, password, active, use_ssl, default_hostgroup, default_schema, schema_locked, 
+	// 	  transaction_persistent, fast_forward, backend, frontend, max_connections, attributes, comment.
+	umap_auth f_accs_map {};
+	umap_auth b_accs_map {};
+
+	// Create the SQLite3 resultsets for 'frontend' and 'backend' users
+	uint32_t num_fields = mysql_num_fields(resultset);
+	MYSQL_FIELD* fields = mysql_fetch_fields(resultset);
+
+	SQLite3_result* _all_users { new SQLite3_result(num_fields) };
+
+	for (uint32_t i = 0; i < num_fields; i++) {
+		_all_users->add_column_definition(SQLITE_TEXT, fields[i].name);
+	}
+
 	vector<char*> pta(static_cast<size_t>(num_fields));
 	while (MYSQL_ROW row = mysql_fetch_row(resultset)) {
-		// compute the 'username' hash for the map
-		uint64_t u_hash = 0, _u_hash2 = 0;
-		SpookyHash myhash {};
-		myhash.Init(1,2);
-		myhash.Update(row[0], strlen(row[0]));
-		myhash.Final(&u_hash, &_u_hash2);
-
-		// is backend
-		if (strcmp(row[8], "1") == 0) {
-			account_details_t* acc_details = create_account_details(row);
-			b_accs_map.insert({u_hash, acc_details});
-		}
-		// is frontend
-		if (strcmp(row[9], "1") == 0) {
-			account_details_t* acc_details = create_account_details(row);
-			f_accs_map.insert({u_hash, acc_details});
-		}
+		add_account_details(row, b_accs_map, f_accs_map);
 
 		// Update the contents of the row for the SQLite3 resultset
 		for (uint32_t i = 0; i < num_fields; i++) {
@@ -871,11 +882,7 @@ static pair<umap_auth, umap_auth> extract_accounts_details(MYSQL_RES* resultset,
 	return { b_accs_map, f_accs_map };
 }
 
-uint64_t MySQL_Authentication::get_runtime_checksum(MYSQL_RES* resultset, unique_ptr<SQLite3_result>& all_users) {
-	if (resultset == NULL) { return 0; }
-
-	pair<umap_auth, umap_auth> acc_maps { extract_accounts_details(resultset, all_users) };
-
+static uint64_t compute_accounts_maps_hash(pair<umap_auth, umap_auth>& acc_maps) {
 	uint64_t b_acc_hash = compute_accounts_hash(acc_maps.first);
 	uint64_t f_acc_hash = compute_accounts_hash(acc_maps.second);
 
@@ -889,6 +896,25 @@ uint64_t MySQL_Authentication::get_runtime_checksum(MYSQL_RES* resultset, unique
 	return b_acc_hash + f_acc_hash;
 }
 
+uint64_t MySQL_Authentication::get_runtime_checksum(MYSQL_RES* resultset, unique_ptr<SQLite3_result>& all_users) {
+	if (resultset == NULL) { return 0; }
+
+	pair<umap_auth, umap_auth> acc_maps { extract_accounts_details(resultset, all_users) };
+
+	return compute_accounts_maps_hash(acc_maps);
+}
+
+uint64_t MySQL_Authentication::get_runtime_checksum(const SQLite3_result* resultset) {
+	if (resultset == NULL) { return 0; }
+
+	pair<umap_auth, umap_auth> acc_maps {};
+	for (SQLite3_row* r : resultset->rows) {
+		add_account_details(r->fields, acc_maps.first, acc_maps.second);
+	}
+
+	return compute_accounts_maps_hash(acc_maps);
+}
+
 void MySQL_Authentication::save_mysql_users(unique_ptr<SQLite3_result>&& users) {
 	this->mysql_users_resultset = std::move(users);
 }
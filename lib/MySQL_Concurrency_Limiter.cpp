@@ -0,0 +1,110 @@
+#include "MySQL_Concurrency_Limiter.h"
+#include "SpookyV2.h"
+
+#include <string.h>
+#include <algorithm>
+
+MySQL_Concurrency_Limiter::MySQL_Concurrency_Limiter() {
+	for (unsigned int i = 0; i < SLOTS; i++) {
+		slots[i].key.store(0, std::memory_order_relaxed);
+		slots[i].running.store(0, std::memory_order_relaxed);
+		slots[i].queued.store(0, std::memory_order_relaxed);
+		pthread_mutex_init(&slots[i].mutex, NULL);
+		slots[i].next_ticket = 0;
+	}
+}
+
+MySQL_Concurrency_Limiter::~MySQL_Concurrency_Limiter() {
+	for (unsigned int i = 0; i < SLOTS; i++) {
+		pthread_mutex_destroy(&slots[i].mutex);
+	}
+}
+
+uint64_t MySQL_Concurrency_Limiter::rule_key(int rule_id, int hid) {
+	// the two highest bits identify the kind of limit, and keep the key from being 0
+	return (1ULL << 62) | ((uint64_t)((uint32_t)rule_id & 0x3FFFFFFF) << 32) | (uint32_t)hid;
+}
+
+uint64_t MySQL_Concurrency_Limiter::user_key(const char *username, int hid) {
+	const uint64_t h = SpookyHash::Hash64(username, strlen(username), (uint64_t)(uint32_t)hid);
+	return (1ULL << 63) | (h >> 2);
+}
+
+int MySQL_Concurrency_Limiter::get_slot(uint64_t key) {
+	const unsigned int start = (key ^ (key >> 29) ^ (key >> 47)) % SLOTS;
+	for (unsigned int i = 0; i < SLOTS; i++) {
+		slot_t& s = slots[(start + i) % SLOTS];
+		uint64_t k = s.key.load(std::memory_order_acquire);
+		if (k == 0) {
+			if (s.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+				return (start + i) % SLOTS;
+			}
+			// claimed concurrently, 'k' holds the key of the new owner
+		}
+		if (k == key) {
+			return (start + i) % SLOTS;
+		}
+	}
+	return -1;
+}
+
+static bool acquire_running(std::atomic<int>& running, int limit) {
+	int cur = running.load(std::memory_order_relaxed);
+	while (cur < limit) {
+		if (running.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MySQL_Concurrency_Limiter::try_acquire(int slot, int limit, uint64_t ticket) {
+	slot_t& s = slots[slot];
+	if (ticket == 0) {
+		if (s.queued.load(std::memory_order_acquire) > 0) {
+			return false;
+		}
+		return acquire_running(s.running, limit);
+	}
+	bool ret = false;
+	pthread_mutex_lock(&s.mutex);
+	// only the first query of the queue can be admitted
+	if (s.waiting.empty() == false && s.waiting.front() == ticket) {
+		ret = acquire_running(s.running, limit);
+		if (ret) {
+			s.waiting.erase(s.waiting.begin());
+			s.queued.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+	pthread_mutex_unlock(&s.mutex);
+	return ret;
+}
+
+void MySQL_Concurrency_Limiter::release(int slot) {
+	slots[slot].running.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+uint64_t MySQL_Concurrency_Limiter::enqueue(int slot) {
+	slot_t& s = slots[slot];
+	pthread_mutex_lock(&s.mutex);
+	const uint64_t ticket = ++s.next_ticket;
+	s.waiting.push_back(ticket);
+	s.queued.fetch_add(1, std::memory_order_acq_rel);
+	pthread_mutex_unlock(&s.mutex);
+	return ticket;
+}
+
+void MySQL_Concurrency_Limiter::dequeue(int slot, uint64_t ticket) {
+	slot_t& s = slots[slot];
+	pthread_mutex_lock(&s.mutex);
+	auto it = std::find(s.waiting.begin(), s.waiting.end(), ticket);
+	if (it != s.waiting.end()) {
+		s.waiting.erase(it);
+		s.queued.fetch_sub(1, std::memory_order_acq_rel);
+	}
+	pthread_mutex_unlock(&s.mutex);
+}
+
+int MySQL_Concurrency_Limiter::get_running(int slot) {
+	return slots[slot].running.load(std::memory_order_relaxed);
+}
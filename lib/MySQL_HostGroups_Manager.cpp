@@ -511,6 +511,18 @@ hg_metrics_map = std::make_tuple(
 			"The number of times that 'auto_increment_delay_multiplex' has been triggered.",
 			metric_tags {}
 		),
+		std::make_tuple (
+			p_hg_counter::multiplex_affinity_released,
+			"proxysql_myhgm_multiplex_affinity_released_total",
+			"The number of times a backend connection wasn't pinned after a statement learned to never need it (requires 'mysql-query_digests').",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_hg_counter::multiplex_affinity_repinned,
+			"proxysql_myhgm_multiplex_affinity_repinned_total",
+			"The number of times a statement depending on the connection state followed a connection not pinned.",
+			metric_tags {}
+		),
 	},
 	// prometheus gauges
 	hg_gauge_vector {
@@ -679,6 +691,8 @@ MySQL_HostGroups_Manager::MySQL_HostGroups_Manager() {
 	status.access_denied_max_user_connections=0;
 	status.select_for_update_or_equivalent=0;
 	status.auto_increment_delay_multiplex=0;
+	status.multiplex_affinity_released=0;
+	status.multiplex_affinity_repinned=0;
 #if 0
 	pthread_mutex_init(&readonly_mutex, NULL);
 #endif // 0
@@ -714,6 +728,7 @@ MySQL_HostGroups_Manager::MySQL_HostGroups_Manager() {
 	incoming_mysql_servers_ssl_params = NULL;
 	incoming_mysql_servers_v2 = NULL;
 	pthread_rwlock_init(&gtid_rwlock, NULL);
+	pthread_rwlock_init(&gtid_ryw_rwlock, NULL);
 	gtid_missing_nodes = false;
 	gtid_ev_loop=NULL;
 	gtid_ev_timer=NULL;
@@ -1529,6 +1544,8 @@ bool MySQL_HostGroups_Manager::commit(
 			generate_mysql_aws_aurora_hostgroups_table();
 		}
 
+		update_gtid_read_your_writes_pairs();
+
 		// hostgroup attributes
 		if (incoming_hostgroup_attributes) {
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_hostgroup_attributes\n");
@@ -1680,6 +1697,60 @@ bool MySQL_HostGroups_Manager::gtid_exists(MySrvC *mysrvc, char * gtid_uuid, uin
 	return ret;
 }
 
+/**
+ * @brief Check if 'mysql-gtid_read_your_writes' applies to a read sent to 'reader_hid' after a write in 'writer_hid'.
+ *
+ * The constraint only applies to the reader hostgroup of the writer hostgroup that executed the write, as
+ * configured in 'mysql_replication_hostgroups', 'mysql_group_replication_hostgroups' or
+ * 'mysql_aws_aurora_hostgroups': any other hostgroup can belong to a different cluster.
+ *
+ * @param writer_hid The hostgroup that executed the last write of the session.
+ * @param reader_hid The hostgroup the read is sent to.
+ * @param tracked Set to true if at least one server of 'reader_hid' has GTID tracking ('gtid_port'). Without
+ *   it the GTID of the write can never be found in the hostgroup.
+ * @return True if the hostgroups are paired, false otherwise.
+ */
+bool MySQL_HostGroups_Manager::gtid_read_your_writes_pair(int writer_hid, int reader_hid, bool *tracked) {
+	bool ret = false;
+	pthread_rwlock_rdlock(&gtid_ryw_rwlock);
+	if (gtid_ryw_pairs.find({ writer_hid, reader_hid }) != gtid_ryw_pairs.end()) {
+		ret = true;
+		*tracked = gtid_tracked_hostgroups.find(reader_hid) != gtid_tracked_hostgroups.end();
+	}
+	pthread_rwlock_unlock(&gtid_ryw_rwlock);
+	return ret;
+}
+
+/**
+ * @brief Rebuilds the (writer, reader) hostgroup pairs used by 'mysql-gtid_read_your_writes' from 'mydb'.
+ * @details Called from commit(), after the hostgroup pairing tables were regenerated.
+ */
+void MySQL_HostGroups_Manager::update_gtid_read_your_writes_pairs() {
+	char *error = NULL;
+	int cols = 0;
+	int affected_rows = 0;
+	SQLite3_result *resultset = NULL;
+	const char *query =
+		"SELECT writer_hostgroup, reader_hostgroup FROM mysql_replication_hostgroups"
+		" UNION SELECT writer_hostgroup, reader_hostgroup FROM mysql_group_replication_hostgroups"
+		" UNION SELECT writer_hostgroup, reader_hostgroup FROM mysql_aws_aurora_hostgroups";
+	mydb->execute_statement(query, &error, &cols, &affected_rows, &resultset);
+	if (error) {
+		proxy_error("Error on %s : %s\n", query, error);
+		free(error);
+	}
+	std::set<std::pair<int,int>> pairs {};
+	if (resultset) {
+		for (const SQLite3_row *r : resultset->rows) {
+			pairs.insert({ atoi(r->fields[0]), atoi(r->fields[1]) });
+		}
+		delete resultset;
+	}
+	pthread_rwlock_wrlock(&gtid_ryw_rwlock);
+	gtid_ryw_pairs.swap(pairs);
+	pthread_rwlock_unlock(&gtid_ryw_rwlock);
+}
+
 void MySQL_HostGroups_Manager::generate_mysql_gtid_executed_tables() {
 	pthread_rwlock_wrlock(&gtid_rwlock);
 	// first, set them all as active = false
@@ -1694,6 +1765,7 @@ void MySQL_HostGroups_Manager::generate_mysql_gtid_executed_tables() {
 
 	// NOTE: We are required to lock while iterating over 'MyHostGroups'. Otherwise race conditions could take place,
 	// e.g. servers could be purged by 'purge_mysql_servers_table' and invalid memory be accessed.
+	std::unordered_set<unsigned int> tracked_hostgroups {};
 	wrlock();
 	for (unsigned int i=0; i<MyHostGroups->len; i++) {
 		MyHGC *myhgc=(MyHGC *)MyHostGroups->index(i);
@@ -1732,10 +1804,16 @@ void MySQL_HostGroups_Manager::generate_mysql_gtid_executed_tables() {
 						//pthread_mutex_unlock(&ev_loop_mutex);
 					}
 				}
+				if (gtid_is) {
+					tracked_hostgroups.insert(myhgc->hid);
+				}
 			}
 		}
 	}
 	wrunlock();
+	pthread_rwlock_wrlock(&gtid_ryw_rwlock);
+	gtid_tracked_hostgroups.swap(tracked_hostgroups);
+	pthread_rwlock_unlock(&gtid_ryw_rwlock);
 	std::vector<string> to_remove;
 	it = gtid_map.begin();
 	while(it != gtid_map.end()) {
@@ -4139,6 +4217,8 @@ void MySQL_HostGroups_Manager::p_update_metrics() {
 	p_update_counter(status.p_counter_array[p_hg_counter::myhgm_myconnpool_destroy], status.myconnpoll_destroy);
 
 	p_update_counter(status.p_counter_array[p_hg_counter::auto_increment_delay_multiplex], status.auto_increment_delay_multiplex);
+	p_update_counter(status.p_counter_array[p_hg_counter::multiplex_affinity_released], status.multiplex_affinity_released);
+	p_update_counter(status.p_counter_array[p_hg_counter::multiplex_affinity_repinned], status.multiplex_affinity_repinned);
 
 	// Update the *connection_pool* metrics
 	this->p_update_connection_pool();
@@ -6193,6 +6273,7 @@ bool AWS_Aurora_Info::update(int r, int _port, char *_end_addr, int maxl, int al
  * @details Input verification is performed in the supplied 'hostgroup_settings'. It's expected to be a valid
  *  JSON that may contain the following fields:
  *   - handle_warnings: Value must be >= 0.
+ *   - load_balancing_algorithm: Value must be 0 (weighted random) or 1 (power-of-two-choices).
  *
  *  In case input verification fails for a field, supplied 'MyHGC' is NOT updated for that field. An error
  *  message is logged specifying the source of the error.
@@ -6215,6 +6296,10 @@ void init_myhgc_hostgroup_settings(const char* hostgroup_settings, MyHGC* myhgc)
 				{ return (monitor_slave_lag_when_null >= 0 && monitor_slave_lag_when_null <= 604800); };
 			const int32_t monitor_slave_lag_when_null = j_get_srv_default_int_val<int32_t>(j, hid, "monitor_slave_lag_when_null", monitor_slave_lag_when_null_check);
 			myhgc->attributes.monitor_slave_lag_when_null = monitor_slave_lag_when_null;
+
+			const auto load_balancing_algorithm_check = [](int8_t algo) -> bool { return algo == 0 || algo == 1; };
+			const int8_t load_balancing_algorithm = j_get_srv_default_int_val<int8_t>(j, hid, "load_balancing_algorithm", load_balancing_algorithm_check);
+			myhgc->attributes.load_balancing_algorithm = load_balancing_algorithm;
 		}
 		catch (const json::exception& e) {
 			proxy_error(
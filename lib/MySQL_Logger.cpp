@@ -10,6 +10,7 @@ using json = nlohmann::json;
 #include "MySQL_Query_Processor.h"
 #include "MySQL_PreparedStatement.h"
 #include "MySQL_Logger.hpp"
+#include "eventslog_columnar.h"
 
 #include <dirent.h>
 #include <libgen.h>
@@ -466,8 +467,77 @@ uint64_t MySQL_Event::write_query_format_2_json(std::fstream *f) {
 	return total_bytes; // always 0
 }
 
+void MySQL_Event::write_query_format_3_columnar(eventslog_columnar::Writer *w) {
+	using namespace eventslog_columnar;
+	const bool have_server = (hid != UINT64_MAX && server);
+	w->put_int(COL_EVENT, et);
+	w->put_int(COL_THREAD_ID, thread_id);
+	w->put_str(COL_USERNAME, username ? username : "", username ? strlen(username) : 0);
+	w->put_str(COL_SCHEMANAME, schemaname ? schemaname : "", schemaname ? strlen(schemaname) : 0);
+	w->put_str(COL_CLIENT, client ? client : "", client ? client_len : 0);
+	w->put_int(COL_HOSTGROUP_ID, hid); // UINT64_MAX, -1 once read back as signed, if there is no hostgroup
+	w->put_str(COL_SERVER, have_server ? server : "", have_server ? server_len : 0);
+	w->put_int(COL_START_TIME, start_time);
+	w->put_int(COL_END_TIME, end_time);
+	w->put_int(COL_CLIENT_STMT_ID, (et == PROXYSQL_COM_STMT_PREPARE || et == PROXYSQL_COM_STMT_EXECUTE) ? client_stmt_id : 0);
+	w->put_int(COL_ROWS_AFFECTED, have_affected_rows ? affected_rows : 0);
+	w->put_int(COL_LAST_INSERT_ID, have_affected_rows ? last_insert_id : 0);
+	w->put_int(COL_ROWS_SENT, have_rows_sent ? rows_sent : 0);
+	w->put_int(COL_DIGEST, query_digest);
+	w->put_str(COL_QUERY, query_ptr ? query_ptr : "", query_ptr ? query_len : 0);
+	w->put_int(COL_FLAGS,
+		(have_affected_rows ? ROW_HAVE_ROWS_AFFECTED : 0) | (have_rows_sent ? ROW_HAVE_ROWS_SENT : 0) |
+		(have_gtid ? ROW_HAVE_GTID : 0) | (have_server ? ROW_HAVE_SERVER : 0)
+	);
+	w->put_str(COL_LAST_GTID, have_gtid ? gtid : "", have_gtid ? strlen(gtid) : 0);
+	w->end_row();
+}
+
 extern MySQL_Query_Processor* GloMyQPro;
 
+MySQL_Logger_Digest_Rate_Limiter::MySQL_Logger_Digest_Rate_Limiter() {
+	for (unsigned int i = 0; i < SLOTS; i++) {
+		slots[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+bool MySQL_Logger_Digest_Rate_Limiter::consume(uint64_t digest, uint64_t now_us, unsigned int rate) {
+	std::atomic<uint64_t>& slot = slots[(digest ^ (digest >> 32)) & (SLOTS - 1)];
+	const uint64_t tag = digest >> 48;
+	const uint32_t now_ms = now_us / 1000;
+	uint64_t cur = slot.load(std::memory_order_relaxed);
+	while (true) {
+		uint64_t tokens = 0;
+		uint32_t last = 0;
+		// 'now_us' is the cached time of the calling thread, which can be slightly behind the time stored by
+		// another thread: a negative elapsed time doesn't refill the bucket, and 'last' never moves backwards.
+		// Only a slot unused for longer than the wrap of 'int32_t' milliseconds looks far in the past.
+		const int32_t elapsed = (cur == 0 ? 0 : (int32_t)(now_ms - (uint32_t)cur));
+		if (cur == 0 || (cur >> 48) != tag || elapsed < -60000) {
+			tokens = rate;
+			last = now_ms;
+		} else {
+			tokens = (cur >> 32) & 0xFFFF;
+			last = (uint32_t)cur;
+			const uint64_t add = elapsed > 0 ? (uint64_t)elapsed * rate / 1000 : 0;
+			if (add && tokens + add >= rate) {
+				tokens = rate;
+				last = now_ms;
+			} else if (add) {
+				tokens += add;
+				last += add * 1000 / rate; // keep the remainder of the elapsed time for the next refill
+			}
+		}
+		if (tokens == 0) {
+			return false;
+		}
+		const uint64_t next = (tag << 48) | ((tokens - 1) << 32) | last;
+		if (slot.compare_exchange_weak(cur, next, std::memory_order_relaxed)) {
+			return true;
+		}
+	}
+}
+
 MySQL_Logger::MySQL_Logger() {
 	events.enabled=false;
 	events.base_filename=NULL;
@@ -483,6 +553,7 @@ MySQL_Logger::MySQL_Logger() {
 	spinlock_rwlock_init(&rwlock);
 #endif
 	events.logfile=NULL;
+	events.columnar=NULL;
 	events.log_file_id=0;
 	events.max_log_file_size=100*1024*1024;
 	audit.logfile=NULL;
@@ -528,11 +599,45 @@ void MySQL_Logger::flush_log() {
 
 void MySQL_Logger::events_close_log_unlocked() {
 	if (events.logfile) {
+		if (events.columnar) {
+			// write the pending rows and the block index, used by the readers to seek by time
+			events_columnar_flush_block_unlocked();
+			const std::string idx = events.columnar->index(events.logfile->tellp());
+			events.logfile->write(idx.data(), idx.size());
+		}
 		events.logfile->flush();
 		events.logfile->close();
 		delete events.logfile;
 		events.logfile=NULL;
 	}
+	if (events.columnar) {
+		delete events.columnar;
+		events.columnar=NULL;
+	}
+}
+
+void MySQL_Logger::events_columnar_flush_block_unlocked() {
+	if (events.columnar->rows() == 0) return;
+	const std::string blk = events.columnar->flush_block(events.logfile->tellp());
+	events.logfile->write(blk.data(), blk.size());
+}
+
+void MySQL_Logger::events_write_columnar_unlocked(MySQL_Event& me) {
+	if (events.columnar == NULL) {
+		// a columnar file can't hold events of other formats: if the file was already written by a thread
+		// not yet aware of the format change, we switch to a new file
+		if (events.logfile->tellp() > 0) {
+			events_flush_log_unlocked();
+			if (events.logfile == NULL) return;
+		}
+		events.columnar = new eventslog_columnar::Writer();
+		const std::string hdr = eventslog_columnar::Writer::file_header();
+		events.logfile->write(hdr.data(), hdr.size());
+	}
+	me.write_query_format_3_columnar(events.columnar);
+	if (events.columnar->full()) {
+		events_columnar_flush_block_unlocked();
+	}
 }
 
 void MySQL_Logger::audit_close_log_unlocked() {
@@ -795,12 +900,23 @@ void MySQL_Logger::log_request(MySQL_Session *sess, MySQL_Data_Stream *myds) {
 	//add a mutex lock in a multithreaded environment, avoid to get a null pointer of events.logfile that leads to the program coredump
         GloMyLogger->wrlock();
 
-	me.write(events.logfile, sess);
-
+	if (mysql_thread___eventslog_format==3) { // format 3 , columnar
+		events_write_columnar_unlocked(me);
+	} else {
+		if (events.columnar) {
+			// switching from the columnar format, the current file is completed with its block index
+			events_flush_log_unlocked();
+		}
+		if (events.logfile) {
+			me.write(events.logfile, sess);
+		}
+	}
 
-	unsigned long curpos=events.logfile->tellp();
-	if (curpos > events.max_log_file_size) {
-		events_flush_log_unlocked();
+	if (events.logfile) {
+		unsigned long curpos=events.logfile->tellp();
+		if (curpos > events.max_log_file_size) {
+			events_flush_log_unlocked();
+		}
 	}
 	wrunlock();
 
@@ -963,6 +1079,12 @@ void MySQL_Logger::log_audit_entry(log_event_type _et, MySQL_Session *sess, MySQ
 void MySQL_Logger::flush() {
 	wrlock();
 	if (events.logfile) {
+		if (events.columnar && events.columnar->rows()) {
+			// don't keep the rows of a partial block in memory for more than one second
+			if (realtime_time() > events.columnar->get_min_start_time() + 1000000) {
+				events_columnar_flush_block_unlocked();
+			}
+		}
 		events.logfile->flush();
 	}
 	if (audit.logfile) {
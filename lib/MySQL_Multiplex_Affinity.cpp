@@ -0,0 +1,45 @@
+#include "MySQL_Multiplex_Affinity.h"
+
+uint64_t MySQL_Multiplex_Affinity::key(uint64_t digest, MUX_AFFINITY_kind kind) {
+	// the same digest has a separate entry for each kind
+	return kind == MUX_AFFINITY_LAST_INSERT_ID ? digest : digest ^ 0x9E3779B97F4A7C15ULL;
+}
+
+bool MySQL_Multiplex_Affinity::releasable(uint64_t digest, MUX_AFFINITY_kind kind, unsigned int min_samples) {
+	const uint64_t k = key(digest, kind);
+	shard_t& shard = get_shard(k);
+	std::lock_guard<std::mutex> lock(shard.mu);
+	auto it = shard.digests.find(k);
+	if (it == shard.digests.end()) {
+		return false;
+	}
+	return it->second.dependent == 0 && it->second.windows >= min_samples;
+}
+
+void MySQL_Multiplex_Affinity::record_window(uint64_t digest, MUX_AFFINITY_kind kind, bool dependent) {
+	const uint64_t k = key(digest, kind);
+	shard_t& shard = get_shard(k);
+	std::lock_guard<std::mutex> lock(shard.mu);
+	auto it = shard.digests.find(k);
+	if (it == shard.digests.end()) {
+		if (shard.digests.size() >= MAX_DIGESTS_PER_SHARD) {
+			return;
+		}
+		it = shard.digests.insert({ k, digest_stats_t { 0, 0 } }).first;
+	}
+	if (it->second.windows < UINT32_MAX) {
+		it->second.windows++;
+	}
+	if (dependent && it->second.dependent < UINT32_MAX) {
+		it->second.dependent++;
+	}
+}
+
+size_t MySQL_Multiplex_Affinity::size() {
+	size_t ret = 0;
+	for (unsigned int i = 0; i < SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(shards[i].mu);
+		ret += shards[i].digests.size();
+	}
+	return ret;
+}
@@ -598,101 +598,67 @@ uint64_t MySQL_STMTs_local_v14::compute_hash(char *user,
 
 MySQL_STMT_Manager_v14::MySQL_STMT_Manager_v14() {
 	last_purge_time = time(NULL);
+	purge_next_shard = 0;
 	pthread_rwlock_init(&rwlock_, NULL);
-	map_stmt_id_to_info= std::map<uint64_t, MySQL_STMT_Global_info *>();       // map using statement id
-	map_stmt_hash_to_info = std::map<uint64_t, MySQL_STMT_Global_info *>();     // map using hashes
+	pthread_mutex_init(&ids_mutex, NULL);
+	pthread_mutex_init(&purge_mutex, NULL);
+	for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS; i++) {
+		pthread_rwlock_init(&shards[i].hash_rwlock_, NULL);
+		pthread_rwlock_init(&shards[i].id_rwlock_, NULL);
+	}
 	free_stmt_ids = std::stack<uint64_t> ();
 
 	next_statement_id =
 	    1;  // we initialize this as 1 because we 0 is not allowed
 	num_stmt_with_ref_client_count_zero = 0;
 	num_stmt_with_ref_server_count_zero = 0;
+	num_stmts = 0;
 	statuses.c_unique = 0;
 	statuses.c_total = 0;
 	statuses.stmt_max_stmt_id = 0;
 	statuses.cached = 0;
 	statuses.s_unique = 0;
 	statuses.s_total = 0;
+	statuses.purged = 0;
 }
 
 MySQL_STMT_Manager_v14::~MySQL_STMT_Manager_v14() {
-	for (auto it = map_stmt_id_to_info.begin(); it != map_stmt_id_to_info.end(); ++it) {
-		MySQL_STMT_Global_info * a = it->second;
-		delete a;
+	for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS; i++) {
+		for (auto it = shards[i].map_stmt_id_to_info.begin(); it != shards[i].map_stmt_id_to_info.end(); ++it) {
+			MySQL_STMT_Global_info * a = it->second;
+			delete a;
+		}
+		shards[i].map_stmt_id_to_info.clear();
+		shards[i].map_stmt_hash_to_info.clear();
+		pthread_rwlock_destroy(&shards[i].hash_rwlock_);
+		pthread_rwlock_destroy(&shards[i].id_rwlock_);
 	}
+	pthread_mutex_destroy(&ids_mutex);
+	pthread_mutex_destroy(&purge_mutex);
 }
 
 void MySQL_STMT_Manager_v14::ref_count_client(uint64_t _stmt_id ,int _v, bool lock) {
 	if (lock)
-		pthread_rwlock_wrlock(&rwlock_);
-	auto s = map_stmt_id_to_info.find(_stmt_id);
-	if (s != map_stmt_id_to_info.end()) {
-		statuses.c_total += _v;
-		MySQL_STMT_Global_info *stmt_info = s->second;
-		if (stmt_info->ref_count_client == 0 && _v == 1) {
+		pthread_rwlock_rdlock(&rwlock_);
+	stmt_shard_t& shard = shard_by_id(_stmt_id);
+	MySQL_STMT_Global_info *stmt_info = NULL;
+	pthread_rwlock_rdlock(&shard.id_rwlock_);
+	auto s = shard.map_stmt_id_to_info.find(_stmt_id);
+	if (s != shard.map_stmt_id_to_info.end()) {
+		stmt_info = s->second;
+	}
+	pthread_rwlock_unlock(&shard.id_rwlock_);
+	if (stmt_info) {
+		__sync_fetch_and_add(&statuses.c_total, _v);
+		int prev = __sync_fetch_and_add(&stmt_info->ref_count_client, _v);
+		if (prev == 0 && _v == 1) {
 			__sync_sub_and_fetch(&num_stmt_with_ref_client_count_zero,1);
 		} else {
-			if (stmt_info->ref_count_client == 1 && _v == -1) {
+			if (prev == 1 && _v == -1) {
 				__sync_add_and_fetch(&num_stmt_with_ref_client_count_zero,1);
 			}
 		}
-		stmt_info->ref_count_client += _v;
-			time_t ct = time(NULL);
-			uint64_t num_client_count_zero = __sync_add_and_fetch(&num_stmt_with_ref_client_count_zero, 0);
-			uint64_t num_server_count_zero = __sync_add_and_fetch(&num_stmt_with_ref_server_count_zero, 0);
-
-			size_t map_size = map_stmt_id_to_info.size();
-			if (
-				(ct > last_purge_time+1) &&
-				(map_size > (unsigned)mysql_thread___max_stmts_cache ) &&
-				(num_client_count_zero > map_size/10) &&
-				(num_server_count_zero > map_size/10)
-			) { // purge only if there is at least 10% gain
-				last_purge_time = ct;
-				int max_purge = map_size ;
-				int i = -1;
-				uint64_t *torem =
-				    (uint64_t *)malloc(max_purge * sizeof(uint64_t));
-				for (std::map<uint64_t, MySQL_STMT_Global_info *>::iterator it =
-				         map_stmt_id_to_info.begin();
-					it != map_stmt_id_to_info.end(); ++it) {
-					if ( (i == (max_purge - 1)) || (i == ((int)num_client_count_zero - 1)) ) {
-						break; // nothing left to clean up
-					}
-					MySQL_STMT_Global_info *a = it->second;
-					if ((__sync_add_and_fetch(&a->ref_count_client, 0) == 0) &&
-						(a->ref_count_server == 0) ) // this to avoid that IDs are incorrectly reused
-					{
-						uint64_t hash = a->hash;
-						auto s2 = map_stmt_hash_to_info.find(hash);
-						if (s2 != map_stmt_hash_to_info.end()) {
-							map_stmt_hash_to_info.erase(s2);
-						}
-						__sync_sub_and_fetch(&num_stmt_with_ref_client_count_zero,1);
-						//if (a->ref_count_server == 0) {
-							//__sync_sub_and_fetch(&num_stmt_with_ref_server_count_zero,1);
-						//}
-						// m.erase(it);
-						// delete a;
-						i++;
-						torem[i] = it->first;
-					}
-				}
-				while (i >= 0) {
-					uint64_t id = torem[i];
-					auto s3 = map_stmt_id_to_info.find(id);
-					MySQL_STMT_Global_info *a = s3->second;
-					if (a->ref_count_server == 0) {
-						__sync_sub_and_fetch(&num_stmt_with_ref_server_count_zero,1);
-						free_stmt_ids.push(id);
-					}
-					map_stmt_id_to_info.erase(s3);
-					statuses.s_total -= a->ref_count_server;
-					delete a;
-					i--;
-				}
-				free(torem);
-			}
+		// statements no longer referenced are removed by purge_unused_statements()
 	}
 	if (lock)
 		pthread_rwlock_unlock(&rwlock_);
@@ -700,25 +666,94 @@ void MySQL_STMT_Manager_v14::ref_count_client(uint64_t _stmt_id ,int _v, bool lo
 
 void MySQL_STMT_Manager_v14::ref_count_server(uint64_t _stmt_id ,int _v, bool lock) {
 	if (lock)
-		pthread_rwlock_wrlock(&rwlock_);
-	std::map<uint64_t, MySQL_STMT_Global_info *>::iterator s;
-	s = map_stmt_id_to_info.find(_stmt_id);
-	if (s != map_stmt_id_to_info.end()) {
-		statuses.s_total += _v;
-		MySQL_STMT_Global_info *stmt_info = s->second;
-		if (stmt_info->ref_count_server == 0 && _v == 1) {
+		pthread_rwlock_rdlock(&rwlock_);
+	stmt_shard_t& shard = shard_by_id(_stmt_id);
+	MySQL_STMT_Global_info *stmt_info = NULL;
+	pthread_rwlock_rdlock(&shard.id_rwlock_);
+	auto s = shard.map_stmt_id_to_info.find(_stmt_id);
+	if (s != shard.map_stmt_id_to_info.end()) {
+		stmt_info = s->second;
+	}
+	pthread_rwlock_unlock(&shard.id_rwlock_);
+	if (stmt_info) {
+		__sync_fetch_and_add(&statuses.s_total, _v);
+		int prev = __sync_fetch_and_add(&stmt_info->ref_count_server, _v);
+		if (prev == 0 && _v == 1) {
 			__sync_sub_and_fetch(&num_stmt_with_ref_server_count_zero,1);
 		} else {
-			if (stmt_info->ref_count_server == 1 && _v == -1) {
+			if (prev == 1 && _v == -1) {
 				__sync_add_and_fetch(&num_stmt_with_ref_server_count_zero,1);
 			}
 		}
-		stmt_info->ref_count_server += _v;
 	}
 	if (lock)
 		pthread_rwlock_unlock(&rwlock_);
 }
 
+// removes from a shard up to max_purge statements with no client and no server references
+// the caller must hold rwlock_ in write mode: no other thread can access any shard
+unsigned int MySQL_STMT_Manager_v14::purge_shard(stmt_shard_t& shard, unsigned int max_purge) {
+	unsigned int purged = 0;
+	for (auto it = shard.map_stmt_id_to_info.begin(); it != shard.map_stmt_id_to_info.end() && purged < max_purge; ) {
+		MySQL_STMT_Global_info *a = it->second;
+		if ((a->ref_count_client == 0) && (a->ref_count_server == 0)) { // this to avoid that IDs are incorrectly reused
+			stmt_shard_t& hash_shard = shard_by_hash(a->hash);
+			auto s2 = hash_shard.map_stmt_hash_to_info.find(a->hash);
+			if (s2 != hash_shard.map_stmt_hash_to_info.end() && s2->second == a) {
+				hash_shard.map_stmt_hash_to_info.erase(s2);
+			}
+			__sync_sub_and_fetch(&num_stmt_with_ref_client_count_zero,1);
+			__sync_sub_and_fetch(&num_stmt_with_ref_server_count_zero,1);
+			__sync_sub_and_fetch(&num_stmts,1);
+			pthread_mutex_lock(&ids_mutex);
+			free_stmt_ids.push(a->statement_id);
+			pthread_mutex_unlock(&ids_mutex);
+			it = shard.map_stmt_id_to_info.erase(it);
+			delete a;
+			purged++;
+		} else {
+			++it;
+		}
+	}
+	return purged;
+}
+
+void MySQL_STMT_Manager_v14::purge_unused_statements() {
+	if (pthread_mutex_trylock(&purge_mutex)) {
+		return; // another thread is already purging
+	}
+	time_t ct = time(NULL);
+	uint64_t num_client_count_zero = __sync_add_and_fetch(&num_stmt_with_ref_client_count_zero, 0);
+	uint64_t num_server_count_zero = __sync_add_and_fetch(&num_stmt_with_ref_server_count_zero, 0);
+	uint64_t map_size = __sync_add_and_fetch(&num_stmts, 0);
+	if (
+		(ct > last_purge_time+1) &&
+		(map_size > (unsigned)mysql_thread___max_stmts_cache ) &&
+		(num_client_count_zero > map_size/10) &&
+		(num_server_count_zero > map_size/10)
+	) { // purge only if there is at least 10% gain
+		last_purge_time = ct;
+		unsigned int max_purge = STMT_MANAGER_PURGE_BATCH;
+		if (num_client_count_zero < max_purge) {
+			max_purge = num_client_count_zero;
+		}
+		unsigned int purged = 0;
+		// shards are processed one at the time, releasing rwlock_ in between
+		// so that worker threads are never blocked for long
+		for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS && purged < max_purge; i++) {
+			pthread_rwlock_wrlock(&rwlock_);
+			purged += purge_shard(shards[purge_next_shard], max_purge - purged);
+			pthread_rwlock_unlock(&rwlock_);
+			purge_next_shard = (purge_next_shard + 1) % STMT_MANAGER_NUM_SHARDS;
+		}
+		if (purged) {
+			__sync_fetch_and_add(&statuses.purged, purged);
+			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Purged %u unused prepared statements\n", purged);
+		}
+	}
+	pthread_mutex_unlock(&purge_mutex);
+}
+
 MySQL_STMTs_local_v14::~MySQL_STMTs_local_v14() {
 	// Note: we do not free the prepared statements because we assume that
 	// if we call this destructor the connection is being destroyed anyway
@@ -744,10 +779,13 @@ MySQL_STMTs_local_v14::~MySQL_STMTs_local_v14() {
 MySQL_STMT_Global_info *MySQL_STMT_Manager_v14::find_prepared_statement_by_hash(
     uint64_t hash) {
 	MySQL_STMT_Global_info *ret = NULL;  // assume we do not find it
-	auto s = map_stmt_hash_to_info.find(hash);
-	if (s != map_stmt_hash_to_info.end()) {
+	stmt_shard_t& shard = shard_by_hash(hash);
+	pthread_rwlock_rdlock(&shard.hash_rwlock_);
+	auto s = shard.map_stmt_hash_to_info.find(hash);
+	if (s != shard.map_stmt_hash_to_info.end()) {
 		ret = s->second;
 	}
+	pthread_rwlock_unlock(&shard.hash_rwlock_);
 	return ret;
 }
 
@@ -755,13 +793,16 @@ MySQL_STMT_Global_info *MySQL_STMT_Manager_v14::find_prepared_statement_by_stmt_
     uint64_t id, bool lock) {
 	MySQL_STMT_Global_info *ret = NULL;  // assume we do not find it
 	if (lock) {
-		pthread_rwlock_wrlock(&rwlock_);
+		pthread_rwlock_rdlock(&rwlock_);
 	}
 
-	auto s = map_stmt_id_to_info.find(id);
-	if (s != map_stmt_id_to_info.end()) {
+	stmt_shard_t& shard = shard_by_id(id);
+	pthread_rwlock_rdlock(&shard.id_rwlock_);
+	auto s = shard.map_stmt_id_to_info.find(id);
+	if (s != shard.map_stmt_id_to_info.end()) {
 		ret = s->second;
 	}
+	pthread_rwlock_unlock(&shard.id_rwlock_);
 
 	if (lock) {
 		pthread_rwlock_unlock(&rwlock_);
@@ -815,6 +856,20 @@ bool MySQL_STMTs_local_v14::client_close(uint32_t client_statement_id) {
 	return false;  // we don't really remove the prepared statement
 }
 
+uint64_t MySQL_STMT_Manager_v14::get_next_statement_id() {
+	uint64_t next_id = 0;
+	pthread_mutex_lock(&ids_mutex);
+	if (free_stmt_ids.size()) {
+		next_id = free_stmt_ids.top();
+		free_stmt_ids.pop();
+	} else {
+		next_id = next_statement_id;
+		next_statement_id++;
+	}
+	pthread_mutex_unlock(&ids_mutex);
+	return next_id;
+}
+
 MySQL_STMT_Global_info *MySQL_STMT_Manager_v14::add_prepared_statement(
     char *u, char *s, char *q, unsigned int ql,
     char *fc, MYSQL_STMT *stmt, bool lock) {
@@ -822,48 +877,42 @@ MySQL_STMT_Global_info *MySQL_STMT_Manager_v14::add_prepared_statement(
 	uint64_t hash = stmt_compute_hash(
 		u, s, q, ql);  // this identifies the prepared statement
 	if (lock) {
-		pthread_rwlock_wrlock(&rwlock_);
+		pthread_rwlock_rdlock(&rwlock_);
 	}
+	stmt_shard_t& hash_shard = shard_by_hash(hash);
+	// the hash map of the shard is kept locked until the statement is also
+	// visible through its id, so that concurrent prepares of the same statement
+	// always end up using the same MySQL_STMT_Global_info
+	pthread_rwlock_wrlock(&hash_shard.hash_rwlock_);
 	// try to find the statement
-	auto f = map_stmt_hash_to_info.find(hash);
-	if (f != map_stmt_hash_to_info.end()) {
+	auto f = hash_shard.map_stmt_hash_to_info.find(hash);
+	if (f != hash_shard.map_stmt_hash_to_info.end()) {
 		// found it!
-		// MySQL_STMT_Global_info *a=f->second;
-		// ret=a->statement_id;
 		ret = f->second;
+		pthread_rwlock_unlock(&hash_shard.hash_rwlock_);
 		ret->update_metadata(stmt);
-		//*is_new = false;
 	} else {
-		// FIXME: add a stack here too!!!
 		// we need to create a new one
-
-		bool free_id_avail = false;
-		free_id_avail = free_stmt_ids.size();
-
-		uint64_t next_id = 0;
-		if (free_id_avail) {
-			next_id = free_stmt_ids.top();
-			free_stmt_ids.pop();
-		} else {
-			next_id = next_statement_id;
-			next_statement_id++;
-		}
-
-		//next_statement_id++;
+		uint64_t next_id = get_next_statement_id();
 		MySQL_STMT_Global_info *a =
 		    new MySQL_STMT_Global_info(next_id, u, s, q, ql, fc, stmt, hash);
 		// insert it in both maps
-		map_stmt_id_to_info.insert(std::make_pair(a->statement_id, a));
-		map_stmt_hash_to_info.insert(std::make_pair(a->hash, a));
-		ret = a;
+		stmt_shard_t& id_shard = shard_by_id(a->statement_id);
+		// hash_rwlock_ before id_rwlock_, see the locking notes of the class
+		pthread_rwlock_wrlock(&id_shard.id_rwlock_);
+		id_shard.map_stmt_id_to_info.insert(std::make_pair(a->statement_id, a));
+		pthread_rwlock_unlock(&id_shard.id_rwlock_);
+		hash_shard.map_stmt_hash_to_info.insert(std::make_pair(a->hash, a));
+		__sync_add_and_fetch(&num_stmts,1);
 		__sync_add_and_fetch(&num_stmt_with_ref_client_count_zero,1);
 		__sync_add_and_fetch(&num_stmt_with_ref_server_count_zero,1);
+		pthread_rwlock_unlock(&hash_shard.hash_rwlock_);
+		ret = a;
 	}
-	if (ret->ref_count_server == 0) {
+	if (__sync_fetch_and_add(&ret->ref_count_server, 1) == 0) {
 		__sync_sub_and_fetch(&num_stmt_with_ref_server_count_zero,1);
 	}
-	ret->ref_count_server++;
-	statuses.s_total++;
+	__sync_fetch_and_add(&statuses.s_total, 1);
 	if (lock) {
 		pthread_rwlock_unlock(&rwlock_);
 	}
@@ -874,25 +923,34 @@ MySQL_STMT_Global_info *MySQL_STMT_Manager_v14::add_prepared_statement(
 void MySQL_STMT_Manager_v14::get_memory_usage(uint64_t& prep_stmt_metadata_mem_usage, uint64_t& prep_stmt_backend_mem_usage) {
 	prep_stmt_backend_mem_usage = 0;
 	prep_stmt_metadata_mem_usage = sizeof(MySQL_STMT_Manager_v14);
-	rdlock();	
-	prep_stmt_metadata_mem_usage += map_stmt_id_to_info.size() * (sizeof(uint64_t) + sizeof(MySQL_STMT_Global_info*));
-	prep_stmt_metadata_mem_usage += map_stmt_hash_to_info.size() * (sizeof(uint64_t) + sizeof(MySQL_STMT_Global_info*));
+	rdlock();
+	pthread_mutex_lock(&ids_mutex);
 	prep_stmt_metadata_mem_usage += free_stmt_ids.size() * (sizeof(uint64_t));
-	for (const auto& keyval : map_stmt_id_to_info) {
-		const MySQL_STMT_Global_info* stmt_global_info = keyval.second;
-		prep_stmt_metadata_mem_usage += stmt_global_info->total_mem_usage;
-		prep_stmt_metadata_mem_usage += stmt_global_info->ref_count_server *
-			((stmt_global_info->num_params * sizeof(MYSQL_BIND)) +
-			(stmt_global_info->num_columns * sizeof(MYSQL_FIELD))) + 16; // ~16 bytes of memory utilized by global_stmt_id and stmt_id mappings
-		prep_stmt_metadata_mem_usage += stmt_global_info->ref_count_client *
-			((stmt_global_info->num_params * sizeof(MYSQL_BIND)) +
-			(stmt_global_info->num_columns * sizeof(MYSQL_FIELD))) + 16; // ~16 bytes of memory utilized by global_stmt_id and stmt_id mappings
-
-		// backend
-		prep_stmt_backend_mem_usage += stmt_global_info->ref_count_server * (sizeof(MYSQL_STMT) +
-			56 + //sizeof(MADB_STMT_EXTENSION)
-			(stmt_global_info->num_params * sizeof(MYSQL_BIND)) + 
-			(stmt_global_info->num_columns * sizeof(MYSQL_FIELD)));
+	pthread_mutex_unlock(&ids_mutex);
+	for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS; i++) {
+		stmt_shard_t& shard = shards[i];
+		pthread_rwlock_rdlock(&shard.hash_rwlock_);
+		pthread_rwlock_rdlock(&shard.id_rwlock_);
+		prep_stmt_metadata_mem_usage += shard.map_stmt_id_to_info.size() * (sizeof(uint64_t) + sizeof(MySQL_STMT_Global_info*));
+		prep_stmt_metadata_mem_usage += shard.map_stmt_hash_to_info.size() * (sizeof(uint64_t) + sizeof(MySQL_STMT_Global_info*));
+		for (const auto& keyval : shard.map_stmt_id_to_info) {
+			const MySQL_STMT_Global_info* stmt_global_info = keyval.second;
+			prep_stmt_metadata_mem_usage += stmt_global_info->total_mem_usage;
+			prep_stmt_metadata_mem_usage += stmt_global_info->ref_count_server *
+				((stmt_global_info->num_params * sizeof(MYSQL_BIND)) +
+				(stmt_global_info->num_columns * sizeof(MYSQL_FIELD))) + 16; // ~16 bytes of memory utilized by global_stmt_id and stmt_id mappings
+			prep_stmt_metadata_mem_usage += stmt_global_info->ref_count_client *
+				((stmt_global_info->num_params * sizeof(MYSQL_BIND)) +
+				(stmt_global_info->num_columns * sizeof(MYSQL_FIELD))) + 16; // ~16 bytes of memory utilized by global_stmt_id and stmt_id mappings
+
+			// backend
+			prep_stmt_backend_mem_usage += stmt_global_info->ref_count_server * (sizeof(MYSQL_STMT) +
+				56 + //sizeof(MADB_STMT_EXTENSION)
+				(stmt_global_info->num_params * sizeof(MYSQL_BIND)) +
+				(stmt_global_info->num_columns * sizeof(MYSQL_FIELD)));
+		}
+		pthread_rwlock_unlock(&shard.id_rwlock_);
+		pthread_rwlock_unlock(&shard.hash_rwlock_);
 	}
 	unlock();
 }
@@ -907,41 +965,47 @@ void MySQL_STMT_Manager_v14::get_metrics(uint64_t *c_unique, uint64_t *c_total,
 	uint64_t c = 0;
 	uint64_t s_u = 0;
 	uint64_t s_t = 0;
-#endif
+	// the exclusive lock is required only to validate the counters
 	pthread_rwlock_wrlock(&rwlock_);
-	statuses.cached = map_stmt_id_to_info.size();
-	statuses.c_unique = statuses.cached - num_stmt_with_ref_client_count_zero;
-	statuses.s_unique = statuses.cached - num_stmt_with_ref_server_count_zero;
+#else
+	pthread_rwlock_rdlock(&rwlock_);
+#endif
+	uint64_t _cached = __sync_add_and_fetch(&num_stmts, 0);
+	uint64_t _c_unique = _cached - __sync_add_and_fetch(&num_stmt_with_ref_client_count_zero, 0);
+	uint64_t _s_unique = _cached - __sync_add_and_fetch(&num_stmt_with_ref_server_count_zero, 0);
 #ifdef DEBUG
-	for (std::map<uint64_t, MySQL_STMT_Global_info *>::iterator it = map_stmt_id_to_info.begin();
-	     it != map_stmt_id_to_info.end(); ++it) {
-		MySQL_STMT_Global_info *a = it->second;
-		c++;
-		if (a->ref_count_client) {
-			c_u++;
-			c_t += a->ref_count_client;
-		}
-		if (a->ref_count_server) {
-			s_u++;
-			s_t += a->ref_count_server;
-		}
-		if (it->first > m) {
-			m = it->first;
+	for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS; i++) {
+		for (auto it = shards[i].map_stmt_id_to_info.begin(); it != shards[i].map_stmt_id_to_info.end(); ++it) {
+			MySQL_STMT_Global_info *a = it->second;
+			c++;
+			if (a->ref_count_client) {
+				c_u++;
+				c_t += a->ref_count_client;
+			}
+			if (a->ref_count_server) {
+				s_u++;
+				s_t += a->ref_count_server;
+			}
+			if (it->first > m) {
+				m = it->first;
+			}
 		}
 	}
-	assert (c_u == statuses.c_unique);
+	assert (c_u == _c_unique);
 	assert (c_t == statuses.c_total);
-	assert (c == statuses.cached);
+	assert (c == _cached);
 	assert (s_t == statuses.s_total);
-	assert (s_u == statuses.s_unique);
+	assert (s_u == _s_unique);
 	*stmt_max_stmt_id = m;
 #endif
+	pthread_mutex_lock(&ids_mutex);
 	*stmt_max_stmt_id = next_statement_id; // this is max stmt_id, no matter if in used or not
-	*c_unique = statuses.c_unique;
-	*c_total = statuses.c_total;
-	*cached = statuses.cached;
-	*s_total = statuses.s_total;
-	*s_unique = statuses.s_unique;
+	pthread_mutex_unlock(&ids_mutex);
+	*c_unique = _c_unique;
+	*c_total = __sync_add_and_fetch(&statuses.c_total, 0);
+	*cached = _cached;
+	*s_total = __sync_add_and_fetch(&statuses.s_total, 0);
+	*s_unique = _s_unique;
 	pthread_rwlock_unlock(&rwlock_);
 }
 
@@ -1032,17 +1096,20 @@ SQLite3_result * MySQL_STMT_Manager_v14::get_prepared_statements_global_infos()
 	result->add_column_definition(SQLITE_TEXT,"ref_count_server");
 	result->add_column_definition(SQLITE_TEXT,"num_columns");
 	result->add_column_definition(SQLITE_TEXT,"num_params");
-	for (std::map<uint64_t, MySQL_STMT_Global_info *>::iterator it = map_stmt_id_to_info.begin();
-			it != map_stmt_id_to_info.end(); ++it) {
-		MySQL_STMT_Global_info *a = it->second;
-		PS_global_stats * pgs = new PS_global_stats(a->statement_id,
-			a->schemaname, a->username,
-			a->hash, a->query,
-			a->ref_count_client, a->ref_count_server, a->num_columns, a->num_params);
-			char **pta = pgs->get_row();
-			result->add_row(pta);
-			pgs->free_row(pta);
-			delete pgs;
+	for (unsigned int i = 0; i < STMT_MANAGER_NUM_SHARDS; i++) {
+		pthread_rwlock_rdlock(&shards[i].id_rwlock_);
+		for (auto it = shards[i].map_stmt_id_to_info.begin(); it != shards[i].map_stmt_id_to_info.end(); ++it) {
+			MySQL_STMT_Global_info *a = it->second;
+			PS_global_stats * pgs = new PS_global_stats(a->statement_id,
+				a->schemaname, a->username,
+				a->hash, a->query,
+				a->ref_count_client, a->ref_count_server, a->num_columns, a->num_params);
+				char **pta = pgs->get_row();
+				result->add_row(pta);
+				pgs->free_row(pta);
+				delete pgs;
+		}
+		pthread_rwlock_unlock(&shards[i].id_rwlock_);
 	}
 	unlock();
 	return result;
@@ -767,6 +767,7 @@ MySQL_Query_Processor_Rule_t* MySQL_Query_Processor::new_query_rule(int rule_id,
 	newQR->flagOUT_weights_total = 0;
 	newQR->flagOUT_ids = NULL;
 	newQR->flagOUT_weights = NULL;
+	newQR->max_concurrency = -1;
 	if (newQR->attributes != NULL) {
 		if (strlen(newQR->attributes)) {
 			nlohmann::json j_attributes = nlohmann::json::parse(newQR->attributes);
@@ -797,6 +798,15 @@ MySQL_Query_Processor_Rule_t* MySQL_Query_Processor::new_query_rule(int rule_id,
 					proxy_error("Failed to parse flagOUTs attributes for rule_id %d : %s\n", newQR->rule_id, flagOUTs.dump().c_str());
 				}
 			}
+			if (j_attributes.find("max_concurrency") != j_attributes.end()) {
+				const nlohmann::json& max_concurrency = j_attributes["max_concurrency"];
+				if (max_concurrency.type() == nlohmann::json::value_t::number_unsigned && max_concurrency.get<uint64_t>() > 0 && max_concurrency.get<uint64_t>() <= INT_MAX) {
+					newQR->max_concurrency = max_concurrency.get<int>();
+				}
+				else {
+					proxy_error("Failed to parse max_concurrency attributes for rule_id %d : %s\n", newQR->rule_id, max_concurrency.dump().c_str());
+				}
+			}
 		}
 	}
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 5, "Creating new rule in %p : rule_id:%d, active:%d, username=%s, schemaname=%s, flagIN:%d, %smatch_digest=\"%s\", %smatch_pattern=\"%s\", flagOUT:%d replace_pattern=\"%s\", destination_hostgroup:%d, apply:%d\n", newQR, newQR->rule_id, newQR->active, newQR->username, newQR->schemaname, newQR->flagIN, (newQR->negate_match_pattern ? "(!)" : ""), newQR->match_digest, (newQR->negate_match_pattern ? "(!)" : ""), newQR->match_pattern, newQR->flagOUT, newQR->replace_pattern, newQR->destination_hostgroup, newQR->apply);
@@ -903,6 +913,7 @@ MySQL_Query_Processor_Rule_t* MySQL_Query_Processor::new_query_rule(const MySQL_
 	newQR->flagOUT_weights_total = 0;
 	newQR->flagOUT_ids = NULL;
 	newQR->flagOUT_weights = NULL;
+	newQR->max_concurrency = -1;
 	if (newQR->attributes != NULL) {
 		if (strlen(newQR->attributes)) {
 			nlohmann::json j_attributes = nlohmann::json::parse(newQR->attributes);
@@ -933,6 +944,15 @@ MySQL_Query_Processor_Rule_t* MySQL_Query_Processor::new_query_rule(const MySQL_
 					proxy_error("Failed to parse flagOUTs attributes for rule_id %d : %s\n", newQR->rule_id, flagOUTs.dump().c_str());
 				}
 			}
+			if (j_attributes.find("max_concurrency") != j_attributes.end()) {
+				const nlohmann::json& max_concurrency = j_attributes["max_concurrency"];
+				if (max_concurrency.type() == nlohmann::json::value_t::number_unsigned && max_concurrency.get<uint64_t>() > 0 && max_concurrency.get<uint64_t>() <= INT_MAX) {
+					newQR->max_concurrency = max_concurrency.get<int>();
+				}
+				else {
+					proxy_error("Failed to parse max_concurrency attributes for rule_id %d : %s\n", newQR->rule_id, max_concurrency.dump().c_str());
+				}
+			}
 		}
 	}
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 5, "Creating new rule in %p : rule_id:%d, active:%d, username=%s, schemaname=%s, flagIN:%d, %smatch_digest=\"%s\", %smatch_pattern=\"%s\", flagOUT:%d replace_pattern=\"%s\", destination_hostgroup:%d, apply:%d\n", newQR, newQR->rule_id, newQR->active, newQR->username, newQR->schemaname, newQR->flagIN, (newQR->negate_match_pattern ? "(!)" : ""), newQR->match_digest, (newQR->negate_match_pattern ? "(!)" : ""), newQR->match_pattern, newQR->flagOUT, newQR->replace_pattern, newQR->destination_hostgroup, newQR->apply);
@@ -361,6 +361,7 @@ Query_Info::Query_Info() {
 	start_time=0;
 	end_time=0;
 	stmt_client_id=0;
+	stages.start=0;
 }
 
 /**
@@ -412,6 +413,7 @@ void Query_Info::begin(unsigned char *_p, int len, bool mysql_header) {
  * Updates query counters and performs clean-up.
  */
 void Query_Info::end() {
+	stages_end();
 	query_parser_update_counters();
 	query_parser_free();
 	if ((end_time-start_time) > (unsigned int)mysql_thread___long_query_time*1000) {
@@ -436,6 +438,44 @@ void Query_Info::end() {
 	}
 }
 
+void Query_Info::stages_begin() {
+	if (sess->thread->variables.stats_time_query_stages == false) {
+		stages.start = 0;
+		return;
+	}
+	stages.start = ticks_time();
+	stages.mark = stages.start;
+	stages.marked = 0;
+}
+
+void Query_Info::stage_mark(enum MySQL_Query_Stage stage) {
+	if (stages.start == 0 || (stages.marked & (1U << stage))) {
+		return;
+	}
+	const uint64_t now = ticks_time();
+	stages.elapsed[stage] = now - stages.mark;
+	stages.mark = now;
+	stages.marked |= (1U << stage);
+}
+
+void Query_Info::stages_end() {
+	if (stages.start == 0) {
+		return;
+	}
+	const uint64_t now = ticks_time();
+	stages.elapsed[query_stage_result] = now - stages.mark;
+	stages.elapsed[query_stage_total] = now - stages.start;
+	stages.marked |= (1U << query_stage_result) | (1U << query_stage_total);
+
+	Latency_Histogram* hists = sess->thread->query_stages;
+	for (int i = 0; i < query_stage___END; i++) {
+		if (stages.marked & (1U << i)) {
+			hists[i].add(ticks_to_ns(stages.elapsed[i]));
+		}
+	}
+	stages.start = 0;
+}
+
 /**
  * @brief Initializes query information with the given parameters.
  * @param _p Pointer to the query data.
@@ -638,6 +678,19 @@ MySQL_Session::MySQL_Session() {
 	handler_function=NULL;
 	client_myds=NULL;
 	to_process=0;
+	thread_session_idx=0;
+	in_ready_list=false;
+	mux_affinity.digest=0;
+	concurrency_limit.slots[0]=-1;
+	concurrency_limit.slots[1]=-1;
+	concurrency_limit.admitted=false;
+	concurrency_limit.queued=false;
+	concurrency_limit.queue=-1;
+	concurrency_limit.ticket=0;
+	concurrency_limit.waiting_since=0;
+	concurrency_limit.user_limit=-1;
+	qc_invalidation.tracked=false;
+	timeout_timer.data=this;
 	mybe=NULL;
 	mirror=false;
 	mirrorPkt.ptr=NULL;
@@ -671,6 +724,8 @@ MySQL_Session::MySQL_Session() {
 	//gtid_trxid = 0;
 	gtid_hid = -1;
 	memset(gtid_buf,0,sizeof(gtid_buf));
+	last_write_gtid_hid = -1;
+	memset(last_write_gtid,0,sizeof(last_write_gtid));
 
 	match_regexes=NULL;
 
@@ -716,6 +771,8 @@ void MySQL_Session::reset() {
 	//gtid_trxid = 0;
 	gtid_hid = -1;
 	memset(gtid_buf,0,sizeof(gtid_buf));
+	last_write_gtid_hid = -1;
+	memset(last_write_gtid,0,sizeof(last_write_gtid));
 	if (session_type == PROXYSQL_SESSION_SQLITE) {
 		SQLite3_Session *sqlite_sess = (SQLite3_Session *)thread->gen_args;
 		if (sqlite_sess && sqlite_sess->sessdb) {
@@ -738,6 +795,7 @@ void MySQL_Session::reset() {
 MySQL_Session::~MySQL_Session() {
 
 	reset(); // we moved this out to allow CHANGE_USER
+	concurrency_limit_release();
 
 	if (locked_on_hostgroup >= 0) {
 		thread->status_variables.stvar[st_var_hostgroup_locked]--;
@@ -1084,6 +1142,8 @@ void MySQL_Session::generate_proxysql_internal_session_json(json &j) {
 	j["warning_in_hg"] = warning_in_hg;
 	j["gtid"]["hid"] = gtid_hid;
 	j["gtid"]["last"] = ( strlen(gtid_buf) ? gtid_buf : "" );
+	j["gtid"]["last_write_hid"] = last_write_gtid_hid;
+	j["gtid"]["last_write"] = ( strlen(last_write_gtid) ? last_write_gtid : "" );
 	json& jqpo = j["qpo"];
 	qpo->get_info_json(jqpo);
 	j["default_schema"] = ( default_schema ? default_schema : "" );
@@ -1885,7 +1945,7 @@ bool MySQL_Session::handler_again___verify_backend_session_track_gtids() {
 		||
 		(b_int == 0) // not configured yet
 	) {
-		if (strcmp(mysql_thread___default_session_track_gtids, (char *)"OWN_GTID")==0) {
+		if (strcmp(mysql_thread___default_session_track_gtids, (char *)"OWN_GTID")==0 || mysql_thread___gtid_read_your_writes) {
 			// backend connection doesn't have session_track_gtids enabled
 			ret = true;
 		} else {
@@ -2839,6 +2899,33 @@ bool MySQL_Session::handler_again___status_CONNECTING_SERVER(int *_rc) {
 			NEXT_IMMEDIATE_NEW(WAITING_CLIENT_DATA);
 		}
 	}
+	if (
+		mybe->server_myds->myconn==NULL && concurrency_limit.admitted==false && mirror==false &&
+		session_fast_forward==SESSION_FORWARD_TYPE_NONE && default_hostgroup>=0 && previous_status.size() &&
+		(previous_status.top()==PROCESSING_QUERY || previous_status.top()==PROCESSING_STMT_EXECUTE)
+	) {
+		int admit_rc = concurrency_limit_admit();
+		if (admit_rc == 1) {
+			// the query waits without a backend connection
+			if (thread->mypolls.poll_timeout==0 || thread->mypolls.poll_timeout > (unsigned int)mysql_thread___poll_timeout_on_failure * 1000) {
+				thread->mypolls.poll_timeout = mysql_thread___poll_timeout_on_failure * 1000;
+			}
+			pause_until=thread->curtime+mysql_thread___connect_retries_delay*1000;
+			*_rc=1;
+			return false;
+		} else if (admit_rc == -1) {
+			string errmsg {};
+			const uint64_t query_time = (thread->curtime - CurrentQuery.start_time)/1000;
+			string_format("Too many concurrent queries for hostgroup %d after %llums", errmsg, current_hostgroup, query_time);
+			client_myds->myprot.generate_pkt_ERR(true,NULL,NULL,1,9007,(char *)"HY000", errmsg.c_str(), true);
+			RequestEnd(mybe->server_myds);
+			while (previous_status.size()) {
+				previous_status.pop();
+			}
+			mybe->server_myds->max_connect_time=0;
+			NEXT_IMMEDIATE_NEW(WAITING_CLIENT_DATA);
+		}
+	}
 	if (mybe->server_myds->myconn==NULL) {
 		handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED__get_connection();
 	}
@@ -3180,7 +3267,9 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 		// shortly after, the packets it used to contain the query will be deallocated
 		// Note2 : we call the next function as if it was _MYSQL_COM_QUERY
 		// because the offset will be identical
+		CurrentQuery.stages_begin();
 		CurrentQuery.begin((unsigned char *)pkt.ptr,pkt.size,true);
+		CurrentQuery.stage_mark(query_stage_digest);
 
 		timespec begint;
 		timespec endt;
@@ -3188,6 +3277,7 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 			clock_gettime(CLOCK_THREAD_CPUTIME_ID,&begint);
 		}
 		qpo= GloMyQPro->process_query(this,pkt.ptr,pkt.size,&CurrentQuery);
+		CurrentQuery.stage_mark(query_stage_query_processor);
 		if (thread->variables.stats_time_query_processor) {
 			clock_gettime(CLOCK_THREAD_CPUTIME_ID,&endt);
 			thread->status_variables.stvar[st_var_query_processor_time] = thread->status_variables.stvar[st_var_query_processor_time] +
@@ -3241,7 +3331,7 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 		);
 		MySQL_STMT_Global_info *stmt_info=NULL;
 		// we first lock GloStmt
-		GloMyStmt->wrlock();
+		GloMyStmt->rdlock();
 		stmt_info=GloMyStmt->find_prepared_statement_by_hash(hash);
 		if (stmt_info) {
 			// the prepared statement exists in GloMyStmt
@@ -3325,6 +3415,8 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 		}
 		CurrentQuery.stmt_info=stmt_info;
 		CurrentQuery.start_time=thread->curtime;
+		// no digest is computed for 'COM_STMT_EXECUTE', the one of the statement is used
+		CurrentQuery.stages_begin();
 
 		timespec begint;
 		timespec endt;
@@ -3332,6 +3424,7 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 			clock_gettime(CLOCK_THREAD_CPUTIME_ID,&begint);
 		}
 		qpo= GloMyQPro->process_query(this,NULL,0,&CurrentQuery);
+		CurrentQuery.stage_mark(query_stage_query_processor);
 		if (qpo->max_lag_ms >= 0) {
 			thread->status_variables.stvar[st_var_queries_with_max_lag_ms]++;
 		}
@@ -4049,7 +4142,9 @@ __get_pkts_from_client:
 									if (session_fast_forward == SESSION_FORWARD_TYPE_NONE) {
 										// Note: CurrentQuery sees the query as sent by the client.
 										// shortly after, the packets it used to contain the query will be deallocated
+										CurrentQuery.stages_begin();
 										CurrentQuery.begin((unsigned char *)pkt.ptr,pkt.size,true);
+										CurrentQuery.stage_mark(query_stage_digest);
 									}
 									rc_break=handler_special_queries(&pkt);
 									if (rc_break==true) {
@@ -4070,6 +4165,7 @@ __get_pkts_from_client:
 										clock_gettime(CLOCK_THREAD_CPUTIME_ID,&begint);
 									}
 									qpo= GloMyQPro->process_query(this,pkt.ptr,pkt.size,&CurrentQuery);
+									CurrentQuery.stage_mark(query_stage_query_processor);
 									if (thread->variables.stats_time_query_processor) {
 										clock_gettime(CLOCK_THREAD_CPUTIME_ID,&endt);
 										thread->status_variables.stvar[st_var_query_processor_time]=thread->status_variables.stvar[st_var_query_processor_time] +
@@ -4333,7 +4429,7 @@ void MySQL_Session::SetQueryTimeout() {
 // false: continue
 bool MySQL_Session::handler_rc0_PROCESSING_STMT_PREPARE(enum session_status& st, MySQL_Data_Stream *myds, bool& prepared_stmt_with_no_params) {
 	thread->status_variables.stvar[st_var_backend_stmt_prepare]++;
-	GloMyStmt->wrlock();
+	GloMyStmt->rdlock();
 	uint32_t client_stmtid=0;
 	uint64_t global_stmtid;
 	//bool is_new;
@@ -4347,12 +4443,15 @@ bool MySQL_Session::handler_rc0_PROCESSING_STMT_PREPARE(enum session_status& st,
 		CurrentQuery.mysql_stmt,
 		false);
 	if (CurrentQuery.QueryParserArgs.digest_text) {
+		// GloMyStmt is only read locked: other threads may be preparing the same statement
+		pthread_rwlock_wrlock(&stmt_info->rwlock_);
 		if (stmt_info->digest_text==NULL) {
 			stmt_info->digest_text=strdup(CurrentQuery.QueryParserArgs.digest_text);
 			stmt_info->digest=CurrentQuery.QueryParserArgs.digest;	// copy digest
 			stmt_info->MyComQueryCmd=CurrentQuery.MyComQueryCmd; // copy MyComQueryCmd
 			stmt_info->calculate_mem_usage();
 		}
+		pthread_rwlock_unlock(&stmt_info->rwlock_);
 	}
 	global_stmtid=stmt_info->statement_id;
 	myds->myconn->local_stmts->backend_insert(global_stmtid,CurrentQuery.mysql_stmt);
@@ -4397,8 +4496,8 @@ void MySQL_Session::handler_rc0_PROCESSING_STMT_EXECUTE(MySQL_Data_Stream *myds)
 		// metadata cache is only hit once. This way we ensure that the next
 		// 'PREPARE' will be answered with the properly updated metadata.
 		/********************************************************************/
-		// Lock the global statement manager
-		GloMyStmt->wrlock();
+		// Lock the global statement manager (update_metadata() locks the statement itself)
+		GloMyStmt->rdlock();
 		// Update the global prepared statement metadata
 		MySQL_STMT_Global_info *stmt_info = GloMyStmt->find_prepared_statement_by_stmt_id(CurrentQuery.stmt_global_id, false);
 		stmt_info->update_metadata(CurrentQuery.mysql_stmt);
@@ -4711,6 +4810,10 @@ void MySQL_Session::handler_rc0_Process_GTID(MySQL_Connection *myconn) {
 			gtid_hid = current_hostgroup;
 			memcpy(gtid_buf,mybe->gtid_uuid,sizeof(gtid_buf));
 		}
+		if (mysql_thread___gtid_read_your_writes) {
+			last_write_gtid_hid = current_hostgroup;
+			memcpy(last_write_gtid,mybe->gtid_uuid,sizeof(last_write_gtid));
+		}
 	}
 }
 
@@ -4880,6 +4983,7 @@ handler_again:
 				MySQL_Data_Stream *myds=mybe->server_myds;
 				MySQL_Connection *myconn=myds->myconn;
 				mybe->server_myds->max_connect_time=0;
+				CurrentQuery.stage_mark(query_stage_connpool);
 				// we insert it in mypolls only if not already there
 				if (myds->mypolls==NULL) {
 					thread->mypolls.add(POLLIN|POLLOUT, mybe->server_myds->fd, mybe->server_myds, thread->curtime);
@@ -4961,6 +5065,7 @@ handler_again:
 
 				if (myconn->async_state_machine==ASYNC_IDLE) {
 					SetQueryTimeout();
+					CurrentQuery.stage_mark(query_stage_backend_sync);
 				}
 				int rc;
 				// declares two timespec variables begint and endt to store the start and end times of the query execution.
@@ -4985,6 +5090,7 @@ handler_again:
 				}
 				gtid_hid = -1;
 				if (rc==0) {
+					CurrentQuery.stage_mark(query_stage_backend);
 
 					if (active_transactions != 0) {  // run this only if currently we think there is a transaction
 						handler_rc0_RefreshActiveTransactions(myconn);
@@ -5009,8 +5115,10 @@ handler_again:
 							if (myconn->mysql->affected_rows != ULLONG_MAX) {
 								last_HG_affected_rows = current_hostgroup;
 								if (mysql_thread___auto_increment_delay_multiplex && myconn->mysql->insert_id) {
-									myconn->auto_increment_delay_token = mysql_thread___auto_increment_delay_multiplex + 1;
-									__sync_fetch_and_add(&MyHGM->status.auto_increment_delay_multiplex, 1);
+									if (multiplex_affinity_release(MUX_AFFINITY_LAST_INSERT_ID, true) == false) {
+										myconn->auto_increment_delay_token = mysql_thread___auto_increment_delay_multiplex + 1;
+										__sync_fetch_and_add(&MyHGM->status.auto_increment_delay_multiplex, 1);
+									}
 								}
 							}
 						}
@@ -5060,6 +5168,7 @@ handler_again:
 				} else {
 					if (rc==-1) {
 						// the query failed
+						CurrentQuery.stage_mark(query_stage_backend);
 						int myerr=mysql_errno(myconn->mysql);
 						char *errmsg = NULL;
 						if (myerr == 0) {
@@ -6710,6 +6819,22 @@ bool MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 	if (CurrentQuery.QueryParserArgs.digest_text) {
 		char *dig=CurrentQuery.QueryParserArgs.digest_text;
 		if (strcasestr(dig,"LAST_INSERT_ID") || strcasestr(dig,"@@IDENTITY")) {
+			// simple "SELECT LAST_INSERT_ID()" or "SELECT @@IDENTITY" , that we can answer without the backend
+			//handle 2564
+			const bool simple_last_insert_id = (
+				(pkt->size==SELECT_LAST_INSERT_ID_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID,(char *)pkt->ptr+5,pkt->size-5)==0)
+				||
+				(pkt->size==SELECT_LAST_INSERT_ID_FROM_DUAL_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID_FROM_DUAL,(char *)pkt->ptr+5,pkt->size-5)==0)
+				||
+				(pkt->size==SELECT_LAST_INSERT_ID_LIMIT1_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID_LIMIT1,(char *)pkt->ptr+5,pkt->size-5)==0)
+                ||
+                (pkt->size==SELECT_VARIABLE_IDENTITY_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_VARIABLE_IDENTITY,(char *)pkt->ptr+5,pkt->size-5)==0)
+                ||
+                (pkt->size==SELECT_VARIABLE_IDENTITY_LIMIT1_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_VARIABLE_IDENTITY_LIMIT1,(char *)pkt->ptr+5,pkt->size-5)==0)
+			);
+			if (simple_last_insert_id == false) {
+				multiplex_affinity_dependent(MUX_AFFINITY_LAST_INSERT_ID);
+			}
 			// we need to try to execute it where the last write was successful
 			if (last_HG_affected_rows >= 0) {
 				MySQL_Backend * _mybe = NULL;
@@ -6728,20 +6853,8 @@ bool MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 				}
 			}
 			// if we reached here, we don't know the right backend
-			// we try to determine if it is a simple "SELECT LAST_INSERT_ID()" or "SELECT @@IDENTITY" and we return mysql->last_insert_id
-
-			//handle 2564
-			if (
-				(pkt->size==SELECT_LAST_INSERT_ID_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID,(char *)pkt->ptr+5,pkt->size-5)==0)
-				||
-				(pkt->size==SELECT_LAST_INSERT_ID_FROM_DUAL_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID_FROM_DUAL,(char *)pkt->ptr+5,pkt->size-5)==0)
-				||
-				(pkt->size==SELECT_LAST_INSERT_ID_LIMIT1_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_LAST_INSERT_ID_LIMIT1,(char *)pkt->ptr+5,pkt->size-5)==0)
-                ||
-                (pkt->size==SELECT_VARIABLE_IDENTITY_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_VARIABLE_IDENTITY,(char *)pkt->ptr+5,pkt->size-5)==0)
-                ||
-                (pkt->size==SELECT_VARIABLE_IDENTITY_LIMIT1_LEN+5 && *((char *)(pkt->ptr)+4)==(char)0x03 && strncasecmp((char *)SELECT_VARIABLE_IDENTITY_LIMIT1,(char *)pkt->ptr+5,pkt->size-5)==0)
-			) {
+			// if it is a simple "SELECT LAST_INSERT_ID()" or "SELECT @@IDENTITY" we return mysql->last_insert_id
+			if (simple_last_insert_id) {
 				char buf[32];
 				sprintf(buf,"%llu",last_insert_id);
 				char buf2[32];
@@ -6804,6 +6917,9 @@ bool MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 	//}
 	if (qpo->cache_ttl>0 && ((prepare_stmt_type & ps_type_prepare_stmt) == 0)) {
 		bool deprecate_eof_active = client_myds->myconn->options.client_flag & CLIENT_DEPRECATE_EOF;
+		if (mysql_thread___query_cache_table_invalidation) {
+			query_cache_track_tables();
+		}
 		uint32_t resbuf=0;
 		unsigned char *aa= GloMyQC->get(
 			client_myds->myconn->userinfo->hash,
@@ -7006,6 +7122,10 @@ void MySQL_Session::handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED
 		char * gtid_uuid=NULL;
 		uint64_t trxid = 0;
 		unsigned long long now_us = 0;
+		// a read following a write of the session, sent to a hostgroup different from the one of the write
+		bool read_your_writes = false;
+		// at least a server of the hostgroup has GTID tracking, only valid with 'read_your_writes'
+		bool read_your_writes_tracked = false;
 		if (qpo->max_lag_ms >= 0) {
 			if (qpo->max_lag_ms > 360000) { // this is an absolute time, we convert it to relative
 				if (now_us == 0) {
@@ -7030,6 +7150,16 @@ void MySQL_Session::handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED
 						with_gtid = true;
 					}
 				}
+			} else if (
+				mysql_thread___gtid_read_your_writes && last_write_gtid[0] && qpo->max_lag_ms < 0 &&
+				last_write_gtid_hid >= 0 && mybe->hostgroup_id != last_write_gtid_hid &&
+				locked_on_hostgroup < 0 && status != PROCESSING_STMT_PREPARE &&
+				CurrentQuery.is_select_NOT_for_update() &&
+				MyHGM->gtid_read_your_writes_pair(last_write_gtid_hid, mybe->hostgroup_id, &read_your_writes_tracked)
+			) {
+				gtid_uuid = last_write_gtid;
+				with_gtid = true;
+				read_your_writes = true;
 			}
 
 			char *sep_pos = NULL;
@@ -7128,9 +7258,35 @@ void MySQL_Session::handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED
 		if (mc) {
 			if (CurrentQuery.waiting_since) {
 				unsigned long long waited = thread->curtime - CurrentQuery.waiting_since;
-				thread->status_variables.stvar[st_var_queries_with_max_lag_ms__total_wait_time_us] += waited;
+				if (read_your_writes == false) {
+					thread->status_variables.stvar[st_var_queries_with_max_lag_ms__total_wait_time_us] += waited;
+				}
 				CurrentQuery.waiting_since = 0;
 			}
+		} else if (read_your_writes) {
+			// without GTID tracking on any server of the hostgroup the GTID can never be found there, waiting
+			// for 'gtid_read_your_writes_timeout_ms' would only delay the query
+			const bool gtid_tracked = CurrentQuery.waiting_since != 0 || read_your_writes_tracked;
+			if (gtid_tracked && CurrentQuery.waiting_since == 0) {
+				CurrentQuery.waiting_since = thread->curtime;
+				thread->status_variables.stvar[st_var_gtid_read_your_writes_delayed]++;
+			} else if (
+				gtid_tracked == false ||
+				thread->curtime - CurrentQuery.waiting_since >= (unsigned long long)mysql_thread___gtid_read_your_writes_timeout_ms * 1000
+			) {
+				// no server of the hostgroup executed the GTID in time: the query is sent to the
+				// hostgroup of the write, the connection is retrieved on the next attempt
+				proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Sess=%p -- GTID %s not found in hostgroup %d , sending the query to hostgroup %d\n", this, last_write_gtid, mybe->hostgroup_id, last_write_gtid_hid);
+				thread->status_variables.stvar[st_var_gtid_read_your_writes_fallback]++;
+				CurrentQuery.waiting_since = 0;
+				const unsigned long long max_connect_time = mybe->server_myds->max_connect_time;
+				current_hostgroup = last_write_gtid_hid;
+				mybe = find_or_create_backend(current_hostgroup);
+				if (mybe->server_myds->max_connect_time == 0) {
+					mybe->server_myds->max_connect_time = max_connect_time;
+				}
+				return;
+			}
 		}
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Sess=%p -- server_myds=%p -- MySQL_Connection %p\n", this, mybe->server_myds,  mybe->server_myds->myconn);
 	if (mybe->server_myds->myconn==NULL) {
@@ -7232,7 +7388,8 @@ void MySQL_Session::MySQL_Result_to_MySQL_wire(MYSQL *mysql, MySQL_ResultSet *My
 		bool com_field_list=client_myds->com_field_list;
 		assert(resultset_completed); // the resultset should always be completed if MySQL_Result_to_MySQL_wire is called
 		if (transfer_started==false) { // we have all the resultset when MySQL_Result_to_MySQL_wire was called
-			if (qpo && qpo->cache_ttl>0 && com_field_list==false) { // the resultset should be cached
+			if (qpo && qpo->cache_ttl>0 && com_field_list==false &&
+				(mysql_thread___query_cache_table_invalidation==false || qc_invalidation.tracked)) { // the resultset should be cached
 				if (mysql_errno(mysql)==0 &&
 					(mysql_warning_count(mysql)==0 || 
 					 mysql_thread___query_cache_handle_warnings==1)) { // no errors
@@ -7258,7 +7415,8 @@ void MySQL_Session::MySQL_Result_to_MySQL_wire(MYSQL *mysql, MySQL_ResultSet *My
 							thread->curtime/1000 ,
 							thread->curtime/1000 ,
 							thread->curtime/1000 + qpo->cache_ttl,
-							deprecate_eof_active
+							deprecate_eof_active,
+							(qc_invalidation.tracked ? &qc_invalidation.tables : NULL)
 						);
 						//l_free(client_myds->resultset_length,aa);
 						client_myds->resultset_length=0;
@@ -7415,17 +7573,48 @@ void MySQL_Session::LogQuery(MySQL_Data_Stream *myds) {
 
 	if (qpo) {
 		if (qpo->log==1) {
-			GloMyLogger->log_request(this, myds);	// we send for logging only if logging is enabled for this query
+			if (LogQuery_sampled()) {
+				GloMyLogger->log_request(this, myds);	// we send for logging only if logging is enabled for this query
+			}
 		} else {
 			if (qpo->log==-1) {
-				if (mysql_thread___eventslog_default_log==1) {
+				if (mysql_thread___eventslog_default_log==1 && LogQuery_sampled()) {
 					GloMyLogger->log_request(this, myds);	// we send for logging only if enabled by default
 				}
 			}
 		}
 	}
 }
+
+bool MySQL_Session::LogQuery_sampled() {
+	if (mysql_thread___eventslog_slow_query_threshold > 0) {
+		if (CurrentQuery.end_time - CurrentQuery.start_time >= (unsigned long long)mysql_thread___eventslog_slow_query_threshold*1000) {
+			return true;
+		}
+	}
+	if (mysql_thread___eventslog_sample_rate > 1) {
+		// 'fastrand()' returns 15 bits, two calls cover the whole range of the variable
+		const unsigned int r = ((unsigned int)fastrand() << 15) | (unsigned int)fastrand();
+		if (r % (unsigned int)mysql_thread___eventslog_sample_rate != 0) {
+			return false;
+		}
+	}
+	if (mysql_thread___eventslog_digest_rate_limit > 0) {
+		uint64_t digest = 0;
+		if (status != PROCESSING_STMT_EXECUTE) {
+			digest = GloMyQPro->get_digest(&CurrentQuery.QueryParserArgs);
+		} else {
+			digest = CurrentQuery.stmt_info->digest;
+		}
+		if (GloMyLogger->digest_rate_limiter.consume(digest, thread->curtime, mysql_thread___eventslog_digest_rate_limit) == false) {
+			return false;
+		}
+	}
+	return true;
+}
 void MySQL_Session::RequestEnd(MySQL_Data_Stream *myds) {
+	concurrency_limit_release();
+
 	// check if multiplexing needs to be disabled
 	char *qdt = NULL;
 
@@ -7435,10 +7624,23 @@ void MySQL_Session::RequestEnd(MySQL_Data_Stream *myds) {
 		qdt = CurrentQuery.stmt_info->digest_text;
 	}
 
+	bool had_found_rows = false;
 	if (qdt && myds && myds->myconn) {
+		had_found_rows = myds->myconn->get_status(STATUS_MYSQL_CONNECTION_FOUND_ROWS);
 		myds->myconn->ProcessQueryAndSetStatusFlags(qdt);
 	}
 
+	multiplex_affinity_track(qdt);
+	if (mysql_thread___query_cache_table_invalidation || qc_invalidation.pending.empty() == false) {
+		query_cache_invalidate_tables(qdt);
+	}
+	qc_invalidation.tracked = false;
+	if (qdt && myds && myds->myconn && had_found_rows == false && myds->myconn->get_status(STATUS_MYSQL_CONNECTION_FOUND_ROWS)) {
+		if (multiplex_affinity_release(MUX_AFFINITY_FOUND_ROWS, false)) {
+			myds->myconn->set_status(false, STATUS_MYSQL_CONNECTION_FOUND_ROWS);
+		}
+	}
+
 	switch (status) {
 		case PROCESSING_STMT_EXECUTE:
 		case PROCESSING_STMT_PREPARE:
@@ -7458,6 +7660,8 @@ void MySQL_Session::RequestEnd(MySQL_Data_Stream *myds) {
 		if (myds->myconn) {
 			myds->myconn->async_free_result();
 			myds->myconn->compute_unknown_transaction_status();
+			// the query is over even if the connection didn't reach the end of it, e.g. after an error
+			myds->myconn->backend_query_ended();
 		}
 		myds->free_mysql_real_query();
 	}
@@ -7476,6 +7680,232 @@ void MySQL_Session::RequestEnd(MySQL_Data_Stream *myds) {
 }
 
 
+bool MySQL_Session::multiplex_affinity_release(MUX_AFFINITY_kind kind, bool skip_current) {
+	if (mysql_thread___multiplex_affinity_learning == false) {
+		return false;
+	}
+	uint64_t digest = 0;
+	if (status != PROCESSING_STMT_EXECUTE) {
+		digest = GloMyQPro->get_digest(&CurrentQuery.QueryParserArgs);
+	} else {
+		digest = CurrentQuery.stmt_info->digest;
+	}
+	if (digest == 0) {
+		return false;
+	}
+	if (mux_affinity.digest && mux_affinity.kind == kind && mux_affinity.released == false) {
+		// a new statement of the same kind replaces the state the previous window was observing
+		MyHGM->multiplex_affinity.record_window(mux_affinity.digest, kind, mux_affinity.dependent);
+	}
+	const bool released = MyHGM->multiplex_affinity.releasable(digest, kind, mysql_thread___multiplex_affinity_min_samples);
+	mux_affinity.digest = digest;
+	mux_affinity.kind = kind;
+	mux_affinity.remaining = mysql_thread___auto_increment_delay_multiplex > 0 ? mysql_thread___auto_increment_delay_multiplex : 1;
+	mux_affinity.released = released;
+	mux_affinity.dependent = false;
+	mux_affinity.skip_current = skip_current;
+	if (released) {
+		__sync_fetch_and_add(&MyHGM->status.multiplex_affinity_released, 1);
+	}
+	return released;
+}
+
+void MySQL_Session::multiplex_affinity_dependent(MUX_AFFINITY_kind kind) {
+	if (mux_affinity.digest == 0 || mux_affinity.kind != kind) {
+		return;
+	}
+	if (mux_affinity.released) {
+		// the connection was already returned to the connection pool, the digest is pinned again from now on
+		__sync_fetch_and_add(&MyHGM->status.multiplex_affinity_repinned, 1);
+	}
+	MyHGM->multiplex_affinity.record_window(mux_affinity.digest, kind, true);
+	mux_affinity.digest = 0;
+}
+
+void MySQL_Session::multiplex_affinity_track(const char *qdt) {
+	if (mux_affinity.digest == 0) {
+		return;
+	}
+	if (mux_affinity.skip_current) {
+		// the statement that opened the window
+		mux_affinity.skip_current = false;
+		return;
+	}
+	if (mux_affinity.kind == MUX_AFFINITY_FOUND_ROWS && qdt && strcasestr(qdt, "FOUND_ROWS(")) {
+		multiplex_affinity_dependent(MUX_AFFINITY_FOUND_ROWS);
+		return;
+	}
+	mux_affinity.remaining--;
+	if (mux_affinity.remaining <= 0) {
+		if (mux_affinity.released == false) {
+			MyHGM->multiplex_affinity.record_window(mux_affinity.digest, mux_affinity.kind, false);
+		}
+		mux_affinity.digest = 0;
+	}
+}
+
+bool MySQL_Session::query_cache_track_tables() {
+	qc_invalidation.tables.clear();
+	qc_invalidation.tracked = false;
+	const char *qdt = CurrentQuery.QueryParserArgs.digest_text;
+	if (qdt == NULL) {
+		return false;
+	}
+	// the digest text of a query longer than these limits is truncated, and may miss some tables
+	if (CurrentQuery.QueryLength >= mysql_thread___query_digests_max_query_length) {
+		return false;
+	}
+	if (mysql_thread___query_digests_stop_at_max_digest_length && CurrentQuery.QueryLength >= mysql_thread___query_digests_max_digest_length) {
+		return false;
+	}
+	std::vector<uint64_t> tables {};
+	qc_extract_tables(qdt, client_myds->myconn->userinfo->schemaname, &tables, NULL);
+	for (const uint64_t table : tables) {
+		qc_invalidation.tables.push_back({ table, 0 });
+	}
+	GloMyQC->get_tables_version(qc_invalidation.tables);
+	qc_invalidation.tracked = true;
+	return true;
+}
+
+void MySQL_Session::query_cache_invalidate_tables(const char *qdt) {
+	std::vector<uint64_t> tables {};
+	if (qdt && client_myds && mysql_thread___query_cache_table_invalidation) {
+		qc_extract_tables(qdt, client_myds->myconn->userinfo->schemaname, NULL, &tables);
+	}
+	if (NumActiveTransactions() > 0) {
+		if (tables.empty() == false) {
+			qc_invalidation.pending.insert(qc_invalidation.pending.end(), tables.begin(), tables.end());
+			std::sort(qc_invalidation.pending.begin(), qc_invalidation.pending.end());
+			qc_invalidation.pending.erase(std::unique(qc_invalidation.pending.begin(), qc_invalidation.pending.end()), qc_invalidation.pending.end());
+		}
+	} else if (qc_invalidation.pending.empty() == false) {
+		tables.insert(tables.end(), qc_invalidation.pending.begin(), qc_invalidation.pending.end());
+		qc_invalidation.pending.clear();
+	}
+	if (tables.empty() == false) {
+		GloMyQC->invalidate_tables(tables);
+	}
+}
+
+int MySQL_Session::get_user_max_concurrency() {
+	if (user_attributes == NULL || user_attributes[0] == '\0') {
+		return -1;
+	}
+	if (concurrency_limit.user_attributes != user_attributes) {
+		// parsed again only if the attributes of the user changed
+		concurrency_limit.user_attributes = user_attributes;
+		concurrency_limit.user_limit = -1;
+		if (strstr(user_attributes, "max_concurrent_queries")) {
+			nlohmann::json j_user_attributes = nlohmann::json::parse(user_attributes, nullptr, false);
+			if (j_user_attributes.is_object()) {
+				auto max_concurrent_queries = j_user_attributes.find("max_concurrent_queries");
+				if (max_concurrent_queries != j_user_attributes.end()) {
+					if (max_concurrent_queries->is_number_unsigned() && max_concurrent_queries->get<uint64_t>() > 0 && max_concurrent_queries->get<uint64_t>() <= INT_MAX) {
+						concurrency_limit.user_limit = max_concurrent_queries->get<int>();
+					} else {
+						proxy_error("Invalid max_concurrent_queries for user %s : %s\n", client_myds->myconn->userinfo->username, max_concurrent_queries->dump().c_str());
+					}
+				}
+			}
+		}
+	}
+	return concurrency_limit.user_limit;
+}
+
+int MySQL_Session::concurrency_limit_admit() {
+	if (concurrency_limit.admitted) {
+		return 0;
+	}
+	MySQL_Concurrency_Limiter& limiter = MyHGM->concurrency_limiter;
+	if (concurrency_limit.queued == false) {
+		concurrency_limit.limits[0] = (qpo && qpo->max_concurrency > 0) ? qpo->max_concurrency : -1;
+		concurrency_limit.limits[1] = get_user_max_concurrency();
+		concurrency_limit.slots[0] = -1;
+		concurrency_limit.slots[1] = -1;
+		if (concurrency_limit.limits[0] > 0) {
+			concurrency_limit.slots[0] = limiter.get_slot(MySQL_Concurrency_Limiter::rule_key(qpo->max_concurrency_rule_id, mybe->hostgroup_id));
+		}
+		if (concurrency_limit.limits[1] > 0) {
+			concurrency_limit.slots[1] = limiter.get_slot(MySQL_Concurrency_Limiter::user_key(client_myds->myconn->userinfo->username, mybe->hostgroup_id));
+		}
+	}
+	int acquired = 0;
+	for (; acquired < 2; acquired++) {
+		const int slot = concurrency_limit.slots[acquired];
+		if (slot < 0) {
+			continue;
+		}
+		const uint64_t ticket = (concurrency_limit.queue == acquired) ? concurrency_limit.ticket : 0;
+		if (limiter.try_acquire(slot, concurrency_limit.limits[acquired], ticket) == false) {
+			break;
+		}
+		if (ticket) {
+			// admitted, the ticket was removed from the queue
+			concurrency_limit.queue = -1;
+			concurrency_limit.ticket = 0;
+		}
+	}
+	if (acquired == 2) {
+		if (concurrency_limit.queued) {
+			concurrency_limit.queued = false;
+			thread->status_variables.stvar[st_var_concurrency_limit_wait_time_us] += thread->curtime - concurrency_limit.waiting_since;
+		}
+		concurrency_limit.admitted = true;
+		return 0;
+	}
+	// limits are acquired all or none
+	for (int i = 0; i < acquired; i++) {
+		if (concurrency_limit.slots[i] >= 0) {
+			limiter.release(concurrency_limit.slots[i]);
+		}
+	}
+	if (concurrency_limit.queued == false) {
+		if (mysql_thread___concurrency_limit_queue_timeout_ms == 0) {
+			thread->status_variables.stvar[st_var_concurrency_limit_rejected]++;
+			return -1;
+		}
+		concurrency_limit.queued = true;
+		concurrency_limit.waiting_since = thread->curtime;
+		thread->status_variables.stvar[st_var_concurrency_limit_queued]++;
+	} else if (thread->curtime - concurrency_limit.waiting_since >= (unsigned long long)mysql_thread___concurrency_limit_queue_timeout_ms * 1000) {
+		thread->status_variables.stvar[st_var_concurrency_limit_wait_time_us] += thread->curtime - concurrency_limit.waiting_since;
+		thread->status_variables.stvar[st_var_concurrency_limit_rejected]++;
+		concurrency_limit_release();
+		return -1;
+	}
+	// the query waits only in the queue of the slot whose limit was hit
+	if (concurrency_limit.queue != acquired) {
+		if (concurrency_limit.queue >= 0) {
+			limiter.dequeue(concurrency_limit.slots[concurrency_limit.queue], concurrency_limit.ticket);
+		}
+		concurrency_limit.queue = acquired;
+		concurrency_limit.ticket = limiter.enqueue(concurrency_limit.slots[acquired]);
+	}
+	return 1;
+}
+
+void MySQL_Session::concurrency_limit_release() {
+	if (concurrency_limit.admitted || concurrency_limit.queued) {
+		MySQL_Concurrency_Limiter& limiter = MyHGM->concurrency_limiter;
+		for (int i = 0; i < 2; i++) {
+			if (concurrency_limit.slots[i] >= 0) {
+				if (concurrency_limit.admitted) {
+					limiter.release(concurrency_limit.slots[i]);
+				} else if (concurrency_limit.queue == i) {
+					limiter.dequeue(concurrency_limit.slots[i], concurrency_limit.ticket);
+				}
+			}
+			concurrency_limit.slots[i] = -1;
+		}
+	}
+	concurrency_limit.admitted = false;
+	concurrency_limit.queued = false;
+	concurrency_limit.queue = -1;
+	concurrency_limit.ticket = 0;
+	concurrency_limit.waiting_since = 0;
+}
+
 // this function tries to report all the memory statistics related to the sessions
 void MySQL_Session::Memory_Stats() {
 	if (thread==NULL)
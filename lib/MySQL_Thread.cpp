@@ -111,6 +111,7 @@ extern MySQL_Authentication *GloMyAuth;
 extern MySQL_Threads_Handler *GloMTH;
 extern MySQL_Monitor *GloMyMon;
 extern MySQL_Logger *GloMyLogger;
+extern MySQL_STMT_Manager_v14 *GloMyStmt;
 
 typedef struct mythr_st_vars {
 	enum MySQL_Thread_status_variable v_idx;
@@ -126,6 +127,23 @@ typedef struct mythr_g_st_vars {
 	uint32_t conv;
 } mythr_g_st_vars_t;
 
+const char* mysql_query_stage_names[query_stage___END] {
+	"digest",
+	"query_processor",
+	"connpool",
+	"backend_sync",
+	"backend",
+	"result",
+	"total",
+};
+
+/**
+ * @brief Upper bounds, in seconds, of the buckets of the 'proxysql_mysql_query_stage_seconds' histograms.
+ */
+static const prometheus::Histogram::BucketBoundaries query_stages_p_buckets {
+	0.000001, 0.000005, 0.00001, 0.00005, 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10
+};
+
 // Note: the order here is not important. 
 mythr_st_vars_t MySQL_Thread_status_variables_counter_array[] {
 	{ st_var_backend_stmt_prepare, p_th_counter::com_backend_stmt_prepare, (char *)"Com_backend_stmt_prepare" },
@@ -138,6 +156,11 @@ mythr_st_vars_t MySQL_Thread_status_variables_counter_array[] {
 	{ st_var_queries_slow,          p_th_counter::slow_queries,            (char *)"Slow_queries" },
 	{ st_var_queries_gtid,          p_th_counter::gtid_consistent_queries, (char *)"GTID_consistent_queries" },
 	{ st_var_gtid_session_collected,p_th_counter::gtid_session_collected,  (char *)"GTID_session_collected" },
+	{ st_var_gtid_read_your_writes_delayed,  p_th_counter::gtid_read_your_writes_delayed,  (char *)"GTID_read_your_writes_delayed" },
+	{ st_var_gtid_read_your_writes_fallback, p_th_counter::gtid_read_your_writes_fallback, (char *)"GTID_read_your_writes_fallback" },
+	{ st_var_concurrency_limit_queued,       p_th_counter::concurrency_limit_queued,       (char *)"Concurrency_limit_queued" },
+	{ st_var_concurrency_limit_rejected,     p_th_counter::concurrency_limit_rejected,     (char *)"Concurrency_limit_rejected" },
+	{ st_var_concurrency_limit_wait_time_us, p_th_counter::concurrency_limit_wait_time_us, (char *)"Concurrency_limit_wait_time_us" },
 	{ st_var_queries_backends_bytes_recv,  p_th_counter::queries_backends_bytes_recv,  (char *)"Queries_backends_bytes_recv" },
 	{ st_var_queries_backends_bytes_sent,  p_th_counter::queries_backends_bytes_sent,  (char *)"Queries_backends_bytes_sent" },
 	{ st_var_queries_frontends_bytes_recv, p_th_counter::queries_frontends_bytes_recv, (char *)"Queries_frontends_bytes_recv" },
@@ -165,6 +188,8 @@ mythr_st_vars_t MySQL_Thread_status_variables_counter_array[] {
 	{ st_var_max_connect_timeout_err,     p_th_counter::max_connect_timeouts,             (char *)"max_connect_timeouts" },
 	{ st_var_generated_pkt_err,           p_th_counter::generated_error_packets,          (char *)"generated_error_packets" },
 	{ st_var_client_host_error_killed_connections, p_th_counter::client_host_error_killed_connections, (char *)"client_host_error_killed_connections" },
+	{ st_var_send_buffer_copied_bytes,    p_th_counter::send_buffer_copied_bytes,         (char *)"Send_buffer_copied_bytes" },
+	{ st_var_writev_bytes_sent,           p_th_counter::writev_bytes_sent,                (char *)"Writev_bytes_sent" },
 };
 
 mythr_g_st_vars_t MySQL_Thread_status_variables_gauge_array[] {
@@ -351,10 +376,14 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"enable_client_deprecate_eof",
 	(char *)"enable_server_deprecate_eof",
 	(char *)"enable_load_data_local_infile",
+	(char *)"use_writev",
 	(char *)"eventslog_filename",
 	(char *)"eventslog_filesize",
 	(char *)"eventslog_default_log",
 	(char *)"eventslog_format",
+	(char *)"eventslog_sample_rate",
+	(char *)"eventslog_slow_query_threshold",
+	(char *)"eventslog_digest_rate_limit",
 	(char *)"auditlog_filename",
 	(char *)"auditlog_filesize",
 	//(char *)"default_charset", // removed in 2.0.13 . Obsoleted previously using MySQL_Variables instead
@@ -426,8 +455,10 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"threshold_resultset_size",
 	(char *)"query_digests_max_digest_length",
 	(char *)"query_digests_max_query_length",
+	(char *)"query_digests_histograms_max",
 	(char *)"query_digests_grouping_limit",
 	(char *)"query_digests_groups_grouping_limit",
+	(char *)"query_digests_cache_size",
 	(char *)"query_rules_fast_routing_algorithm",
 	(char *)"wait_timeout",
 	(char *)"throttle_max_bytes_per_second_to_client",
@@ -447,6 +478,9 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"reset_connection_algorithm",
 	(char *)"auto_increment_delay_multiplex",
 	(char *)"auto_increment_delay_multiplex_timeout_ms",
+	(char *)"multiplex_affinity_learning",
+	(char *)"multiplex_affinity_min_samples",
+	(char *)"concurrency_limit_queue_timeout_ms",
 	(char *)"long_query_time",
 	(char *)"query_cache_size_MB",
 	(char *)"query_cache_soft_ttl_pct",
@@ -462,7 +496,10 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"default_authentication_plugin",
 	(char *)"kill_backend_connection_when_disconnect",
 	(char *)"client_session_track_gtid",
+	(char *)"gtid_read_your_writes",
+	(char *)"gtid_read_your_writes_timeout_ms",
 	(char *)"sessions_sort",
+	(char *)"sessions_ready_list",
 #ifdef IDLE_THREADS
 	(char *)"session_idle_show_processlist",
 #endif // IDLE_THREADS
@@ -475,6 +512,7 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"query_digests_normalize_digest_text",
 	(char *)"query_digests_track_hostname",
 	(char *)"query_digests_keep_comment",
+	(char *)"query_digests_stop_at_max_digest_length",
 	(char *)"parse_failure_logs_digest",
 	(char *)"servers_stats",
 	(char *)"default_reconnect",
@@ -499,7 +537,9 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"aurora_max_lag_ms_only_read_from_replicas",
 	(char *)"stats_time_backend_query",
 	(char *)"stats_time_query_processor",
+	(char *)"stats_time_query_stages",
 	(char *)"query_cache_stores_empty_result",
+	(char *)"query_cache_table_invalidation",
 	(char *)"data_packets_history_size",
 	(char *)"handle_warnings",
 	(char *)"evaluate_replication_lag_on_servers_load",
@@ -671,6 +711,36 @@ th_metrics_map = std::make_tuple(
 			"Total queries with GTID session state.",
 			metric_tags {}
 		),
+		std::make_tuple (
+			p_th_counter::gtid_read_your_writes_delayed,
+			"proxysql_gtid_read_your_writes_delayed_total",
+			"Reads delayed because no server of the hostgroup had yet executed the last GTID written by the session (see 'mysql-gtid_read_your_writes').",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::gtid_read_your_writes_fallback,
+			"proxysql_gtid_read_your_writes_fallback_total",
+			"Reads sent to the hostgroup of the last write after waiting 'mysql-gtid_read_your_writes_timeout_ms', or immediately when no server of the hostgroup has GTID tracking.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::concurrency_limit_queued,
+			"proxysql_concurrency_limit_queued_total",
+			"Queries queued because the concurrency limit of their query rule or user was reached.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::concurrency_limit_rejected,
+			"proxysql_concurrency_limit_rejected_total",
+			"Queries rejected after waiting 'mysql-concurrency_limit_queue_timeout_ms' for their concurrency limit.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::concurrency_limit_wait_time_us,
+			"proxysql_concurrency_limit_wait_time_total",
+			"Total time waited by the queries queued for their concurrency limit, in microseconds.",
+			metric_tags {}
+		),
 
 		// ====================================================================
 		std::make_tuple (
@@ -800,6 +870,18 @@ th_metrics_map = std::make_tuple(
 			"proxysql_client_host_error_killed_connections",
 			"Killed client connections because address exceeded 'client_host_error_counts'.",
 			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::send_buffer_copied_bytes,
+			"proxysql_send_buffer_copied_bytes_total",
+			"Bytes copied from the outgoing packets into the send buffers before being written to the network.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::writev_bytes_sent,
+			"proxysql_writev_bytes_sent_total",
+			"Bytes written to the network directly from the outgoing packets, without copies (see 'mysql-use_writev').",
+			metric_tags {}
 		)
 	},
 	th_gauge_vector {
@@ -1036,6 +1118,7 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.threshold_resultset_size=4*1024*1024;
 	variables.query_digests_max_digest_length=2*1024;
 	variables.query_digests_max_query_length=65000; // legacy default
+	variables.query_digests_histograms_max=10000;
 	variables.query_rules_fast_routing_algorithm=1;
 	variables.wait_timeout=8*3600*1000;
 	variables.throttle_max_bytes_per_second_to_client=0;
@@ -1056,6 +1139,9 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.reset_connection_algorithm=2;
 	variables.auto_increment_delay_multiplex=5;
 	variables.auto_increment_delay_multiplex_timeout_ms=10000;
+	variables.multiplex_affinity_learning=false;
+	variables.multiplex_affinity_min_samples=100;
+	variables.concurrency_limit_queue_timeout_ms=5000;
 	variables.long_query_time=1000;
 	variables.query_cache_size_MB=256;
 	variables.query_cache_soft_ttl_pct=0;
@@ -1077,6 +1163,9 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.eventslog_filesize=100*1024*1024;
 	variables.eventslog_default_log=0;
 	variables.eventslog_format=1;
+	variables.eventslog_sample_rate=1;
+	variables.eventslog_slow_query_threshold=0;
+	variables.eventslog_digest_rate_limit=0;
 	variables.auditlog_filename=strdup((char *)"");
 	variables.auditlog_filesize=100*1024*1024;
 	//variables.server_capabilities=CLIENT_FOUND_ROWS | CLIENT_PROTOCOL_41 | CLIENT_IGNORE_SIGPIPE | CLIENT_TRANSACTIONS | CLIENT_SECURE_CONNECTION | CLIENT_CONNECT_WITH_DB;
@@ -1100,16 +1189,22 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.query_digests_normalize_digest_text=false;
 	variables.query_digests_track_hostname=false;
 	variables.query_digests_keep_comment=false;
+	variables.query_digests_stop_at_max_digest_length=false;
 	variables.parse_failure_logs_digest=false;
 	variables.connpoll_reset_queue_length = 50;
 	variables.min_num_servers_lantency_awareness = 1000;
 	variables.aurora_max_lag_ms_only_read_from_replicas = 2;
 	variables.stats_time_backend_query=false;
 	variables.stats_time_query_processor=false;
+	variables.stats_time_query_stages=false;
 	variables.query_cache_stores_empty_result=true;
+	variables.query_cache_table_invalidation=false;
 	variables.kill_backend_connection_when_disconnect=true;
 	variables.client_session_track_gtid=true;
+	variables.gtid_read_your_writes=false;
+	variables.gtid_read_your_writes_timeout_ms=1000;
 	variables.sessions_sort=true;
+	variables.sessions_ready_list=false;
 #ifdef IDLE_THREADS
 	variables.session_idle_ms=1;
 	variables.session_idle_show_processlist=true;
@@ -1133,9 +1228,11 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 #endif /*debug */
 	variables.query_digests_grouping_limit = 3;
 	variables.query_digests_groups_grouping_limit= 10; // changed in 2.6.0 , was 0
+	variables.query_digests_cache_size=4096;
 	variables.enable_client_deprecate_eof=true;
 	variables.enable_server_deprecate_eof=true;
 	variables.enable_load_data_local_infile=false;
+	variables.use_writev=true;
 	variables.log_mysql_warnings_enabled=false;
 	variables.data_packets_history_size=0;
 	variables.protocol_compression_level=3;
@@ -1147,6 +1244,20 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	// Initialize prometheus metrics
 	init_prometheus_counter_array<th_metrics_map_idx, p_th_counter>(th_metrics_map, this->status_variables.p_counter_array);
 	init_prometheus_gauge_array<th_metrics_map_idx, p_th_gauge>(th_metrics_map, this->status_variables.p_gauge_array);
+	{
+		auto& query_stages_family = prometheus::BuildHistogram()
+			.Name("proxysql_mysql_query_stage_seconds")
+			.Help("Latency of each stage of the processing of a query (see 'mysql-stats_time_query_stages').")
+			.Register(*GloVars.prometheus_registry);
+		for (int i = 0; i < query_stage___END; i++) {
+			status_variables.p_query_stages_array[i] = std::addressof(
+				query_stages_family.Add({{ "stage", mysql_query_stage_names[i] }}, query_stages_p_buckets)
+			);
+			status_variables.p_query_stages_exported[i].resize(query_stages_p_buckets.size() + 2, 0);
+		}
+	}
+	// timestamps used by 'mysql-stats_time_query_stages'
+	ticks_calibrate();
 
 	// Init client_host_cache mutex
 	pthread_mutex_init(&mutex_client_host_cache, NULL);
@@ -1738,7 +1849,7 @@ bool MySQL_Threads_Handler::set_variable(char *name, const char *value) {	// thi
 	}
 	if (!strcasecmp(name,"eventslog_format")) {
 		int intv=atoi(value);
-		if (intv >= 1 && intv <= 2) {
+		if (intv >= 1 && intv <= 3) {
 			if (variables.eventslog_format!=intv) {
 				// if we are switching format, we need to switch file too
 				if (GloMyLogger) {
@@ -2131,11 +2242,13 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_bool["automatic_detect_sqli"]           = make_tuple(&variables.automatic_detect_sqli,           false);
 		VariablesPointers_bool["client_session_track_gtid"]       = make_tuple(&variables.client_session_track_gtid,       false);
 		VariablesPointers_bool["commands_stats"]                  = make_tuple(&variables.commands_stats,                  false);
+		VariablesPointers_bool["gtid_read_your_writes"]           = make_tuple(&variables.gtid_read_your_writes,           false);
 		VariablesPointers_bool["connection_warming"]              = make_tuple(&variables.connection_warming,              false);
 		VariablesPointers_bool["default_reconnect"]               = make_tuple(&variables.default_reconnect,               false);
 		VariablesPointers_bool["enable_client_deprecate_eof"]     = make_tuple(&variables.enable_client_deprecate_eof,     false);
 		VariablesPointers_bool["enable_server_deprecate_eof"]     = make_tuple(&variables.enable_server_deprecate_eof,     false);
 		VariablesPointers_bool["enable_load_data_local_infile"]   = make_tuple(&variables.enable_load_data_local_infile,   false);
+		VariablesPointers_bool["use_writev"]                      = make_tuple(&variables.use_writev,                      false);
 		VariablesPointers_bool["enforce_autocommit_on_reads"]     = make_tuple(&variables.enforce_autocommit_on_reads,     false);
 		VariablesPointers_bool["firewall_whitelist_enabled"]      = make_tuple(&variables.firewall_whitelist_enabled,      false);
 		VariablesPointers_bool["kill_backend_connection_when_disconnect"] = make_tuple(&variables.kill_backend_connection_when_disconnect, false);
@@ -2147,6 +2260,7 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_bool["monitor_writer_is_also_reader"]   = make_tuple(&variables.monitor_writer_is_also_reader,   false);
 		VariablesPointers_bool["multiplexing"]                    = make_tuple(&variables.multiplexing,                    false);
 		VariablesPointers_bool["query_cache_stores_empty_result"] = make_tuple(&variables.query_cache_stores_empty_result, false);
+		VariablesPointers_bool["query_cache_table_invalidation"]  = make_tuple(&variables.query_cache_table_invalidation,  false);
 		VariablesPointers_bool["query_digests"]                   = make_tuple(&variables.query_digests,                   false);
 		VariablesPointers_bool["query_digests_lowercase"]         = make_tuple(&variables.query_digests_lowercase,         false);
 		VariablesPointers_bool["query_digests_replace_null"]      = make_tuple(&variables.query_digests_replace_null,      false);
@@ -2154,11 +2268,15 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_bool["query_digests_normalize_digest_text"] = make_tuple(&variables.query_digests_normalize_digest_text, false);
 		VariablesPointers_bool["query_digests_track_hostname"]    = make_tuple(&variables.query_digests_track_hostname,    false);
 		VariablesPointers_bool["query_digests_keep_comment"]      = make_tuple(&variables.query_digests_keep_comment,      false);
+		VariablesPointers_bool["query_digests_stop_at_max_digest_length"] = make_tuple(&variables.query_digests_stop_at_max_digest_length, false);
 		VariablesPointers_bool["parse_failure_logs_digest"]       = make_tuple(&variables.parse_failure_logs_digest,       false);
 		VariablesPointers_bool["servers_stats"]                   = make_tuple(&variables.servers_stats,                   false);
 		VariablesPointers_bool["sessions_sort"]                   = make_tuple(&variables.sessions_sort,                   false);
+		VariablesPointers_bool["sessions_ready_list"]             = make_tuple(&variables.sessions_ready_list,             false);
+		VariablesPointers_bool["multiplex_affinity_learning"]     = make_tuple(&variables.multiplex_affinity_learning,     false);
 		VariablesPointers_bool["stats_time_backend_query"]        = make_tuple(&variables.stats_time_backend_query,        false);
 		VariablesPointers_bool["stats_time_query_processor"]      = make_tuple(&variables.stats_time_query_processor,      false);
+		VariablesPointers_bool["stats_time_query_stages"]         = make_tuple(&variables.stats_time_query_stages,         false);
 		VariablesPointers_bool["use_tcp_keepalive"]               = make_tuple(&variables.use_tcp_keepalive,               false);
 		VariablesPointers_bool["verbose_query_error"]             = make_tuple(&variables.verbose_query_error,             false);
 #ifdef IDLE_THREADS
@@ -2224,12 +2342,17 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		// query processor and query digest
 		VariablesPointers_int["auto_increment_delay_multiplex"]  = make_tuple(&variables.auto_increment_delay_multiplex,   0,     1000000, false);
 		VariablesPointers_int["auto_increment_delay_multiplex_timeout_ms"]  = make_tuple(&variables.auto_increment_delay_multiplex_timeout_ms,   0, 3600*1000, false);
+		VariablesPointers_int["multiplex_affinity_min_samples"]  = make_tuple(&variables.multiplex_affinity_min_samples,   1,     1000000, false);
+		VariablesPointers_int["concurrency_limit_queue_timeout_ms"] = make_tuple(&variables.concurrency_limit_queue_timeout_ms, 0, 3600*1000, false);
+		VariablesPointers_int["gtid_read_your_writes_timeout_ms"] = make_tuple(&variables.gtid_read_your_writes_timeout_ms, 0, 3600*1000, false);
 		VariablesPointers_int["default_query_delay"]             = make_tuple(&variables.default_query_delay,              0,   3600*1000, false);
 		VariablesPointers_int["default_query_timeout"]           = make_tuple(&variables.default_query_timeout,         1000,20*24*3600*1000, false);
 		VariablesPointers_int["query_digests_grouping_limit"]    = make_tuple(&variables.query_digests_grouping_limit,     1,        2089, false);
 		VariablesPointers_int["query_digests_groups_grouping_limit"] = make_tuple(&variables.query_digests_groups_grouping_limit, 0, 2089, false);
+		VariablesPointers_int["query_digests_cache_size"] = make_tuple(&variables.query_digests_cache_size, 0, 1048576, false);
 		VariablesPointers_int["query_digests_max_digest_length"] = make_tuple(&variables.query_digests_max_digest_length, 16, 1*1024*1024, false);
 		VariablesPointers_int["query_digests_max_query_length"]  = make_tuple(&variables.query_digests_max_query_length,  16, 1*1024*1024, false);
+		VariablesPointers_int["query_digests_histograms_max"]    = make_tuple(&variables.query_digests_histograms_max,     0,    1000000, false);
 		VariablesPointers_int["query_rules_fast_routing_algorithm"]  = make_tuple(&variables.query_rules_fast_routing_algorithm,  1, 2, false);
 		VariablesPointers_int["query_processor_iterations"]      = make_tuple(&variables.query_processor_iterations,       0,   1000*1000, false);
 		VariablesPointers_int["query_processor_regex"]           = make_tuple(&variables.query_processor_regex,            1,           2, false);
@@ -2276,6 +2399,9 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["auditlog_filesize"]     = make_tuple(&variables.auditlog_filesize,    1024*1024, 1*1024*1024*1024, false);
 		VariablesPointers_int["eventslog_filesize"]    = make_tuple(&variables.eventslog_filesize,   1024*1024, 1*1024*1024*1024, false);
 		VariablesPointers_int["eventslog_default_log"] = make_tuple(&variables.eventslog_default_log,        0,                1, false);
+		VariablesPointers_int["eventslog_sample_rate"] = make_tuple(&variables.eventslog_sample_rate,        1,        1000*1000, false);
+		VariablesPointers_int["eventslog_slow_query_threshold"] = make_tuple(&variables.eventslog_slow_query_threshold, 0, 20*24*3600*1000, false);
+		VariablesPointers_int["eventslog_digest_rate_limit"] = make_tuple(&variables.eventslog_digest_rate_limit, 0,    65535, false);
 		// various
 		VariablesPointers_int["long_query_time"]           = make_tuple(&variables.long_query_time,              0,  20*24*3600*1000, false);
 		VariablesPointers_int["max_allowed_packet"]        = make_tuple(&variables.max_allowed_packet,        8192,   1024*1024*1024, false);
@@ -3009,7 +3135,21 @@ void MySQL_Thread::poll_listener_del(int sock) {
 void MySQL_Thread::unregister_session(int idx) {
 	if (mysql_sessions==NULL) return;
 	proxy_debug(PROXY_DEBUG_NET,1,"Thread=%p, Session=%p -- Unregistered session\n", this, mysql_sessions->index(idx));
-	mysql_sessions->remove_index_fast(idx);
+	MySQL_Session *sess=(MySQL_Session *)mysql_sessions->remove_index_fast(idx);
+	sess->timeout_timer.cancel();
+	if (sess->in_ready_list) {
+		// not expected in the common case: sessions are taken out of the list before being processed
+		for (MySQL_Session *& ready_sess : ready_sessions) {
+			if (ready_sess == sess) {
+				ready_sess=NULL;
+			}
+		}
+		sess->in_ready_list=false;
+	}
+	if ((unsigned int)idx < mysql_sessions->len) {
+		// 'remove_index_fast()' moved the last session in place of the removed one
+		((MySQL_Session *)mysql_sessions->index(idx))->thread_session_idx=idx;
+	}
 }
 
 
@@ -3329,6 +3469,10 @@ __run_skip_1:
 			// house keeping
 			run___cleanup_mirror_queue();
 			GloMyQPro->update_query_processor_stats();
+			GloMyStmt->purge_unused_statements();
+		}
+		if (maintenance_loop == true) {
+			release_stale_firewall_caches<MySQL_Session>(GloMyQPro->get_firewall_whitelist_version());
 		}
 
 			if (rc == -1 && errno == EINTR)
@@ -3346,7 +3490,11 @@ __run_skip_1:
 			refresh_variables();
 		}
 
-		run_SetAllSession_ToProcess0<MySQL_Thread,MySQL_Session>();
+		if (ready_list_active) {
+			run_SetReadySessions_ToProcess0();
+		} else {
+			run_SetAllSession_ToProcess0<MySQL_Thread,MySQL_Session>();
+		}
 
 #ifdef IDLE_THREADS
 		// here we handle epoll_wait()
@@ -3760,9 +3908,29 @@ void MySQL_Thread::ProcessAllSessions_CompletedMirrorSession(unsigned int& n, My
  * @param total_active_transactions_ Reference to the total number of active transactions across all sessions.
  */
 void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned long long sess_time, unsigned int& total_active_transactions_) {
-	unsigned int numTrx=0;
 	total_active_transactions_ += sess->active_transactions;
 	sess->to_process=1;
+	ProcessAllSessions_CheckTimeouts(sess, sess_time);
+	ProcessAllSessions_CheckBackends(sess);
+}
+
+/**
+ * @brief Checks if a session in CONNECTING_CLIENT state exceeded 'mysql-connect_timeout_client', and if so
+ *   marks it as unhealthy.
+ */
+void MySQL_Thread::ProcessAllSessions_CheckConnectTimeout(MySQL_Session *sess) {
+	unsigned long long sess_time = sess->IdleTime();
+	if (sess_time/1000 > (unsigned long long)mysql_thread___connect_timeout_client) {
+		proxy_warning("Closing not established client connection %s:%d after %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
+		sess->healthy = 0;
+		if (mysql_thread___client_host_cache_size) {
+			GloMTH->update_client_host_cache(sess->client_myds->client_addr, true);
+		}
+	}
+}
+
+void MySQL_Thread::ProcessAllSessions_CheckTimeouts(MySQL_Session *sess, unsigned long long sess_time) {
+	unsigned int numTrx=0;
 	/**
 	 * @brief Handles session timeout conditions and associated actions.
 	 * 
@@ -3817,6 +3985,9 @@ void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsig
 			}
 		}
 	}
+}
+
+void MySQL_Thread::ProcessAllSessions_CheckBackends(MySQL_Session *sess) {
 	/**
 	 * @brief Handles server table version change and its associated actions.
 	 * 
@@ -3936,13 +4107,21 @@ void MySQL_Thread::process_all_sessions() {
 #ifdef IDLE_THREADS
 	bool idle_maintenance_thread=epoll_thread;
 #endif // IDLE_THREADS
-	int rc;
 	bool sess_sort=mysql_thread___sessions_sort;
+	bool ready_list=mysql_thread___sessions_ready_list;
 #ifdef IDLE_THREADS
 	if (idle_maintenance_thread) {
 		sess_sort=false;
+		ready_list=false;
 	}
 #endif // IDLE_THREADS
+	if (ready_list != ready_list_active) {
+		set_ready_list_active(ready_list);
+	}
+	if (ready_list_active) {
+		process_ready_sessions();
+		return;
+	}
 	if (sess_sort && mysql_sessions->len > 3) {
 		ProcessAllSessions_SortingSessions<MySQL_Session>();
 	}
@@ -3960,14 +4139,7 @@ void MySQL_Thread::process_all_sessions() {
 			}
 		}
 		if (sess->status == CONNECTING_CLIENT) {
-			unsigned long long sess_time = sess->IdleTime();
-			if (sess_time/1000 > (unsigned long long)mysql_thread___connect_timeout_client) {
-				proxy_warning("Closing not established client connection %s:%d after %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
-				sess->healthy = 0;
-				if (mysql_thread___client_host_cache_size) {
-					GloMTH->update_client_host_cache(sess->client_myds->client_addr, true);
-				}
-			}
+			ProcessAllSessions_CheckConnectTimeout(sess);
 		}
 		if (maintenance_loop) {
 			unsigned long long sess_time = sess->IdleTime();
@@ -3992,40 +4164,233 @@ void MySQL_Thread::process_all_sessions() {
 			// removing this logic in 2.0.15
 			//sess->active_transactions = -1;
 		}
-		if (unlikely(sess->healthy==0)) {
-			ProcessAllSessions_Healthy0(sess, n);
+		ProcessAllSessions_Session(sess, n);
+	}
+	if (maintenance_loop) {
+		unsigned int total_active_transactions_tmp;
+		total_active_transactions_tmp=__sync_add_and_fetch(&status_variables.active_transactions,0);
+		__sync_bool_compare_and_swap(&status_variables.active_transactions,total_active_transactions_tmp,total_active_transactions_);
+	}
+}
+
+/**
+ * @brief Runs the handler of a session that needs processing, and closes unhealthy and killed sessions.
+ *
+ * @param sess The session to process.
+ * @param n Index of the session in 'mysql_sessions', decremented if the session is unregistered.
+ * @return True if the session was unregistered and deleted, false otherwise.
+ */
+bool MySQL_Thread::ProcessAllSessions_Session(MySQL_Session *sess, unsigned int& n) {
+	int rc;
+	if (unlikely(sess->healthy==0)) {
+		ProcessAllSessions_Healthy0(sess, n);
+		return true;
+	}
+	if (sess->to_process==1) {
+		if (sess->pause_until <= curtime) {
+			rc=sess->handler();
+			//total_active_transactions_+=sess->active_transactions;
+			if (rc==-1 || sess->killed==true) {
+				char _buf[1024];
+				if (sess->client_myds && sess->killed)
+					proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
+				sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
+				GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
+				unregister_session(n);
+				n--;
+				delete sess;
+				return true;
+			}
+		}
+	} else {
+		if (unlikely(sess->killed==true)) {
+			// this is a special cause, if killed the session needs to be executed no matter if paused
+			sess->handler();
+			char _buf[1024];
+			if (sess->client_myds)
+				proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
+			sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
+			GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
+			unregister_session(n);
+			n--;
+			delete sess;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Adds a session to the ready list, processed by 'process_ready_sessions()' in the current loop.
+ * @details Doesn't change 'to_process': sessions added before poll() have it reset, in the same way
+ *   'run_SetAllSession_ToProcess0()' does for all the sessions when the ready list isn't in use.
+ */
+void MySQL_Thread::push_ready_session(MySQL_Session *sess) {
+	if (ready_list_active == false || sess->in_ready_list) {
+		return;
+	}
+	sess->in_ready_list=true;
+	ready_sessions.push_back(sess);
+}
+
+/**
+ * @brief Adds a session to the ready list if it has pending work: events or expired waits marked by
+ *   'process_data_on_data_stream()' and 'check_timing_out_session()', or the session being unhealthy.
+ */
+void MySQL_Thread::push_ready_session_if_pending(MySQL_Session *sess) {
+	if (ready_list_active == false || sess == NULL) {
+		return;
+	}
+	if (sess->to_process==1 || sess->healthy==0) {
+		push_ready_session(sess);
+	}
+}
+
+/**
+ * @brief Switches between processing all the sessions at every loop, and processing only the sessions in the
+ *   ready list, with the timeouts driven by 'sessions_timers'.
+ */
+void MySQL_Thread::set_ready_list_active(bool active) {
+	for (MySQL_Session *sess : ready_sessions) {
+		if (sess) {
+			sess->in_ready_list=false;
+		}
+	}
+	ready_sessions.clear();
+	ready_list_active=active;
+	for (unsigned int n=0; n<mysql_sessions->len; n++) {
+		MySQL_Session *sess=(MySQL_Session *)mysql_sessions->index(n);
+		sess->thread_session_idx=n;
+		if (active) {
+			// the first loop processes all the sessions, as without the ready list
+			push_ready_session(sess);
 		} else {
-			if (sess->to_process==1) {
-				if (sess->pause_until <= curtime) {
-					rc=sess->handler();
-					//total_active_transactions_+=sess->active_transactions;
-					if (rc==-1 || sess->killed==true) {
-						char _buf[1024];
-						if (sess->client_myds && sess->killed)
-							proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
-						sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
-						GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
-						unregister_session(n);
-						n--;
-						delete sess;
-					}
-				}
-			} else {
-				if (unlikely(sess->killed==true)) {
-					// this is a special cause, if killed the session needs to be executed no matter if paused
-					sess->handler();
-					char _buf[1024];
-					if (sess->client_myds)
-						proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
-					sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
-					GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
-					unregister_session(n);
-					n--;
-					delete sess;
-				}
+			sess->timeout_timer.cancel();
+		}
+	}
+	reschedule_session_timers=active;
+}
+
+/**
+ * @brief Resets 'to_process' of the sessions added to the ready list before poll().
+ */
+void MySQL_Thread::run_SetReadySessions_ToProcess0() {
+	for (MySQL_Session *sess : ready_sessions) {
+		if (sess) {
+			sess->to_process=0;
+		}
+	}
+}
+
+/**
+ * @brief Schedules the timer of a session at the earliest time one of its timeouts can expire.
+ * @details The deadline is computed from the current idle time and transaction age, which can only be
+ *   extended by the activity of the session: the timeouts are evaluated again when the timer expires, and the
+ *   timer rescheduled if none is reached. Sessions not idle are checked again after the shortest timeout.
+ */
+void MySQL_Thread::schedule_session_timeout(MySQL_Session *sess) {
+	const unsigned long long idle_ms = sess->IdleTime()/1000;
+	unsigned long long timeout_ms = (unsigned long long)mysql_thread___wait_timeout;
+	if ((unsigned long long)mysql_thread___max_transaction_idle_time < timeout_ms) {
+		timeout_ms = (unsigned long long)mysql_thread___max_transaction_idle_time;
+	}
+	if (sess->status == CONNECTING_CLIENT && (unsigned long long)mysql_thread___connect_timeout_client < timeout_ms) {
+		timeout_ms = (unsigned long long)mysql_thread___connect_timeout_client;
+	}
+	unsigned long long delay_ms = timeout_ms > idle_ms ? timeout_ms - idle_ms : 0;
+	// a transaction not started yet can't exceed 'max_transaction_time' before its full duration
+	unsigned long long trx_delay_ms = (unsigned long long)mysql_thread___max_transaction_time;
+	if (sess->active_transactions > 0 && sess->transaction_started_at > 0 && curtime > sess->transaction_started_at) {
+		const unsigned long long trx_ms = (curtime - sess->transaction_started_at)/1000;
+		trx_delay_ms = trx_delay_ms > trx_ms ? trx_delay_ms - trx_ms : 0;
+	}
+	if (trx_delay_ms < delay_ms) {
+		delay_ms = trx_delay_ms;
+	}
+	// the timeouts are exceeded only once strictly greater
+	sessions_timers.schedule(&sess->timeout_timer, curtime/1000 + delay_ms + 1);
+}
+
+/**
+ * @brief Evaluates the timeouts of a session whose timer expired: the session is added to the ready list if it
+ *   needs to be closed, otherwise its timer is rescheduled.
+ */
+void MySQL_Thread::session_timeout_expired(MySQL_Session *sess) {
+	if (sess->status == CONNECTING_CLIENT) {
+		ProcessAllSessions_CheckConnectTimeout(sess);
+	}
+	if (sess->healthy && sess->killed == false) {
+		ProcessAllSessions_CheckTimeouts(sess, sess->IdleTime());
+	}
+	if (sess->healthy==0 || sess->killed) {
+		push_ready_session(sess);
+	} else {
+		schedule_session_timeout(sess);
+	}
+}
+
+/**
+ * @brief Processes the sessions in the ready list, in place of 'process_all_sessions()'.
+ * @details The cost of a loop depends on the sessions with pending work, rather than on all the connected
+ *   ones: sessions are added to the ready list by the events handling, by their registration, and by the
+ *   expiration of their timer in 'sessions_timers'. The maintenance loop still visits all the sessions for
+ *   the checks on the backends and the count of the active transactions, but without processing them.
+ */
+void MySQL_Thread::process_ready_sessions() {
+	sessions_timers.advance(curtime/1000, [this] (Timer_Wheel_Entry *e) {
+		session_timeout_expired((MySQL_Session *)e->data);
+	});
+	if (reschedule_session_timers) {
+		reschedule_session_timers=false;
+		for (unsigned int n=0; n<mysql_sessions->len; n++) {
+			schedule_session_timeout((MySQL_Session *)mysql_sessions->index(n));
+		}
+	}
+	unsigned int total_active_transactions_=0;
+	if (maintenance_loop) {
+		for (unsigned int n=0; n<mysql_sessions->len; n++) {
+			MySQL_Session *sess=(MySQL_Session *)mysql_sessions->index(n);
+			total_active_transactions_ += sess->active_transactions;
+			ProcessAllSessions_CheckBackends(sess);
+			if (sess->hgs_expired_conns.empty() == false) {
+				sess->to_process=1;
+			}
+			if (sess->to_process==1 || sess->killed || sess->healthy==0) {
+				push_ready_session(sess);
 			}
 		}
 	}
+	// sessions registered while processing are appended, and processed in this same loop
+	for (size_t i=0; i<ready_sessions.size(); i++) {
+		MySQL_Session *sess=ready_sessions[i];
+		if (sess == NULL) { // unregistered while in the list
+			continue;
+		}
+		ready_sessions[i]=NULL;
+		sess->in_ready_list=false;
+		unsigned int n=sess->thread_session_idx;
+		if (sess->mirror==true) { // this is a mirror session
+			if (sess->status==WAITING_CLIENT_DATA) { // the mirror session has completed
+				ProcessAllSessions_CompletedMirrorSession(n, sess);
+				continue;
+			}
+		}
+		if (ProcessAllSessions_Session(sess, n) == false) {
+			processed_sessions.push_back(sess);
+		}
+	}
+	ready_sessions.clear();
+	for (MySQL_Session *sess : processed_sessions) {
+		sess->to_process=0;
+		if (sess->timeout_timer.scheduled() == false) {
+			schedule_session_timeout(sess);
+		}
+		if (sess->mirror) {
+			// the completion of mirror sessions is detected in the next loop
+			push_ready_session(sess);
+		}
+	}
+	processed_sessions.clear();
 	if (maintenance_loop) {
 		unsigned int total_active_transactions_tmp;
 		total_active_transactions_tmp=__sync_add_and_fetch(&status_variables.active_transactions,0);
@@ -4066,6 +4431,7 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(threshold_resultset_size);
 	REFRESH_VARIABLE_INT(query_digests_max_digest_length);
 	REFRESH_VARIABLE_INT(query_digests_max_query_length);
+	REFRESH_VARIABLE_INT(query_digests_histograms_max);
 	REFRESH_VARIABLE_INT(wait_timeout);
 	REFRESH_VARIABLE_INT(throttle_max_bytes_per_second_to_client);
 	REFRESH_VARIABLE_INT(throttle_ratio_server_to_client);
@@ -4083,6 +4449,9 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(reset_connection_algorithm);
 	REFRESH_VARIABLE_INT(auto_increment_delay_multiplex);
 	REFRESH_VARIABLE_INT(auto_increment_delay_multiplex_timeout_ms);
+	REFRESH_VARIABLE_BOOL(multiplex_affinity_learning);
+	REFRESH_VARIABLE_INT(multiplex_affinity_min_samples);
+	REFRESH_VARIABLE_INT(concurrency_limit_queue_timeout_ms);
 	REFRESH_VARIABLE_INT(default_max_latency_ms);
 	REFRESH_VARIABLE_INT(long_query_time);
 	REFRESH_VARIABLE_INT(query_cache_size_MB);
@@ -4176,6 +4545,9 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(eventslog_filesize);
 	REFRESH_VARIABLE_INT(eventslog_default_log);
 	REFRESH_VARIABLE_INT(eventslog_format);
+	REFRESH_VARIABLE_INT(eventslog_sample_rate);
+	REFRESH_VARIABLE_INT(eventslog_slow_query_threshold);
+	REFRESH_VARIABLE_INT(eventslog_digest_rate_limit);
 	REFRESH_VARIABLE_CHAR(eventslog_filename);
 	REFRESH_VARIABLE_INT(auditlog_filesize);
 	REFRESH_VARIABLE_CHAR(auditlog_filename);
@@ -4184,6 +4556,7 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_CHAR(default_schema);
 	REFRESH_VARIABLE_CHAR(keep_multiplexing_variables);
 	REFRESH_VARIABLE_CHAR(proxy_protocol_networks);
+	proxy_protocol_networks.compile(mysql_thread___proxy_protocol_networks);
 	REFRESH_VARIABLE_CHAR(default_authentication_plugin);
 	mysql_thread___default_authentication_plugin_int = GloMTH->variables.default_authentication_plugin_int;
 	mysql_thread___server_capabilities=GloMTH->get_variable_uint16((char *)"server_capabilities");
@@ -4209,17 +4582,24 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_BOOL(query_digests_track_hostname);
 	REFRESH_VARIABLE_INT(query_digests_grouping_limit);
 	REFRESH_VARIABLE_INT(query_digests_groups_grouping_limit);
+	REFRESH_VARIABLE_INT(query_digests_cache_size);
 	REFRESH_VARIABLE_BOOL(query_digests_keep_comment);
+	REFRESH_VARIABLE_BOOL(query_digests_stop_at_max_digest_length);
 	REFRESH_VARIABLE_BOOL(parse_failure_logs_digest);
 	variables.min_num_servers_lantency_awareness=GloMTH->get_variable_int((char *)"min_num_servers_lantency_awareness");
 	variables.aurora_max_lag_ms_only_read_from_replicas=GloMTH->get_variable_int((char *)"aurora_max_lag_ms_only_read_from_replicas");
 	variables.stats_time_backend_query=(bool)GloMTH->get_variable_int((char *)"stats_time_backend_query");
 	variables.stats_time_query_processor=(bool)GloMTH->get_variable_int((char *)"stats_time_query_processor");
+	variables.stats_time_query_stages=(bool)GloMTH->get_variable_int((char *)"stats_time_query_stages");
 	variables.query_cache_stores_empty_result=(bool)GloMTH->get_variable_int((char *)"query_cache_stores_empty_result");
 	REFRESH_VARIABLE_INT(hostgroup_manager_verbose);
 	REFRESH_VARIABLE_BOOL(kill_backend_connection_when_disconnect);
 	REFRESH_VARIABLE_BOOL(client_session_track_gtid);
+	REFRESH_VARIABLE_BOOL(gtid_read_your_writes);
+	REFRESH_VARIABLE_BOOL(query_cache_table_invalidation);
+	REFRESH_VARIABLE_INT(gtid_read_your_writes_timeout_ms);
 	REFRESH_VARIABLE_BOOL(sessions_sort);
+	REFRESH_VARIABLE_BOOL(sessions_ready_list);
 #ifdef IDLE_THREADS
 	REFRESH_VARIABLE_BOOL(session_idle_show_processlist);
 #endif // IDLE_THREADS
@@ -4229,6 +4609,7 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_BOOL(enable_client_deprecate_eof);
 	REFRESH_VARIABLE_BOOL(enable_server_deprecate_eof);
 	REFRESH_VARIABLE_BOOL(enable_load_data_local_infile);
+	REFRESH_VARIABLE_BOOL(use_writev);
 	REFRESH_VARIABLE_BOOL(log_mysql_warnings_enabled);
 	REFRESH_VARIABLE_INT(client_host_cache_size);
 	REFRESH_VARIABLE_INT(client_host_error_counts);
@@ -4237,6 +4618,8 @@ void MySQL_Thread::refresh_variables() {
 #ifdef DEBUG
 	REFRESH_VARIABLE_BOOL(session_debug);
 #endif /* DEBUG */
+	// the timeouts of the sessions could have changed
+	reschedule_session_timers=true;
 	GloMTH->wrunlock();
 	pthread_mutex_unlock(&GloVars.global.ext_glomth_mutex);
 }
@@ -4282,6 +4665,8 @@ MySQL_Thread::MySQL_Thread() {
 	last_move_to_idle_thread_time=0;
 	maintenance_loop=true;
 	retrieve_gtids_required = false;
+	ready_list_active=false;
+	reschedule_session_timers=false;
 
 	servers_table_version_previous=0;
 	servers_table_version_current=0;
@@ -4297,6 +4682,7 @@ MySQL_Thread::MySQL_Thread() {
 	variables.aurora_max_lag_ms_only_read_from_replicas = 2;
 	variables.stats_time_backend_query=false;
 	variables.stats_time_query_processor=false;
+	variables.stats_time_query_stages=false;
 	variables.query_cache_stores_empty_result=true;
 
 	for (int i=0; i<SQL_NAME_LAST_LOW_WM; i++) {
@@ -4323,6 +4709,8 @@ void MySQL_Thread::register_session_connection_handler(MySQL_Session *_sess, boo
 	_sess->connections_handler=true;
 	assert(_new);
 	mysql_sessions->add(_sess);
+	_sess->thread_session_idx=mysql_sessions->len-1;
+	push_ready_session(_sess);
 }
 
 
@@ -4339,7 +4727,7 @@ void MySQL_Thread::register_session_connection_handler(MySQL_Session *_sess, boo
  */
 void MySQL_Thread::unregister_session_connection_handler(int idx, bool _new) {
 	assert(_new);
-	mysql_sessions->remove_index_fast(idx);
+	unregister_session(idx);
 }
 
 void MySQL_Thread::listener_handle_new_connection(MySQL_Data_Stream *myds, unsigned int n) {
@@ -4624,6 +5012,12 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 		pta[1]=buf;
 		result->add_row(pta);
 	}
+	{	// Cost of each of the timestamps taken by 'mysql-stats_time_query_stages'
+		pta[0]=(char *)"Query_Stages_timer_overhead_ns";
+		sprintf(buf,"%llu",ticks_overhead_ns());
+		pta[1]=buf;
+		result->add_row(pta);
+	}
 	for (unsigned int i=0; i<sizeof(MySQL_Thread_status_variables_counter_array)/sizeof(mythr_st_vars_t) ; i++) {
 		if (MySQL_Thread_status_variables_counter_array[i].name) {
 			if (strlen(MySQL_Thread_status_variables_counter_array[i].name)) {
@@ -4675,6 +5069,18 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 		pta[1]=buf;
 		result->add_row(pta);
 	}
+	{	// connections not pinned after statements learned to never need it
+		pta[0]=(char *)"Multiplex_affinity_released";
+		sprintf(buf,"%llu",MyHGM->status.multiplex_affinity_released);
+		pta[1]=buf;
+		result->add_row(pta);
+	}
+	{	// statements depending on the state of a connection not pinned
+		pta[0]=(char *)"Multiplex_affinity_repinned";
+		sprintf(buf,"%llu",MyHGM->status.multiplex_affinity_repinned);
+		pta[1]=buf;
+		result->add_row(pta);
+	}
 	{	// Servers_table_version
 		pta[0]=(char *)"Servers_table_version";
 		sprintf(buf,"%u",MyHGM->get_servers_table_version());
@@ -5356,6 +5762,94 @@ unsigned int MySQL_Threads_Handler::get_active_transations() {
 	return q;
 }
 
+void MySQL_Threads_Handler::get_query_stages(Latency_Histogram* hists) {
+	if ((__sync_fetch_and_add(&status_variables.threads_initialized, 0) == 0) || this->shutdown_) return;
+	for (unsigned int i=0;i<num_threads;i++) {
+		if (mysql_threads) {
+			MySQL_Thread *thr=(MySQL_Thread *)mysql_threads[i].worker;
+			if (thr) {
+				for (int j=0; j<query_stage___END; j++) {
+					hists[j].merge(thr->query_stages[j]);
+				}
+			}
+		}
+	}
+}
+
+SQLite3_result* MySQL_Threads_Handler::SQL3_Query_Stages() {
+	const int colnum=9;
+	SQLite3_result* result=new SQLite3_result(colnum);
+	result->add_column_definition(SQLITE_TEXT,"stage");
+	result->add_column_definition(SQLITE_TEXT,"count_star");
+	result->add_column_definition(SQLITE_TEXT,"sum_time_ns");
+	result->add_column_definition(SQLITE_TEXT,"p50_ns");
+	result->add_column_definition(SQLITE_TEXT,"p90_ns");
+	result->add_column_definition(SQLITE_TEXT,"p95_ns");
+	result->add_column_definition(SQLITE_TEXT,"p99_ns");
+	result->add_column_definition(SQLITE_TEXT,"p999_ns");
+	result->add_column_definition(SQLITE_TEXT,"max_ns");
+
+	// the histograms are too large for the stack of the Admin threads
+	Latency_Histogram* hists=new Latency_Histogram[query_stage___END];
+	get_query_stages(hists);
+
+	for (int i=0; i<query_stage___END; i++) {
+		const Latency_Histogram& h=hists[i];
+		const string vals[] {
+			std::to_string(h.count()), std::to_string(h.sum()), std::to_string(h.percentile(50)),
+			std::to_string(h.percentile(90)), std::to_string(h.percentile(95)), std::to_string(h.percentile(99)),
+			std::to_string(h.percentile(99.9)), std::to_string(h.max())
+		};
+		char* pta[colnum];
+		pta[0]=(char *)mysql_query_stage_names[i];
+		for (int j=1; j<colnum; j++) {
+			pta[j]=(char *)vals[j-1].c_str();
+		}
+		result->add_row(pta);
+	}
+
+	delete[] hists;
+	return result;
+}
+
+void MySQL_Threads_Handler::p_update_query_stages() {
+	Latency_Histogram* hists=new Latency_Histogram[query_stage___END];
+	get_query_stages(hists);
+
+	const size_t p_buckets=query_stages_p_buckets.size()+1;
+	for (int i=0; i<query_stage___END; i++) {
+		const Latency_Histogram& h=hists[i];
+		vector<uint64_t> cur(p_buckets, 0);
+		size_t p_idx=0;
+		for (int j=0; j<Latency_Histogram::BUCKETS; j++) {
+			const double upper_s=Latency_Histogram::bucket_upper_bound(j)/1000000000.0;
+			while (p_idx < query_stages_p_buckets.size() && upper_s > query_stages_p_buckets[p_idx]) {
+				p_idx++;
+			}
+			cur[p_idx]+=h.bucket_count(j);
+		}
+
+		// 'ObserveMultiple' takes increments, the values exported so far are kept to compute them
+		vector<uint64_t>& exported=status_variables.p_query_stages_exported[i];
+		vector<double> increments(p_buckets, 0);
+		bool updated=false;
+		for (size_t j=0; j<p_buckets; j++) {
+			if (cur[j] > exported[j]) {
+				increments[j]=cur[j]-exported[j];
+				exported[j]=cur[j];
+				updated=true;
+			}
+		}
+		if (updated) {
+			const uint64_t sum_ns=h.sum() > exported[p_buckets] ? h.sum() - exported[p_buckets] : 0;
+			exported[p_buckets]=h.sum();
+			status_variables.p_query_stages_array[i]->ObserveMultiple(increments, sum_ns/1000000000.0);
+		}
+	}
+
+	delete[] hists;
+}
+
 #ifdef IDLE_THREADS
 unsigned int MySQL_Threads_Handler::get_non_idle_client_connections() {
 	if ((__sync_fetch_and_add(&status_variables.threads_initialized, 0) == 0) || this->shutdown_) return 0;
@@ -5450,6 +5944,7 @@ void MySQL_Threads_Handler::p_update_metrics() {
 	get_mysql_backend_buffers_bytes();
 	get_mysql_frontend_buffers_bytes();
 	get_mysql_session_internal_bytes();
+	p_update_query_stages();
 	for (unsigned int i=0; i<sizeof(MySQL_Thread_status_variables_counter_array)/sizeof(mythr_st_vars_t) ; i++) {
 		if (MySQL_Thread_status_variables_counter_array[i].name) {
 			get_status_variable(
@@ -29,6 +29,8 @@ MySrvC::MySrvC(
 	queries_sent=0;
 	bytes_sent=0;
 	bytes_recv=0;
+	queries_in_flight=0;
+	query_latency_ewma_us=0;
 	max_connections_used=0;
 	queries_gtid_sync=0;
 	time_last_detected_error=0;
@@ -1367,6 +1367,7 @@ PgSQL_Connection::PgSQL_Connection() {
 	pgsql_conn = NULL;
 	result_type = 0;
 	pgsql_result = NULL;
+	ps_result_rows = 0;
 	query_result = NULL;
 	query_result_reuse = NULL;
 	new_result = true;
@@ -1747,7 +1748,7 @@ handler_again:
 			}
 		} else if (result_type == 2) {
 			if (ps_result.id == 'D') {
-				unsigned int bytes_recv=query_result->add_row(&ps_result);
+				unsigned int bytes_recv=query_result->add_row(&ps_result, ps_result_rows);
 				update_bytes_recv(bytes_recv);
 				processed_bytes += bytes_recv;	// issue #527 : this variable will store the amount of bytes processed during this event
 
@@ -2073,7 +2074,7 @@ void PgSQL_Connection::fetch_result_cont(short event) {
 		return;
 	
 	if (is_copy_out == false) {
-		switch (PShandleRowData(pgsql_conn, new_result, &ps_result)) {
+		switch (handle_row_data()) {
 		case 0:
 			result_type = 2;
 			return;
@@ -2102,7 +2103,7 @@ void PgSQL_Connection::fetch_result_cont(short event) {
 		return;
 	}
 
-	switch (PShandleRowData(pgsql_conn, new_result, &ps_result)) {
+	switch (handle_row_data()) {
 	case 0:
 		result_type = 2;
 		return;
@@ -2120,6 +2121,19 @@ void PgSQL_Connection::fetch_result_cont(short event) {
 	pgsql_result = PQgetResult(pgsql_conn);
 }
 
+int PgSQL_Connection::handle_row_data() {
+	if (pgsql_thread___bulk_data_rows == false || query_result == NULL) {
+		ps_result_rows = 1;
+		return PShandleRowData(pgsql_conn, new_result, &ps_result);
+	}
+	// the block is copied as it is into the resultset buffer: fill what is left of it, or a new one
+	int max_length = query_result->buffer_available_capacity();
+	if (max_length == 0) {
+		max_length = PGSQL_RESULTSET_BUFLEN;
+	}
+	return PShandleRowDataBulk(pgsql_conn, new_result, max_length, &ps_result, &ps_result_rows);
+}
+
 void PgSQL_Connection::flush() {
 	reset_error();
 	int res = PQflush(pgsql_conn);
@@ -691,6 +691,9 @@ PgSQL_HostGroups_Manager::PgSQL_HostGroups_Manager() {
 	status.access_denied_max_user_connections=0;
 	status.select_for_update_or_equivalent=0;
 	status.auto_increment_delay_multiplex=0;
+	status.copy_in_commands=0;
+	status.copy_in_bytes=0;
+	status.copy_in_rows=0;
 #if 0
 	pthread_mutex_init(&readonly_mutex, NULL);
 	pthread_mutex_init(&lock, NULL);
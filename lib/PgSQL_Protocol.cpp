@@ -1769,7 +1769,7 @@ unsigned int PgSQL_Protocol::copy_ready_status_to_PgSQL_Query_Result(bool send,
 	return size;
 }
 
-unsigned int PgSQL_Protocol::copy_buffer_to_PgSQL_Query_Result(bool send, PgSQL_Query_Result* pg_query_result, const PSresult* result) {
+unsigned int PgSQL_Protocol::copy_buffer_to_PgSQL_Query_Result(bool send, PgSQL_Query_Result* pg_query_result, const PSresult* result, unsigned int rows) {
 	assert(pg_query_result);
 	assert(result && result->len && result->data);
 
@@ -1798,11 +1798,10 @@ unsigned int PgSQL_Protocol::copy_buffer_to_PgSQL_Query_Result(bool send, PgSQL_
 		//pg_query_result->buffer_to_PSarrayOut();
 		pg_query_result->PSarrayOUT.add(_ptr, size);
 	}
-	pg_query_result->pkt_count++;
+	pg_query_result->pkt_count += rows;
 
-	// assuming single-row result
 	if (result->id == 'D')
-		pg_query_result->num_rows += 1;
+		pg_query_result->num_rows += rows;
 
 	return size;
 }
@@ -1990,9 +1989,9 @@ unsigned int PgSQL_Query_Result::add_row(const PGresult* result) {
 	return proto->copy_row_to_PgSQL_Query_Result(false,this, result);
 }
 
-unsigned int PgSQL_Query_Result::add_row(const PSresult* result) {
+unsigned int PgSQL_Query_Result::add_row(const PSresult* result, unsigned int rows) {
 
-	const unsigned int res = proto->copy_buffer_to_PgSQL_Query_Result(false, this, result);
+	const unsigned int res = proto->copy_buffer_to_PgSQL_Query_Result(false, this, result, rows);
 	result_packet_type |= PGSQL_QUERY_RESULT_TUPLE; // temporary
 	return res;
 }
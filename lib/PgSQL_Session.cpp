@@ -592,6 +592,11 @@ PgSQL_Session::PgSQL_Session() {
 
 	match_regexes = NULL;
 	copy_cmd_matcher = NULL;
+	copy_in.batch.ptr = NULL;
+	copy_in.batch.size = 0;
+	copy_in.batch_capacity = 0;
+	copy_in.bytes = 0;
+	copy_in.rows = 0;
 	init(); // we moved this out to allow CHANGE_USER
 
 	last_insert_id = 0; // #1093
@@ -686,6 +691,10 @@ PgSQL_Session::~PgSQL_Session() {
 	delete qpo;
 	match_regexes = NULL;
 	copy_cmd_matcher = NULL;
+	if (copy_in.batch.ptr) {
+		l_free(copy_in.batch_capacity, copy_in.batch.ptr);
+		copy_in.batch.ptr = NULL;
+	}
 	if (mirror) {
 		__sync_sub_and_fetch(&GloPTH->status_variables.mirror_sessions_current, 1);
 		//GloPTH->status_variables.p_gauge_array[p_th_gauge::mirror_concurrency]->Decrement();
@@ -2316,7 +2325,7 @@ void PgSQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 		);
 		MySQL_STMT_Global_info* stmt_info = NULL;
 		// we first lock GloStmt
-		GloMyStmt->wrlock();
+		GloMyStmt->rdlock();
 		stmt_info = GloMyStmt->find_prepared_statement_by_hash(hash);
 		if (stmt_info) {
 			// the prepared statement exists in GloMyStmt
@@ -3317,6 +3326,10 @@ __get_pkts_from_client:
 			}
 			break;
 		case FAST_FORWARD:
+			if (session_fast_forward == SESSION_FORWARD_TYPE_COPY_STDIN) {
+				copy_in_add_to_batch(pkt);
+				break;
+			}
 			mybe->server_myds->PSarrayOUT->add(pkt.ptr, pkt.size);
 			break;
 			// This state is required because it covers the following situation:
@@ -3421,7 +3434,7 @@ void PgSQL_Session::SetQueryTimeout() {
 // false: continue
 bool PgSQL_Session::handler_rc0_PROCESSING_STMT_PREPARE(enum session_status& st, PgSQL_Data_Stream* myds, bool& prepared_stmt_with_no_params) {
 	thread->status_variables.stvar[st_var_backend_stmt_prepare]++;
-	GloMyStmt->wrlock();
+	GloMyStmt->rdlock();
 	uint32_t client_stmtid = 0;
 	uint64_t global_stmtid;
 	//bool is_new;
@@ -3435,12 +3448,15 @@ bool PgSQL_Session::handler_rc0_PROCESSING_STMT_PREPARE(enum session_status& st,
 		CurrentQuery.mysql_stmt,
 		false);
 	if (CurrentQuery.QueryParserArgs.digest_text) {
+		// GloMyStmt is only read locked: other threads may be preparing the same statement
+		pthread_rwlock_wrlock(&stmt_info->rwlock_);
 		if (stmt_info->digest_text == NULL) {
 			stmt_info->digest_text = strdup(CurrentQuery.QueryParserArgs.digest_text);
 			stmt_info->digest = CurrentQuery.QueryParserArgs.digest;	// copy digest
 			//stmt_info->MyComQueryCmd = CurrentQuery.PgQueryCmd; // copy MyComQueryCmd
 			stmt_info->calculate_mem_usage();
 		}
+		pthread_rwlock_unlock(&stmt_info->rwlock_);
 	}
 	global_stmtid = stmt_info->statement_id;
 	myds->myconn->local_stmts->backend_insert(global_stmtid, CurrentQuery.mysql_stmt);
@@ -3486,8 +3502,8 @@ void PgSQL_Session::handler_rc0_PROCESSING_STMT_EXECUTE(PgSQL_Data_Stream* myds)
 		// metadata cache is only hit once. This way we ensure that the next
 		// 'PREPARE' will be answered with the properly updated metadata.
 		/********************************************************************/
-		// Lock the global statement manager
-		GloMyStmt->wrlock();
+		// Lock the global statement manager (update_metadata() locks the statement itself)
+		GloMyStmt->rdlock();
 		// Update the global prepared statement metadata
 		MySQL_STMT_Global_info* stmt_info = GloMyStmt->find_prepared_statement_by_stmt_id(CurrentQuery.stmt_global_id, false);
 		stmt_info->update_metadata(CurrentQuery.mysql_stmt);
@@ -3807,6 +3823,9 @@ handler_again:
 			// register the PgSQL_Data_Stream
 			thread->mypolls.add(POLLIN | POLLOUT, mybe->server_myds->fd, mybe->server_myds, thread->curtime);
 		}
+		if (session_fast_forward == SESSION_FORWARD_TYPE_COPY_STDIN) {
+			copy_in_flush_batch();
+		}
 		client_myds->PSarrayOUT->copy_add(mybe->server_myds->PSarrayIN, 0, mybe->server_myds->PSarrayIN->len);
 
 		constexpr unsigned char ready_packet[] = { 0x5A, 0x00, 0x00, 0x00, 0x05 };
@@ -3816,6 +3835,7 @@ handler_again:
 			// if session_fast_forward type is COPY STDIN, we need to check if it is ready packet
 			if (session_fast_forward == SESSION_FORWARD_TYPE_COPY_STDIN) {
 				const PtrSize_t& data = mybe->server_myds->PSarrayIN->pdata[mybe->server_myds->PSarrayIN->len - 1];
+				copy_in_process_backend_msg(data);
 				if (is_copy_ready_packet == false && data.size == 6) {
 					//const unsigned char* ptr = (static_cast<unsigned char*>(data.ptr) /*+ (data.size - 6)*/);
 					if (memcmp(data.ptr, ready_packet, sizeof(ready_packet)) == 0) {
@@ -6978,6 +6998,8 @@ void PgSQL_Session::switch_normal_to_fast_forward_mode(PtrSize_t& pkt, std::stri
 	proxy_info("Received command '%s'%s. Switching to Fast Forward mode (Session Type:0x%02X)\n",
 		command.data(), client_info.c_str(), session_type);
 	session_fast_forward = session_type;
+	copy_in.bytes = 0;
+	copy_in.rows = 0;
 
 	if (client_myds->PSarrayIN->len) {
 		proxy_error("UNEXPECTED PACKET FROM CLIENT -- PLEASE REPORT A BUG\n");
@@ -7052,6 +7074,13 @@ void PgSQL_Session::switch_fast_forward_to_normal_mode() {
 
 		proxy_info("Switching back to Normal mode (Session Type:0x%02X)%s\n", 
 			session_fast_forward, client_info.c_str());
+		if (session_fast_forward == SESSION_FORWARD_TYPE_COPY_STDIN) {
+			// the batch is flushed before forwarding the backend messages, it is empty at this point
+			assert(copy_in.batch.size == 0);
+			__sync_fetch_and_add(&PgHGM->status.copy_in_commands, 1);
+			__sync_fetch_and_add(&PgHGM->status.copy_in_bytes, copy_in.bytes);
+			__sync_fetch_and_add(&PgHGM->status.copy_in_rows, copy_in.rows);
+		}
 		session_fast_forward = SESSION_FORWARD_TYPE_NONE;
 		PgSQL_Data_Stream* myds = mybe->server_myds;
 		PgSQL_Connection* myconn = myds->myconn;
@@ -7066,3 +7095,56 @@ void PgSQL_Session::switch_fast_forward_to_normal_mode() {
 		assert(0);
 	}
 }
+
+void PgSQL_Session::copy_in_add_to_batch(PtrSize_t& pkt) {
+	if (pkt.size > 5 && *static_cast<unsigned char*>(pkt.ptr) == 'd') { // CopyData
+		copy_in.bytes += pkt.size - 5;
+	}
+	if (copy_in.batch.ptr && copy_in.batch.size + pkt.size > copy_in.batch_capacity) {
+		copy_in_flush_batch();
+	}
+	if (pkt.size >= PGSQL_RESULTSET_BUFLEN) {
+		// no point in copying a message that already fills a batch
+		mybe->server_myds->PSarrayOUT->add(pkt.ptr, pkt.size);
+		return;
+	}
+	if (copy_in.batch.ptr == NULL) {
+		copy_in.batch_capacity = PGSQL_RESULTSET_BUFLEN;
+		copy_in.batch.ptr = l_alloc(copy_in.batch_capacity);
+		copy_in.batch.size = 0;
+	}
+	memcpy(static_cast<unsigned char*>(copy_in.batch.ptr) + copy_in.batch.size, pkt.ptr, pkt.size);
+	copy_in.batch.size += pkt.size;
+	l_free(pkt.size, pkt.ptr);
+}
+
+void PgSQL_Session::copy_in_flush_batch() {
+	if (copy_in.batch.ptr == NULL) return;
+	if (copy_in.batch.size) {
+		// ownership of the buffer moves to the backend data stream
+		mybe->server_myds->PSarrayOUT->add(copy_in.batch.ptr, copy_in.batch.size);
+	} else {
+		l_free(copy_in.batch_capacity, copy_in.batch.ptr);
+	}
+	copy_in.batch.ptr = NULL;
+	copy_in.batch.size = 0;
+}
+
+void PgSQL_Session::copy_in_process_backend_msg(const PtrSize_t& pkt) {
+	// CommandComplete: 'C' + int32 length + "COPY <rows>\0"
+	constexpr char tag[] = "COPY ";
+	const char* msg = static_cast<const char*>(pkt.ptr);
+	if (pkt.size > 5 + sizeof(tag) - 1 && msg[0] == 'C' && strncmp(msg + 5, tag, sizeof(tag) - 1) == 0) {
+		copy_in.rows += strtoull(msg + 5 + sizeof(tag) - 1, NULL, 10);
+	}
+}
+
+bool PgSQL_Session::copy_in_backend_is_slow() const {
+	if (session_fast_forward != SESSION_FORWARD_TYPE_COPY_STDIN || mybe == NULL || mybe->server_myds == NULL) {
+		return false;
+	}
+	// same threshold used in the other direction by 'set_backend_to_be_skipped_if_frontend_is_slow()'.
+	// Small messages are batched, so every entry in 'PSarrayOUT' is close to 'PGSQL_RESULTSET_BUFLEN'
+	const unsigned int buffered_data = mybe->server_myds->PSarrayOUT->len * PGSQL_RESULTSET_BUFLEN;
+	return buffered_data > overflow_safe_multiply<4,unsigned int>(pgsql_thread___threshold_resultset_size);
+}
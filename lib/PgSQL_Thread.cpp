@@ -366,6 +366,7 @@ static char* pgsql_thread_variables_names[] = {
 	(char*)"max_transaction_idle_time",
 	(char*)"max_transaction_time",
 	(char*)"multiplexing",
+	(char*)"bulk_data_rows",
 	(char*)"log_unhealthy_connections",
 	(char*)"enforce_autocommit_on_reads",
 	(char*)"autocommit_false_not_reusable",
@@ -379,6 +380,7 @@ static char* pgsql_thread_variables_names[] = {
 	(char*)"query_digests_max_query_length",
 	(char*)"query_digests_grouping_limit",
 	(char*)"query_digests_groups_grouping_limit",
+	(char*)"query_digests_cache_size",
 	(char*)"query_rules_fast_routing_algorithm",
 	(char*)"wait_timeout",
 	(char*)"throttle_max_bytes_per_second_to_client",
@@ -425,6 +427,7 @@ static char* pgsql_thread_variables_names[] = {
 	(char*)"query_digests_normalize_digest_text",
 	(char*)"query_digests_track_hostname",
 	(char*)"query_digests_keep_comment",
+	(char*)"query_digests_stop_at_max_digest_length",
 	(char*)"parse_failure_logs_digest",
 	(char*)"servers_stats",
 	(char*)"default_reconnect",
@@ -1044,6 +1047,7 @@ PgSQL_Threads_Handler::PgSQL_Threads_Handler() {
 	variables.have_ssl = true; // changed in 2.6.0 , was false by default for performance reason
 	variables.commands_stats = true;
 	variables.multiplexing = true;
+	variables.bulk_data_rows = true;
 	variables.log_unhealthy_connections = true;
 	variables.enforce_autocommit_on_reads = false;
 	variables.autocommit_false_not_reusable = false;
@@ -1056,6 +1060,7 @@ PgSQL_Threads_Handler::PgSQL_Threads_Handler() {
 	variables.query_digests_normalize_digest_text = false;
 	variables.query_digests_track_hostname = false;
 	variables.query_digests_keep_comment = false;
+	variables.query_digests_stop_at_max_digest_length = false;
 	variables.parse_failure_logs_digest = false;
 	variables.min_num_servers_lantency_awareness = 1000;
 	variables.aurora_max_lag_ms_only_read_from_replicas = 2;
@@ -1085,6 +1090,7 @@ PgSQL_Threads_Handler::PgSQL_Threads_Handler() {
 #endif /*debug */
 	variables.query_digests_grouping_limit = 3;
 	variables.query_digests_groups_grouping_limit = 10; // changed in 2.6.0 , was 0
+	variables.query_digests_cache_size = 4096;
 	variables.enable_client_deprecate_eof = true;
 	variables.enable_server_deprecate_eof = true;
 	variables.enable_load_data_local_infile = false;
@@ -2062,6 +2068,7 @@ char** PgSQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_bool["monitor_wait_timeout"] = make_tuple(&variables.monitor_wait_timeout, false);
 		VariablesPointers_bool["monitor_writer_is_also_reader"] = make_tuple(&variables.monitor_writer_is_also_reader, false);
 		VariablesPointers_bool["multiplexing"] = make_tuple(&variables.multiplexing, false);
+		VariablesPointers_bool["bulk_data_rows"] = make_tuple(&variables.bulk_data_rows, false);
 		VariablesPointers_bool["query_cache_stores_empty_result"] = make_tuple(&variables.query_cache_stores_empty_result, false);
 		VariablesPointers_bool["query_digests"] = make_tuple(&variables.query_digests, false);
 		VariablesPointers_bool["query_digests_lowercase"] = make_tuple(&variables.query_digests_lowercase, false);
@@ -2070,6 +2077,7 @@ char** PgSQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_bool["query_digests_normalize_digest_text"] = make_tuple(&variables.query_digests_normalize_digest_text, false);
 		VariablesPointers_bool["query_digests_track_hostname"] = make_tuple(&variables.query_digests_track_hostname, false);
 		VariablesPointers_bool["query_digests_keep_comment"] = make_tuple(&variables.query_digests_keep_comment, false);
+		VariablesPointers_bool["query_digests_stop_at_max_digest_length"] = make_tuple(&variables.query_digests_stop_at_max_digest_length, false);
 		VariablesPointers_bool["parse_failure_logs_digest"] = make_tuple(&variables.parse_failure_logs_digest, false);
 		VariablesPointers_bool["servers_stats"] = make_tuple(&variables.servers_stats, false);
 		VariablesPointers_bool["sessions_sort"] = make_tuple(&variables.sessions_sort, false);
@@ -2154,6 +2162,7 @@ char** PgSQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["default_query_timeout"] = make_tuple(&variables.default_query_timeout, 1000, 20 * 24 * 3600 * 1000, false);
 		VariablesPointers_int["query_digests_grouping_limit"] = make_tuple(&variables.query_digests_grouping_limit, 1, 2089, false);
 		VariablesPointers_int["query_digests_groups_grouping_limit"] = make_tuple(&variables.query_digests_groups_grouping_limit, 0, 2089, false);
+		VariablesPointers_int["query_digests_cache_size"] = make_tuple(&variables.query_digests_cache_size, 0, 1048576, false);
 		VariablesPointers_int["query_digests_max_digest_length"] = make_tuple(&variables.query_digests_max_digest_length, 16, 1 * 1024 * 1024, false);
 		VariablesPointers_int["query_digests_max_query_length"] = make_tuple(&variables.query_digests_max_query_length, 16, 1 * 1024 * 1024, false);
 		VariablesPointers_int["query_rules_fast_routing_algorithm"] = make_tuple(&variables.query_rules_fast_routing_algorithm, 1, 2, false);
@@ -3136,6 +3145,9 @@ void PgSQL_Thread::run() {
 			run___cleanup_mirror_queue();
 			GloPgQPro->update_query_processor_stats();
 		}
+		if (maintenance_loop == true) {
+			release_stale_firewall_caches<PgSQL_Session>(GloPgQPro->get_firewall_whitelist_version());
+		}
 
 		if (rc == -1 && errno == EINTR)
 			// poll() timeout, try again
@@ -3786,6 +3798,7 @@ void PgSQL_Thread::refresh_variables() {
 	pgsql_thread___connect_retries_on_failure = GloPTH->get_variable_int((char*)"connect_retries_on_failure");
 	pgsql_thread___connect_retries_delay = GloPTH->get_variable_int((char*)"connect_retries_delay");
 	pgsql_thread___multiplexing = (bool)GloPTH->get_variable_int((char*)"multiplexing");
+	pgsql_thread___bulk_data_rows = (bool)GloPTH->get_variable_int((char*)"bulk_data_rows");
 	pgsql_thread___connection_delay_multiplex_ms = GloPTH->get_variable_int((char*)"connection_delay_multiplex_ms");
 	pgsql_thread___connection_max_age_ms = GloPTH->get_variable_int((char*)"connection_max_age_ms");
 	pgsql_thread___connect_timeout_client = GloPTH->get_variable_int((char*)"connect_timeout_client");
@@ -3978,7 +3991,9 @@ void PgSQL_Thread::refresh_variables() {
 	pgsql_thread___query_digests_track_hostname = (bool)GloPTH->get_variable_int((char*)"query_digests_track_hostname");
 	pgsql_thread___query_digests_grouping_limit = (int)GloPTH->get_variable_int((char*)"query_digests_grouping_limit");
 	pgsql_thread___query_digests_groups_grouping_limit = (int)GloPTH->get_variable_int((char*)"query_digests_groups_grouping_limit");
+	pgsql_thread___query_digests_cache_size = (int)GloPTH->get_variable_int((char*)"query_digests_cache_size");
 	pgsql_thread___query_digests_keep_comment = (bool)GloPTH->get_variable_int((char*)"query_digests_keep_comment");
+	pgsql_thread___query_digests_stop_at_max_digest_length = (bool)GloPTH->get_variable_int((char*)"query_digests_stop_at_max_digest_length");
 
 	variables.query_cache_stores_empty_result = (bool)GloPTH->get_variable_int((char*)"query_cache_stores_empty_result");
 	/*
@@ -4258,6 +4273,20 @@ SQLite3_result* PgSQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 		pta[1] = buf;
 		result->add_row(pta);
 	}
+	{	// COPY FROM STDIN
+		pta[0] = (char*)"Copy_In_commands";
+		sprintf(buf, "%llu", PgHGM->status.copy_in_commands);
+		pta[1] = buf;
+		result->add_row(pta);
+		pta[0] = (char*)"Copy_In_bytes";
+		sprintf(buf, "%llu", PgHGM->status.copy_in_bytes);
+		pta[1] = buf;
+		result->add_row(pta);
+		pta[0] = (char*)"Copy_In_rows";
+		sprintf(buf, "%llu", PgHGM->status.copy_in_rows);
+		pta[1] = buf;
+		result->add_row(pta);
+	}
 #ifdef IDLE_THREADS
 	{	// Connections non idle
 		pta[0] = (char*)"Client_Connections_non_idle";
@@ -346,6 +346,11 @@ pthread_mutex_t sock_mutex = PTHREAD_MUTEX_INITIALIZER;
 //pthread_mutex_t admin_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t users_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Queries used to load the MySQL users and query rules to runtime, also used to validate the runtime snapshot
+#define MYSQL_USERS_LOAD_QUERY "SELECT username,password,use_ssl,default_hostgroup,default_schema,schema_locked,transaction_persistent,fast_forward,backend,frontend,max_connections,attributes,comment FROM main.mysql_users WHERE active=1 AND default_hostgroup>=0"
+#define MYSQL_QUERY_RULES_LOAD_QUERY "SELECT rule_id, username, schemaname, flagIN, client_addr, proxy_addr, proxy_port, digest, match_digest, match_pattern, negate_match_pattern, re_modifiers, flagOUT, replace_pattern, destination_hostgroup, cache_ttl, cache_empty_result, cache_timeout, reconnect, timeout, retries, delay, next_query_flagIN, mirror_flagOUT, mirror_hostgroup, error_msg, ok_msg, sticky_conn, multiplex, gtid_from_hostgroup, log, apply, attributes, comment FROM main.mysql_query_rules WHERE active=1 ORDER BY rule_id"
+#define MYSQL_QUERY_RULES_FAST_ROUTING_LOAD_QUERY "SELECT username, schemaname, flagIN, destination_hostgroup, comment FROM main.mysql_query_rules_fast_routing ORDER BY username, schemaname, flagIN"
+
 //pthread_mutex_t test_mysql_firewall_whitelist_mutex = PTHREAD_MUTEX_INITIALIZER;
 //std::unordered_map<std::string, void *> map_test_mysql_firewall_whitelist_rules;
 //char rand_del[6];
@@ -368,6 +373,7 @@ static char * admin_variables_names[]= {
 	(char *)"stats_mysql_query_digest_to_disk",
 	(char *)"stats_system_cpu",
 	(char *)"stats_system_memory",
+	(char *)"stats_history_timeseries",
 	(char *)"mysql_ifaces",
 	(char *)"pgsql_ifaces",
 	(char *)"telnet_admin_ifaces",
@@ -376,6 +382,7 @@ static char * admin_variables_names[]= {
 	(char *)"read_only",
 //	(char *)"hash_passwords",
 	(char *)"vacuum_stats",
+	(char *)"runtime_snapshot",
 	(char *)"version",
 	(char *)"cluster_username",
 	(char *)"cluster_password",
@@ -396,6 +403,9 @@ static char * admin_variables_names[]= {
 	(char *)"cluster_admin_variables_save_to_disk",
 	(char *)"cluster_ldap_variables_save_to_disk",
 	(char *)"cluster_mysql_servers_sync_algorithm",
+	(char *)"cluster_changelog_max_rows",
+	(char *)"cluster_push_notifications",
+	(char *)"cluster_push_fanout",
 	(char *)"checksum_mysql_query_rules",
 	(char *)"checksum_mysql_servers",
 	(char *)"checksum_mysql_users",
@@ -1161,6 +1171,7 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 	bool stats_mysql_global=false;
 	bool stats_memory_metrics=false;
 	bool stats_mysql_commands_counters=false;
+	bool stats_mysql_query_stages=false;
 	bool stats_pgsql_commands_counters = false;
 	bool stats_mysql_query_rules=false;
 	bool stats_pgsql_query_rules = false;
@@ -1317,6 +1328,8 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 		{ stats_pgsql_free_connections=true; refresh=true; }
 	if (strstr(query_no_space,"stats_mysql_commands_counters"))
 		{ stats_mysql_commands_counters=true; refresh=true; }
+	if (strstr(query_no_space,"stats_mysql_query_stages"))
+		{ stats_mysql_query_stages=true; refresh=true; }
 	if (strstr(query_no_space, "stats_pgsql_commands_counters"))
 		{ stats_pgsql_commands_counters = true; refresh = true; }
 	if (strstr(query_no_space,"stats_mysql_query_rules"))
@@ -1463,6 +1476,10 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 	if (strstr(query_no_space,"mysql_server_aws_aurora_check_status")) {
 		monitor_mysql_server_aws_aurora_check_status=true; refresh=true;
 	}
+	// with the time series store, the 'stats_history' tables are only written when queried
+	if (GloProxyStats->variables.stats_history_timeseries && strstr(query_no_space,"stats_history")) {
+		GloProxyStats->timeseries_materialize(query_no_space);
+	}
 //	if (stats_mysql_processlist || stats_mysql_connection_pool || stats_mysql_query_digest || stats_mysql_query_digest_reset) {
 	if (refresh==true) {
 		//pthread_mutex_lock(&admin_mutex);
@@ -1524,6 +1541,8 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 			stats___pgsql_query_rules();
 		if (stats_mysql_commands_counters)
 			stats___mysql_commands_counters();
+		if (stats_mysql_query_stages)
+			stats___mysql_query_stages();
 		if (stats_pgsql_commands_counters)
 			stats___pgsql_commands_counters();
 		if (stats_mysql_users)
@@ -1685,7 +1704,7 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 		stats_mysql_processlist || stats_mysql_connection_pool || stats_mysql_connection_pool_reset ||
 		stats_mysql_query_digest || stats_mysql_query_digest_reset || stats_mysql_errors ||
 		stats_mysql_errors_reset || stats_mysql_global || stats_memory_metrics || 
-		stats_mysql_commands_counters || stats_mysql_query_rules || stats_mysql_users ||
+		stats_mysql_commands_counters || stats_mysql_query_stages || stats_mysql_query_rules || stats_mysql_users ||
 		stats_mysql_gtid_executed || stats_mysql_free_connections || 
 		stats_pgsql_global || stats_pgsql_connection_pool || stats_pgsql_connection_pool_reset ||
 		stats_pgsql_free_connections || stats_pgsql_users || stats_pgsql_processlist ||
@@ -1884,6 +1903,7 @@ void ProxySQL_Admin::vacuum_stats(bool is_admin) {
 	}
 	const vector<string> tablenames = {
 		"stats_mysql_commands_counters",
+		"stats_mysql_query_stages",
 		"stats_pgsql_commands_counters",
 		"stats_mysql_free_connections",
 		"stats_pgsql_free_connections",
@@ -2602,6 +2622,7 @@ ProxySQL_Admin::ProxySQL_Admin() :
 	variables.pgsql_show_processlist_extended = false;
 	//variables.hash_passwords=true;	// issue #676
 	variables.vacuum_stats=true;	// issue #1011
+	variables.runtime_snapshot=false;
 	variables.admin_read_only=false;	// by default, the admin interface accepts writes
 	variables.admin_version=(char *)PROXYSQL_VERSION;
 	variables.cluster_username=strdup((char *)"");
@@ -2616,6 +2637,9 @@ ProxySQL_Admin::ProxySQL_Admin() :
 	variables.cluster_admin_variables_diffs_before_sync = 3;
 	variables.cluster_ldap_variables_diffs_before_sync = 3;
 	variables.cluster_mysql_servers_sync_algorithm = 1;
+	variables.cluster_changelog_max_rows = 100000;
+	variables.cluster_push_notifications = false;
+	variables.cluster_push_fanout = 3;
 	checksum_variables.checksum_mysql_query_rules = true;
 	checksum_variables.checksum_mysql_servers = true;
 	checksum_variables.checksum_mysql_users = true;
@@ -2635,6 +2659,7 @@ ProxySQL_Admin::ProxySQL_Admin() :
 	variables.stats_mysql_query_digest_to_disk = 0;
 	variables.stats_system_cpu = 60;
 	variables.stats_system_memory = 60;
+	variables.stats_history_timeseries = false;
 	GloProxyStats->variables.stats_mysql_connection_pool = 60;
 	GloProxyStats->variables.stats_mysql_connections = 60;
 	GloProxyStats->variables.stats_mysql_query_cache = 60;
@@ -2643,6 +2668,7 @@ ProxySQL_Admin::ProxySQL_Admin() :
 #ifndef NOJEM
 	GloProxyStats->variables.stats_system_memory = 60;
 #endif
+	GloProxyStats->variables.stats_history_timeseries = false;
 
 	variables.restapi_enabled = false;
 	variables.restapi_enabled_old = false;
@@ -2655,6 +2681,7 @@ ProxySQL_Admin::ProxySQL_Admin() :
 	variables.web_verbosity = 0;
 	variables.p_memory_metrics_interval = 61;
 	all_modules_started = false;
+	snapshot_read = false;
 #ifdef DEBUG
 	variables.debug=GloVars.global.gdbg;
 	debug_output = 1;
@@ -3296,6 +3323,9 @@ char * ProxySQL_Admin::get_variable(char *name) {
 			sprintf(intbuf,"%d",variables.stats_system_memory);
 			return strdup(intbuf);
 		}
+		if (!strcasecmp(name,"stats_history_timeseries")) {
+			return strdup((variables.stats_history_timeseries ? "true" : "false"));
+		}
 	}
 	if (!strcasecmp(name,"admin_credentials")) return s_strdup(variables.admin_credentials);
 	if (!strcasecmp(name,"mysql_ifaces")) return s_strdup(variables.mysql_ifaces);
@@ -3342,6 +3372,17 @@ char * ProxySQL_Admin::get_variable(char *name) {
 		sprintf(intbuf, "%d", variables.cluster_mysql_servers_sync_algorithm);
 		return strdup(intbuf);
 	}
+	if (!strcasecmp(name,"cluster_changelog_max_rows")) {
+		sprintf(intbuf, "%d", variables.cluster_changelog_max_rows);
+		return strdup(intbuf);
+	}
+	if (!strcasecmp(name,"cluster_push_notifications")) {
+		return strdup((variables.cluster_push_notifications ? "true" : "false"));
+	}
+	if (!strcasecmp(name,"cluster_push_fanout")) {
+		sprintf(intbuf, "%d", variables.cluster_push_fanout);
+		return strdup(intbuf);
+	}
 	if (!strcasecmp(name,"cluster_mysql_query_rules_save_to_disk")) {
 		return strdup((variables.cluster_mysql_query_rules_save_to_disk ? "true" : "false"));
 	}
@@ -3378,6 +3419,9 @@ char * ProxySQL_Admin::get_variable(char *name) {
 	if (!strcasecmp(name,"vacuum_stats")) {
 		return strdup((variables.vacuum_stats ? "true" : "false"));
 	}
+	if (!strcasecmp(name,"runtime_snapshot")) {
+		return strdup((variables.runtime_snapshot ? "true" : "false"));
+	}
 	if (!strcasecmp(name,"checksum_mysql_query_rules")) {
 		return strdup((checksum_variables.checksum_mysql_query_rules ? "true" : "false"));
 	}
@@ -3643,6 +3687,19 @@ bool ProxySQL_Admin::set_variable(char *name, char *value, bool lock) {  // this
 			}
 		}
 #endif
+		if (!strcasecmp(name,"stats_history_timeseries")) {
+			if (strcasecmp(value,"true")==0 || strcasecmp(value,"1")==0) {
+				variables.stats_history_timeseries=true;
+				GloProxyStats->variables.stats_history_timeseries=true;
+				return true;
+			}
+			if (strcasecmp(value,"false")==0 || strcasecmp(value,"0")==0) {
+				variables.stats_history_timeseries=false;
+				GloProxyStats->variables.stats_history_timeseries=false;
+				return true;
+			}
+			return false;
+		}
 	}
 	if (!strcasecmp(name,"mysql_ifaces")) {
 		if (vallen) {
@@ -3877,6 +3934,43 @@ bool ProxySQL_Admin::set_variable(char *name, char *value, bool lock) {  // this
 			return false;
 		}
 	}
+	if (!strcasecmp(name,"cluster_changelog_max_rows")) {
+		int intv=atoi(value);
+		if (intv >= 0 && intv <= 10000000) {
+			if (intv == 0) {
+				GloProxyCluster->mysql_query_rules_changelog.reset();
+				GloProxyCluster->mysql_users_changelog.reset();
+			}
+			variables.cluster_changelog_max_rows=intv;
+			__sync_lock_test_and_set(&GloProxyCluster->cluster_changelog_max_rows, intv);
+			return true;
+		} else {
+			return false;
+		}
+	}
+	if (!strcasecmp(name,"cluster_push_notifications")) {
+		if (strcasecmp(value,"true")==0 || strcasecmp(value,"1")==0) {
+			variables.cluster_push_notifications=true;
+			__sync_lock_test_and_set(&GloProxyCluster->cluster_push_notifications, true);
+			return true;
+		}
+		if (strcasecmp(value,"false")==0 || strcasecmp(value,"0")==0) {
+			variables.cluster_push_notifications=false;
+			__sync_lock_test_and_set(&GloProxyCluster->cluster_push_notifications, false);
+			return true;
+		}
+		return false;
+	}
+	if (!strcasecmp(name,"cluster_push_fanout")) {
+		int intv=atoi(value);
+		if (intv >= 1 && intv <= 1000) {
+			variables.cluster_push_fanout=intv;
+			__sync_lock_test_and_set(&GloProxyCluster->cluster_push_fanout, intv);
+			return true;
+		} else {
+			return false;
+		}
+	}
 	if (!strcasecmp(name,"version")) {
 		if (strcasecmp(value,(char *)PROXYSQL_VERSION)==0) {
 			return true;
@@ -3913,6 +4007,17 @@ bool ProxySQL_Admin::set_variable(char *name, char *value, bool lock) {  // this
 		}
 		return false;
 	}
+	if (!strcasecmp(name,"runtime_snapshot")) {
+		if (strcasecmp(value,"true")==0 || strcasecmp(value,"1")==0) {
+			variables.runtime_snapshot=true;
+			return true;
+		}
+		if (strcasecmp(value,"false")==0 || strcasecmp(value,"0")==0) {
+			variables.runtime_snapshot=false;
+			return true;
+		}
+		return false;
+	}
 	if (!strcasecmp(name,"restapi_enabled")) {
 		if (strcasecmp(value,"true")==0 || strcasecmp(value,"1")==0) {
 			variables.restapi_enabled=true;
@@ -5243,6 +5348,7 @@ void ProxySQL_Admin::flush_mysql_users__from_memory_to_disk() {
 	}
 	admindb->execute("PRAGMA foreign_keys = ON");
 	admindb->wrunlock();
+	save_runtime_snapshot();
 }
 
 void ProxySQL_Admin::flush_pgsql_users__from_memory_to_disk() {
@@ -5307,6 +5413,9 @@ void ProxySQL_Admin::flush_GENERIC__from_to(const string& name, const string& di
 	}
 	admindb->execute("PRAGMA foreign_keys = ON");
 	admindb->wrunlock();
+	if (name == "mysql_query_rules" && direction == "memory_to_disk") {
+		save_runtime_snapshot();
+	}
 }
 
 void ProxySQL_Admin::flush_mysql_variables__from_memory_to_disk() {
@@ -5399,6 +5508,199 @@ void ProxySQL_Admin::init_pgsql_firewall() {
 	load_pgsql_firewall_to_runtime();
 }
 
+string ProxySQL_Admin::get_snapshot_path() {
+	return string { GloVars.datadir } + "/proxysql_runtime.snapshot";
+}
+
+void ProxySQL_Admin::save_runtime_snapshot() {
+	if (variables.runtime_snapshot == false || GloMyAuth == NULL || GloMyQPro == NULL) {
+		return;
+	}
+	vector<ProxySQL_Snapshot::section_t> sections {};
+	string buf {};
+
+	// Not all the callers hold 'sql_query_global_mutex' (shutdown, Cluster syncs), the resultsets of the query
+	// rules are read under the Query Processor lock, held while they are replaced, and the users under
+	// 'users_mutex'. Checksums are copied under 'checksum_mutex', always locked after the Query Processor.
+	GloMyQPro->rdlock();
+	pthread_mutex_lock(&users_mutex);
+	pthread_mutex_lock(&GloVars.checksum_mutex);
+	SQLite3_result* users = GloMyAuth->get_current_mysql_users();
+	if (users != NULL && GloMyLdapAuth == NULL) {
+		const ProxySQL_Checksum_Value& c = GloVars.checksums_values.mysql_users;
+		sections.push_back({ "mysql_users", c.checksum, c.epoch, { users } });
+	}
+	SQLite3_result* rules = GloMyQPro->get_current_query_rules_inner();
+	SQLite3_result* fast_routing = GloMyQPro->get_current_query_rules_fast_routing_inner();
+	if (rules != NULL && fast_routing != NULL) {
+		const ProxySQL_Checksum_Value& c = GloVars.checksums_values.mysql_query_rules;
+		sections.push_back({ "mysql_query_rules", c.checksum, c.epoch, { rules, fast_routing } });
+	}
+	pthread_mutex_unlock(&GloVars.checksum_mutex);
+	buf = ProxySQL_Snapshot::serialize(sections);
+	pthread_mutex_unlock(&users_mutex);
+	GloMyQPro->wrunlock();
+
+	string err {};
+	const string path { get_snapshot_path() };
+	if (ProxySQL_Snapshot::write(path, buf, err)) {
+		proxy_info("Runtime snapshot saved to %s (%lu bytes)\n", path.c_str(), buf.size());
+	} else {
+		proxy_error("Unable to save runtime snapshot: %s\n", err.c_str());
+	}
+}
+
+ProxySQL_Snapshot::section_t* ProxySQL_Admin::get_snapshot_section(const string& name) {
+	if (snapshot_read == false) {
+		snapshot_read = true;
+		if (
+			variables.runtime_snapshot == false || all_modules_started ||
+			GloVars.__cmd_proxysql_initial || GloVars.__cmd_proxysql_reload
+		) {
+			return nullptr;
+		}
+		string err {};
+		const string path { get_snapshot_path() };
+		if (access(path.c_str(), F_OK) != 0) {
+			proxy_info("Runtime snapshot %s not found, loading runtime from the database\n", path.c_str());
+			return nullptr;
+		}
+		unsigned long long curtime1 = monotonic_time();
+		if (ProxySQL_Snapshot::read(path, snapshot_sections, err) == false) {
+			proxy_warning("Unable to read runtime snapshot, loading runtime from the database: %s\n", err.c_str());
+			return nullptr;
+		}
+		unsigned long long curtime2 = monotonic_time();
+		proxy_info("Runtime snapshot %s read in %llums\n", path.c_str(), (curtime2 - curtime1) / 1000);
+	}
+	for (ProxySQL_Snapshot::section_t& section : snapshot_sections) {
+		if (section.name == name) {
+			return &section;
+		}
+	}
+	return nullptr;
+}
+
+bool ProxySQL_Admin::load_mysql_users_from_snapshot() {
+	if (GloMyLdapAuth) {
+		return false;
+	}
+	ProxySQL_Snapshot::section_t* section { get_snapshot_section("mysql_users") };
+	if (section == nullptr || section->resultsets.size() != 1 || section->resultsets[0]->columns != 13) {
+		return false;
+	}
+	unique_ptr<SQLite3_result> users { section->resultsets[0] };
+	section->resultsets.clear();
+
+	const string checksum { get_checksum_from_hash(GloMyAuth->get_runtime_checksum(users.get())) };
+	if (checksum != section->checksum) {
+		proxy_warning(
+			"Runtime snapshot checksum mismatch for 'mysql_users': expected '%s', computed '%s'\n",
+			section->checksum.c_str(), checksum.c_str()
+		);
+		return false;
+	}
+	init_users(std::move(users), checksum, section->epoch);
+	snapshot_loaded.push_back(section->name);
+	proxy_info("Loaded 'mysql_users' from runtime snapshot\n");
+
+	return true;
+}
+
+bool ProxySQL_Admin::load_mysql_query_rules_from_snapshot() {
+	ProxySQL_Snapshot::section_t* section { get_snapshot_section("mysql_query_rules") };
+	if (
+		section == nullptr || section->resultsets.size() != 2 ||
+		section->resultsets[0]->columns != 34 || section->resultsets[1]->columns != 5
+	) {
+		return false;
+	}
+	SQLite3_result* rules { section->resultsets[0] };
+	SQLite3_result* fast_routing { section->resultsets[1] };
+	section->resultsets.clear();
+
+	const string checksum { get_checksum_from_hash(rules->raw_checksum() + fast_routing->raw_checksum()) };
+	if (checksum != section->checksum) {
+		proxy_warning(
+			"Runtime snapshot checksum mismatch for 'mysql_query_rules': expected '%s', computed '%s'\n",
+			section->checksum.c_str(), checksum.c_str()
+		);
+		delete rules;
+		delete fast_routing;
+		return false;
+	}
+	// 'load_mysql_query_rules_to_runtime' takes ownership of the resultsets
+	load_mysql_query_rules_to_runtime(rules, fast_routing, checksum, section->epoch);
+	snapshot_loaded.push_back(section->name);
+	proxy_info("Loaded 'mysql_query_rules' from runtime snapshot\n");
+
+	return true;
+}
+
+void ProxySQL_Admin::validate_runtime_snapshot() {
+	ProxySQL_Snapshot::free_sections(snapshot_sections);
+
+	for (const string& name : snapshot_loaded) {
+		char* error = NULL;
+		int cols = 0;
+		int affected_rows = 0;
+		string checksum {};
+		string runtime_checksum {};
+
+		if (name == "mysql_users") {
+			SQLite3_result* resultset = NULL;
+			admindb->execute_statement(MYSQL_USERS_LOAD_QUERY, &error, &cols, &affected_rows, &resultset);
+			if (resultset) {
+				checksum = get_checksum_from_hash(GloMyAuth->get_runtime_checksum(resultset));
+				delete resultset;
+			}
+		} else if (name == "mysql_query_rules") {
+			SQLite3_result* resultset = NULL;
+			SQLite3_result* resultset2 = NULL;
+			admindb->execute_statement(MYSQL_QUERY_RULES_LOAD_QUERY, &error, &cols, &affected_rows, &resultset);
+			if (error == NULL) {
+				admindb->execute_statement(
+					MYSQL_QUERY_RULES_FAST_ROUTING_LOAD_QUERY, &error, &cols, &affected_rows, &resultset2
+				);
+			}
+			if (resultset && resultset2) {
+				checksum = get_checksum_from_hash(resultset->raw_checksum() + resultset2->raw_checksum());
+			}
+			delete resultset;
+			delete resultset2;
+		}
+		if (error) {
+			proxy_error("Error validating runtime snapshot for '%s': %s\n", name.c_str(), error);
+			free(error);
+		}
+
+		pthread_mutex_lock(&GloVars.checksum_mutex);
+		if (name == "mysql_users") {
+			runtime_checksum = GloVars.checksums_values.mysql_users.checksum;
+		} else {
+			runtime_checksum = GloVars.checksums_values.mysql_query_rules.checksum;
+		}
+		pthread_mutex_unlock(&GloVars.checksum_mutex);
+
+		if (checksum == runtime_checksum) {
+			proxy_info("Runtime snapshot validated for '%s'\n", name.c_str());
+			continue;
+		}
+		proxy_warning(
+			"Runtime snapshot for '%s' doesn't match the database ('%s' vs '%s'), reloading it from the database\n",
+			name.c_str(), runtime_checksum.c_str(), checksum.c_str()
+		);
+		pthread_mutex_lock(&sql_query_global_mutex);
+		if (name == "mysql_users") {
+			init_users();
+		} else {
+			load_mysql_query_rules_to_runtime();
+		}
+		pthread_mutex_unlock(&sql_query_global_mutex);
+	}
+	snapshot_loaded.clear();
+}
+
 template<enum SERVER_TYPE pt>
 void ProxySQL_Admin::add_admin_users() {
 #ifdef DEBUG
@@ -5428,6 +5730,16 @@ void ProxySQL_Admin::__refresh_users(
 		mysql_users_resultset.reset(added_users);
 	}
 
+	// the checksum of the users includes the LDAP mappings, which aren't tracked by the changelog
+	SQLite3_result* changes = NULL;
+	const unsigned int changelog_max_rows =
+		(GloProxyCluster && GloMyLdapAuth == NULL) ? __sync_fetch_and_add(&GloProxyCluster->cluster_changelog_max_rows, 0) : 0;
+	if (changelog_max_rows) {
+		changes = GloProxyCluster->mysql_users_changelog.diff(
+			{ GloMyAuth->get_current_mysql_users() }, { mysql_users_resultset.get() }
+		);
+	}
+
 	if (GloMyLdapAuth) {
 		__add_active_users_ldap();
 	}
@@ -5454,8 +5766,14 @@ void ProxySQL_Admin::__refresh_users(
 			buff = const_cast<char*>(checksum.c_str());
 		}
 
+		const string prev_checksum { GloVars.checksums_values.mysql_users.checksum };
 		GloVars.checksums_values.mysql_users.set_checksum(buff);
 		GloVars.checksums_values.mysql_users.version++;
+		if (changelog_max_rows) {
+			GloProxyCluster->mysql_users_changelog.add(
+				prev_checksum, GloVars.checksums_values.mysql_users.checksum, changes, changelog_max_rows
+			);
+		}
 		time_t t = time(NULL);
 
 		const bool same_checksum = no_resultset_supplied == false;
@@ -5732,7 +6050,7 @@ SQLite3_result* ProxySQL_Admin::__add_active_users(
 	if (__user==NULL) {
 		if (mysql_users_resultset == nullptr) {
 			if constexpr (pt == SERVER_TYPE_MYSQL) {
-				str = (char*)"SELECT username,password,use_ssl,default_hostgroup,default_schema,schema_locked,transaction_persistent,fast_forward,backend,frontend,max_connections,attributes,comment FROM main.mysql_users WHERE active=1 AND default_hostgroup>=0";
+				str = (char*)MYSQL_USERS_LOAD_QUERY;
 			} else if constexpr (pt == SERVER_TYPE_PGSQL) {
 				str = (char*)"SELECT username,password,use_ssl,default_hostgroup,transaction_persistent,fast_forward,backend,frontend,max_connections,attributes,comment FROM main.pgsql_users WHERE active=1 AND default_hostgroup>=0";
 			}
@@ -7629,7 +7947,7 @@ char* ProxySQL_Admin::load_mysql_query_rules_to_runtime(SQLite3_result* SQLite3_
 	int affected_rows=0;
 	if (GloMyQPro==NULL) return (char *)"Global Query Processor not started: command impossible to run";
 	SQLite3_result *resultset=NULL;
-	char *query=(char *)"SELECT rule_id, username, schemaname, flagIN, client_addr, proxy_addr, proxy_port, digest, match_digest, match_pattern, negate_match_pattern, re_modifiers, flagOUT, replace_pattern, destination_hostgroup, cache_ttl, cache_empty_result, cache_timeout, reconnect, timeout, retries, delay, next_query_flagIN, mirror_flagOUT, mirror_hostgroup, error_msg, ok_msg, sticky_conn, multiplex, gtid_from_hostgroup, log, apply, attributes, comment FROM main.mysql_query_rules WHERE active=1 ORDER BY rule_id";
+	char *query=(char *)MYSQL_QUERY_RULES_LOAD_QUERY;
 	if (SQLite3_query_rules_resultset==NULL) {
 		admindb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
 	} else {
@@ -7641,7 +7959,7 @@ char* ProxySQL_Admin::load_mysql_query_rules_to_runtime(SQLite3_result* SQLite3_
 	int cols2 = 0;
 	int affected_rows2 = 0;
 	SQLite3_result *resultset2 = NULL;
-	char *query2=(char *)"SELECT username, schemaname, flagIN, destination_hostgroup, comment FROM main.mysql_query_rules_fast_routing ORDER BY username, schemaname, flagIN";
+	char *query2=(char *)MYSQL_QUERY_RULES_FAST_ROUTING_LOAD_QUERY;
 	if (SQLite3_query_rules_fast_routing_resultset==NULL) {
 		admindb->execute_statement(query2, &error2 , &cols2 , &affected_rows2 , &resultset2);
 	} else {
@@ -7670,6 +7988,18 @@ char* ProxySQL_Admin::load_mysql_query_rules_to_runtime(SQLite3_result* SQLite3_
 			hash2 = resultset2->raw_checksum();
 		}
 
+		// Changes for Cluster peers are also computed outside of critical sections. The previous resultsets
+		// are only replaced by this function, so they can be accessed without locking the Query Processor.
+		SQLite3_result* changes = NULL;
+		const unsigned int changelog_max_rows =
+			GloProxyCluster ? __sync_fetch_and_add(&GloProxyCluster->cluster_changelog_max_rows, 0) : 0;
+		if (changelog_max_rows) {
+			changes = GloProxyCluster->mysql_query_rules_changelog.diff(
+				{ GloMyQPro->get_current_query_rules_inner(), GloMyQPro->get_current_query_rules_fast_routing_inner() },
+				{ resultset, resultset2 }
+			);
+		}
+
 		unsigned long long curtime1 = monotonic_time();
 		GloMyQPro->wrlock();
 		// Checksums are always generated - 'admin-checksum_*' deprecated
@@ -7693,8 +8023,14 @@ char* ProxySQL_Admin::load_mysql_query_rules_to_runtime(SQLite3_result* SQLite3_
 				buff = const_cast<char*>(checksum.c_str());
 			}
 
+			const string prev_checksum { GloVars.checksums_values.mysql_query_rules.checksum };
 			GloVars.checksums_values.mysql_query_rules.set_checksum(buff);
 			GloVars.checksums_values.mysql_query_rules.version++;
+			if (changelog_max_rows) {
+				GloProxyCluster->mysql_query_rules_changelog.add(
+					prev_checksum, GloVars.checksums_values.mysql_query_rules.checksum, changes, changelog_max_rows
+				);
+			}
 			time_t t = time(NULL);
 
 			// Since the supplied checksum is the already computed one and both resultset are
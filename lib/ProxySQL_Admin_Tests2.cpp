@@ -5,11 +5,13 @@
 #include <memory>
 #include <vector>       // std::vector
 #include <unordered_set>
+#include <tuple>
 
 #include "MySQL_Query_Processor.h"
 #include "PgSQL_Query_Processor.h"
 
 #include "MySQL_Data_Stream.h"
+#include "QP_firewall_whitelist.h"
 
 static int int_cmp(const void *a, const void *b) {
 	const unsigned long long *ia = (const unsigned long long *)a;
@@ -54,11 +56,54 @@ void ProxySQL_Admin::map_test_mysql_firewall_whitelist_rules_cleanup() {
 	map_test_mysql_firewall_whitelist_rules.clear();
 }
 
+/**
+ * @brief Benchmarks the compiled whitelist used by the sessions ('QP_firewall_whitelist').
+ * @details The whitelist is built once from the rules, and each tuple of the rules is resolved once, like
+ *   sessions do. Then the digests of the rules are searched 'loops' times, through the resolved entries.
+ *   Build and lookup times are reported in the error log, to be compared with 'cmd' 1 and 2.
+ * @return The number of active rules in 'ret1', and the number of digests found in 'ret2'.
+ */
+static bool ProxySQL_Test___Load_MySQL_Whitelist_compiled(SQLite3_result *resultset, int *ret1, int *ret2, int loops) {
+	unsigned long long t1 = monotonic_time();
+	QP_firewall_whitelist *wl = new QP_firewall_whitelist(NULL, resultset);
+	unsigned long long t2 = monotonic_time();
+	std::vector<std::tuple<const QP_firewall_whitelist_rules *, int, uint64_t>> lookups {};
+	for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
+		SQLite3_row *r=*it;
+		if (atoi(r->fields[0]) == 0) {
+			continue;
+		}
+		const QP_firewall_whitelist_rules *wr = wl->find_rules(r->fields[1], r->fields[2], r->fields[3]);
+		lookups.push_back({ wr, atoi(r->fields[4]), strtoull(r->fields[5],NULL,0) });
+	}
+	unsigned long long t3 = monotonic_time();
+	int found = 0;
+	for (int loop = 0 ; loop < loops ; loop++) {
+		found = 0;
+		for (const auto& l : lookups) {
+			const QP_firewall_whitelist_rules *wr = std::get<0>(l);
+			if (wr && wr->allowed(std::get<1>(l), std::get<2>(l))) {
+				found++;
+			}
+		}
+	}
+	unsigned long long t4 = monotonic_time();
+	proxy_info(
+		"Compiled firewall whitelist: %lu rules, built in %llu us, resolved in %llu us, %d x %lu lookups in %llu us\n",
+		lookups.size(), t2 - t1, t3 - t2, loops, lookups.size(), t4 - t3
+	);
+	wl->release();
+	*ret1 = lookups.size();
+	*ret2 = found;
+	return true;
+}
+
 bool ProxySQL_Admin::ProxySQL_Test___Load_MySQL_Whitelist(int *ret1, int *ret2, int cmd, int loops) {
 	// cmd == 1 : populate the structure with a global mutex
 	// cmd == 2 : perform lookup with a global mutex
 	// cmd == 3 : perform lookup with a mutex for each call
 	// cmd == 4 : populate the structure with a global mutex , but without cleaning up
+	// cmd == 5 : build the compiled whitelist used by the sessions, and perform lookups on it
 	// all accept an extra argument that is the number of loops
 	char *q = (char *)"SELECT * FROM mysql_firewall_whitelist_rules ORDER BY RANDOM()";
 	char *error=NULL;
@@ -76,6 +121,8 @@ bool ProxySQL_Admin::ProxySQL_Test___Load_MySQL_Whitelist(int *ret1, int *ret2,
 	if (error) {
 		proxy_error("Error on %s : %s\n", q, error);
 		return false;
+	} else if (cmd == 5) {
+		ret = ProxySQL_Test___Load_MySQL_Whitelist_compiled(resultset, ret1, ret2, loops > 0 ? loops : 1);
 	} else {
 		*ret1 = resultset->rows_count;
 		int loop = 0;
@@ -769,7 +816,7 @@ void ProxySQL_Admin::ProxySQL_Test_Handler(ProxySQL_Admin *SPA, S* sess, char *q
 					if (test_arg1==0) {
 						test_arg1=1;
 					}
-					if (test_arg1 > 4) {
+					if (test_arg1 > 5) {
 						test_arg1=1;
 					}
 /*
@@ -784,7 +831,7 @@ void ProxySQL_Admin::ProxySQL_Test_Handler(ProxySQL_Admin *SPA, S* sess, char *q
 					SPA->ProxySQL_Test___Load_MySQL_Whitelist(&ret1, &ret2, test_arg1, test_arg2);
 					if (test_arg1==1 || test_arg1==4) {
 						SPA->send_ok_msg_to_client(sess, (char *)"Processed all rows from firewall whitelist", ret1, query_no_space);
-					} else if (test_arg1==2 || test_arg1==3) {
+					} else if (test_arg1==2 || test_arg1==3 || test_arg1==5) {
 						if (ret1 == ret2) {
 							SPA->send_ok_msg_to_client(sess, (char *)"Verified all rows from firewall whitelist", ret1, query_no_space);
 						} else {
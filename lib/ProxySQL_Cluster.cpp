@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <utility>
 
 #include "proxysql.h"
@@ -13,6 +14,7 @@
 #include "ProxySQL_Cluster.hpp"
 #include "MySQL_Authentication.hpp"
 #include "MySQL_LDAP_Authentication.hpp"
+#include "MySQL_Query_Processor.h"
 
 #ifdef DEBUG
 #define DEB "_DEBUG"
@@ -43,6 +45,8 @@ extern ProxySQL_Cluster * GloProxyCluster;
 extern ProxySQL_Admin *GloAdmin;
 extern MySQL_LDAP_Authentication* GloMyLdapAuth;
 extern MySQL_Authentication* GloMyAuth;
+extern MySQL_Query_Processor* GloMyQPro;
+extern pthread_mutex_t users_mutex;
 
 void * ProxySQL_Cluster_Monitor_thread(void *args) {
 	pthread_attr_t thread_attr;
@@ -68,6 +72,7 @@ void * ProxySQL_Cluster_Monitor_thread(void *args) {
 	int query_error_counter = 0;
 	char *query_error = NULL;
 	int cluster_check_status_frequency_count = 0;
+	uint64_t wake_up_seq = 0;
 	MYSQL *conn = mysql_init(NULL);
 
 	if (conn==NULL) {
@@ -221,13 +226,38 @@ void * ProxySQL_Cluster_Monitor_thread(void *args) {
 						}
 						if (++query_error_counter == QUERY_ERROR_RATE) query_error_counter = 0;
 					}
-					unsigned long long end_time=monotonic_time();
 					if (rc_query == 0) {
-						unsigned long long elapsed_time = (end_time - start_time);
-						unsigned long long e_ms = elapsed_time / 1000;
 						int ci = __sync_fetch_and_add(&GloProxyCluster->cluster_check_interval_ms,0);
-						if ((unsigned) ci > e_ms) {
-							usleep((ci-e_ms)*1000); // remember, usleep is in us
+						const unsigned long long next_check_time = start_time + (unsigned long long)ci * 1000;
+						// wait for the next check. With push notifications enabled, the wait is interrupted to
+						// notify the peer as soon as the local configuration changes, and to check the peer as
+						// soon as it notifies a change
+						while (glovars.shutdown == 0) {
+							if (GloProxyCluster->cluster_push_notifications) {
+								unsigned int fanout = __sync_fetch_and_add(&GloProxyCluster->cluster_push_fanout, 0);
+								bool push_send = false;
+								bool push_received = false;
+								rc_bool = GloProxyCluster->Fetch_Push_State(node->hostname, node->port, fanout, push_send, push_received);
+								if (push_send) {
+									proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Sending push notification to peer %s:%d\n", node->hostname, node->port);
+									rc_query = mysql_query(conn, CLUSTER_QUERY_PUSH_NOTIFICATION);
+									if (rc_query) {
+										proxy_error(
+											"Cluster: unable to run query on %s:%d using user %s : %s . Error: %s\n",
+											node->hostname, node->port, creds.user.c_str(), CLUSTER_QUERY_PUSH_NOTIFICATION, mysql_error(conn)
+										);
+									}
+								}
+								if (push_received) {
+									proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Received push notification from peer %s:%d\n", node->hostname, node->port);
+									break;
+								}
+							}
+							unsigned long long now = monotonic_time();
+							if (now >= next_check_time || rc_query || rc_bool == false) {
+								break;
+							}
+							GloProxyCluster->wait_monitor_wake_up(next_check_time - now, wake_up_seq);
 						}
 					}
 				}
@@ -294,6 +324,14 @@ ProxySQL_Node_Entry::ProxySQL_Node_Entry(char *_hostname, uint16_t _port, uint64
 ProxySQL_Node_Entry::ProxySQL_Node_Entry(char* _hostname, uint16_t _port, uint64_t _weight, char* _comment, char* ip) {
 	hash = 0;
 	global_checksum = 0;
+	// only the changes performed from now on are notified to the peer
+	push.checksum = __sync_fetch_and_add(&GloVars.checksums_values.global_checksum, 0);
+	push.received = false;
+	push.sent_cnt = 0;
+	push.received_cnt = 0;
+	global_checksum_changed_at = 0;
+	last_sync_lag_us = 0;
+	last_sync_age_s = 0;
 	ip_addr = NULL;
 	hostname = NULL;
 	if (_hostname) {
@@ -796,6 +834,26 @@ void ProxySQL_Node_Entry::set_checksums(MYSQL_RES *_r) {
 		if (v->diff_check)
 			v->diff_check++;
 	}
+	if (push.received) {
+		// the peer notified the change once loaded to runtime: there is no need to wait for more checks to
+		// confirm that its configuration is stable
+		push.received = false;
+		const std::pair<ProxySQL_Checksum_Value_2*, unsigned int> pushed_checksums[] = {
+			{ &checksums_values.admin_variables, diff_av },
+			{ &checksums_values.mysql_query_rules, diff_mqr },
+			{ &checksums_values.mysql_servers, diff_ms },
+			{ &checksums_values.mysql_servers_v2, diff_ms },
+			{ &checksums_values.mysql_users, diff_mu },
+			{ &checksums_values.mysql_variables, diff_mv },
+			{ &checksums_values.proxysql_servers, diff_ps },
+			{ &checksums_values.ldap_variables, diff_lv },
+		};
+		for (const auto& pushed : pushed_checksums) {
+			if (pushed.first->diff_check && pushed.first->diff_check < pushed.second) {
+				pushed.first->diff_check = pushed.second;
+			}
+		}
+	}
 	pthread_mutex_unlock(&GloVars.checksum_mutex);
 	// we now do a series of checks, and we take action
 	// note that this is done outside the critical section
@@ -1123,12 +1181,215 @@ uint64_t mysql_raw_checksum(MYSQL_RES* resultset) {
 	return res_hash;
 }
 
+/**
+ * @brief Returns the size of the data of a resultset received from a peer, for the 'pulled_bytes' metrics.
+ */
+static uint64_t get_mysql_res_bytes(MYSQL_RES* result) {
+	uint64_t bytes = 0;
+	if (result == nullptr) {
+		return bytes;
+	}
+	const unsigned int num_fields = mysql_num_fields(result);
+	while (mysql_fetch_row(result)) {
+		const unsigned long* lengths = mysql_fetch_lengths(result);
+		for (unsigned int i = 0; i < num_fields; i++) {
+			bytes += lengths[i];
+		}
+	}
+	mysql_data_seek(result, 0);
+	return bytes;
+}
+
+/**
+ * @brief Replaces the content of 'mysql_query_rules' and 'mysql_query_rules_fast_routing' with the rules fetched
+ *   from a peer, in the format of 'CLUSTER_QUERY_MYSQL_QUERY_RULES' and
+ *   'CLUSTER_QUERY_MYSQL_QUERY_RULES_FAST_ROUTING'.
+ */
+void update_mysql_query_rules(SQLite3_result* rules, SQLite3_result* fast_routing) {
+	//GloAdmin->admindb->execute("PRAGMA quick_check");
+	GloAdmin->admindb->execute("DELETE FROM mysql_query_rules");
+	GloAdmin->admindb->execute("DELETE FROM mysql_query_rules_fast_routing");
+	char *q = (char *)"INSERT INTO mysql_query_rules (rule_id, active, username, schemaname, flagIN, client_addr, proxy_addr, proxy_port, digest, match_digest, match_pattern, negate_match_pattern, re_modifiers, flagOUT, replace_pattern, destination_hostgroup, cache_ttl, cache_empty_result, cache_timeout, reconnect, timeout, retries, delay, next_query_flagIN, mirror_flagOUT, mirror_hostgroup, error_msg, ok_msg, sticky_conn, multiplex, gtid_from_hostgroup, log, apply, attributes, comment) VALUES (?1 , ?2 , ?3 , ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15, ?16, ?17, ?18, ?19, ?20, ?21, ?22, ?23, ?24, ?25, ?26, ?27, ?28, ?29, ?30, ?31, ?32, ?33, ?34, ?35)";
+	sqlite3_stmt *statement1 = NULL;
+	//sqlite3 *mydb3 = GloAdmin->admindb->get_db();
+	//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q, -1, &statement1, 0);
+	int rc = GloAdmin->admindb->prepare_v2(q, &statement1);
+	ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+	GloAdmin->admindb->execute("BEGIN TRANSACTION");
+	for (SQLite3_row* r : rules->rows) {
+		char **row = r->fields;
+		rc=(*proxy_sqlite3_bind_int64)(statement1, 1, atoll(row[0])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // rule_id
+		rc=(*proxy_sqlite3_bind_int64)(statement1, 2, 1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // active
+		rc=(*proxy_sqlite3_bind_text)(statement1, 3, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
+		rc=(*proxy_sqlite3_bind_text)(statement1, 4, row[2], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
+		rc=(*proxy_sqlite3_bind_text)(statement1, 5, row[3], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
+		rc=(*proxy_sqlite3_bind_text)(statement1, 6, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // client_addr
+		rc=(*proxy_sqlite3_bind_text)(statement1, 7, row[5], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // proxy_addr
+		rc=(*proxy_sqlite3_bind_text)(statement1, 8, row[6], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // proxy_port
+		rc=(*proxy_sqlite3_bind_text)(statement1, 9, row[7], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // digest
+		rc=(*proxy_sqlite3_bind_text)(statement1, 10, row[8], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // match_digest
+		rc=(*proxy_sqlite3_bind_text)(statement1, 11, row[9], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // match_pattern
+		rc=(*proxy_sqlite3_bind_text)(statement1, 12, row[10], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // negate_match_pattern
+		rc=(*proxy_sqlite3_bind_text)(statement1, 13, row[11], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // re_modifiers
+		rc=(*proxy_sqlite3_bind_text)(statement1, 14, row[12], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagOUT
+		rc=(*proxy_sqlite3_bind_text)(statement1, 15, row[13], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // replace_pattern
+		rc=(*proxy_sqlite3_bind_text)(statement1, 16, row[14], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
+		rc=(*proxy_sqlite3_bind_text)(statement1, 17, row[15], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_ttl
+		rc=(*proxy_sqlite3_bind_text)(statement1, 18, row[16], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_empty_result
+		rc=(*proxy_sqlite3_bind_text)(statement1, 19, row[17], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_timeout
+		rc=(*proxy_sqlite3_bind_text)(statement1, 20, row[18], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // reconnect
+		rc=(*proxy_sqlite3_bind_text)(statement1, 21, row[19], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // timeout
+		rc=(*proxy_sqlite3_bind_text)(statement1, 22, row[20], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // retries
+		rc=(*proxy_sqlite3_bind_text)(statement1, 23, row[21], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // delay
+		rc=(*proxy_sqlite3_bind_text)(statement1, 24, row[22], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // next_query_flagIN
+		rc=(*proxy_sqlite3_bind_text)(statement1, 25, row[23], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // mirror_flagOUT
+		rc=(*proxy_sqlite3_bind_text)(statement1, 26, row[24], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // mirror_hostgroup
+		rc=(*proxy_sqlite3_bind_text)(statement1, 27, row[25], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // error_msg
+		rc=(*proxy_sqlite3_bind_text)(statement1, 28, row[26], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // OK_msg
+		rc=(*proxy_sqlite3_bind_text)(statement1, 29, row[27], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // sticky_conn
+		rc=(*proxy_sqlite3_bind_text)(statement1, 30, row[28], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // multiplex
+		rc=(*proxy_sqlite3_bind_text)(statement1, 31, row[29], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // gtid_from_hostgroup
+		rc=(*proxy_sqlite3_bind_text)(statement1, 32, row[30], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // log
+		rc=(*proxy_sqlite3_bind_text)(statement1, 33, row[31], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // apply
+		rc=(*proxy_sqlite3_bind_text)(statement1, 34, row[32], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // attributes
+		rc=(*proxy_sqlite3_bind_text)(statement1, 35, row[33], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
+		SAFE_SQLITE3_STEP2(statement1);
+		rc=(*proxy_sqlite3_clear_bindings)(statement1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+		rc=(*proxy_sqlite3_reset)(statement1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+	}
+	(*proxy_sqlite3_finalize)(statement1);
+	GloAdmin->admindb->execute("COMMIT");
+
+
+	std::string query32frs = "INSERT INTO mysql_query_rules_fast_routing(username, schemaname, flagIN, destination_hostgroup, comment) VALUES " + generate_multi_rows_query(32,5);
+	char *q1fr = (char *)"INSERT INTO mysql_query_rules_fast_routing(username, schemaname, flagIN, destination_hostgroup, comment) VALUES (?1, ?2, ?3, ?4, ?5)";
+	char *q32fr = (char *)query32frs.c_str();
+	sqlite3_stmt *statement1fr = NULL;
+	sqlite3_stmt *statement32fr = NULL;
+	//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q1fr, -1, &statement1fr, 0);
+	rc = GloAdmin->admindb->prepare_v2(q1fr, &statement1fr);
+	ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+	//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q32fr, -1, &statement32fr, 0);
+	rc = GloAdmin->admindb->prepare_v2(q32fr, &statement32fr);
+	ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+	int row_idx=0;
+	int max_bulk_row_idx=fast_routing->rows_count/32;
+	max_bulk_row_idx=max_bulk_row_idx*32;
+	GloAdmin->admindb->execute("BEGIN TRANSACTION");
+	for (SQLite3_row* r : fast_routing->rows) {
+		char **row = r->fields;
+		int idx=row_idx%32;
+		if (row_idx<max_bulk_row_idx) { // bulk
+			rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+1, row[0], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
+			rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+2, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
+			rc=(*proxy_sqlite3_bind_int64)(statement32fr, (idx*5)+3, atoll(row[2])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
+			rc=(*proxy_sqlite3_bind_int64)(statement32fr, (idx*5)+4, atoll(row[3])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
+			rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+5, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
+			if (idx==31) {
+				SAFE_SQLITE3_STEP2(statement32fr);
+				rc=(*proxy_sqlite3_clear_bindings)(statement32fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+				rc=(*proxy_sqlite3_reset)(statement32fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+			}
+		} else { // single row
+			rc=(*proxy_sqlite3_bind_text)(statement1fr, 1, row[0], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
+			rc=(*proxy_sqlite3_bind_text)(statement1fr, 2, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
+			rc=(*proxy_sqlite3_bind_int64)(statement1fr, 3, atoll(row[2])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
+			rc=(*proxy_sqlite3_bind_int64)(statement1fr, 4, atoll(row[3])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
+			rc=(*proxy_sqlite3_bind_text)(statement1fr, 5, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
+			SAFE_SQLITE3_STEP2(statement1fr);
+			rc=(*proxy_sqlite3_clear_bindings)(statement1fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+			rc=(*proxy_sqlite3_reset)(statement1fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
+		}
+		row_idx++;
+	}
+	(*proxy_sqlite3_finalize)(statement1fr);
+	(*proxy_sqlite3_finalize)(statement32fr);
+	//GloAdmin->admindb->execute("PRAGMA integrity_check");
+	GloAdmin->admindb->execute("COMMIT");
+}
+
+bool ProxySQL_Cluster::pull_mysql_query_rules_changes_from_peer(
+	MYSQL* conn, const char* hostname, uint16_t port, const string& expected_checksum, const time_t epoch, uint64_t& bytes
+) {
+	if (__sync_fetch_and_add(&cluster_changelog_max_rows, 0) == 0) {
+		return false;
+	}
+	pthread_mutex_lock(&GloVars.checksum_mutex);
+	const string own_checksum { GloVars.checksums_values.mysql_query_rules.checksum };
+	pthread_mutex_unlock(&GloVars.checksum_mutex);
+
+	const string query { string { CLUSTER_QUERY_MYSQL_QUERY_RULES_CHANGES } + "'" + own_checksum + "'" };
+	if (mysql_query(conn, query.c_str())) {
+		proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching MySQL Query Rules changes since %s from peer %s:%d failed: %s\n", own_checksum.c_str(), hostname, port, mysql_error(conn));
+		proxy_info("Cluster: Fetching MySQL Query Rules changes since %s from peer %s:%d failed: %s\n", own_checksum.c_str(), hostname, port, mysql_error(conn));
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_query_rules_failure]->Increment();
+		return false;
+	}
+	MYSQL_RES* result = mysql_store_result(conn);
+	bytes += get_mysql_res_bytes(result);
+	std::unique_ptr<SQLite3_result> changes { get_SQLite3_resulset(result) };
+	mysql_free_result(result);
+	proxy_info(
+		"Cluster: Fetching MySQL Query Rules changes since %s from peer %s:%d completed: %d rows\n",
+		own_checksum.c_str(), hostname, port, changes ? changes->rows_count : 0
+	);
+
+	bool loaded = false;
+	// the runtime resultsets of the Query Processor are replaced only while holding 'sql_query_global_mutex'
+	pthread_mutex_lock(&GloAdmin->sql_query_global_mutex);
+	const vector<SQLite3_result*> base {
+		GloMyQPro->get_current_query_rules_inner(), GloMyQPro->get_current_query_rules_fast_routing_inner()
+	};
+	vector<SQLite3_result*> resultsets { mysql_query_rules_changelog.apply_changes(base, changes.get()) };
+	if (resultsets.size() == 2) {
+		const uint64_t query_rules_hash = resultsets[0]->raw_checksum() + resultsets[1]->raw_checksum();
+		const string computed_checksum { get_checksum_from_hash(query_rules_hash) };
+		if (expected_checksum == computed_checksum) {
+			proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Loading to runtime MySQL Query Rules changes from peer %s:%d\n", hostname, port);
+			proxy_info("Cluster: Loading to runtime MySQL Query Rules changes from peer %s:%d\n", hostname, port);
+			update_mysql_query_rules(resultsets[0], resultsets[1]);
+			// ownership of the resultsets is passed to the 'Query Processor'
+			GloAdmin->load_mysql_query_rules_to_runtime(resultsets[0], resultsets[1], expected_checksum, epoch);
+			if (GloProxyCluster->cluster_mysql_query_rules_save_to_disk == true) {
+				proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Saving to disk MySQL Query Rules from peer %s:%d\n", hostname, port);
+				proxy_info("Cluster: Saving to disk MySQL Query Rules from peer %s:%d\n", hostname, port);
+				GloAdmin->flush_GENERIC__from_to("mysql_query_rules", "memory_to_disk");
+			} else {
+				proxy_debug(PROXY_DEBUG_CLUSTER, 5, "NOT saving to disk MySQL Query Rules from peer %s:%d\n", hostname, port);
+				proxy_info("Cluster: NOT saving to disk MySQL Query Rules from peer %s:%d\n", hostname, port);
+			}
+			loaded = true;
+		} else {
+			proxy_info(
+				"Cluster: Applying MySQL Query Rules changes from peer %s:%d failed because of mismatching checksum. Expected: %s , Computed: %s\n",
+				hostname, port, expected_checksum.c_str(), computed_checksum.c_str()
+			);
+			delete resultsets[0];
+			delete resultsets[1];
+		}
+	} else {
+		proxy_info("Cluster: Applying MySQL Query Rules changes from peer %s:%d failed: changes don't match the local rules\n", hostname, port);
+	}
+	pthread_mutex_unlock(&GloAdmin->sql_query_global_mutex);
+
+	if (loaded) {
+		nodes.Record_Sync(hostname, port, epoch);
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_query_rules_success]->Increment();
+		metrics.p_counter_array[p_cluster_counter::pulled_mysql_query_rules_success]->Increment();
+	} else {
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_query_rules_failure]->Increment();
+	}
+	return loaded;
+}
+
 void ProxySQL_Cluster::pull_mysql_query_rules_from_peer(const string& expected_checksum, const time_t epoch) {
 	char * hostname = NULL;
 	char * ip_address = NULL;
 	uint16_t port = 0;
 	bool fetch_failed = false;
+	uint64_t pulled_bytes = 0;
 	pthread_mutex_lock(&GloProxyCluster->update_mysql_query_rules_mutex);
+	const unsigned long long start_time = monotonic_time();
 	nodes.get_peer_to_sync_mysql_query_rules(&hostname, &port, &ip_address);
 	if (hostname) {
 		cluster_creds_t creds {};
@@ -1157,15 +1418,21 @@ void ProxySQL_Cluster::pull_mysql_query_rules_from_peer(const string& expected_c
 			if (rc_conn) {
 				MySQL_Monitor::update_dns_cache_from_mysql_conn(conn);
 
+				if (pull_mysql_query_rules_changes_from_peer(conn, hostname, port, expected_checksum, epoch, pulled_bytes)) {
+					goto __exit_pull_mysql_query_rules_from_peer;
+				}
+
 				MYSQL_RES *result1 = NULL;
 				MYSQL_RES *result2 = NULL;
 				//rc_query = mysql_query(conn,"SELECT rule_id, username, schemaname, flagIN, client_addr, proxy_addr, proxy_port, digest, match_digest, match_pattern, negate_match_pattern, re_modifiers, flagOUT, replace_pattern, destination_hostgroup, cache_ttl, cache_empty_result, cache_timeout, reconnect, timeout, retries, delay, next_query_flagIN, mirror_flagOUT, mirror_hostgroup, error_msg, ok_msg, sticky_conn, multiplex, gtid_from_hostgroup, log, apply, attributes, comment FROM runtime_mysql_query_rules");
 				int rc_query = mysql_query(conn,CLUSTER_QUERY_MYSQL_QUERY_RULES);
 				if ( rc_query == 0 ) {
 					result1 = mysql_store_result(conn);
+					pulled_bytes += get_mysql_res_bytes(result1);
 					rc_query = mysql_query(conn,CLUSTER_QUERY_MYSQL_QUERY_RULES_FAST_ROUTING);
 					if ( rc_query == 0) {
 						result2 = mysql_store_result(conn);
+						pulled_bytes += get_mysql_res_bytes(result2);
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching MySQL Query Rules from peer %s:%d completed\n", hostname, port);
 						proxy_info("Cluster: Fetching MySQL Query Rules from peer %s:%d completed\n", hostname, port);
 
@@ -1182,105 +1449,7 @@ void ProxySQL_Cluster::pull_mysql_query_rules_from_peer(const string& expected_c
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Loading to runtime MySQL Query Rules from peer %s:%d\n", hostname, port);
 						proxy_info("Cluster: Loading to runtime MySQL Query Rules from peer %s:%d\n", hostname, port);
 						pthread_mutex_lock(&GloAdmin->sql_query_global_mutex);
-						//GloAdmin->admindb->execute("PRAGMA quick_check");
-						GloAdmin->admindb->execute("DELETE FROM mysql_query_rules");
-						GloAdmin->admindb->execute("DELETE FROM mysql_query_rules_fast_routing");
-						MYSQL_ROW row;
-						char *q = (char *)"INSERT INTO mysql_query_rules (rule_id, active, username, schemaname, flagIN, client_addr, proxy_addr, proxy_port, digest, match_digest, match_pattern, negate_match_pattern, re_modifiers, flagOUT, replace_pattern, destination_hostgroup, cache_ttl, cache_empty_result, cache_timeout, reconnect, timeout, retries, delay, next_query_flagIN, mirror_flagOUT, mirror_hostgroup, error_msg, ok_msg, sticky_conn, multiplex, gtid_from_hostgroup, log, apply, attributes, comment) VALUES (?1 , ?2 , ?3 , ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15, ?16, ?17, ?18, ?19, ?20, ?21, ?22, ?23, ?24, ?25, ?26, ?27, ?28, ?29, ?30, ?31, ?32, ?33, ?34, ?35)";
-						sqlite3_stmt *statement1 = NULL;
-						//sqlite3 *mydb3 = GloAdmin->admindb->get_db();
-						//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q, -1, &statement1, 0);
-						int rc = GloAdmin->admindb->prepare_v2(q, &statement1);
-						ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-						GloAdmin->admindb->execute("BEGIN TRANSACTION");
-						while ((row = mysql_fetch_row(result1))) {
-							rc=(*proxy_sqlite3_bind_int64)(statement1, 1, atoll(row[0])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // rule_id
-							rc=(*proxy_sqlite3_bind_int64)(statement1, 2, 1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // active
-							rc=(*proxy_sqlite3_bind_text)(statement1, 3, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
-							rc=(*proxy_sqlite3_bind_text)(statement1, 4, row[2], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
-							rc=(*proxy_sqlite3_bind_text)(statement1, 5, row[3], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
-							rc=(*proxy_sqlite3_bind_text)(statement1, 6, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // client_addr
-							rc=(*proxy_sqlite3_bind_text)(statement1, 7, row[5], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // proxy_addr
-							rc=(*proxy_sqlite3_bind_text)(statement1, 8, row[6], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // proxy_port
-							rc=(*proxy_sqlite3_bind_text)(statement1, 9, row[7], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // digest
-							rc=(*proxy_sqlite3_bind_text)(statement1, 10, row[8], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // match_digest
-							rc=(*proxy_sqlite3_bind_text)(statement1, 11, row[9], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // match_pattern
-							rc=(*proxy_sqlite3_bind_text)(statement1, 12, row[10], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // negate_match_pattern
-							rc=(*proxy_sqlite3_bind_text)(statement1, 13, row[11], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // re_modifiers
-							rc=(*proxy_sqlite3_bind_text)(statement1, 14, row[12], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagOUT
-							rc=(*proxy_sqlite3_bind_text)(statement1, 15, row[13], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // replace_pattern
-							rc=(*proxy_sqlite3_bind_text)(statement1, 16, row[14], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
-							rc=(*proxy_sqlite3_bind_text)(statement1, 17, row[15], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_ttl
-							rc=(*proxy_sqlite3_bind_text)(statement1, 18, row[16], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_empty_result
-							rc=(*proxy_sqlite3_bind_text)(statement1, 19, row[17], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // cache_timeout
-							rc=(*proxy_sqlite3_bind_text)(statement1, 20, row[18], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // reconnect
-							rc=(*proxy_sqlite3_bind_text)(statement1, 21, row[19], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // timeout
-							rc=(*proxy_sqlite3_bind_text)(statement1, 22, row[20], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // retries
-							rc=(*proxy_sqlite3_bind_text)(statement1, 23, row[21], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // delay
-							rc=(*proxy_sqlite3_bind_text)(statement1, 24, row[22], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // next_query_flagIN
-							rc=(*proxy_sqlite3_bind_text)(statement1, 25, row[23], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // mirror_flagOUT
-							rc=(*proxy_sqlite3_bind_text)(statement1, 26, row[24], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // mirror_hostgroup
-							rc=(*proxy_sqlite3_bind_text)(statement1, 27, row[25], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // error_msg
-							rc=(*proxy_sqlite3_bind_text)(statement1, 28, row[26], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // OK_msg
-							rc=(*proxy_sqlite3_bind_text)(statement1, 29, row[27], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // sticky_conn
-							rc=(*proxy_sqlite3_bind_text)(statement1, 30, row[28], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // multiplex
-							rc=(*proxy_sqlite3_bind_text)(statement1, 31, row[29], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // gtid_from_hostgroup
-							rc=(*proxy_sqlite3_bind_text)(statement1, 32, row[30], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // log
-							rc=(*proxy_sqlite3_bind_text)(statement1, 33, row[31], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // apply
-							rc=(*proxy_sqlite3_bind_text)(statement1, 34, row[32], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // attributes
-							rc=(*proxy_sqlite3_bind_text)(statement1, 35, row[33], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
-							SAFE_SQLITE3_STEP2(statement1);
-							rc=(*proxy_sqlite3_clear_bindings)(statement1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-							rc=(*proxy_sqlite3_reset)(statement1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-						}
-						(*proxy_sqlite3_finalize)(statement1);
-						GloAdmin->admindb->execute("COMMIT");
-
-
-						std::string query32frs = "INSERT INTO mysql_query_rules_fast_routing(username, schemaname, flagIN, destination_hostgroup, comment) VALUES " + generate_multi_rows_query(32,5);
-						char *q1fr = (char *)"INSERT INTO mysql_query_rules_fast_routing(username, schemaname, flagIN, destination_hostgroup, comment) VALUES (?1, ?2, ?3, ?4, ?5)";
-						char *q32fr = (char *)query32frs.c_str();
-						sqlite3_stmt *statement1fr = NULL;
-						sqlite3_stmt *statement32fr = NULL;
-						//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q1fr, -1, &statement1fr, 0);
-						rc = GloAdmin->admindb->prepare_v2(q1fr, &statement1fr);
-						ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-						//rc=(*proxy_sqlite3_prepare_v2)(mydb3, q32fr, -1, &statement32fr, 0);
-						rc = GloAdmin->admindb->prepare_v2(q32fr, &statement32fr);
-						ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-						int row_idx=0;
-						int max_bulk_row_idx=mysql_num_rows(result2)/32;
-						max_bulk_row_idx=max_bulk_row_idx*32;
-						GloAdmin->admindb->execute("BEGIN TRANSACTION");
-						while ((row = mysql_fetch_row(result2))) {
-							int idx=row_idx%32;
-							if (row_idx<max_bulk_row_idx) { // bulk
-								rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+1, row[0], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
-								rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+2, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
-								rc=(*proxy_sqlite3_bind_int64)(statement32fr, (idx*5)+3, atoll(row[2])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
-								rc=(*proxy_sqlite3_bind_int64)(statement32fr, (idx*5)+4, atoll(row[3])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
-								rc=(*proxy_sqlite3_bind_text)(statement32fr, (idx*5)+5, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
-								if (idx==31) {
-									SAFE_SQLITE3_STEP2(statement32fr);
-									rc=(*proxy_sqlite3_clear_bindings)(statement32fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-									rc=(*proxy_sqlite3_reset)(statement32fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-								}
-							} else { // single row
-								rc=(*proxy_sqlite3_bind_text)(statement1fr, 1, row[0], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
-								rc=(*proxy_sqlite3_bind_text)(statement1fr, 2, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // schemaname
-								rc=(*proxy_sqlite3_bind_int64)(statement1fr, 3, atoll(row[2])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // flagIN
-								rc=(*proxy_sqlite3_bind_int64)(statement1fr, 4, atoll(row[3])); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // destination_hostgroup
-								rc=(*proxy_sqlite3_bind_text)(statement1fr, 5, row[4], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // comment
-								SAFE_SQLITE3_STEP2(statement1fr);
-								rc=(*proxy_sqlite3_clear_bindings)(statement1fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-								rc=(*proxy_sqlite3_reset)(statement1fr); ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
-							}
-							row_idx++;
-						}
-						(*proxy_sqlite3_finalize)(statement1fr);
-						(*proxy_sqlite3_finalize)(statement32fr);
-						//GloAdmin->admindb->execute("PRAGMA integrity_check");
-						GloAdmin->admindb->execute("COMMIT");
+						update_mysql_query_rules(SQLite3_query_rules_resultset.get(), SQLite3_query_rules_fast_routing_resultset.get());
 
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Loading MySQL Query Rules to Runtime from peer %s:%d\n", hostname, port);
 						// We release the ownership of the memory for 'SQLite3' resultsets here since now it's no longer
@@ -1297,6 +1466,7 @@ void ProxySQL_Cluster::pull_mysql_query_rules_from_peer(const string& expected_c
 							proxy_info("Cluster: NOT saving to disk MySQL Query Rules from peer %s:%d\n", hostname, port);
 						}
 						pthread_mutex_unlock(&GloAdmin->sql_query_global_mutex);
+						nodes.Record_Sync(hostname, port, epoch);
 						metrics.p_counter_array[p_cluster_counter::pulled_mysql_query_rules_success]->Increment();
 
 						} else {
@@ -1335,6 +1505,8 @@ void ProxySQL_Cluster::pull_mysql_query_rules_from_peer(const string& expected_c
 			}
 		}
 __exit_pull_mysql_query_rules_from_peer:
+		metrics.p_counter_array[p_cluster_counter::pulled_bytes_mysql_query_rules]->Increment(pulled_bytes);
+		metrics.p_counter_array[p_cluster_counter::pull_time_mysql_query_rules]->Increment((monotonic_time() - start_time) / 1000000.0);
 		if (conn) {
 			if (conn->net.pvio) {
 				mysql_close(conn);
@@ -1363,7 +1535,7 @@ uint64_t get_mysql_users_checksum(
 	return raw_users_checksum;
 }
 
-void update_mysql_users(MYSQL_RES* result) {
+void update_mysql_users(SQLite3_result* result) {
 	GloAdmin->admindb->execute("DELETE FROM mysql_users");
 	char* q = (char *)"INSERT INTO mysql_users (username, password, active, use_ssl, default_hostgroup, default_schema,"
 		" schema_locked, transaction_persistent, fast_forward, backend, frontend, max_connections, attributes, comment)"
@@ -1373,7 +1545,8 @@ void update_mysql_users(MYSQL_RES* result) {
 	int rc = GloAdmin->admindb->prepare_v2(q, &statement1);
 	ASSERT_SQLITE_OK(rc, GloAdmin->admindb);
 
-	while (MYSQL_ROW row = mysql_fetch_row(result)) {
+	for (SQLite3_row* r : result->rows) {
+		char **row = r->fields;
 		rc=(*proxy_sqlite3_bind_text)(statement1, 1, row[0], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // username
 		rc=(*proxy_sqlite3_bind_text)(statement1, 2, row[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // password
 		rc=(*proxy_sqlite3_bind_int64)(statement1, 3, 1); ASSERT_SQLITE_OK(rc, GloAdmin->admindb); // active
@@ -1418,12 +1591,81 @@ void update_ldap_mappings(MYSQL_RES* result) {
 	}
 }
 
+bool ProxySQL_Cluster::pull_mysql_users_changes_from_peer(
+	MYSQL* conn, const char* hostname, uint16_t port, const string& expected_checksum, const time_t epoch, uint64_t& bytes
+) {
+	// the checksum of the users includes the LDAP mappings, which aren't tracked by the changelog
+	if (GloMyLdapAuth || __sync_fetch_and_add(&cluster_changelog_max_rows, 0) == 0) {
+		return false;
+	}
+	pthread_mutex_lock(&GloVars.checksum_mutex);
+	const string own_checksum { GloVars.checksums_values.mysql_users.checksum };
+	pthread_mutex_unlock(&GloVars.checksum_mutex);
+
+	const string query { string { CLUSTER_QUERY_MYSQL_USERS_CHANGES } + "'" + own_checksum + "'" };
+	if (mysql_query(conn, query.c_str())) {
+		proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching MySQL Users changes since %s from peer %s:%d failed: %s\n", own_checksum.c_str(), hostname, port, mysql_error(conn));
+		proxy_info("Cluster: Fetching MySQL Users changes since %s from peer %s:%d failed: %s\n", own_checksum.c_str(), hostname, port, mysql_error(conn));
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_users_failure]->Increment();
+		return false;
+	}
+	MYSQL_RES* result = mysql_store_result(conn);
+	bytes += get_mysql_res_bytes(result);
+	std::unique_ptr<SQLite3_result> changes { get_SQLite3_resulset(result) };
+	mysql_free_result(result);
+	proxy_info(
+		"Cluster: Fetching MySQL Users changes since %s from peer %s:%d completed: %d rows\n",
+		own_checksum.c_str(), hostname, port, changes ? changes->rows_count : 0
+	);
+
+	pthread_mutex_lock(&users_mutex);
+	const vector<SQLite3_result*> base { GloMyAuth->get_current_mysql_users() };
+	vector<SQLite3_result*> resultsets { mysql_users_changelog.apply_changes(base, changes.get()) };
+	pthread_mutex_unlock(&users_mutex);
+
+	unique_ptr<SQLite3_result> mysql_users_resultset { resultsets.size() == 1 ? resultsets[0] : nullptr };
+	if (mysql_users_resultset == nullptr) {
+		proxy_info("Cluster: Applying MySQL Users changes from peer %s:%d failed: changes don't match the local users\n", hostname, port);
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_users_failure]->Increment();
+		return false;
+	}
+	const string computed_checksum { get_checksum_from_hash(GloMyAuth->get_runtime_checksum(mysql_users_resultset.get())) };
+	if (expected_checksum != computed_checksum) {
+		proxy_info(
+			"Cluster: Applying MySQL Users changes from peer %s:%d failed because of mismatching checksum. Expected: %s , Computed: %s\n",
+			hostname, port, expected_checksum.c_str(), computed_checksum.c_str()
+		);
+		metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_users_failure]->Increment();
+		return false;
+	}
+
+	update_mysql_users(mysql_users_resultset.get());
+	proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Loading to runtime MySQL Users changes from peer %s:%d\n", hostname, port);
+	proxy_info("Cluster: Loading to runtime MySQL Users changes from peer %s:%d\n", hostname, port);
+	GloAdmin->init_users(std::move(mysql_users_resultset), expected_checksum, epoch);
+	if (GloProxyCluster->cluster_mysql_users_save_to_disk == true) {
+		proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Saving to disk MySQL Users from peer %s:%d\n", hostname, port);
+		proxy_info("Cluster: Saving to disk MySQL Users from peer %s:%d\n", hostname, port);
+		GloAdmin->flush_mysql_users__from_memory_to_disk();
+	} else {
+		proxy_debug(PROXY_DEBUG_CLUSTER, 5, "NOT saving to disk MySQL Users from peer %s:%d\n", hostname, port);
+		proxy_info("Cluster: NOT saving to disk MySQL Users from peer %s:%d\n", hostname, port);
+	}
+
+	nodes.Record_Sync(hostname, port, epoch);
+	metrics.p_counter_array[p_cluster_counter::pulled_changes_mysql_users_success]->Increment();
+	metrics.p_counter_array[p_cluster_counter::pulled_mysql_users_success]->Increment();
+	return true;
+}
+
 void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksum, const time_t epoch) {
 	char * hostname = NULL;
 	char * ip_address = NULL;
 	uint16_t port = 0;
 	bool fetch_failed = false;
+	uint64_t pulled_bytes = 0;
 	pthread_mutex_lock(&GloProxyCluster->update_mysql_users_mutex);
+	const unsigned long long start_time = monotonic_time();
 	nodes.get_peer_to_sync_mysql_users(&hostname, &port, &ip_address);
 	if (hostname) {
 		cluster_creds_t creds {};
@@ -1466,10 +1708,15 @@ void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksu
 
 			MySQL_Monitor::update_dns_cache_from_mysql_conn(conn);
 
+			if (pull_mysql_users_changes_from_peer(conn, hostname, port, expected_checksum, epoch, pulled_bytes)) {
+				goto __exit_pull_mysql_users_from_peer;
+			}
+
 			int rc_query = mysql_query(conn, CLUSTER_QUERY_MYSQL_USERS);
 			if (rc_query == 0) {
 				MYSQL_RES* mysql_users_result = mysql_store_result(conn);
 				MYSQL_RES* ldap_mapping_result = nullptr;
+				pulled_bytes += get_mysql_res_bytes(mysql_users_result);
 
 				proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching MySQL Users from peer %s:%d completed\n", hostname, port);
 				proxy_info("Cluster: Fetching MySQL Users from peer %s:%d completed\n", hostname, port);
@@ -1484,6 +1731,7 @@ void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksu
 
 					if (rc_query == 0) {
 						ldap_mapping_result = mysql_store_result(conn);
+						pulled_bytes += get_mysql_res_bytes(ldap_mapping_result);
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching LDAP Mappings from peer %s:%d completed\n", hostname, port);
 						proxy_info("Cluster: Fetching LDAP Mappings from peer %s:%d completed\n", hostname, port);
 					} else {
@@ -1502,7 +1750,7 @@ void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksu
 				proxy_info("Cluster: Computed checksum for MySQL Users from peer %s:%d : %s\n", hostname, port, computed_checksum.c_str());
 
 				if (expected_checksum == computed_checksum) {
-					update_mysql_users(mysql_users_result);
+					update_mysql_users(mysql_users_resultset.get());
 					mysql_free_result(mysql_users_result);
 
 					if (GloMyLdapAuth) {
@@ -1536,6 +1784,7 @@ void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksu
 						}
 					}
 
+					nodes.Record_Sync(hostname, port, epoch);
 					metrics.p_counter_array[p_cluster_counter::pulled_mysql_users_success]->Increment();
 
 					if (GloMyLdapAuth) {
@@ -1576,6 +1825,8 @@ void ProxySQL_Cluster::pull_mysql_users_from_peer(const string& expected_checksu
 			}
 		}
 __exit_pull_mysql_users_from_peer:
+		metrics.p_counter_array[p_cluster_counter::pulled_bytes_mysql_users]->Increment(pulled_bytes);
+		metrics.p_counter_array[p_cluster_counter::pull_time_mysql_users]->Increment((monotonic_time() - start_time) / 1000000.0);
 		if (conn) {
 			if (conn->net.pvio) {
 				mysql_close(conn);
@@ -1797,6 +2048,7 @@ void ProxySQL_Cluster::pull_runtime_mysql_servers_from_peer(const runtime_mysql_
 						// free result
 						mysql_free_result(result);
 
+						nodes.Record_Sync(hostname, port, peer_runtime_mysql_server.epoch);
 						metrics.p_counter_array[p_cluster_counter::pulled_mysql_servers_success]->Increment();
 					}
 				}
@@ -1865,7 +2117,9 @@ void ProxySQL_Cluster::pull_mysql_servers_v2_from_peer(const mysql_servers_v2_ch
 	char* peer_mysql_servers_v2_checksum = NULL;
 	char* peer_runtime_mysql_servers_checksum = NULL;
 	bool fetch_failed = false;
+	uint64_t pulled_bytes = 0;
 	pthread_mutex_lock(&GloProxyCluster->update_mysql_servers_v2_mutex);
+	const unsigned long long start_time = monotonic_time();
 	nodes.get_peer_to_sync_mysql_servers_v2(&hostname, &port, &peer_mysql_servers_v2_checksum, 
 		&peer_runtime_mysql_servers_checksum, &ip_address);
 	if (hostname) {
@@ -1991,6 +2245,7 @@ void ProxySQL_Cluster::pull_mysql_servers_v2_from_peer(const mysql_servers_v2_ch
 
 					if (it_err == 0) {
 						results[i] = fetch_res;
+						pulled_bytes += get_mysql_res_bytes(fetch_res);
 					} else {
 						fetching_error = true;
 						fetch_failed = true;
@@ -2017,6 +2272,7 @@ void ProxySQL_Cluster::pull_mysql_servers_v2_from_peer(const mysql_servers_v2_ch
 					MYSQL_RES* fetch_res = nullptr;
 					if (fetch_and_store(conn, query, &fetch_res) == 0) {
 						results[7] = fetch_res;
+						pulled_bytes += get_mysql_res_bytes(fetch_res);
 					} else {
 						fetching_error = true;
 					}
@@ -2326,6 +2582,7 @@ void ProxySQL_Cluster::pull_mysql_servers_v2_from_peer(const mysql_servers_v2_ch
 						mysql_free_result(result);
 					}
 
+					nodes.Record_Sync(hostname, port, peer_mysql_server_v2.epoch);
 					metrics.p_counter_array[p_cluster_counter::pulled_mysql_servers_success]->Increment();
 				}
 			} else {
@@ -2336,6 +2593,8 @@ void ProxySQL_Cluster::pull_mysql_servers_v2_from_peer(const mysql_servers_v2_ch
 			}
 		}
 	__exit_pull_mysql_servers_v2_from_peer:
+		metrics.p_counter_array[p_cluster_counter::pulled_bytes_mysql_servers]->Increment(pulled_bytes);
+		metrics.p_counter_array[p_cluster_counter::pull_time_mysql_servers]->Increment((monotonic_time() - start_time) / 1000000.0);
 		if (conn) {
 			if (conn->net.pvio) {
 				mysql_close(conn);
@@ -2511,6 +2770,7 @@ void ProxySQL_Cluster::pull_global_variables_from_peer(const string& var_type, c
 						proxy_error("Invalid parameter supplied to 'pull_global_variables_from_peer': var_type=%s\n", var_type.c_str());
 						assert(0);
 					}
+					nodes.Record_Sync(hostname, port, epoch);
 					metrics.p_counter_array[success_metric]->Increment();
 					} else {
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching %s Variables from peer %s:%d failed: Checksum changed from %s to %s\n",
@@ -2636,6 +2896,7 @@ void ProxySQL_Cluster::pull_proxysql_servers_from_peer(const std::string& expect
 							proxy_debug(PROXY_DEBUG_CLUSTER, 5, "NOT saving to disk ProxySQL Servers from peer %s:%d\n", hostname, port);
 							proxy_info("Cluster: NOT saving to disk ProxySQL Servers from peer %s:%d\n", hostname, port);
 						}
+						nodes.Record_Sync(hostname, port, epoch);
 						metrics.p_counter_array[p_cluster_counter::pulled_proxysql_servers_success]->Increment();
 					} else {
 						proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Fetching ProxySQL Servers from peer %s:%d failed: Checksum changed from %s to %s\n",
@@ -2973,6 +3234,7 @@ bool ProxySQL_Cluster_Nodes::Update_Global_Checksum(char * _h, uint16_t _p, MYSQ
 			} else {
 				proxy_debug(PROXY_DEBUG_CLUSTER, 5, "Global checksum for peer %s:%d is different from fetched one. Local checksum:[0x%lX] Fetched checksum:[0x%llX]\n", node->get_hostname(), node->get_port(), node->global_checksum, v);
 				node->global_checksum = v;
+				node->global_checksum_changed_at = monotonic_time();
 			}
 		}
 		//pthread_mutex_unlock(&GloVars.checksum_mutex);
@@ -3505,6 +3767,96 @@ void ProxySQL_Cluster_Nodes::get_peer_to_sync_proxysql_servers(char **host, uint
 	}
 }
 
+/**
+ * @brief Key used to select the peers notified of a local change: the peers with the lowest keys are notified.
+ *   Mixing the checksum into the key selects different peers for every change.
+ */
+static uint64_t push_target_key(uint64_t node_hash, uint64_t checksum) {
+	uint64_t k = node_hash ^ checksum;
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+bool ProxySQL_Cluster_Nodes::Receive_Push_Notification(const char* addr, const char* admin_mysql_ifaces) {
+	// the admin interfaces are in the format 'host1:port1;host2:port2', only the ports are relevant
+	std::vector<uint16_t> ports {};
+	const std::string ifaces { admin_mysql_ifaces };
+	size_t start = 0;
+	while (start < ifaces.size()) {
+		size_t end = ifaces.find(';', start);
+		if (end == std::string::npos) {
+			end = ifaces.size();
+		}
+		const std::string iface { ifaces.substr(start, end - start) };
+		const size_t sep = iface.rfind(':');
+		if (sep != std::string::npos) {
+			ports.push_back(atoi(iface.c_str() + sep + 1));
+		}
+		start = end + 1;
+	}
+	bool ret = false;
+	pthread_mutex_lock(&mutex);
+	for (const auto& entry : umap_proxy_nodes) {
+		ProxySQL_Node_Entry* node = entry.second;
+		const char* ip = node->get_ipaddress();
+		const bool same_host = strcmp(node->get_hostname(), addr) == 0 || (ip && strcmp(ip, addr) == 0);
+		if (same_host && std::find(ports.begin(), ports.end(), node->get_port()) != ports.end()) {
+			node->push.received = true;
+			node->push.received_cnt++;
+			ret = true;
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+bool ProxySQL_Cluster_Nodes::Fetch_Push_State(char* _h, uint16_t _p, unsigned int fanout, bool& send, bool& received) {
+	bool ret = false;
+	send = false;
+	received = false;
+	const uint64_t local_checksum = __sync_fetch_and_add(&GloVars.checksums_values.global_checksum, 0);
+	uint64_t hash_ = generate_hash(_h, _p);
+	pthread_mutex_lock(&mutex);
+	std::unordered_map<uint64_t, ProxySQL_Node_Entry *>::iterator ite = umap_proxy_nodes.find(hash_);
+	if (ite != umap_proxy_nodes.end()) {
+		ProxySQL_Node_Entry * node = ite->second;
+		if (node->push.checksum != local_checksum) {
+			node->push.checksum = local_checksum;
+			const uint64_t key = push_target_key(node->get_hash(), local_checksum);
+			unsigned int lower_keys = 0;
+			for (const auto& entry : umap_proxy_nodes) {
+				if (push_target_key(entry.second->get_hash(), local_checksum) < key) {
+					lower_keys++;
+				}
+			}
+			send = lower_keys < fanout;
+			if (send) {
+				node->push.sent_cnt++;
+			}
+		}
+		received = node->push.received;
+		ret = true;
+	}
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+void ProxySQL_Cluster_Nodes::Record_Sync(const char* _h, uint16_t _p, time_t epoch) {
+	uint64_t hash_ = generate_hash((char*)_h, _p);
+	std::unordered_map<uint64_t, ProxySQL_Node_Entry *>::iterator ite = umap_proxy_nodes.find(hash_);
+	if (ite != umap_proxy_nodes.end()) {
+		ProxySQL_Node_Entry * node = ite->second;
+		const unsigned long long curtime = monotonic_time();
+		const time_t now = time(NULL);
+		node->last_sync_lag_us = node->global_checksum_changed_at ? curtime - node->global_checksum_changed_at : 0;
+		node->last_sync_age_s = now > epoch ? now - epoch : 0;
+	}
+}
+
 SQLite3_result * ProxySQL_Cluster_Nodes::stats_proxysql_servers_checksums() {
 	const int colnum=9;
 	SQLite3_result *result=new SQLite3_result(colnum);
@@ -3591,7 +3943,7 @@ SQLite3_result * ProxySQL_Cluster_Nodes::stats_proxysql_servers_checksums() {
 }
 
 SQLite3_result * ProxySQL_Cluster_Nodes::stats_proxysql_servers_metrics() {
-	const int colnum=10;
+	const int colnum=14;
 	SQLite3_result *result=new SQLite3_result(colnum);
 	result->add_column_definition(SQLITE_TEXT,"hostname");
 	result->add_column_definition(SQLITE_TEXT,"port");
@@ -3603,6 +3955,10 @@ SQLite3_result * ProxySQL_Cluster_Nodes::stats_proxysql_servers_metrics() {
 	result->add_column_definition(SQLITE_TEXT,"Queries");
 	result->add_column_definition(SQLITE_TEXT,"Client_Connections_connected");
 	result->add_column_definition(SQLITE_TEXT,"Client_Connections_created");
+	result->add_column_definition(SQLITE_TEXT,"Push_Notifications_sent");
+	result->add_column_definition(SQLITE_TEXT,"Push_Notifications_received");
+	result->add_column_definition(SQLITE_TEXT,"Last_Sync_Lag_ms");
+	result->add_column_definition(SQLITE_TEXT,"Last_Sync_Age_s");
 
 	char buf[32];
 	int k;
@@ -3631,6 +3987,14 @@ SQLite3_result * ProxySQL_Cluster_Nodes::stats_proxysql_servers_metrics() {
 		pta[8]=strdup(buf);
 		sprintf(buf,"%llu", curr->Client_Connections_created);
 		pta[9]=strdup(buf);
+		sprintf(buf,"%llu", node->push.sent_cnt);
+		pta[10]=strdup(buf);
+		sprintf(buf,"%llu", node->push.received_cnt);
+		pta[11]=strdup(buf);
+		sprintf(buf,"%llu", node->last_sync_lag_us/1000);
+		pta[12]=strdup(buf);
+		sprintf(buf,"%ld", (long)node->last_sync_age_s);
+		pta[13]=strdup(buf);
 
 		result->add_row(pta);
 		for (k=0; k<colnum; k++) {
@@ -4200,6 +4564,122 @@ cluster_metrics_map = std::make_tuple(
 			}
 		),
 
+		// pulled_changes
+		// ====================================================================
+		std::make_tuple (
+			p_cluster_counter::pulled_changes_mysql_query_rules_success,
+			"proxysql_cluster_pulled_changes_total",
+			"Number of times only the changes to a 'module' have been pulled from a peer. Failures fall back to pull the whole 'module'.",
+			metric_tags {
+				{ "module_name", "mysql_query_rules" },
+				{ "status", "success" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pulled_changes_mysql_query_rules_failure,
+			"proxysql_cluster_pulled_changes_total",
+			"Number of times only the changes to a 'module' have been pulled from a peer. Failures fall back to pull the whole 'module'.",
+			metric_tags {
+				{ "module_name", "mysql_query_rules" },
+				{ "status", "failure" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pulled_changes_mysql_users_success,
+			"proxysql_cluster_pulled_changes_total",
+			"Number of times only the changes to a 'module' have been pulled from a peer. Failures fall back to pull the whole 'module'.",
+			metric_tags {
+				{ "module_name", "mysql_users" },
+				{ "status", "success" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pulled_changes_mysql_users_failure,
+			"proxysql_cluster_pulled_changes_total",
+			"Number of times only the changes to a 'module' have been pulled from a peer. Failures fall back to pull the whole 'module'.",
+			metric_tags {
+				{ "module_name", "mysql_users" },
+				{ "status", "failure" }
+			}
+		),
+		// ====================================================================
+
+		// pulled_bytes
+		// ====================================================================
+		std::make_tuple (
+			p_cluster_counter::pulled_bytes_mysql_query_rules,
+			"proxysql_cluster_pulled_bytes_total",
+			"Number of bytes of data received while pulling a 'module' from a peer.",
+			metric_tags {
+				{ "module_name", "mysql_query_rules" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pulled_bytes_mysql_servers,
+			"proxysql_cluster_pulled_bytes_total",
+			"Number of bytes of data received while pulling a 'module' from a peer.",
+			metric_tags {
+				{ "module_name", "mysql_servers" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pulled_bytes_mysql_users,
+			"proxysql_cluster_pulled_bytes_total",
+			"Number of bytes of data received while pulling a 'module' from a peer.",
+			metric_tags {
+				{ "module_name", "mysql_users" }
+			}
+		),
+		// ====================================================================
+
+		// pull_time
+		// ====================================================================
+		std::make_tuple (
+			p_cluster_counter::pull_time_mysql_query_rules,
+			"proxysql_cluster_pull_seconds_total",
+			"Time spent pulling a 'module' from a peer, loading it to runtime included.",
+			metric_tags {
+				{ "module_name", "mysql_query_rules" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pull_time_mysql_servers,
+			"proxysql_cluster_pull_seconds_total",
+			"Time spent pulling a 'module' from a peer, loading it to runtime included.",
+			metric_tags {
+				{ "module_name", "mysql_servers" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::pull_time_mysql_users,
+			"proxysql_cluster_pull_seconds_total",
+			"Time spent pulling a 'module' from a peer, loading it to runtime included.",
+			metric_tags {
+				{ "module_name", "mysql_users" }
+			}
+		),
+		// ====================================================================
+
+		// push notifications
+		// ====================================================================
+		std::make_tuple (
+			p_cluster_counter::push_notifications_sent,
+			"proxysql_cluster_push_notifications_total",
+			"Number of configuration change notifications exchanged with peers.",
+			metric_tags {
+				{ "direction", "sent" }
+			}
+		),
+		std::make_tuple (
+			p_cluster_counter::push_notifications_received,
+			"proxysql_cluster_push_notifications_total",
+			"Number of configuration change notifications exchanged with peers.",
+			metric_tags {
+				{ "direction", "received" }
+			}
+		),
+		// ====================================================================
+
 		// sync_conflict same epoch
 		// ====================================================================
 		std::make_tuple (
@@ -4337,7 +4817,31 @@ cluster_metrics_map = std::make_tuple(
 	cluster_gauge_vector {}
 );
 
-ProxySQL_Cluster::ProxySQL_Cluster() : proxysql_servers_to_monitor(NULL) {
+/**
+ * @brief Order of 'runtime_mysql_query_rules': 'ORDER BY rule_id'.
+ */
+static bool cmp_query_rules_rows(char **a, char **b) {
+	return atoll(a[0]) < atoll(b[0]);
+}
+
+/**
+ * @brief Order of 'runtime_mysql_query_rules_fast_routing': 'ORDER BY username, schemaname, flagIN'.
+ * @details Text columns use the SQLite 'BINARY' collation, equivalent to 'strcmp()'.
+ */
+static bool cmp_query_rules_fast_routing_rows(char **a, char **b) {
+	int r = strcmp(a[0], b[0]);
+	if (r == 0) {
+		r = strcmp(a[1], b[1]);
+	}
+	if (r == 0) {
+		return atoll(a[2]) < atoll(b[2]);
+	}
+	return r < 0;
+}
+
+ProxySQL_Cluster::ProxySQL_Cluster() : proxysql_servers_to_monitor(NULL),
+	mysql_query_rules_changelog({ 34, 5 }, { cmp_query_rules_rows, cmp_query_rules_fast_routing_rows }),
+	mysql_users_changelog({ 13 }, { nullptr }) {
 	pthread_mutex_init(&mutex,NULL);
 	pthread_mutex_init(&update_mysql_query_rules_mutex,NULL);
 	pthread_mutex_init(&update_runtime_mysql_servers_mutex,NULL);
@@ -4360,6 +4864,10 @@ ProxySQL_Cluster::ProxySQL_Cluster() : proxysql_servers_to_monitor(NULL) {
 	cluster_mysql_users_save_to_disk = true;
 	cluster_proxysql_servers_save_to_disk = true;
 	cluster_mysql_servers_sync_algorithm = 1;
+	cluster_changelog_max_rows = 100000;
+	cluster_push_notifications = false;
+	cluster_push_fanout = 3;
+	wake_up_seq = 0;
 	init_prometheus_counter_array<cluster_metrics_map_idx, p_cluster_counter>(cluster_metrics_map, this->metrics.p_counter_array);
 	init_prometheus_gauge_array<cluster_metrics_map_idx, p_cluster_gauge>(cluster_metrics_map, this->metrics.p_gauge_array);
 }
@@ -4383,6 +4891,37 @@ void ProxySQL_Cluster::p_update_metrics() {
 	this->nodes.update_prometheus_nodes_metrics();
 };
 
+void ProxySQL_Cluster::wake_monitor_threads() {
+	{
+		std::lock_guard<std::mutex> lock(wake_up_mutex);
+		wake_up_seq++;
+	}
+	wake_up_cond.notify_all();
+}
+
+void ProxySQL_Cluster::wait_monitor_wake_up(unsigned long long timeout_us, uint64_t& seq) {
+	std::unique_lock<std::mutex> lock(wake_up_mutex);
+	wake_up_cond.wait_for(lock, std::chrono::microseconds(timeout_us), [&] { return wake_up_seq != seq; });
+	seq = wake_up_seq;
+}
+
+bool ProxySQL_Cluster::Fetch_Push_State(char* _h, uint16_t _p, unsigned int fanout, bool& send, bool& received) {
+	bool ret = nodes.Fetch_Push_State(_h, _p, fanout, send, received);
+	if (send) {
+		metrics.p_counter_array[p_cluster_counter::push_notifications_sent]->Increment();
+	}
+	return ret;
+}
+
+bool ProxySQL_Cluster::Receive_Push_Notification(const char* addr, const char* admin_mysql_ifaces) {
+	bool ret = nodes.Receive_Push_Notification(addr, admin_mysql_ifaces);
+	if (ret) {
+		metrics.p_counter_array[p_cluster_counter::push_notifications_received]->Increment();
+		wake_monitor_threads();
+	}
+	return ret;
+}
+
 // this function returns credentials to the caller, used by monitoring threads
 cluster_creds_t ProxySQL_Cluster::get_credentials() {
 	pthread_mutex_lock(&mutex);
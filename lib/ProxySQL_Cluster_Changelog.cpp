@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "proxysql.h"
+#include "cpp.h"
+#ifndef SPOOKYV2
+#include "SpookyV2.h"
+#define SPOOKYV2
+#endif
+
+#include "ProxySQL_Cluster_Changelog.hpp"
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+/**
+ * @brief Hash of the content of a row, used to match the rows of two versions of a table.
+ * @details The length of each field is hashed as well, so that NULL, empty fields and fields boundaries are
+ *   all told apart.
+ */
+static uint64_t row_hash(char **fields, int cnt) {
+	SpookyHash myhash;
+	myhash.Init(23,5);
+	for (int i = 0; i < cnt; i++) {
+		uint32_t len = UINT32_MAX;
+		if (fields[i]) {
+			len = strlen(fields[i]);
+			myhash.Update(&len, sizeof(len));
+			myhash.Update(fields[i], len);
+		} else {
+			myhash.Update(&len, sizeof(len));
+		}
+	}
+	uint64_t hash1, hash2;
+	myhash.Final(&hash1, &hash2);
+	return hash1;
+}
+
+ProxySQL_Cluster_Changelog::ProxySQL_Cluster_Changelog(
+	const vector<int>& _table_columns, const vector<row_cmp_t>& _row_cmps
+) : table_columns(_table_columns), row_cmps(_row_cmps), columns(0), num_rows(0) {
+	assert(table_columns.size() == row_cmps.size());
+	for (int c : table_columns) {
+		columns = std::max(columns, c);
+	}
+}
+
+ProxySQL_Cluster_Changelog::~ProxySQL_Cluster_Changelog() {
+	_reset();
+}
+
+SQLite3_result* ProxySQL_Cluster_Changelog::new_changes_resultset() const {
+	SQLite3_result* result = new SQLite3_result(columns + 2);
+	result->add_column_definition(SQLITE_TEXT, "op");
+	result->add_column_definition(SQLITE_TEXT, "tbl");
+	for (int i = 0; i < columns; i++) {
+		const string name { "c" + std::to_string(i) };
+		result->add_column_definition(SQLITE_TEXT, name.c_str());
+	}
+	return result;
+}
+
+SQLite3_result* ProxySQL_Cluster_Changelog::diff(const vector<SQLite3_result*>& prev, const vector<SQLite3_result*>& cur) const {
+	if (prev.size() != table_columns.size() || cur.size() != table_columns.size()) {
+		return NULL;
+	}
+	for (size_t t = 0; t < table_columns.size(); t++) {
+		if (prev[t] == NULL || cur[t] == NULL) {
+			return NULL;
+		}
+		if (prev[t]->columns != table_columns[t] || cur[t]->columns != table_columns[t]) {
+			return NULL;
+		}
+	}
+	SQLite3_result* changes = new_changes_resultset();
+	vector<char *> change(columns + 2, NULL);
+	const auto add_change = [&] (const char* op, size_t t, char **fields) -> void {
+		const string tbl { std::to_string(t) };
+		change[0] = const_cast<char*>(op);
+		change[1] = const_cast<char*>(tbl.c_str());
+		for (int i = 0; i < columns; i++) {
+			change[i + 2] = i < table_columns[t] ? fields[i] : NULL;
+		}
+		changes->add_row(&change[0]);
+	};
+	// deleted rows of all the tables are recorded first, see 'apply_changes()'
+	vector<vector<char **>> inserted(table_columns.size());
+	for (size_t t = 0; t < table_columns.size(); t++) {
+		unordered_map<uint64_t, char **> prev_rows {};
+		prev_rows.reserve(prev[t]->rows.size());
+		for (SQLite3_row* r : prev[t]->rows) {
+			prev_rows.emplace(row_hash(r->fields, table_columns[t]), r->fields);
+		}
+		for (SQLite3_row* r : cur[t]->rows) {
+			if (prev_rows.erase(row_hash(r->fields, table_columns[t])) == 0) {
+				inserted[t].push_back(r->fields);
+			}
+		}
+		for (const auto& prev_row : prev_rows) {
+			add_change("D", t, prev_row.second);
+		}
+	}
+	for (size_t t = 0; t < table_columns.size(); t++) {
+		for (char **fields : inserted[t]) {
+			add_change("I", t, fields);
+		}
+	}
+	return changes;
+}
+
+void ProxySQL_Cluster_Changelog::add(const string& from, const string& to, SQLite3_result* changes, unsigned int max_rows) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (changes == NULL || max_rows == 0 || (unsigned int)changes->rows_count > max_rows) {
+		delete changes;
+		_reset();
+		return;
+	}
+	if (from == to && changes->rows_count == 0) {
+		// reload without changes
+		delete changes;
+		return;
+	}
+	if (entries.empty() == false && entries.back().to != from) {
+		_reset();
+	}
+	entries.push_back({ from, to, changes });
+	num_rows += changes->rows_count;
+	while (num_rows > max_rows) {
+		entry_t& entry = entries.front();
+		num_rows -= entry.changes->rows_count;
+		delete entry.changes;
+		entries.pop_front();
+	}
+}
+
+SQLite3_result* ProxySQL_Cluster_Changelog::get_changes(const string& checksum) {
+	std::lock_guard<std::mutex> lock(mutex);
+	// the same checksum can be present more than once, i.e. after a change is reverted: the most recent entry
+	// returns the shortest list of changes
+	size_t first = entries.size();
+	while (first > 0) {
+		if (entries[first - 1].from == checksum) {
+			break;
+		}
+		first--;
+	}
+	if (first == 0) {
+		return NULL;
+	}
+	SQLite3_result* result = new_changes_resultset();
+	for (size_t i = first - 1; i < entries.size(); i++) {
+		for (SQLite3_row* r : entries[i].changes->rows) {
+			result->add_row(r);
+		}
+	}
+	return result;
+}
+
+vector<SQLite3_result*> ProxySQL_Cluster_Changelog::apply_changes(
+	const vector<SQLite3_result*>& base, const SQLite3_result* changes
+) const {
+	vector<SQLite3_result*> results {};
+	if (base.size() != table_columns.size() || changes == NULL || changes->columns != columns + 2) {
+		return results;
+	}
+	vector<unordered_map<uint64_t, char **>> tables(table_columns.size());
+	for (size_t t = 0; t < table_columns.size(); t++) {
+		if (base[t] == NULL || base[t]->columns != table_columns[t]) {
+			return results;
+		}
+		tables[t].reserve(base[t]->rows.size());
+		for (SQLite3_row* r : base[t]->rows) {
+			if (tables[t].emplace(row_hash(r->fields, table_columns[t]), r->fields).second == false) {
+				return results;
+			}
+		}
+	}
+	// changes are applied in order: the 'D' of an updated row always precedes its 'I'
+	for (SQLite3_row* r : changes->rows) {
+		if (r->fields[0] == NULL || r->fields[1] == NULL) {
+			return results;
+		}
+		const int t = atoi(r->fields[1]);
+		if (t < 0 || t >= (int)table_columns.size()) {
+			return results;
+		}
+		char **fields = r->fields + 2;
+		const uint64_t hash = row_hash(fields, table_columns[t]);
+		if (strcmp(r->fields[0], "D") == 0) {
+			if (tables[t].erase(hash) == 0) {
+				return results;
+			}
+		} else if (strcmp(r->fields[0], "I") == 0) {
+			if (tables[t].emplace(hash, fields).second == false) {
+				return results;
+			}
+		} else {
+			return results;
+		}
+	}
+	for (size_t t = 0; t < table_columns.size(); t++) {
+		vector<char **> rows {};
+		rows.reserve(tables[t].size());
+		for (const auto& row : tables[t]) {
+			rows.push_back(row.second);
+		}
+		if (row_cmps[t]) {
+			std::sort(rows.begin(), rows.end(), row_cmps[t]);
+		}
+		SQLite3_result* result = new SQLite3_result(table_columns[t]);
+		for (SQLite3_column* c : base[t]->column_definition) {
+			result->add_column_definition(c->datatype, c->name);
+		}
+		for (char **fields : rows) {
+			result->add_row(fields);
+		}
+		results.push_back(result);
+	}
+	return results;
+}
+
+void ProxySQL_Cluster_Changelog::_reset() {
+	for (entry_t& entry : entries) {
+		delete entry.changes;
+	}
+	entries.clear();
+	num_rows = 0;
+}
+
+void ProxySQL_Cluster_Changelog::reset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	_reset();
+}
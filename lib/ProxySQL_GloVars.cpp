@@ -13,8 +13,10 @@
 #include <uuid/uuid.h>
 
 #include "MySQL_LDAP_Authentication.hpp"
+#include "ProxySQL_Cluster.hpp"
 
 extern MySQL_LDAP_Authentication* GloMyLdapAuth;
+extern ProxySQL_Cluster* GloProxyCluster;
 
 void (*flush_logs_function)() = NULL;
 
@@ -624,6 +626,12 @@ uint64_t ProxySQL_GlobalVariables::generate_global_checksum() {
 	uint64_t h1, h2;
 	myhash.Final(&h1, &h2);
 	h1 = h1/2; // ugly way to make it signed within LLONG_MAX
-	checksums_values.global_checksum = h1;
+	if (checksums_values.global_checksum != h1) {
+		checksums_values.global_checksum = h1;
+		// the monitor threads notify the change to the peers
+		if (GloProxyCluster && GloProxyCluster->cluster_push_notifications) {
+			GloProxyCluster->wake_monitor_threads();
+		}
+	}
 	return h1;
 }
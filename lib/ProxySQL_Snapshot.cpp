@@ -0,0 +1,281 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "proxysql.h"
+#include "cpp.h"
+#ifndef SPOOKYV2
+#include "SpookyV2.h"
+#define SPOOKYV2
+#endif
+
+#include "ProxySQL_Snapshot.hpp"
+
+using std::string;
+using std::vector;
+
+#define SNAPSHOT_MAGIC "PSQLSNAP"
+#define SNAPSHOT_MAGIC_LEN 8
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_TRAILER_LEN (2 * sizeof(uint64_t))
+
+static void put_u32(string& buf, uint32_t v) {
+	buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void put_i64(string& buf, int64_t v) {
+	buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void put_str(string& buf, const char* s) {
+	if (s == NULL) {
+		put_u32(buf, UINT32_MAX);
+		return;
+	}
+	const uint32_t len = strlen(s);
+	put_u32(buf, len);
+	buf.append(s, len + 1);
+}
+
+/**
+ * @brief Bounds checked cursor over the mapped snapshot file.
+ * @details Any read past the end of the payload sets 'err', after which all the reads return zeroed values.
+ */
+class snapshot_reader_t {
+	public:
+	snapshot_reader_t(const char* _data, size_t _size) : data(_data), size(_size), pos(0), err(false) {}
+	uint32_t get_u32() {
+		uint32_t v = 0;
+		if (check(sizeof(v))) {
+			memcpy(&v, data + pos, sizeof(v));
+			pos += sizeof(v);
+		}
+		return v;
+	}
+	int64_t get_i64() {
+		int64_t v = 0;
+		if (check(sizeof(v))) {
+			memcpy(&v, data + pos, sizeof(v));
+			pos += sizeof(v);
+		}
+		return v;
+	}
+	/**
+	 * @brief Returns a pointer to the next string, within the mapped file. NULL for NULL fields, or on error.
+	 */
+	const char* get_str() {
+		const uint32_t len = get_u32();
+		if (err || len == UINT32_MAX) {
+			return NULL;
+		}
+		if (check(static_cast<size_t>(len) + 1) == false || data[pos + len] != '\0') {
+			err = true;
+			return NULL;
+		}
+		const char* s = data + pos;
+		pos += static_cast<size_t>(len) + 1;
+		return s;
+	}
+	bool error() const { return err; }
+	bool at_end() const { return pos == size; }
+	private:
+	bool check(size_t len) {
+		if (err || len > size - pos) {
+			err = true;
+		}
+		return err == false;
+	}
+	const char* data;
+	size_t size;
+	size_t pos;
+	bool err;
+};
+
+string ProxySQL_Snapshot::serialize(const vector<section_t>& sections) {
+	string buf {};
+	buf.append(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+	put_u32(buf, SNAPSHOT_VERSION);
+	put_u32(buf, sections.size());
+
+	for (const section_t& section : sections) {
+		put_str(buf, section.name.c_str());
+		put_str(buf, section.checksum.c_str());
+		put_i64(buf, section.epoch);
+		put_u32(buf, section.resultsets.size());
+
+		for (const SQLite3_result* resultset : section.resultsets) {
+			put_u32(buf, resultset->columns);
+			put_u32(buf, resultset->rows.size());
+			for (const SQLite3_column* column : resultset->column_definition) {
+				put_u32(buf, column->datatype);
+				put_str(buf, column->name);
+			}
+			for (const SQLite3_row* row : resultset->rows) {
+				for (int i = 0; i < resultset->columns; i++) {
+					put_str(buf, row->fields[i]);
+				}
+			}
+		}
+	}
+
+	uint64_t hash1 = 0, hash2 = 0;
+	SpookyHash::Hash128(buf.data(), buf.size(), &hash1, &hash2);
+	buf.append(reinterpret_cast<const char*>(&hash1), sizeof(hash1));
+	buf.append(reinterpret_cast<const char*>(&hash2), sizeof(hash2));
+
+	return buf;
+}
+
+bool ProxySQL_Snapshot::write(const string& path, const string& buf, string& err) {
+	const string tmp_path { path + ".tmp" };
+	int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		err = "Unable to open " + tmp_path + ": " + strerror(errno);
+		return false;
+	}
+	size_t written = 0;
+	while (written < buf.size()) {
+		ssize_t rc = ::write(fd, buf.data() + written, buf.size() - written);
+		if (rc < 0) {
+			if (errno == EINTR) continue;
+			err = "Unable to write " + tmp_path + ": " + strerror(errno);
+			close(fd);
+			unlink(tmp_path.c_str());
+			return false;
+		}
+		written += rc;
+	}
+	if (fsync(fd) != 0) {
+		err = "Unable to fsync " + tmp_path + ": " + strerror(errno);
+		close(fd);
+		unlink(tmp_path.c_str());
+		return false;
+	}
+	close(fd);
+	if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+		err = "Unable to rename " + tmp_path + " to " + path + ": " + strerror(errno);
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+static bool parse_sections(
+	const char* data, size_t size, vector<ProxySQL_Snapshot::section_t>& sections, string& err
+) {
+	snapshot_reader_t reader { data + SNAPSHOT_MAGIC_LEN, size - SNAPSHOT_MAGIC_LEN };
+	const uint32_t version = reader.get_u32();
+	if (version != SNAPSHOT_VERSION) {
+		err = "unsupported version " + std::to_string(version);
+		return false;
+	}
+	const uint32_t sections_cnt = reader.get_u32();
+	vector<const char*> fields {};
+
+	for (uint32_t s = 0; s < sections_cnt && reader.error() == false; s++) {
+		const char* name = reader.get_str();
+		const char* checksum = reader.get_str();
+		const int64_t epoch = reader.get_i64();
+		const uint32_t resultsets_cnt = reader.get_u32();
+		if (name == NULL || checksum == NULL) {
+			break;
+		}
+		sections.push_back({ name, checksum, static_cast<time_t>(epoch), {} });
+		ProxySQL_Snapshot::section_t& section = sections.back();
+
+		for (uint32_t r = 0; r < resultsets_cnt && reader.error() == false; r++) {
+			const uint32_t columns = reader.get_u32();
+			const uint32_t rows = reader.get_u32();
+			if (reader.error() || columns == 0 || columns > 1024) {
+				break;
+			}
+			SQLite3_result* resultset = new SQLite3_result(columns);
+			section.resultsets.push_back(resultset);
+
+			for (uint32_t c = 0; c < columns; c++) {
+				const int datatype = reader.get_u32();
+				const char* col_name = reader.get_str();
+				resultset->add_column_definition(datatype, col_name ? col_name : "");
+			}
+			fields.resize(columns);
+			for (uint32_t i = 0; i < rows && reader.error() == false; i++) {
+				for (uint32_t c = 0; c < columns; c++) {
+					fields[c] = reader.get_str();
+				}
+				if (reader.error() == false) {
+					resultset->add_row(&fields[0]);
+				}
+			}
+		}
+	}
+
+	if (reader.error() || reader.at_end() == false) {
+		err = "malformed content";
+		return false;
+	}
+
+	return true;
+}
+
+bool ProxySQL_Snapshot::read(const string& path, vector<section_t>& sections, string& err) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		err = "Unable to open " + path + ": " + strerror(errno);
+		return false;
+	}
+	struct stat statbuf;
+	if (fstat(fd, &statbuf) != 0) {
+		err = "Unable to fstat " + path + ": " + strerror(errno);
+		close(fd);
+		return false;
+	}
+	const size_t size = statbuf.st_size;
+	if (size < SNAPSHOT_MAGIC_LEN + SNAPSHOT_TRAILER_LEN) {
+		err = "Invalid snapshot " + path + ": file too short";
+		close(fd);
+		return false;
+	}
+	char* data = static_cast<char*>(mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0));
+	close(fd);
+	if (data == MAP_FAILED) {
+		err = "Unable to mmap " + path + ": " + strerror(errno);
+		return false;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	bool ret = false;
+	const size_t payload_size = size - SNAPSHOT_TRAILER_LEN;
+	uint64_t hash1 = 0, hash2 = 0;
+	uint64_t exp_hash[2];
+	memcpy(exp_hash, data + payload_size, sizeof(exp_hash));
+
+	if (memcmp(data, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) != 0) {
+		err = "Invalid snapshot " + path + ": bad magic";
+	} else {
+		SpookyHash::Hash128(data, payload_size, &hash1, &hash2);
+		if (hash1 != exp_hash[0] || hash2 != exp_hash[1]) {
+			err = "Invalid snapshot " + path + ": checksum mismatch";
+		} else {
+			string parse_err {};
+			ret = parse_sections(data, payload_size, sections, parse_err);
+			if (ret == false) {
+				err = "Invalid snapshot " + path + ": " + parse_err;
+				free_sections(sections);
+			}
+		}
+	}
+
+	munmap(data, size);
+	return ret;
+}
+
+void ProxySQL_Snapshot::free_sections(vector<section_t>& sections) {
+	for (section_t& section : sections) {
+		for (SQLite3_result* resultset : section.resultsets) {
+			delete resultset;
+		}
+	}
+	sections.clear();
+}
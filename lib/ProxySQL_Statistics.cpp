@@ -52,6 +52,8 @@ ProxySQL_Statistics::ProxySQL_Statistics() {
 	next_timer_system_memory = 0;
 #endif
 	next_timer_MySQL_Query_Cache = 0;
+	timeseries = NULL;
+	variables.stats_history_timeseries = false;
 }
 
 ProxySQL_Statistics::~ProxySQL_Statistics() {
@@ -61,6 +63,10 @@ ProxySQL_Statistics::~ProxySQL_Statistics() {
 	delete tables_defs_statsdb_disk;
 	delete statsdb_mem;
 //	delete statsdb_disk;
+	if (timeseries) {
+		delete timeseries;
+		timeseries = NULL;
+	}
 }
 
 void ProxySQL_Statistics::init() {
@@ -264,7 +270,190 @@ bool ProxySQL_Statistics::system_memory_timetoget(unsigned long long curtime) {
 }
 #endif
 
+/**
+ * @brief Tables of 'stats_history' kept in the time series store when 'admin-stats_history_timeseries' is
+ *   enabled. The aggregations are the ones of the 'INSERT INTO <table>_hour SELECT' statements of the SQLite
+ *   tables, and so are the retentions: 7 days for the samples and 365 days for the hourly aggregates.
+ */
+struct timeseries_table_def_t {
+	const char *name;
+	std::vector<std::string> columns;
+	std::vector<TS_aggregation> aggregations;
+};
+
+static const timeseries_table_def_t timeseries_tables_defs[] = {
+	{
+		"system_cpu",
+		{ "tms_utime", "tms_stime" },
+		{ TS_AGG_SUM, TS_AGG_SUM }
+	},
+#ifndef NOJEM
+	{
+		"system_memory",
+		{ "allocated", "resident", "active", "mapped", "metadata", "retained" },
+		{ TS_AGG_AVG, TS_AGG_AVG, TS_AGG_AVG, TS_AGG_AVG, TS_AGG_AVG, TS_AGG_AVG }
+	},
+#endif
+	{
+		"mysql_connections",
+		{
+			"Client_Connections_aborted", "Client_Connections_connected", "Client_Connections_created",
+			"Server_Connections_aborted", "Server_Connections_connected", "Server_Connections_created",
+			"ConnPool_get_conn_failure", "ConnPool_get_conn_immediate", "ConnPool_get_conn_success",
+			"Questions", "Slow_queries", "GTID_consistent_queries"
+		},
+		{
+			TS_AGG_MAX, TS_AGG_AVG, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_AVG, TS_AGG_MAX,
+			TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX
+		}
+	},
+	{
+		"myhgm_connections",
+		{
+			"MyHGM_myconnpoll_destroy", "MyHGM_myconnpoll_get", "MyHGM_myconnpoll_get_ok",
+			"MyHGM_myconnpoll_push", "MyHGM_myconnpoll_reset"
+		},
+		{ TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX }
+	},
+	{
+		"mysql_query_cache",
+		{
+			"count_GET", "count_GET_OK", "count_SET", "bytes_IN", "bytes_OUT", "Entries_Purged",
+			"Entries_In_Cache", "Memory_Bytes"
+		},
+		{ TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_MAX, TS_AGG_AVG, TS_AGG_AVG }
+	},
+};
+
+// retentions of the samples and of the hourly aggregates, the same of the SQLite tables
+#define TIMESERIES_RETENTION (3600*24*7)
+#define TIMESERIES_HOUR_RETENTION (3600*24*365)
+
+ProxySQL_TimeSeries * ProxySQL_Statistics::get_timeseries() {
+	std::lock_guard<std::mutex> lock(timeseries_mutex);
+	if (timeseries == NULL) {
+		ProxySQL_TimeSeries *tsdb = new ProxySQL_TimeSeries(std::string(GloVars.datadir) + "/stats_history_ts");
+		for (const timeseries_table_def_t& def : timeseries_tables_defs) {
+			const std::string hour_name = std::string(def.name) + "_hour";
+			// the hourly aggregates aren't downsampled further, their aggregations are unused
+			tsdb->add_table(hour_name.c_str(), def.columns, def.aggregations, 86400, TIMESERIES_HOUR_RETENTION, NULL);
+			tsdb->add_table(def.name, def.columns, def.aggregations, 3600, TIMESERIES_RETENTION, hour_name.c_str());
+		}
+		timeseries = tsdb;
+	}
+	return timeseries;
+}
+
+void ProxySQL_Statistics::timeseries_append(const char *name, const uint64_t *values) {
+	ProxySQL_TimeSeries *tsdb = get_timeseries();
+	const std::vector<std::string> columns = tsdb->get_columns(name);
+	std::vector<int64_t> v(columns.size());
+	for (size_t i = 0; i < columns.size(); i++) {
+		v[i] = values[i+1];
+	}
+	tsdb->append(name, values[0], v.data());
+}
+
+SQLite3_result * ProxySQL_Statistics::get_timeseries_metrics(const char *name, int interval) {
+	std::string table_name = name;
+	time_t ts = time(NULL);
+	switch (interval) {
+		case 1800:
+		case 3600:
+		case 7200:
+			break;
+		case 28800:
+		case 86400:
+		case 259200:
+		case 604800:
+		case 2592000:
+		case 7776000:
+			table_name += "_hour";
+			break;
+		default:
+			// LCOV_EXCL_START
+			assert(0);
+			break;
+			// LCOV_EXCL_STOP
+	}
+	return get_timeseries()->get_metrics(table_name.c_str(), ts-interval, ts);
+}
+
+/**
+ * @brief Returns true if 'query' references the table 'name' as a whole word: 'system_cpu' doesn't match
+ *   'system_cpu_hour'.
+ */
+static bool query_references_table(const char *query, const std::string& name) {
+	const auto is_ident = [] (char c) { return isalnum((unsigned char)c) || c == '_'; };
+	for (const char *p = strstr(query, name.c_str()); p != NULL; p = strstr(p + 1, name.c_str())) {
+		if ((p == query || is_ident(p[-1]) == false) && is_ident(p[name.size()]) == false) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ProxySQL_Statistics::timeseries_materialize(const char *query) {
+	ProxySQL_TimeSeries *tsdb = get_timeseries();
+	// serializes the rewrites, each one is a transaction
+	std::lock_guard<std::mutex> lock(timeseries_mutex);
+	const time_t now = time(NULL);
+	for (const std::string& name : tsdb->get_table_names()) {
+		if (query_references_table(query, name) == false) {
+			continue;
+		}
+		const bool is_hour = name.size() > 5 && name.compare(name.size() - 5, 5, "_hour") == 0;
+		const int64_t retention = (is_hour ? TIMESERIES_HOUR_RETENTION : TIMESERIES_RETENTION);
+		int64_t& materialized_to = timeseries_materialized_to[name];
+		const std::vector<std::string> columns = tsdb->get_columns(name.c_str());
+		std::string q = "INSERT OR REPLACE INTO " + name + " VALUES (?1";
+		for (size_t i = 0; i < columns.size(); i++) {
+			q += ",?" + to_string(i+2);
+		}
+		q += ")";
+		// rows are timestamp followed by the columns
+		// only the samples appended since the previous call are copied, and the range they cover is replaced:
+		// the rows written before 'stats_history_timeseries' was enabled are kept
+		std::vector<int64_t> rows {};
+		int64_t first_ts = INT64_MAX;
+		int64_t last_ts = materialized_to;
+		tsdb->for_each(name.c_str(), materialized_to + 1, INT64_MAX, [&](int64_t ts, const int64_t *values) {
+			first_ts = std::min(first_ts, ts);
+			last_ts = std::max(last_ts, ts);
+			rows.push_back(ts);
+			rows.insert(rows.end(), values, values + columns.size());
+		});
+		int rc;
+		sqlite3 *mydb3=statsdb_disk->get_db();
+		sqlite3_stmt *statement=NULL;
+		statsdb_disk->execute("BEGIN");
+		// the periodic inserts, and so their retention 'DELETE', are skipped while the store is enabled
+		statsdb_disk->execute(("DELETE FROM " + name + " WHERE timestamp < " + to_string(now - retention)).c_str());
+		if (rows.empty()) {
+			statsdb_disk->execute("COMMIT");
+			continue;
+		}
+		statsdb_disk->execute(("DELETE FROM " + name + " WHERE timestamp >= " + to_string(first_ts)).c_str());
+		rc=(*proxy_sqlite3_prepare_v2)(mydb3, q.c_str(), -1, &statement, 0);
+		ASSERT_SQLITE_OK(rc, statsdb_disk);
+		for (size_t r = 0; r < rows.size(); r += columns.size() + 1) {
+			for (size_t i = 0; i <= columns.size(); i++) {
+				rc=(*proxy_sqlite3_bind_int64)(statement, i+1, rows[r+i]); ASSERT_SQLITE_OK(rc, statsdb_disk);
+			}
+			SAFE_SQLITE3_STEP2(statement);
+			rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, statsdb_disk);
+			rc=(*proxy_sqlite3_reset)(statement);
+		}
+		(*proxy_sqlite3_finalize)(statement);
+		statsdb_disk->execute("COMMIT");
+		materialized_to = last_ts;
+	}
+}
+
 SQLite3_result * ProxySQL_Statistics::get_mysql_metrics(int interval) {
+	if (variables.stats_history_timeseries) {
+		return get_timeseries_metrics("mysql_connections", interval);
+	}
 	SQLite3_result *resultset = NULL;
 	int cols;
 	int affected_rows;
@@ -320,6 +509,9 @@ SQLite3_result * ProxySQL_Statistics::get_mysql_metrics(int interval) {
 }
 
 SQLite3_result * ProxySQL_Statistics::get_myhgm_metrics(int interval) {
+	if (variables.stats_history_timeseries) {
+		return get_timeseries_metrics("myhgm_connections", interval);
+	}
 	SQLite3_result *resultset = NULL;
 	int cols;
 	int affected_rows;
@@ -363,6 +555,9 @@ SQLite3_result * ProxySQL_Statistics::get_myhgm_metrics(int interval) {
 }
 
 SQLite3_result * ProxySQL_Statistics::get_MySQL_Query_Cache_metrics(int interval) {
+	if (variables.stats_history_timeseries) {
+		return get_timeseries_metrics("mysql_query_cache", interval);
+	}
 	SQLite3_result *resultset = NULL;
 	int cols;
 	int affected_rows;
@@ -408,6 +603,9 @@ SQLite3_result * ProxySQL_Statistics::get_MySQL_Query_Cache_metrics(int interval
 
 #ifndef NOJEM
 SQLite3_result * ProxySQL_Statistics::get_system_memory_metrics(int interval) {
+	if (variables.stats_history_timeseries) {
+		return get_timeseries_metrics("system_memory", interval);
+	}
 	SQLite3_result *resultset = NULL;
 	int cols;
 	int affected_rows;
@@ -453,6 +651,9 @@ SQLite3_result * ProxySQL_Statistics::get_system_memory_metrics(int interval) {
 #endif
 
 SQLite3_result * ProxySQL_Statistics::get_system_cpu_metrics(int interval) {
+	if (variables.stats_history_timeseries) {
+		return get_timeseries_metrics("system_cpu", interval);
+	}
 	SQLite3_result *resultset = NULL;
 	int cols;
 	int affected_rows;
@@ -500,6 +701,11 @@ void ProxySQL_Statistics::system_cpu_sets() {
 	int rc;
 	struct tms buf;
 	if (times(&buf) > -1) {
+		if (variables.stats_history_timeseries) {
+			const uint64_t values[3] = { (uint64_t)time(NULL), (uint64_t)buf.tms_utime, (uint64_t)buf.tms_stime };
+			timeseries_append("system_cpu", values);
+			return;
+		}
 		sqlite3 *mydb3=statsdb_disk->get_db();
 		sqlite3_stmt *statement1=NULL;
 		char *query1=NULL;
@@ -583,6 +789,12 @@ void ProxySQL_Statistics::system_memory_sets() {
 		mallctl("stats.metadata", &metadata, &sz, NULL, 0);
 		mallctl("stats.retained", &retained, &sz, NULL, 0);
 
+		if (variables.stats_history_timeseries) {
+			(*proxy_sqlite3_finalize)(statement1);
+			const uint64_t values[7] = { (uint64_t)ts, allocated, resident, active, mapped, metadata, retained };
+			timeseries_append("system_memory", values);
+			return;
+		}
 
 		rc = (*proxy_sqlite3_bind_int64)(statement1, 1, ts); ASSERT_SQLITE_OK(rc, statsdb_disk);
 		rc = (*proxy_sqlite3_bind_int64)(statement1, 2, allocated); ASSERT_SQLITE_OK(rc, statsdb_disk);
@@ -741,6 +953,12 @@ void ProxySQL_Statistics::MyHGM_Handler_sets_v1(SQLite3_result *resultset) {
 		}
 	}
 
+	if (variables.stats_history_timeseries) {
+		(*proxy_sqlite3_finalize)(statement1);
+		timeseries_append("myhgm_connections", myhgm_connections_values);
+		return;
+	}
+
 	for (int i=0; i<6; i++) {
 		rc=(*proxy_sqlite3_bind_int64)(statement1, i+1, myhgm_connections_values[i]); ASSERT_SQLITE_OK(rc, statsdb_disk);
 	}
@@ -926,6 +1144,12 @@ void ProxySQL_Statistics::MySQL_Threads_Handler_sets_v1(SQLite3_result *resultse
 		}
 	}
 
+	if (variables.stats_history_timeseries) {
+		(*proxy_sqlite3_finalize)(statement1);
+		timeseries_append("mysql_connections", mysql_connections_values);
+		return;
+	}
+
 	for (int i=0; i<13; i++) {
 		rc=(*proxy_sqlite3_bind_int64)(statement1, i+1, mysql_connections_values[i]); ASSERT_SQLITE_OK(rc, statsdb_disk);
 	}
@@ -1031,6 +1255,12 @@ void ProxySQL_Statistics::MySQL_Query_Cache_sets(SQLite3_result *resultset) {
 		}
 	}
 
+	if (variables.stats_history_timeseries) {
+		(*proxy_sqlite3_finalize)(statement1);
+		timeseries_append("mysql_query_cache", qc_values);
+		return;
+	}
+
 	for (int i=0; i<9; i++) {
 		rc=(*proxy_sqlite3_bind_int64)(statement1, i+1, qc_values[i]); ASSERT_SQLITE_OK(rc, statsdb_disk);
 	}
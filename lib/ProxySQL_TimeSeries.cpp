@@ -0,0 +1,633 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "proxysql.h"
+#include "cpp.h"
+
+#include "ProxySQL_TimeSeries.hpp"
+
+using std::string;
+using std::vector;
+
+#define TS_BLOCK_MAGIC "PXTS"
+#define TS_BLOCK_VERSION 1
+
+namespace {
+
+/**
+ * @brief Writes bits MSB first.
+ */
+class TS_BitWriter {
+	public:
+	string buf;
+	int free_bits = 0; // bits still available in the last byte
+	void write(uint64_t v, int nbits) {
+		while (nbits > 0) {
+			if (free_bits == 0) {
+				buf.push_back(0);
+				free_bits = 8;
+			}
+			const int n = std::min(nbits, free_bits);
+			const uint8_t bits = (v >> (nbits - n)) & ((1U << n) - 1);
+			buf.back() |= (char)(bits << (free_bits - n));
+			free_bits -= n;
+			nbits -= n;
+		}
+	}
+	void write_bit(bool b) { write(b ? 1 : 0, 1); }
+};
+
+/**
+ * @brief Reads the bits written by 'TS_BitWriter', failing instead of reading past the end.
+ */
+class TS_BitReader {
+	const unsigned char *buf;
+	size_t len; // in bits
+	size_t pos = 0;
+	public:
+	TS_BitReader(const unsigned char *_buf, size_t _len) : buf(_buf), len(_len * 8) {}
+	bool read(int nbits, uint64_t& v) {
+		if (pos + nbits > len) {
+			return false;
+		}
+		v = 0;
+		while (nbits > 0) {
+			const int used = pos & 7;
+			const int n = std::min(nbits, 8 - used);
+			const uint8_t byte = buf[pos >> 3];
+			v = (v << n) | ((byte >> (8 - used - n)) & ((1U << n) - 1));
+			pos += n;
+			nbits -= n;
+		}
+		return true;
+	}
+	bool read_bit(bool& b) {
+		uint64_t v = 0;
+		const bool rc = read(1, v);
+		b = v;
+		return rc;
+	}
+};
+
+template <typename T>
+void put_le(string& s, T v) {
+	for (size_t i = 0; i < sizeof(T); i++) {
+		s.push_back((char)((uint64_t)v >> (8 * i)));
+	}
+}
+
+template <typename T>
+T get_le(const unsigned char *p) {
+	uint64_t v = 0;
+	for (size_t i = 0; i < sizeof(T); i++) {
+		v |= (uint64_t)p[i] << (8 * i);
+	}
+	return (T)v;
+}
+
+// delta-of-delta buckets: control bits, value bits, bias
+struct dod_bucket { uint64_t ctrl; int ctrl_bits; int bits; int64_t bias; };
+const dod_bucket dod_buckets[] = {
+	{ 0x2, 2, 7, 63 },    // '10'   [-63, 64]
+	{ 0x6, 3, 9, 255 },   // '110'  [-255, 256]
+	{ 0xE, 4, 12, 2047 }, // '1110' [-2047, 2048]
+};
+
+void encode_timestamps(TS_BitWriter& w, const vector<int64_t>& samples, size_t stride) {
+	int64_t prev_ts = 0;
+	int64_t prev_delta = 0;
+	for (size_t i = 0; i < samples.size(); i += stride) {
+		const int64_t ts = samples[i];
+		if (i == 0) {
+			w.write((uint64_t)ts, 64);
+		} else {
+			// wrapping arithmetic, only out of range timestamps could overflow
+			const int64_t delta = (int64_t)((uint64_t)ts - (uint64_t)prev_ts);
+			const int64_t dod = (int64_t)((uint64_t)delta - (uint64_t)prev_delta);
+			if (dod == 0) {
+				w.write_bit(0);
+			} else {
+				bool done = false;
+				for (const dod_bucket& b : dod_buckets) {
+					if (dod >= -b.bias && dod <= b.bias + 1) {
+						w.write(b.ctrl, b.ctrl_bits);
+						w.write((uint64_t)(dod + b.bias), b.bits);
+						done = true;
+						break;
+					}
+				}
+				if (done == false) {
+					w.write(0xF, 4);
+					w.write((uint64_t)dod, 64);
+				}
+			}
+			prev_delta = delta;
+		}
+		prev_ts = ts;
+	}
+}
+
+bool decode_timestamps(TS_BitReader& r, uint32_t count, vector<int64_t>& ts) {
+	int64_t prev_ts = 0;
+	int64_t prev_delta = 0;
+	uint64_t v = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (i == 0) {
+			if (r.read(64, v) == false) return false;
+			prev_ts = (int64_t)v;
+		} else {
+			// count the leading '1' of the control bits, up to 4
+			int ones = 0;
+			bool b = true;
+			while (ones < 4) {
+				if (r.read_bit(b) == false) return false;
+				if (b == false) break;
+				ones++;
+			}
+			int64_t dod = 0;
+			if (ones == 4) {
+				if (r.read(64, v) == false) return false;
+				dod = (int64_t)v;
+			} else if (ones > 0) {
+				const dod_bucket& bk = dod_buckets[ones - 1];
+				if (r.read(bk.bits, v) == false) return false;
+				dod = (int64_t)v - bk.bias;
+			}
+			prev_delta = (int64_t)((uint64_t)prev_delta + (uint64_t)dod);
+			prev_ts = (int64_t)((uint64_t)prev_ts + (uint64_t)prev_delta);
+		}
+		ts.push_back(prev_ts);
+	}
+	return true;
+}
+
+void encode_values(TS_BitWriter& w, const vector<int64_t>& samples, size_t stride, size_t col) {
+	uint64_t prev = 0;
+	int prev_lz = -1;
+	int prev_tz = -1;
+	for (size_t i = 0; i < samples.size(); i += stride) {
+		const uint64_t v = (uint64_t)samples[i + 1 + col];
+		if (i == 0) {
+			w.write(v, 64);
+			prev = v;
+			continue;
+		}
+		const uint64_t x = v ^ prev;
+		prev = v;
+		if (x == 0) {
+			w.write_bit(0);
+			continue;
+		}
+		w.write_bit(1);
+		const int lz = __builtin_clzll(x);
+		const int tz = __builtin_ctzll(x);
+		if (prev_lz >= 0 && lz >= prev_lz && tz >= prev_tz) {
+			// the meaningful bits fit in the previous window
+			w.write_bit(0);
+			w.write(x >> prev_tz, 64 - prev_lz - prev_tz);
+		} else {
+			const int len = 64 - lz - tz;
+			w.write_bit(1);
+			w.write(lz, 6);
+			w.write(len - 1, 6);
+			w.write(x >> tz, len);
+			prev_lz = lz;
+			prev_tz = tz;
+		}
+	}
+}
+
+bool decode_values(TS_BitReader& r, uint32_t count, vector<int64_t>& values) {
+	uint64_t prev = 0;
+	int prev_lz = -1;
+	int prev_tz = -1;
+	uint64_t v = 0;
+	bool b = false;
+	for (uint32_t i = 0; i < count; i++) {
+		if (i == 0) {
+			if (r.read(64, v) == false) return false;
+			prev = v;
+		} else {
+			if (r.read_bit(b) == false) return false;
+			if (b) {
+				if (r.read_bit(b) == false) return false;
+				if (b) {
+					uint64_t lz = 0, len = 0;
+					if (r.read(6, lz) == false || r.read(6, len) == false) return false;
+					len++;
+					if (lz + len > 64) return false;
+					prev_lz = lz;
+					prev_tz = 64 - lz - len;
+				} else if (prev_lz < 0) {
+					return false;
+				}
+				if (r.read(64 - prev_lz - prev_tz, v) == false) return false;
+				prev ^= v << prev_tz;
+			}
+		}
+		values.push_back((int64_t)prev);
+	}
+	return true;
+}
+
+int64_t aggregate(TS_aggregation agg, const vector<int64_t>& samples, size_t stride, size_t col) {
+	int64_t ret = 0;
+	int64_t n = 0;
+	for (size_t i = 0; i < samples.size(); i += stride, n++) {
+		const int64_t v = samples[i + 1 + col];
+		switch (agg) {
+			case TS_AGG_MAX:
+				ret = (n == 0 || v > ret) ? v : ret;
+				break;
+			case TS_AGG_AVG:
+			case TS_AGG_SUM:
+				ret += v;
+				break;
+		}
+	}
+	if (agg == TS_AGG_AVG && n) {
+		ret /= n;
+	}
+	return ret;
+}
+
+bool mkdir_p(const string& path) {
+	size_t pos = 0;
+	while ((pos = path.find('/', pos + 1)) != string::npos) {
+		const string p = path.substr(0, pos);
+		if (mkdir(p.c_str(), 0750) && errno != EEXIST) return false;
+	}
+	return mkdir(path.c_str(), 0750) == 0 || errno == EEXIST;
+}
+
+} // namespace
+
+string TS_Block::encode(int64_t block_start, uint32_t ncols, const vector<int64_t>& samples) {
+	const size_t stride = ncols + 1;
+	const uint32_t count = samples.size() / stride;
+	vector<string> streams(stride);
+	{
+		TS_BitWriter w {};
+		encode_timestamps(w, samples, stride);
+		streams[0] = std::move(w.buf);
+	}
+	for (uint32_t c = 0; c < ncols; c++) {
+		TS_BitWriter w {};
+		encode_values(w, samples, stride, c);
+		streams[c + 1] = std::move(w.buf);
+	}
+	string blk { TS_BLOCK_MAGIC };
+	put_le<uint32_t>(blk, TS_BLOCK_VERSION);
+	put_le<uint32_t>(blk, ncols);
+	put_le<uint32_t>(blk, count);
+	put_le<int64_t>(blk, block_start);
+	for (const string& s : streams) {
+		put_le<uint32_t>(blk, s.size());
+	}
+	for (const string& s : streams) {
+		blk += s;
+	}
+	return blk;
+}
+
+bool TS_Block::decode(const unsigned char *buf, size_t len, uint32_t ncols, vector<int64_t>& samples) {
+	const size_t hdr_len = 24 + 4 * (ncols + 1);
+	if (len < hdr_len || memcmp(buf, TS_BLOCK_MAGIC, 4) != 0 || get_le<uint32_t>(buf + 4) != TS_BLOCK_VERSION) {
+		return false;
+	}
+	if (get_le<uint32_t>(buf + 8) != ncols) {
+		return false;
+	}
+	const uint32_t count = get_le<uint32_t>(buf + 12);
+	vector<vector<int64_t>> cols(ncols + 1);
+	size_t off = hdr_len;
+	for (uint32_t c = 0; c <= ncols; c++) {
+		const size_t slen = get_le<uint32_t>(buf + 24 + 4 * c);
+		if (off + slen > len) {
+			return false;
+		}
+		TS_BitReader r { buf + off, slen };
+		cols[c].reserve(count);
+		const bool rc = c == 0 ? decode_timestamps(r, count, cols[c]) : decode_values(r, count, cols[c]);
+		if (rc == false) {
+			return false;
+		}
+		off += slen;
+	}
+	samples.reserve(samples.size() + (size_t)count * (ncols + 1));
+	for (uint32_t i = 0; i < count; i++) {
+		for (uint32_t c = 0; c <= ncols; c++) {
+			samples.push_back(cols[c][i]);
+		}
+	}
+	return true;
+}
+
+TS_Table::TS_Table(const string& _name, const string& _dir, const vector<string>& _columns,
+	const vector<TS_aggregation>& _aggregations, int64_t _block_span, int64_t _retention, TS_Table *_downsample
+) : name(_name), dir(_dir), columns(_columns), aggregations(_aggregations), downsample(_downsample),
+	block_span(_block_span), retention(_retention), open_block_start(-1), open_fd(-1)
+{
+	if (mkdir_p(dir) == false) {
+		proxy_error("Unable to create time series directory %s: %s\n", dir.c_str(), strerror(errno));
+	}
+}
+
+TS_Table::~TS_Table() {
+	if (open_fd >= 0) {
+		close(open_fd);
+		open_fd = -1;
+	}
+}
+
+string TS_Table::block_path(int64_t block_start, const char *ext) const {
+	return dir + "/" + std::to_string(block_start) + ext;
+}
+
+vector<int64_t> TS_Table::list_blocks(const char *ext) const {
+	vector<int64_t> ret {};
+	DIR *d = opendir(dir.c_str());
+	if (d == NULL) {
+		return ret;
+	}
+	const size_t ext_len = strlen(ext);
+	struct dirent *ent = NULL;
+	while ((ent = readdir(d)) != NULL) {
+		const size_t l = strlen(ent->d_name);
+		if (l > ext_len && strcmp(ent->d_name + l - ext_len, ext) == 0) {
+			char *end = NULL;
+			const long long start = strtoll(ent->d_name, &end, 10);
+			if (end == ent->d_name + l - ext_len) {
+				ret.push_back(start);
+			}
+		}
+	}
+	closedir(d);
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+void TS_Table::load_journal(int64_t block_start) {
+	const string path = block_path(block_start, ".open");
+	const size_t rec_len = (columns.size() + 1) * sizeof(int64_t);
+	open_samples.clear();
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	vector<int64_t> rec(columns.size() + 1);
+	while (::read(fd, rec.data(), rec_len) == (ssize_t)rec_len) {
+		open_samples.insert(open_samples.end(), rec.begin(), rec.end());
+	}
+	close(fd);
+	open_block_start = block_start;
+}
+
+void TS_Table::recover() {
+	const vector<int64_t> journals = list_blocks(".open");
+	for (size_t i = 0; i < journals.size(); i++) {
+		load_journal(journals[i]);
+		if (i + 1 < journals.size()) {
+			seal_open_block();
+		}
+	}
+	if (open_block_start >= 0) {
+		// a torn record at the end of the journal is discarded, the file is rewritten with the valid ones
+		const string path = block_path(open_block_start, ".open");
+		open_fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+		if (open_fd >= 0 && open_samples.size()) {
+			if (write(open_fd, open_samples.data(), open_samples.size() * sizeof(int64_t)) < 0) {
+				proxy_error("Unable to write time series journal %s: %s\n", path.c_str(), strerror(errno));
+			}
+		}
+	}
+}
+
+void TS_Table::open_block(int64_t block_start) {
+	const string path = block_path(block_start, ".open");
+	open_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+	if (open_fd < 0) {
+		proxy_error("Unable to create time series journal %s: %s\n", path.c_str(), strerror(errno));
+	}
+	open_block_start = block_start;
+	open_samples.clear();
+}
+
+void TS_Table::seal_open_block() {
+	if (open_block_start < 0) {
+		return;
+	}
+	const int64_t block_start = open_block_start;
+	if (open_samples.size()) {
+		const string blk = TS_Block::encode(block_start, columns.size(), open_samples);
+		const string path = block_path(block_start, ".blk");
+		const string tmp_path = path + ".tmp";
+		int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+		bool rc = fd >= 0 && write(fd, blk.data(), blk.size()) == (ssize_t)blk.size();
+		if (fd >= 0) {
+			rc = rc && fsync(fd) == 0;
+			close(fd);
+		}
+		if (rc == false || rename(tmp_path.c_str(), path.c_str())) {
+			// the journal is kept, and sealed again by the next 'recover()'
+			proxy_error("Unable to write time series block %s: %s\n", path.c_str(), strerror(errno));
+			unlink(tmp_path.c_str());
+		} else {
+			unlink(block_path(block_start, ".open").c_str());
+		}
+		if (downsample) {
+			vector<int64_t> agg(columns.size());
+			for (size_t c = 0; c < columns.size(); c++) {
+				agg[c] = aggregate(aggregations[c], open_samples, columns.size() + 1, c);
+			}
+			downsample->append(block_start, agg.data());
+		}
+	} else {
+		unlink(block_path(block_start, ".open").c_str());
+	}
+	if (open_fd >= 0) {
+		close(open_fd);
+		open_fd = -1;
+	}
+	open_block_start = -1;
+	open_samples.clear();
+}
+
+void TS_Table::purge(int64_t now) {
+	for (int64_t start : list_blocks(".blk")) {
+		if (start + block_span > now - retention) {
+			break;
+		}
+		unlink(block_path(start, ".blk").c_str());
+	}
+}
+
+void TS_Table::append(int64_t ts, const int64_t *values) {
+	const int64_t block_start = ts - ((ts % block_span) + block_span) % block_span;
+	// samples older than the open block (the clock moved backward) are kept in the open block
+	if (open_block_start >= 0 && block_start > open_block_start) {
+		seal_open_block();
+	}
+	if (open_block_start < 0) {
+		open_block(block_start);
+		purge(ts);
+	}
+	const size_t pos = open_samples.size();
+	open_samples.push_back(ts);
+	open_samples.insert(open_samples.end(), values, values + columns.size());
+	if (open_fd >= 0) {
+		const size_t len = (columns.size() + 1) * sizeof(int64_t);
+		if (write(open_fd, &open_samples[pos], len) != (ssize_t)len) {
+			proxy_error("Unable to write time series journal of %s: %s\n", name.c_str(), strerror(errno));
+		}
+	}
+}
+
+bool TS_Table::read_block(int64_t block_start, vector<int64_t>& samples) const {
+	const string path = block_path(block_start, ".blk");
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	bool rc = false;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			rc = TS_Block::decode((const unsigned char *)map, st.st_size, columns.size(), samples);
+			munmap(map, st.st_size);
+		}
+	}
+	close(fd);
+	if (rc == false) {
+		proxy_error("Malformed time series block %s\n", path.c_str());
+	}
+	return rc;
+}
+
+void TS_Table::read(int64_t from, int64_t to, vector<int64_t>& samples) const {
+	const size_t stride = columns.size() + 1;
+	vector<int64_t> all {};
+	for (int64_t start : list_blocks(".blk")) {
+		if (start > to || start + block_span <= from) {
+			continue;
+		}
+		vector<int64_t> blk {};
+		if (read_block(start, blk)) {
+			all.insert(all.end(), blk.begin(), blk.end());
+		}
+	}
+	all.insert(all.end(), open_samples.begin(), open_samples.end());
+	// blocks and samples are normally already in order, unless the clock moved backward
+	vector<size_t> idx {};
+	for (size_t i = 0; i + stride <= all.size(); i += stride) {
+		if (all[i] >= from && all[i] <= to) {
+			idx.push_back(i);
+		}
+	}
+	std::stable_sort(idx.begin(), idx.end(), [&all](size_t a, size_t b) { return all[a] < all[b]; });
+	samples.reserve(samples.size() + idx.size() * stride);
+	for (size_t i : idx) {
+		samples.insert(samples.end(), all.begin() + i, all.begin() + i + stride);
+	}
+}
+
+ProxySQL_TimeSeries::ProxySQL_TimeSeries(const string& _base_dir) : base_dir(_base_dir) {}
+
+ProxySQL_TimeSeries::~ProxySQL_TimeSeries() {
+	for (auto& it : tables) {
+		delete it.second;
+	}
+	tables.clear();
+}
+
+void ProxySQL_TimeSeries::add_table(const char *name, const vector<string>& columns,
+	const vector<TS_aggregation>& aggregations, int64_t block_span, int64_t retention, const char *downsample
+) {
+	std::lock_guard<std::mutex> lock(mu);
+	if (tables.find(name) != tables.end()) {
+		return;
+	}
+	TS_Table *ds = NULL;
+	if (downsample) {
+		auto it = tables.find(downsample);
+		assert(it != tables.end());
+		ds = it->second;
+	}
+	TS_Table *t = new TS_Table(name, base_dir + "/" + name, columns, aggregations, block_span, retention, ds);
+	t->recover();
+	tables[name] = t;
+}
+
+bool ProxySQL_TimeSeries::has_table(const char *name) const {
+	std::lock_guard<std::mutex> lock(mu);
+	return tables.find(name) != tables.end();
+}
+
+void ProxySQL_TimeSeries::append(const char *name, int64_t ts, const int64_t *values) {
+	std::lock_guard<std::mutex> lock(mu);
+	auto it = tables.find(name);
+	if (it != tables.end()) {
+		it->second->append(ts, values);
+	}
+}
+
+vector<string> ProxySQL_TimeSeries::get_columns(const char *name) const {
+	std::lock_guard<std::mutex> lock(mu);
+	auto it = tables.find(name);
+	if (it == tables.end()) {
+		return {};
+	}
+	return it->second->get_columns();
+}
+
+vector<string> ProxySQL_TimeSeries::get_table_names() const {
+	std::lock_guard<std::mutex> lock(mu);
+	vector<string> ret {};
+	for (const auto& it : tables) {
+		ret.push_back(it.first);
+	}
+	return ret;
+}
+
+SQLite3_result * ProxySQL_TimeSeries::get_metrics(const char *name, int64_t from, int64_t to) const {
+	const vector<string> columns = get_columns(name);
+	if (columns.empty()) {
+		return NULL;
+	}
+	const size_t ncols = columns.size() + 2;
+	SQLite3_result *result = new SQLite3_result(ncols);
+	result->add_column_definition(SQLITE_TEXT, "ts");
+	result->add_column_definition(SQLITE_TEXT, "timestamp");
+	for (const string& c : columns) {
+		result->add_column_definition(SQLITE_TEXT, c.c_str());
+	}
+	vector<string> fields(ncols);
+	vector<char *> pta(ncols);
+	for_each(name, from, to, [&](int64_t ts, const int64_t *values) {
+		char buf[32];
+		const time_t t = ts;
+		struct tm tm;
+		gmtime_r(&t, &tm);
+		strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+		fields[0] = buf;
+		fields[1] = std::to_string(ts);
+		for (size_t c = 0; c + 2 < ncols; c++) {
+			fields[c + 2] = std::to_string(values[c]);
+		}
+		for (size_t c = 0; c < ncols; c++) {
+			pta[c] = (char *)fields[c].c_str();
+		}
+		result->add_row(pta.data());
+	});
+	return result;
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+
+#include "QC_table_index.h"
+
+QC_table_index::QC_table_index(std::function<bool(uint64_t)> _entry_exists) : entry_exists(_entry_exists), epoch(0) {
+	for (unsigned int i = 0; i < QUERY_CACHE_TABLE_INDEX_SHARDS; i++) {
+		pthread_mutex_init(&shards[i].mutex, NULL);
+	}
+}
+
+QC_table_index::~QC_table_index() {
+	for (unsigned int i = 0; i < QUERY_CACHE_TABLE_INDEX_SHARDS; i++) {
+		pthread_mutex_destroy(&shards[i].mutex);
+	}
+}
+
+uint64_t QC_table_index::get_epoch() {
+	return __sync_fetch_and_add(&epoch, 0);
+}
+
+bool QC_table_index::track(uint64_t key, const std::vector<std::pair<uint64_t,uint64_t>>& tables) {
+	for (const auto& t : tables) {
+		const uint64_t th = t.first;
+		shard_t& shard = get_shard(th);
+		pthread_mutex_lock(&shard.mutex);
+		auto it = shard.tables.find(th);
+		// the table was modified after the query started, the resultset may be stale. For a table not in the
+		// index its slot is checked, it may have been invalidated (or erased) after the query started
+		const uint64_t invalidated_at = (it == shard.tables.end() ? get_slot(shard, th) : it->second.invalidated_at);
+		if (invalidated_at > t.second) {
+			pthread_mutex_unlock(&shard.mutex);
+			return false;
+		}
+		if (it == shard.tables.end()) {
+			if (shard.tables.size() >= shard.sweep_at) {
+				sweep(shard);
+			}
+			// the table inherits the invalidations of its slot
+			it = shard.tables.emplace(th, table_t {}).first;
+			it->second.invalidated_at = get_slot(shard, th);
+		}
+		table_t& table = it->second;
+		table.keys.push_back(key);
+		if (table.keys.size() >= table.compact_at) {
+			// drop the keys of entries already expired or replaced
+			std::sort(table.keys.begin(), table.keys.end());
+			table.keys.erase(std::unique(table.keys.begin(), table.keys.end()), table.keys.end());
+			table.keys.erase(
+				std::remove_if(table.keys.begin(), table.keys.end(),
+					[this] (uint64_t k) { return entry_exists(k) == false; }
+				),
+				table.keys.end()
+			);
+			table.compact_at = std::max(table.compact_at, table.keys.size() * 2);
+		}
+		pthread_mutex_unlock(&shard.mutex);
+	}
+	return true;
+}
+
+void QC_table_index::sweep(shard_t& shard) {
+	for (auto it = shard.tables.begin(); it != shard.tables.end(); ) {
+		table_t& table = it->second;
+		table.keys.erase(
+			std::remove_if(table.keys.begin(), table.keys.end(),
+				[this] (uint64_t k) { return entry_exists(k) == false; }
+			),
+			table.keys.end()
+		);
+		if (table.keys.empty()) {
+			uint64_t& slot = get_slot(shard, it->first);
+			slot = std::max(slot, table.invalidated_at);
+			it = shard.tables.erase(it);
+		} else {
+			++it;
+		}
+	}
+	shard.sweep_at = std::max((size_t)1024, shard.tables.size() * 2);
+}
+
+void QC_table_index::invalidate(uint64_t table, std::vector<uint64_t>& keys) {
+	shard_t& shard = get_shard(table);
+	pthread_mutex_lock(&shard.mutex);
+	// the epoch is bumped under the shard mutex, a query tracking the table either sees the new epoch or
+	// adds its key before it is returned
+	const uint64_t cur_epoch = __sync_add_and_fetch(&epoch, 1);
+	auto it = shard.tables.find(table);
+	if (it == shard.tables.end()) {
+		// no entries read from the table, only queries still running can be affected
+		get_slot(shard, table) = cur_epoch;
+	} else {
+		it->second.invalidated_at = cur_epoch;
+		keys.swap(it->second.keys);
+		it->second.compact_at = 1024;
+	}
+	pthread_mutex_unlock(&shard.mutex);
+}
+
+void QC_table_index::clear() {
+	for (unsigned int i = 0; i < QUERY_CACHE_TABLE_INDEX_SHARDS; i++) {
+		shard_t& shard = shards[i];
+		pthread_mutex_lock(&shard.mutex);
+		for (const auto& table : shard.tables) {
+			uint64_t& slot = get_slot(shard, table.first);
+			slot = std::max(slot, table.second.invalidated_at);
+		}
+		shard.tables.clear();
+		shard.sweep_at = 1024;
+		pthread_mutex_unlock(&shard.mutex);
+	}
+}
+
+size_t QC_table_index::size() {
+	size_t ret = 0;
+	for (unsigned int i = 0; i < QUERY_CACHE_TABLE_INDEX_SHARDS; i++) {
+		pthread_mutex_lock(&shards[i].mutex);
+		ret += shards[i].tables.size();
+		pthread_mutex_unlock(&shards[i].mutex);
+	}
+	return ret;
+}
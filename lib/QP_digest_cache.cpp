@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "QP_digest_cache.h"
+#include "SpookyV2.h"
+
+QP_digest_cache::QP_digest_cache(unsigned int _num_entries) {
+	num_entries = 1;
+	while (num_entries < _num_entries) {
+		num_entries <<= 1;
+	}
+	entries = (entry_t *)calloc(num_entries, sizeof(entry_t));
+	hits = 0;
+	misses = 0;
+}
+
+QP_digest_cache::~QP_digest_cache() {
+	reset();
+	free(entries);
+	entries = NULL;
+}
+
+void QP_digest_cache::reset() {
+	for (unsigned int i = 0; i < num_entries; i++) {
+		entry_t *e = &entries[i];
+		if (e->digest_text) {
+			free(e->digest_text);
+		}
+		if (e->first_comment) {
+			free(e->first_comment);
+		}
+		memset(e, 0, sizeof(entry_t));
+	}
+}
+
+void QP_digest_cache::compute_key(const char *query, int query_length, uint64_t opts_seed, uint64_t *key1, uint64_t *key2) {
+	*key1 = opts_seed;
+	*key2 = query_length;
+	SpookyHash::Hash128(query, query_length, key1, key2);
+}
+
+const QP_digest_cache::entry_t * QP_digest_cache::lookup(uint64_t key1, uint64_t key2) {
+	entry_t *e = &entries[key1 & (num_entries - 1)];
+	if (e->digest_text && e->key1 == key1 && e->key2 == key2) {
+		hits++;
+		return e;
+	}
+	misses++;
+	return NULL;
+}
+
+void QP_digest_cache::insert(uint64_t key1, uint64_t key2, uint64_t digest, const char *digest_text, const char *first_comment) {
+	entry_t *e = &entries[key1 & (num_entries - 1)];
+	if (e->digest_text) {
+		free(e->digest_text);
+	}
+	if (e->first_comment) {
+		free(e->first_comment);
+	}
+	e->key1 = key1;
+	e->key2 = key2;
+	e->digest = digest;
+	e->digest_text_length = strlen(digest_text);
+	e->digest_text = (char *)malloc(e->digest_text_length + 1);
+	memcpy(e->digest_text, digest_text, e->digest_text_length + 1);
+	e->first_comment = (first_comment ? strdup(first_comment) : NULL);
+}
+
+unsigned long long QP_digest_cache::get_memory_usage() {
+	unsigned long long s = sizeof(QP_digest_cache) + num_entries * sizeof(entry_t);
+	for (unsigned int i = 0; i < num_entries; i++) {
+		entry_t *e = &entries[i];
+		if (e->digest_text) {
+			s += e->digest_text_length + 1;
+		}
+		if (e->first_comment) {
+			s += strlen(e->first_comment) + 1;
+		}
+	}
+	return s;
+}
@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "QP_fast_routing_table.h"
+#include "SpookyV2.h"
+
+uint64_t QP_fast_routing_table::hash_key(const char *key, size_t len) {
+	return SpookyHash::Hash64(key, len, 0);
+}
+
+QP_fast_routing_table::QP_fast_routing_table(const char *keys_values, size_t keys_values_size) {
+	keys = (char *)malloc(keys_values_size ? keys_values_size : 1);
+	memcpy(keys, keys_values, keys_values_size);
+	keys_size = keys_values_size;
+	num_entries = 0;
+	// the number of entries is not known in advance: count the pairs first
+	unsigned int num_pairs = 0;
+	char *ptr = keys;
+	while (ptr < keys + keys_size) {
+		char *ptr2 = ptr + strlen(ptr) + 1;
+		ptr = ptr2 + strlen(ptr2) + 1;
+		num_pairs++;
+	}
+	uint64_t num_slots = 16;
+	while (num_slots < 2ULL * num_pairs) {
+		num_slots <<= 1;
+	}
+	mask = num_slots - 1;
+	slots = (slot_t *)calloc(num_slots, sizeof(slot_t));
+	ptr = keys;
+	while (ptr < keys + keys_size) {
+		size_t len = strlen(ptr);
+		char *ptr2 = ptr + len + 1;
+		int destination_hostgroup = atoi(ptr2);
+		uint64_t h = hash_key(ptr, len);
+		uint64_t i = h & mask;
+		while (slots[i].key) {
+			if (slots[i].hash == h && strcmp(slots[i].key, ptr) == 0) {
+				break;
+			}
+			i = (i + 1) & mask;
+		}
+		if (slots[i].key == NULL) {
+			slots[i].hash = h;
+			slots[i].key = ptr;
+			num_entries++;
+		}
+		slots[i].destination_hostgroup = destination_hostgroup;
+		ptr = ptr2 + strlen(ptr2) + 1;
+	}
+}
+
+QP_fast_routing_table::~QP_fast_routing_table() {
+	free(slots);
+	slots = NULL;
+	free(keys);
+	keys = NULL;
+}
+
+int QP_fast_routing_table::lookup(const char *key) const {
+	uint64_t h = hash_key(key, strlen(key));
+	uint64_t i = h & mask;
+	while (slots[i].key) {
+		if (slots[i].hash == h && strcmp(slots[i].key, key) == 0) {
+			return slots[i].destination_hostgroup;
+		}
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+unsigned long long QP_fast_routing_table::get_memory_usage() const {
+	return sizeof(QP_fast_routing_table) + (mask + 1) * sizeof(slot_t) + keys_size;
+}
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "proxysql.h"
+#include "cpp.h"
+#include "query_processor.h"
+#include "QP_firewall_whitelist.h"
+
+QP_firewall_digest_set::QP_firewall_digest_set(std::vector<uint64_t>& _digests) {
+	std::sort(_digests.begin(), _digests.end());
+	_digests.erase(std::unique(_digests.begin(), _digests.end()), _digests.end());
+	len = _digests.size();
+	digests = (uint64_t *)malloc((len ? len : 1) * sizeof(uint64_t));
+	if (len) {
+		memcpy(digests, _digests.data(), len * sizeof(uint64_t));
+	}
+	uint64_t bloom_bits = 64;
+	while (bloom_bits < 16ULL * len) {
+		bloom_bits <<= 1;
+	}
+	bloom_mask = bloom_bits - 1;
+	bloom = (uint64_t *)calloc(bloom_bits / 64, sizeof(uint64_t));
+	for (unsigned int i = 0; i < len; i++) {
+		const uint64_t b1 = digests[i] & bloom_mask;
+		const uint64_t b2 = (digests[i] >> 32) & bloom_mask;
+		bloom[b1 >> 6] |= 1ULL << (b1 & 63);
+		bloom[b2 >> 6] |= 1ULL << (b2 & 63);
+	}
+}
+
+QP_firewall_digest_set::~QP_firewall_digest_set() {
+	free(digests);
+	digests = NULL;
+	free(bloom);
+	bloom = NULL;
+}
+
+bool QP_firewall_digest_set::contains(uint64_t digest) const {
+	const uint64_t b1 = digest & bloom_mask;
+	const uint64_t b2 = (digest >> 32) & bloom_mask;
+	if ((bloom[b1 >> 6] & (1ULL << (b1 & 63))) == 0 || (bloom[b2 >> 6] & (1ULL << (b2 & 63))) == 0) {
+		return false;
+	}
+	return std::binary_search(digests, digests + len, digest);
+}
+
+unsigned long long QP_firewall_digest_set::get_memory_usage() const {
+	return sizeof(QP_firewall_digest_set) + len * sizeof(uint64_t) + (bloom_mask + 1) / 8;
+}
+
+QP_firewall_whitelist_rules::QP_firewall_whitelist_rules(std::unordered_map<int, std::vector<uint64_t>>& digests) {
+	sets.reserve(digests.size());
+	for (auto& it : digests) {
+		sets.push_back({ it.first, new QP_firewall_digest_set(it.second) });
+	}
+}
+
+QP_firewall_whitelist_rules::~QP_firewall_whitelist_rules() {
+	for (auto& it : sets) {
+		delete it.second;
+	}
+	sets.clear();
+}
+
+bool QP_firewall_whitelist_rules::allowed(int flagIN, uint64_t digest) const {
+	for (const auto& it : sets) {
+		if (it.first == flagIN) {
+			return it.second->contains(digest);
+		}
+	}
+	return false;
+}
+
+unsigned long long QP_firewall_whitelist_rules::get_memory_usage() const {
+	unsigned long long ret = sizeof(QP_firewall_whitelist_rules) + sets.capacity() * sizeof(sets[0]);
+	for (const auto& it : sets) {
+		ret += it.second->get_memory_usage();
+	}
+	return ret;
+}
+
+// usernames, client addresses and schemas can't contain a NULL byte: it is a collision free delimiter
+std::string QP_firewall_whitelist::users_key(const char *username, const char *client_address) {
+	std::string s = username;
+	s += '\0';
+	s += client_address;
+	return s;
+}
+
+std::string QP_firewall_whitelist::rules_key(const char *username, const char *client_address, const char *schemaname) {
+	std::string s = users_key(username, client_address);
+	s += '\0';
+	s += schemaname;
+	return s;
+}
+
+QP_firewall_whitelist::QP_firewall_whitelist(SQLite3_result *users_resultset, SQLite3_result *rules_resultset) {
+	version = 0;
+	refcnt = 1;
+	users_memory = 0;
+	rules_memory = 0;
+	if (users_resultset) {
+		for (std::vector<SQLite3_row *>::iterator it = users_resultset->rows.begin() ; it != users_resultset->rows.end(); ++it) {
+			SQLite3_row *r=*it;
+			int active = atoi(r->fields[0]);
+			if (active == 0) {
+				continue;
+			}
+			char * mode = r->fields[3];
+			int m = WUS_OFF;
+			if (strcmp(mode,(char *)"DETECTING")==0) {
+				m = WUS_DETECTING;
+			} else if (strcmp(mode,(char *)"PROTECTING")==0) {
+				m = WUS_PROTECTING;
+			}
+			users[users_key(r->fields[1], r->fields[2])] = m;
+		}
+		for (const auto& it : users) {
+			users_memory += it.first.capacity() + sizeof(it.second);
+		}
+	}
+	if (rules_resultset) {
+		// group the digests by tuple and flagIN first, then compile each tuple
+		std::unordered_map<std::string, std::unordered_map<int, std::vector<uint64_t>>> digests {};
+		for (std::vector<SQLite3_row *>::iterator it = rules_resultset->rows.begin() ; it != rules_resultset->rows.end(); ++it) {
+			SQLite3_row *r=*it;
+			int active = atoi(r->fields[0]);
+			if (active == 0) {
+				continue;
+			}
+			int flagIN = atoi(r->fields[4]);
+			unsigned long long digest_num = strtoull(r->fields[5],NULL,0);
+			digests[rules_key(r->fields[1], r->fields[2], r->fields[3])][flagIN].push_back(digest_num);
+		}
+		for (auto& it : digests) {
+			QP_firewall_whitelist_rules *wr = new QP_firewall_whitelist_rules(it.second);
+			rules_memory += it.first.capacity() + sizeof(wr) + wr->get_memory_usage();
+			rules[it.first] = wr;
+		}
+	}
+}
+
+QP_firewall_whitelist::~QP_firewall_whitelist() {
+	for (auto& it : rules) {
+		delete it.second;
+	}
+	rules.clear();
+	users.clear();
+}
+
+void QP_firewall_whitelist::release() {
+	if (__sync_sub_and_fetch(&refcnt, 1) == 0) {
+		delete this;
+	}
+}
+
+int QP_firewall_whitelist::find_user(const char *username, const char *client_address) const {
+	auto it = users.find(users_key(username, client_address));
+	if (it != users.end()) {
+		return it->second;
+	}
+	return WUS_NOT_FOUND;
+}
+
+const QP_firewall_whitelist_rules * QP_firewall_whitelist::find_rules(const char *username, const char *client_address, const char *schemaname) const {
+	auto it = rules.find(rules_key(username, client_address, schemaname));
+	if (it != rules.end()) {
+		return it->second;
+	}
+	return NULL;
+}
+
+void QP_firewall_session_cache::resolve(QP_firewall_whitelist *_whitelist, const char *_username, const char *_client_address, const char *_schemaname) {
+	reset();
+	whitelist = _whitelist;
+	username = _username;
+	client_address = _client_address;
+	schemaname = _schemaname;
+	rules_client_address = client_address.c_str();
+	mode = whitelist->find_user(_username, _client_address);
+	if (mode == WUS_NOT_FOUND) {
+		rules_client_address = "";
+		mode = whitelist->find_user(_username, rules_client_address);
+	}
+	if (mode == WUS_NOT_FOUND) {
+		mode = WUS_PROTECTING; // by default, everything should be blocked!
+	}
+	if (mode == WUS_DETECTING || mode == WUS_PROTECTING) {
+		rules = whitelist->find_rules(_username, rules_client_address, _schemaname);
+	}
+}
+
+void QP_firewall_session_cache::reset() {
+	if (whitelist) {
+		whitelist->release();
+		whitelist = NULL;
+	}
+	rules = NULL;
+	mode = WUS_NOT_FOUND;
+	rules_client_address = "";
+}
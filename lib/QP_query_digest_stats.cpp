@@ -24,6 +24,7 @@ static void my_itoa(char s[], unsigned long long n)
      reverse(s);
 }
 
+std::atomic<int> QP_query_digest_stats::histograms_count { 0 };
 
 QP_query_digest_stats::QP_query_digest_stats(const char* _user, const char* _schema, uint64_t _digest, const char* _digest_text,
 	int _hid, const char* _client_addr, int query_digests_max_digest_length) {
@@ -59,6 +60,28 @@ QP_query_digest_stats::QP_query_digest_stats(const char* _user, const char* _sch
 	rows_affected = 0;
 	rows_sent = 0;
 	hid = _hid;
+	histogram = NULL;
+}
+void QP_query_digest_stats::init_histogram(int max_histograms) {
+	if (histogram) return;
+	if (histograms_count.fetch_add(1) < max_histograms) {
+		histogram = new Digest_Latency_Histogram();
+	} else {
+		histograms_count--;
+	}
+}
+void QP_query_digest_stats::merge_histogram(QP_query_digest_stats *qds) {
+	if (qds->histogram == NULL) return;
+	if (histogram == NULL) {
+		histogram = qds->histogram;
+		qds->histogram = NULL;
+	} else {
+		histogram->merge(*qds->histogram);
+	}
+}
+void QP_query_digest_stats::merge(QP_query_digest_stats *qds) {
+	add_time(qds->min_time, qds->last_seen, qds->rows_affected, qds->rows_sent, qds->count_star);
+	merge_histogram(qds);
 }
 void QP_query_digest_stats::add_time(
 	unsigned long long t, unsigned long long n, unsigned long long ra, unsigned long long rs,
@@ -80,6 +103,11 @@ void QP_query_digest_stats::add_time(
 	last_seen=n;
 }
 QP_query_digest_stats::~QP_query_digest_stats() {
+	if (histogram) {
+		delete histogram;
+		histogram=NULL;
+		histograms_count--;
+	}
 	if (digest_text) {
 		free(digest_text);
 		digest_text=NULL;
@@ -185,6 +213,18 @@ char **QP_query_digest_stats::get_row(umap_query_digest_text *digest_text_umap,
 	//sprintf(qdsp->rows_sent,"%llu",rows_sent);
 	my_itoa(qdsp->rows_sent,rows_sent);
 	pta[13]=qdsp->rows_sent;
+	if (histogram) {
+		my_itoa(qdsp->p50_time,histogram->percentile(50));
+		pta[14]=qdsp->p50_time;
+		my_itoa(qdsp->p95_time,histogram->percentile(95));
+		pta[15]=qdsp->p95_time;
+		my_itoa(qdsp->p99_time,histogram->percentile(99));
+		pta[16]=qdsp->p99_time;
+	} else {
+		pta[14]=NULL;
+		pta[15]=NULL;
+		pta[16]=NULL;
+	}
 	return pta;
 }
 
@@ -52,6 +52,7 @@ static uint64_t Glo_dataOUT = 0;
 static uint64_t Glo_cntPurge = 0;
 static uint64_t Glo_size_values = 0;
 static uint64_t Glo_total_freed_memory = 0;
+static uint64_t Glo_cntInvalidated = 0;
 
 template<typename QC_DERIVED>
 bool Query_Cache<QC_DERIVED>::shutting_down = false;
@@ -131,6 +132,24 @@ public:
 	 */
 	int count() const;
 
+	/**
+	 * Marks the entry with the given key to be dropped, if it exists.
+	 * The entry stops being returned by lookups immediately and is freed by the next purge.
+	 *
+	 * @param key The key of the entry to be dropped.
+	 * @return True if the entry existed and was still valid, false otherwise.
+	 */
+	bool drop(uint64_t key);
+
+	/**
+	 * Checks if an entry with the given key exists and is not marked to be dropped.
+	 * Unlike lookup(), it doesn't update the GET counters.
+	 *
+	 * @param key The key of the entry.
+	 * @return True if the entry exists, false otherwise.
+	 */
+	bool exists(uint64_t key);
+
 private:
 	pthread_rwlock_t lock;
 	std::vector<std::shared_ptr<QC_entry_t>> entries;
@@ -361,6 +380,37 @@ std::weak_ptr<QC_entry_t> KV_BtreeArray::lookup(uint64_t key) {
 	return entry_ptr;
 };
 
+bool KV_BtreeArray::drop(uint64_t key) {
+	bool ret = false;
+	rdlock();
+	btree::btree_map<uint64_t,std::weak_ptr<QC_entry_t>>::iterator lookup;
+	lookup = bt_map.find(key);
+	if (lookup != bt_map.end()) {
+		if (std::shared_ptr<QC_entry_t> found_entry_shared = lookup->second.lock()) {
+			if (found_entry_shared->expire_ms != EXPIRE_DROPIT) {
+				found_entry_shared->expire_ms = EXPIRE_DROPIT;
+				ret = true;
+			}
+		}
+	}
+	unlock();
+	return ret;
+}
+
+bool KV_BtreeArray::exists(uint64_t key) {
+	bool ret = false;
+	rdlock();
+	btree::btree_map<uint64_t,std::weak_ptr<QC_entry_t>>::iterator lookup;
+	lookup = bt_map.find(key);
+	if (lookup != bt_map.end()) {
+		if (std::shared_ptr<QC_entry_t> found_entry_shared = lookup->second.lock()) {
+			ret = found_entry_shared->expire_ms != EXPIRE_DROPIT;
+		}
+	}
+	unlock();
+	return ret;
+}
+
 void KV_BtreeArray::clear(bool release_entries) {
 
 	wrlock();
@@ -470,6 +520,12 @@ qc_metrics_map = std::make_tuple(
 			"proxysql_query_cache_entries_total",
 			"Number of entries currently stored in the query cache.",
 			metric_tags {}
+		),
+		std::make_tuple (
+			p_qc_counter::query_cache_invalidated,
+			"proxysql_query_cache_invalidated_total",
+			"Number of entries dropped because a table they were read from was modified.",
+			metric_tags {}
 		)
 	},
 	qc_gauge_vector {
@@ -504,7 +560,8 @@ unsigned int Query_Cache<QC_DERIVED>::current_used_memory_pct(uint64_t max_memor
 }
 
 template <typename QC_DERIVED>
-Query_Cache<QC_DERIVED>::Query_Cache() {
+Query_Cache<QC_DERIVED>::Query_Cache()
+	: table_index([this] (uint64_t k) { return KVs[k%SHARED_QUERY_CACHE_HASH_TABLES]->exists(k); }) {
 #ifdef DEBUG
 	if (glovars.has_debug==false) {
 #else
@@ -538,6 +595,7 @@ void Query_Cache<QC_DERIVED>::p_update_metrics() {
 	p_update_counter(this->metrics.p_counter_array[p_qc_counter::query_cache_bytes_out], Glo_dataOUT);
 	p_update_counter(this->metrics.p_counter_array[p_qc_counter::query_cache_purged], Glo_cntPurge);
 	p_update_counter(this->metrics.p_counter_array[p_qc_counter::query_cache_entries], Glo_num_entries);
+	p_update_counter(this->metrics.p_counter_array[p_qc_counter::query_cache_invalidated], Glo_cntInvalidated);
 }
 
 template <typename QC_DERIVED>
@@ -588,7 +646,8 @@ std::shared_ptr<QC_entry_t> Query_Cache<QC_DERIVED>::get(uint64_t user_hash, con
 
 template <typename QC_DERIVED>
 bool Query_Cache<QC_DERIVED>::set(QC_entry_t* entry, uint64_t user_hash, const unsigned char *kp, uint32_t kl, 
-	unsigned char *vp, uint32_t vl, uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms) {
+	unsigned char *vp, uint32_t vl, uint64_t create_ms, uint64_t curtime_ms, uint64_t expire_ms,
+	const std::vector<std::pair<uint64_t,uint64_t>>* tables) {
 	entry->klen=kl;
 	entry->length=vl;
 	entry->refreshing=false;
@@ -604,9 +663,47 @@ bool Query_Cache<QC_DERIVED>::set(QC_entry_t* entry, uint64_t user_hash, const u
 	entry->key=hk;
 	entry->kv=KVs[i];
 	KVs[i]->replace(hk, entry);
+	if (tables) {
+		// the entry is indexed only after being stored: an invalidation running concurrently either
+		// finds the key in the index, or bumps the epoch before the key is added and track()
+		// fails, dropping the entry here
+		if (table_index.track(hk, *tables) == false) {
+			if (KVs[i]->drop(hk)) {
+				__sync_fetch_and_add(&Glo_cntInvalidated, 1);
+			}
+			return false;
+		}
+	}
 	return true;
 }
 
+template <typename QC_DERIVED>
+void Query_Cache<QC_DERIVED>::get_tables_version(std::vector<std::pair<uint64_t,uint64_t>>& tables) {
+	const uint64_t epoch = table_index.get_epoch();
+	for (auto& t : tables) {
+		t.second = epoch;
+	}
+}
+
+template <typename QC_DERIVED>
+uint64_t Query_Cache<QC_DERIVED>::invalidate_tables(const std::vector<uint64_t>& tables) {
+	uint64_t dropped = 0;
+	std::vector<uint64_t> keys {};
+	for (const uint64_t th : tables) {
+		table_index.invalidate(th, keys);
+		for (const uint64_t k : keys) {
+			if (KVs[k%SHARED_QUERY_CACHE_HASH_TABLES]->drop(k)) {
+				dropped++;
+			}
+		}
+		keys.clear();
+	}
+	if (dropped) {
+		__sync_fetch_and_add(&Glo_cntInvalidated, dropped);
+	}
+	return dropped;
+}
+
 template <typename QC_DERIVED>
 uint64_t Query_Cache<QC_DERIVED>::flush() {
 	uint64_t total_count=0;
@@ -614,6 +711,8 @@ uint64_t Query_Cache<QC_DERIVED>::flush() {
 		total_count+=KVs[i]->count();
 		KVs[i]->clear(true);
 	}
+	// the last invalidations are kept, queries already running must still notice them
+	table_index.clear();
 	return total_count;
 };
 
@@ -681,6 +780,12 @@ SQLite3_result* Query_Cache<QC_DERIVED>::SQL3_getStats() {
 		pta[1]=buf;
 		result->add_row(pta);
 	}
+	{ // Glo_cntInvalidated
+		pta[0]=(char *)"Query_Cache_Invalidated";
+		sprintf(buf,"%lu", Glo_cntInvalidated);
+		pta[1]=buf;
+		result->add_row(pta);
+	}
 	free(pta);
 	return result;
 }
@@ -692,6 +797,256 @@ void Query_Cache<QC_DERIVED>::purgeHash(uint64_t max_memory_size) {
 	purgeHash((monotonic_time() / 1000ULL), curr_pct);
 }
 
+/**
+ * @brief Minimal tokenizer over a digest text, only used to find table names.
+ * @details Words are returned lowercased, with '.' separated (and backquoted) parts joined, so that
+ *  'db.tbl' and '`db`.`tbl`' produce the same token. Literals, comments and operators are returned as
+ *  single character punctuation tokens, or skipped.
+ */
+class QC_digest_tokenizer {
+public:
+	QC_digest_tokenizer(const char* _s) : s(_s) {}
+
+	/**
+	 * @brief Reads the next token.
+	 * @return False when the end of the digest was reached.
+	 */
+	bool next() {
+		text.clear();
+		name = false;
+		parts = 0;
+		for (;;) {
+			while (*s && isspace((unsigned char)*s)) s++;
+			if (*s == '\0') return false;
+			if (s[0] == '/' && s[1] == '*') {
+				const char* e = strstr(s + 2, "*/");
+				s = e ? e + 2 : s + strlen(s);
+				continue;
+			}
+			if (*s == '#' || (s[0] == '-' && s[1] == '-' && (s[2] == ' ' || s[2] == '\0'))) {
+				while (*s && *s != '\n') s++;
+				continue;
+			}
+			break;
+		}
+		if (*s == '\'' || *s == '"') {
+			const char q = *s++;
+			while (*s && *s != q) {
+				if (*s == '\\' && s[1]) s++;
+				s++;
+			}
+			if (*s) s++;
+			text = "?";
+			return true;
+		}
+		if (is_word_char(*s) || *s == '`') {
+			name = (*s == '`');
+			for (;;) {
+				if (*s == '`') {
+					s++;
+					while (*s) {
+						if (*s == '`') {
+							if (s[1] != '`') break;
+							s++;
+						}
+						text += tolower((unsigned char)*s++);
+					}
+					if (*s) s++;
+				} else {
+					while (is_word_char(*s)) {
+						text += tolower((unsigned char)*s++);
+					}
+				}
+				parts++;
+				if (s[0] == '.' && (is_word_char(s[1]) || s[1] == '`')) {
+					text += '.';
+					name = true;
+					s++;
+					continue;
+				}
+				break;
+			}
+			return true;
+		}
+		text = *s++;
+		return true;
+	}
+
+	bool is(const char* w) const { return name == false && text == w; }
+
+	std::string text;
+	// true when the token can only be an identifier (quoted, or qualified)
+	bool name = false;
+	int parts = 0;
+
+private:
+	const char* s;
+	static bool is_word_char(char c) {
+		return isalnum((unsigned char)c) || c == '_' || c == '$' || (c & 0x80);
+	}
+};
+
+/**
+ * @brief Words that can follow a table reference and must not be taken as its alias.
+ */
+static const std::unordered_set<std::string> qc_table_stop_words {
+	"where", "join", "inner", "left", "right", "outer", "cross", "natural", "straight_join", "on", "using",
+	"group", "order", "limit", "having", "union", "except", "intersect", "set", "values", "value", "select",
+	"for", "lock", "window", "partition", "use", "force", "ignore", "into", "from", "procedure", "returning",
+	"as", "dual", "if", "exists", "not", "to", "add", "modify", "change", "drop", "rename", "engine",
+	"default", "character", "charset", "collate", "with", "read", "write", "duplicate", "low_priority",
+	"high_priority", "delayed", "quick", "temporary", "table", "tables", "lateral", "key", "index"
+};
+
+/**
+ * @brief Statements for which all the referenced tables are reported as written.
+ */
+static const std::unordered_set<std::string> qc_write_verbs {
+	"insert", "replace", "update", "delete", "truncate", "alter", "drop", "rename", "load"
+};
+
+void qc_extract_tables(const char* digest_text, const char* schemaname, std::vector<uint64_t>* read_tables,
+	std::vector<uint64_t>* write_tables) {
+	if (digest_text == NULL) {
+		return;
+	}
+	if (read_tables == NULL) {
+		// only writing statements are of interest: skip all the digests that don't start with one of
+		// them, unless they contain multiple statements
+		const char* p = digest_text;
+		for (;;) {
+			while (*p && (isspace((unsigned char)*p) || *p == '(')) p++;
+			if (p[0] == '/' && p[1] == '*' && strstr(p + 2, "*/")) {
+				p = strstr(p + 2, "*/") + 2;
+				continue;
+			}
+			break;
+		}
+		const char* e = p;
+		while (isalpha((unsigned char)*e) || *e == '_') e++;
+		std::string verb(p, e - p);
+		std::transform(verb.begin(), verb.end(), verb.begin(), ::tolower);
+		if (qc_write_verbs.count(verb) == 0 && verb != "with" && strchr(digest_text, ';') == NULL) {
+			return;
+		}
+	}
+
+	std::string schema = schemaname ? schemaname : "";
+	std::transform(schema.begin(), schema.end(), schema.begin(), ::tolower);
+
+	std::vector<QC_digest_tokenizer> toks {};
+	{
+		QC_digest_tokenizer tok(digest_text);
+		while (tok.next()) {
+			toks.push_back(tok);
+		}
+	}
+
+	std::vector<uint64_t> stmt_tables {};
+	std::string stmt_verb {};
+	bool stmt_start = true;
+
+	const auto is_name = [&toks] (size_t i) -> bool {
+		if (i >= toks.size()) return false;
+		const QC_digest_tokenizer& t = toks[i];
+		if (t.name) return true;
+		if (t.text.empty() || !(isalpha((unsigned char)t.text[0]) || t.text[0] == '_' || t.text[0] == '$' || (t.text[0] & 0x80))) {
+			return false;
+		}
+		return qc_table_stop_words.count(t.text) == 0;
+	};
+	const auto add_table = [&] (const QC_digest_tokenizer& t) {
+		std::string fqn {};
+		if (t.parts == 1) {
+			fqn = schema + "." + t.text;
+		} else {
+			fqn = t.text;
+		}
+		stmt_tables.push_back(SpookyHash::Hash64(fqn.c_str(), fqn.length(), 0));
+	};
+	// reads a table reference, with an optional alias, and when 'list' is true the comma separated
+	// references following it. Returns the index of the first token not consumed.
+	const auto read_tables_at = [&] (size_t i, bool list) -> size_t {
+		for (;;) {
+			if (is_name(i) == false) {
+				return i;
+			}
+			add_table(toks[i]);
+			i++;
+			if (i < toks.size() && toks[i].is("as")) {
+				i += 2;
+			} else if (is_name(i) && toks[i].parts == 1) {
+				i++;
+			}
+			if (list && i < toks.size() && toks[i].is(",")) {
+				i++;
+				continue;
+			}
+			return i;
+		}
+	};
+	const auto end_statement = [&] () {
+		if (write_tables && qc_write_verbs.count(stmt_verb)) {
+			write_tables->insert(write_tables->end(), stmt_tables.begin(), stmt_tables.end());
+		}
+		if (read_tables) {
+			read_tables->insert(read_tables->end(), stmt_tables.begin(), stmt_tables.end());
+		}
+		stmt_tables.clear();
+		stmt_verb.clear();
+		stmt_start = true;
+	};
+
+	size_t i = 0;
+	while (i < toks.size()) {
+		const QC_digest_tokenizer& t = toks[i];
+		if (t.is(";")) {
+			end_statement();
+			i++;
+			continue;
+		}
+		if (t.is("(")) {
+			i++;
+			continue;
+		}
+		// the statement following the common table expressions of a WITH clause
+		const bool verb = stmt_start || (stmt_verb == "with" && toks[i-1].is(")"));
+		stmt_start = false;
+		if (verb && t.name == false) {
+			stmt_verb = t.text;
+		}
+		if (t.is("from") || t.is("join")) {
+			i = read_tables_at(i + 1, t.is("from"));
+			continue;
+		}
+		if (verb && (t.is("insert") || t.is("replace") || t.is("update"))) {
+			// skip the modifiers up to the target table
+			i++;
+			while (i < toks.size() && (toks[i].is("low_priority") || toks[i].is("high_priority")
+				|| toks[i].is("delayed") || toks[i].is("ignore") || toks[i].is("into"))) {
+				i++;
+			}
+			i = read_tables_at(i, t.is("update"));
+			continue;
+		}
+		if (t.is("table") && (stmt_verb == "truncate" || stmt_verb == "alter" || stmt_verb == "drop"
+			|| stmt_verb == "rename" || stmt_verb == "load")) {
+			i++;
+			while (i < toks.size() && (toks[i].is("if") || toks[i].is("not") || toks[i].is("exists"))) {
+				i++;
+			}
+			i = read_tables_at(i, true);
+			continue;
+		}
+		if (verb && t.is("truncate")) {
+			i = read_tables_at(i + 1, false);
+			continue;
+		}
+		i++;
+	}
+	end_statement();
+}
+
 template
 class Query_Cache<MySQL_Query_Cache>;
 
@@ -17,6 +17,9 @@ using json = nlohmann::json;
 #include "MySQL_Data_Stream.h"
 #include "query_processor.h"
 #include "QP_rule_text.h"
+#include "QP_digest_cache.h"
+#include "QP_fast_routing_table.h"
+#include "QP_firewall_whitelist.h"
 #include "MySQL_Query_Processor.h"
 #include "PgSQL_Query_Processor.h"
 
@@ -36,9 +39,11 @@ extern ProxySQL_Admin *GloAdmin;
 
 // per thread variables
 __thread unsigned int _thr_SQP_version;
-__thread std::vector<QP_rule_t*>* _thr_SQP_rules;
-__thread khash_t(khStrInt)* _thr_SQP_rules_fast_routing;
-__thread char* _thr___rules_fast_routing___keys_values;
+__thread QP_compiled_rules_t* _thr_SQP_compiled_rules;
+__thread unsigned long long* _thr_SQP_rules_hits; // one counter per rule in _thr_SQP_compiled_rules
+__thread QP_digest_cache* _thr_SQP_digest_cache;
+__thread char* _thr_SQP_digest_scratch;
+__thread size_t _thr_SQP_digest_scratch_size;
 
 struct __RE2_objects_t {
 	pcrecpp::RE_Options* opt1;
@@ -49,14 +54,6 @@ struct __RE2_objects_t {
 
 typedef struct __RE2_objects_t re2_t;
 
-static int int_cmp(const void *a, const void *b) {
-	const unsigned long long *ia = (const unsigned long long *)a;
-	const unsigned long long *ib = (const unsigned long long *)b;
-	if (*ia < *ib) return -1;
-	if (*ia > *ib) return 1;
-	return 0;
-}
-
 static bool rules_sort_comp_function (QP_rule_t * a, QP_rule_t * b) { 
 	return (a->rule_id < b->rule_id); 
 }
@@ -175,7 +172,7 @@ static void __delete_query_rule(QP_rule_t *qr) {
 // delete all the query rules in a Query Processor Table
 // Note that this function is called by:
 //  - GloQPro with &rules (generic table). In Query_Processor destrutor.
-//  - Each mysql thread with _thr_SQP_rules (per thread table). During destruction or rules recreation.
+//  - Each set of compiled rules shared by the mysql threads (QP_compiled_rules_t), when its last reference is released.
 //  - ProxySQL_Admin at 'load_mysql_variables_to_runtime', during global rules recreation. For this case, the
 //    function is used outside the 'Query_Processor' due to flow present in 'load_mysql_variables_to_runtime'
 //    of freeing the previous resources associated to the 'query_rules' and 'query_rules_fast_routing' out of
@@ -191,6 +188,19 @@ void __reset_rules(std::vector<QP_rule_t *> * qrs) {
 	qrs->clear();
 }
 
+// drops a reference to a set of compiled rules, freeing it if it was the last one
+static void __release_compiled_rules(QP_compiled_rules_t *cr) {
+	if (cr == NULL) return;
+	if (__sync_sub_and_fetch(&cr->refcnt, 1) == 0) {
+		proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Freeing compiled rules with version=%d\n", cr->version);
+		__reset_rules(&cr->rules);
+		if (cr->rules_fast_routing) {
+			delete cr->rules_fast_routing;
+		}
+		delete cr;
+	}
+}
+
 template <typename QP_DERIVED>
 Query_Processor<QP_DERIVED>::Query_Processor(int _query_rules_fast_routing_algorithm) {
 #ifdef DEBUG
@@ -212,6 +222,9 @@ Query_Processor<QP_DERIVED>::Query_Processor(int _query_rules_fast_routing_algor
 	global_firewall_whitelist_users_result___size = 0;
 	global_firewall_whitelist_rules_map___size = 0;
 	global_firewall_whitelist_rules_result___size = 0;
+	// empty whitelist, resolved by the sessions until the first load_firewall()
+	firewall_whitelist = new QP_firewall_whitelist(NULL, NULL);
+	firewall_whitelist_version = 0;
 
 	pthread_rwlock_init(&rwlock, NULL);
 	pthread_rwlock_init(&digest_rwlock, NULL);
@@ -237,7 +250,13 @@ Query_Processor<QP_DERIVED>::Query_Processor(int _query_rules_fast_routing_algor
 	rules_fast_routing = nullptr;
 	rules_fast_routing___keys_values = NULL;
 	rules_fast_routing___keys_values___size = 0;
+	// empty set of compiled rules, adopted by the threads until the first commit()
+	compiled_rules = new QP_compiled_rules_t {};
+	compiled_rules->refcnt = 1;
 	new_req_conns_count = 0;
+	query_digests_cache_hits = 0;
+	query_digests_cache_misses = 0;
+	query_digests_truncated = 0;
 }
 
 template <typename QP_DERIVED>
@@ -251,6 +270,8 @@ Query_Processor<QP_DERIVED>::~Query_Processor() {
 		rules_fast_routing___keys_values = NULL;
 		rules_fast_routing___keys_values___size = 0;
 	}
+	__release_compiled_rules(compiled_rules);
+	compiled_rules = nullptr;
 	for (std::unordered_map<uint64_t, void *>::iterator it=digest_umap.begin(); it!=digest_umap.end(); ++it) {
 		QP_query_digest_stats *qds=(QP_query_digest_stats *)it->second;
 		delete qds;
@@ -280,30 +301,42 @@ Query_Processor<QP_DERIVED>::~Query_Processor() {
 		delete global_firewall_whitelist_sqli_fingerprints_runtime;
 		global_firewall_whitelist_sqli_fingerprints_runtime = NULL;
 	}
+	firewall_whitelist->release();
+	firewall_whitelist = nullptr;
 }
 
 // This function is called by each thread when it starts. It create a Query Processor Table for each thread
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::init_thread() {
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Initializing Per-Thread Query Processor Table with version=0\n");
-	_thr_SQP_version=0;
-	_thr_SQP_rules=new std::vector<QP_rule_t *>;
-	// per-thread 'rules_fast_routing' structures are created on demand
-	_thr_SQP_rules_fast_routing = nullptr;
-	_thr___rules_fast_routing___keys_values = NULL;
+	rdlock();
+	_thr_SQP_version = __sync_add_and_fetch(&version,0);
+	_thr_SQP_compiled_rules = compiled_rules;
+	__sync_fetch_and_add(&_thr_SQP_compiled_rules->refcnt, 1);
+	wrunlock();
+	_thr_SQP_rules_hits = (unsigned long long *)calloc(_thr_SQP_compiled_rules->rules.size() + 1, sizeof(unsigned long long));
+	// the digest cache is created on demand by query_parser_init()
+	_thr_SQP_digest_cache = nullptr;
+	// the scratch buffer for digests of large queries grows on demand up to query_digests_max_query_length
+	_thr_SQP_digest_scratch = NULL;
+	_thr_SQP_digest_scratch_size = 0;
 }
 
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::end_thread() {
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Destroying Per-Thread Query Processor Table with version=%d\n", _thr_SQP_version);
-	__reset_rules(_thr_SQP_rules);
-	delete _thr_SQP_rules;
-	if (_thr_SQP_rules_fast_routing) {
-		kh_destroy(khStrInt, _thr_SQP_rules_fast_routing);
-	}
-	if (_thr___rules_fast_routing___keys_values) {
-		free(_thr___rules_fast_routing___keys_values);
-		_thr___rules_fast_routing___keys_values = NULL;
+	__release_compiled_rules(_thr_SQP_compiled_rules);
+	_thr_SQP_compiled_rules = nullptr;
+	free(_thr_SQP_rules_hits);
+	_thr_SQP_rules_hits = NULL;
+	if (_thr_SQP_digest_cache) {
+		delete _thr_SQP_digest_cache;
+		_thr_SQP_digest_cache = nullptr;
+	}
+	if (_thr_SQP_digest_scratch) {
+		free(_thr_SQP_digest_scratch);
+		_thr_SQP_digest_scratch = NULL;
+		_thr_SQP_digest_scratch_size = 0;
 	}
 }
 
@@ -341,6 +374,21 @@ unsigned long long Query_Processor<QP_DERIVED>::get_new_req_conns_count() {
 	return __sync_fetch_and_add(&new_req_conns_count, 0);
 }
 
+template <typename QP_DERIVED>
+unsigned long long Query_Processor<QP_DERIVED>::get_query_digests_cache_hits() {
+	return __sync_fetch_and_add(&query_digests_cache_hits, 0);
+}
+
+template <typename QP_DERIVED>
+unsigned long long Query_Processor<QP_DERIVED>::get_query_digests_cache_misses() {
+	return __sync_fetch_and_add(&query_digests_cache_misses, 0);
+}
+
+template <typename QP_DERIVED>
+unsigned long long Query_Processor<QP_DERIVED>::get_query_digests_truncated() {
+	return __sync_fetch_and_add(&query_digests_truncated, 0);
+}
+
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::delete_query_rule(QP_rule_t *qr) {
 	__delete_query_rule(qr);
@@ -395,12 +443,53 @@ void Query_Processor<QP_DERIVED>::sort(bool lock) {
 		wrunlock();
 }
 
-// when commit is called, the version number is increased and the this will trigger the mysql threads to get a new Query Processor Table
+template <typename QP_DERIVED>
+QP_compiled_rules_t* Query_Processor<QP_DERIVED>::compile_rules() {
+	int query_processor_regex = 1;
+	if constexpr (std::is_same_v<QP_DERIVED,MySQL_Query_Processor>) {
+		query_processor_regex = GloMTH->get_variable_int("query_processor_regex");
+	} else if constexpr (std::is_same_v<QP_DERIVED,PgSQL_Query_Processor>) {
+		query_processor_regex = GloPTH->get_variable_int("query_processor_regex");
+	}
+	QP_compiled_rules_t* cr = new QP_compiled_rules_t {};
+	cr->refcnt = 1;
+	QP_rule_t *qr1;
+	QP_rule_t *qr2;
+	for (std::vector<QP_rule_t *>::iterator it=rules.begin(); it!=rules.end(); ++it) {
+		qr1=*it;
+		if (qr1->active) {
+			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Copying Query Rule id: %d\n", qr1->rule_id);
+			qr2=(static_cast<QP_DERIVED*>(this))->new_query_rule(static_cast<const TypeQueryRule*>(qr1));
+			qr2->parent=qr1;	// pointer to parent to speed up parent update (hits)
+			if (qr2->match_digest) {
+				proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Compiling regex for rule_id: %d, match_digest: %s\n", qr2->rule_id, qr2->match_digest);
+				qr2->regex_engine1=(void *)compile_query_rule(qr2,1, query_processor_regex);
+			}
+			if (qr2->match_pattern) {
+				proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Compiling regex for rule_id: %d, match_pattern: %s\n", qr2->rule_id, qr2->match_pattern);
+				qr2->regex_engine2=(void *)compile_query_rule(qr2,2, query_processor_regex);
+			}
+			cr->rules.push_back(qr2);
+		}
+	}
+	if (this->query_rules_fast_routing_algorithm == 1 && rules_fast_routing___keys_values___size) {
+		cr->rules_fast_routing = new QP_fast_routing_table(rules_fast_routing___keys_values, rules_fast_routing___keys_values___size);
+		// a single table shared by all the threads
+		rules_mem_used += cr->rules_fast_routing->get_memory_usage();
+	}
+	return cr;
+}
+
+// when commit is called, the version number is increased and the this will trigger the mysql threads to adopt the
+// new compiled rules. The rules are compiled only once here, while the caller holds the write lock.
 // The operation is asynchronous
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::commit() {
-	__sync_add_and_fetch(&version,1);
+	QP_compiled_rules_t* prev_compiled_rules = compiled_rules;
+	compiled_rules = compile_rules();
+	compiled_rules->version = __sync_add_and_fetch(&version,1);
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Increasing version number to %d - all threads will notice this and refresh their rules\n", version);
+	__release_compiled_rules(prev_compiled_rules);
 }
 
 template <typename QP_DERIVED>
@@ -519,6 +608,35 @@ int Query_Processor<QP_DERIVED>::search_rules_fast_routing_dest_hg(
 	return dest_hg;
 }
 
+template <typename QP_DERIVED>
+int Query_Processor<QP_DERIVED>::search_rules_fast_routing_dest_hg(
+	const QP_fast_routing_table* _rules_fast_routing, const char* u, const char* s, int flagIN
+) {
+	int dest_hg = -1;
+	const size_t u_len = strlen(u);
+	size_t keylen = u_len+strlen(rand_del)+strlen(s)+30; // 30 is a big number
+
+	char keybuf[256];
+	char * keybuf_ptr = keybuf;
+
+	if (keylen >= sizeof(keybuf)) {
+		keybuf_ptr = (char *)malloc(keylen);
+	}
+	sprintf(keybuf_ptr,"%s%s%s---%d", u, rand_del, s, flagIN);
+
+	dest_hg = _rules_fast_routing->lookup(keybuf_ptr);
+	if (dest_hg == -1) {
+		// no match for the user, search with an empty username
+		dest_hg = _rules_fast_routing->lookup(keybuf_ptr + u_len);
+	}
+
+	if (keylen >= sizeof(keybuf)) {
+		free(keybuf_ptr);
+	}
+
+	return dest_hg;
+}
+
 struct get_query_digests_parallel_args {
 	unsigned long long ret;
 	pthread_t thr;
@@ -815,9 +933,9 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 	curtime1 = monotonic_time(); // curtime1 must always be initialized
 	if (use_resultset) {
 		if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
-			result = new SQLite3_result(14, true);
+			result = new SQLite3_result(DIGEST_STATS_COLUMNS, true);
 		} else {
-			result = new SQLite3_result(14);
+			result = new SQLite3_result(DIGEST_STATS_COLUMNS);
 		}
 		result->add_column_definition(SQLITE_TEXT,"hid");
 		if constexpr (std::is_same_v<QP_DERIVED,MySQL_Query_Processor>){
@@ -837,6 +955,9 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 		result->add_column_definition(SQLITE_TEXT,"max_time");
 		result->add_column_definition(SQLITE_TEXT,"rows_affected");
 		result->add_column_definition(SQLITE_TEXT,"rows_sent");
+		result->add_column_definition(SQLITE_TEXT,"p50_time");
+		result->add_column_definition(SQLITE_TEXT,"p95_time");
+		result->add_column_definition(SQLITE_TEXT,"p99_time");
 		if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
 			int n=DIGEST_STATS_FAST_THREADS;
 			get_query_digests_parallel_args args[n];
@@ -913,9 +1034,7 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 		if (it != digest_umap_aux.end()) {
 			// found
 			QP_query_digest_stats *qds_equal = (QP_query_digest_stats *)it->second;
-			qds_equal->add_time(
-				qds->min_time, qds->last_seen, qds->rows_affected, qds->rows_sent, qds->count_star
-			);
+			qds_equal->merge(qds);
 			delete qds;
 		} else {
 			digest_umap_aux.insert(element);
@@ -938,9 +1057,7 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 		if (it != digest_umap.end()) {
 			// found
 			QP_query_digest_stats *qds_equal = (QP_query_digest_stats *)it->second;
-			qds_equal->add_time(
-				qds->min_time, qds->last_seen, qds->rows_affected, qds->rows_sent, qds->count_star
-			);
+			qds_equal->merge(qds);
 			delete qds;
 		} else {
 			digest_umap.insert(element);
@@ -965,9 +1082,9 @@ SQLite3_result * Query_Processor<QP_DERIVED>::get_query_digests() {
 	size_t map_size = digest_umap.size();
 	curtime1 = monotonic_time(); // curtime1 must always be initialized
 	if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
-		result = new SQLite3_result(14, true);
+		result = new SQLite3_result(DIGEST_STATS_COLUMNS, true);
 	} else {
-		result = new SQLite3_result(14);
+		result = new SQLite3_result(DIGEST_STATS_COLUMNS);
 	}
 	result->add_column_definition(SQLITE_TEXT,"hid");
 	if constexpr (std::is_same_v<QP_DERIVED, MySQL_Query_Processor>) {
@@ -987,6 +1104,9 @@ SQLite3_result * Query_Processor<QP_DERIVED>::get_query_digests() {
 	result->add_column_definition(SQLITE_TEXT,"max_time");
 	result->add_column_definition(SQLITE_TEXT,"rows_affected");
 	result->add_column_definition(SQLITE_TEXT,"rows_sent");
+	result->add_column_definition(SQLITE_TEXT,"p50_time");
+	result->add_column_definition(SQLITE_TEXT,"p95_time");
+	result->add_column_definition(SQLITE_TEXT,"p99_time");
 	if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
 		int n=DIGEST_STATS_FAST_THREADS;
 		get_query_digests_parallel_args args[n];
@@ -1056,9 +1176,9 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 		free_me = true;
 		defer_free = true;
 		if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
-			result = new SQLite3_result(14, true);
+			result = new SQLite3_result(DIGEST_STATS_COLUMNS, true);
 		} else {
-			result = new SQLite3_result(14);
+			result = new SQLite3_result(DIGEST_STATS_COLUMNS);
 		}
 		result->add_column_definition(SQLITE_TEXT,"hid");
 		if constexpr (std::is_same_v<QP_DERIVED, MySQL_Query_Processor>) {
@@ -1078,6 +1198,9 @@ std::pair<SQLite3_result *, int> Query_Processor<QP_DERIVED>::get_query_digests_
 		result->add_column_definition(SQLITE_TEXT,"max_time");
 		result->add_column_definition(SQLITE_TEXT,"rows_affected");
 		result->add_column_definition(SQLITE_TEXT,"rows_sent");
+		result->add_column_definition(SQLITE_TEXT,"p50_time");
+		result->add_column_definition(SQLITE_TEXT,"p95_time");
+		result->add_column_definition(SQLITE_TEXT,"p99_time");
 		if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
 			for (int i=0; i<n; i++) {
 				args[i].m=i;
@@ -1187,9 +1310,9 @@ SQLite3_result * Query_Processor<QP_DERIVED>::get_query_digests_reset() {
 	size_t map_size = digest_umap.size();
 	curtime1 = monotonic_time(); // curtime1 must always be initialized
 	if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
-		result = new SQLite3_result(14, true);
+		result = new SQLite3_result(DIGEST_STATS_COLUMNS, true);
 	} else {
-		result = new SQLite3_result(14);
+		result = new SQLite3_result(DIGEST_STATS_COLUMNS);
 	}
 	result->add_column_definition(SQLITE_TEXT,"hid");
 	if constexpr (std::is_same_v<QP_DERIVED, MySQL_Query_Processor>) {
@@ -1209,6 +1332,9 @@ SQLite3_result * Query_Processor<QP_DERIVED>::get_query_digests_reset() {
 	result->add_column_definition(SQLITE_TEXT,"max_time");
 	result->add_column_definition(SQLITE_TEXT,"rows_affected");
 	result->add_column_definition(SQLITE_TEXT,"rows_sent");
+	result->add_column_definition(SQLITE_TEXT,"p50_time");
+	result->add_column_definition(SQLITE_TEXT,"p95_time");
+	result->add_column_definition(SQLITE_TEXT,"p99_time");
 	if (map_size >= DIGEST_STATS_FAST_MINSIZE) {
 		for (int i=0; i<n; i++) {
 			args[i].m=i;
@@ -1285,68 +1411,20 @@ Query_Processor_Output* Query_Processor<QP_DERIVED>::process_query(TypeSession*
 	// to avoid unnecssary deallocation/allocation, we initialize qpo witout new allocation
 
 	if (__sync_add_and_fetch(&version,0) > _thr_SQP_version) {
-		// update local rules;
+		// adopt the new compiled rules: they are shared, nothing is copied or compiled here
 		proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Detected a changed in version. Global:%d , local:%d . Refreshing...\n", version, _thr_SQP_version);
+		QP_compiled_rules_t* prev_compiled_rules = _thr_SQP_compiled_rules;
 		rdlock();
 		_thr_SQP_version=__sync_add_and_fetch(&version,0);
-		__reset_rules(_thr_SQP_rules);
-		QP_rule_t *qr1;
-		QP_rule_t *qr2;
-		for (std::vector<QP_rule_t *>::iterator it=rules.begin(); it!=rules.end(); ++it) {
-			qr1=*it;
-			if (qr1->active) {
-				proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Copying Query Rule id: %d\n", qr1->rule_id);
-				qr2=(static_cast<QP_DERIVED*>(this))->new_query_rule(static_cast<const TypeQueryRule*>(qr1));
-				qr2->parent=qr1;	// pointer to parent to speed up parent update (hits)
-				if (qr2->match_digest) {
-					proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Compiling regex for rule_id: %d, match_digest: %s\n", qr2->rule_id, qr2->match_digest);
-					qr2->regex_engine1=(void *)compile_query_rule(qr2,1, GET_THREAD_VARIABLE(query_processor_regex));
-				}
-				if (qr2->match_pattern) {
-					proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 4, "Compiling regex for rule_id: %d, match_pattern: %s\n", qr2->rule_id, qr2->match_pattern);
-					qr2->regex_engine2=(void *)compile_query_rule(qr2,2, GET_THREAD_VARIABLE(query_processor_regex));
-				}
-				_thr_SQP_rules->push_back(qr2);
-			}
-		}
-		if (this->query_rules_fast_routing_algorithm == 1) {
-			if (_thr_SQP_rules_fast_routing) {
-				kh_destroy(khStrInt, _thr_SQP_rules_fast_routing);
-				_thr_SQP_rules_fast_routing = nullptr;
-			}
-			if (_thr___rules_fast_routing___keys_values) {
-				free(_thr___rules_fast_routing___keys_values);
-				_thr___rules_fast_routing___keys_values = NULL;
-			}
-			if (rules_fast_routing___keys_values___size) {
-				_thr_SQP_rules_fast_routing = kh_init(khStrInt); // create a hashtable
-				_thr___rules_fast_routing___keys_values = (char *)malloc(rules_fast_routing___keys_values___size);
-				memcpy(_thr___rules_fast_routing___keys_values, rules_fast_routing___keys_values, rules_fast_routing___keys_values___size);
-				char *ptr = _thr___rules_fast_routing___keys_values;
-				while (ptr < _thr___rules_fast_routing___keys_values + rules_fast_routing___keys_values___size) {
-					char *ptr2 = ptr+strlen(ptr)+1;
-					int destination_hostgroup = atoi(ptr2);
-					int ret;
-					khiter_t k = kh_put(khStrInt, _thr_SQP_rules_fast_routing, ptr, &ret); // add the key
-					kh_value(_thr_SQP_rules_fast_routing, k) = destination_hostgroup; // set the value of the key
-					ptr = ptr2+strlen(ptr2)+1;
-				}
-			}
-		} else {
-			if (_thr_SQP_rules_fast_routing) {
-				kh_destroy(khStrInt, _thr_SQP_rules_fast_routing);
-				_thr_SQP_rules_fast_routing = nullptr;
-			}
-			if (_thr___rules_fast_routing___keys_values) {
-				free(_thr___rules_fast_routing___keys_values);
-				_thr___rules_fast_routing___keys_values = nullptr;
-			}
-		}
-		//for (std::unordered_map<std::string, int>::iterator it = rules_fast_routing.begin(); it != rules_fast_routing.end(); ++it) {
-		//	_thr_SQP_rules_fast_routing->insert(
-		//}
+		_thr_SQP_compiled_rules = compiled_rules;
+		__sync_fetch_and_add(&_thr_SQP_compiled_rules->refcnt, 1);
 		wrunlock();
+		__release_compiled_rules(prev_compiled_rules);
+		// hits not yet flushed belong to the previous rules, and are discarded
+		free(_thr_SQP_rules_hits);
+		_thr_SQP_rules_hits = (unsigned long long *)calloc(_thr_SQP_compiled_rules->rules.size() + 1, sizeof(unsigned long long));
 	}
+	std::vector<QP_rule_t *>& thr_rules = _thr_SQP_compiled_rules->rules;
 	QP_rule_t *qr = NULL;
 	re2_t *re2p;
 	int flagIN=0;
@@ -1370,7 +1448,7 @@ Query_Processor_Output* Query_Processor<QP_DERIVED>::process_query(TypeSession*
 		}
 	}
 __internal_loop:
-	for (std::vector<QP_rule_t *>::iterator it=_thr_SQP_rules->begin(); it!=_thr_SQP_rules->end(); ++it) {
+	for (std::vector<QP_rule_t *>::iterator it=thr_rules.begin(); it!=thr_rules.end(); ++it) {
 		qr=*it;
 		if (qr->flagIN != flagIN) {
 			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 6, "query rule %d has no matching flagIN\n", qr->rule_id);
@@ -1481,7 +1559,7 @@ __internal_loop:
 		}
 
 		// if we arrived here, we have a match
-		qr->hits++; // this is done without atomic function because it updates only the local variables
+		_thr_SQP_rules_hits[it - thr_rules.begin()]++; // rules are shared, hits are counted per thread
 		bool set_flagOUT=false;
 		if (qr->flagOUT_weights_total > 0) {
 			int rnd = random() % qr->flagOUT_weights_total;
@@ -1630,9 +1708,9 @@ __exit_process_mysql_query:
 
 		int dst_hg = -1;
 
-		if (_thr_SQP_rules_fast_routing != nullptr) {
+		if (_thr_SQP_compiled_rules->rules_fast_routing != nullptr) {
 			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 7, "Searching thread-local 'rules_fast_routing' hashmap with: user='%s', schema='%s', and flagIN='%d'\n", u, s, flagIN);
-			dst_hg = search_rules_fast_routing_dest_hg(&_thr_SQP_rules_fast_routing, u, s, flagIN, false);
+			dst_hg = search_rules_fast_routing_dest_hg(_thr_SQP_compiled_rules->rules_fast_routing, u, s, flagIN);
 		} else if (rules_fast_routing != nullptr) {
 			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 7, "Searching global 'rules_fast_routing' hashmap with: user='%s', schema='%s', and flagIN='%d'\n", u, s, flagIN);
 			// NOTE: A pointer to the member 'this->rules_fast_routing' is required, since the value of the
@@ -1662,23 +1740,24 @@ __exit_process_mysql_query:
 					check_run = true;
 					username = sess->client_myds->myconn->userinfo->username;
 					client_address = sess->client_myds->addr.addr;
-					pthread_mutex_lock(&global_firewall_whitelist_mutex);
-					// FIXME
-					// for now this function search for either username@ip or username@''
-					int wus_status = find_firewall_whitelist_user(username, client_address);
-					if (wus_status == WUS_NOT_FOUND) {
-						client_address = (char *)"";
-						wus_status = find_firewall_whitelist_user(username, client_address);
-					}
-					if (wus_status == WUS_NOT_FOUND) {
-						wus_status = WUS_PROTECTING; // by default, everything should be blocked!
+					char * schemaname = sess->client_myds->myconn->userinfo->schemaname;
+					// the user mode and the whitelisted digests are resolved once per session, and again only
+					// if username, client address or schema change, or if a new whitelist is loaded
+					QP_firewall_session_cache& fw_cache = sess->firewall_cache;
+					const unsigned int fw_version = get_firewall_whitelist_version();
+					if (fw_cache.valid(fw_version, username, client_address, schemaname) == false) {
+						pthread_mutex_lock(&global_firewall_whitelist_mutex);
+						QP_firewall_whitelist* fw = firewall_whitelist;
+						fw->acquire();
+						pthread_mutex_unlock(&global_firewall_whitelist_mutex);
+						fw_cache.resolve(fw, username, client_address, schemaname);
 					}
+					int wus_status = fw_cache.mode;
 					ret->firewall_whitelist_mode = wus_status;
 					if (wus_status == WUS_DETECTING || wus_status == WUS_PROTECTING) {
 						bool allowed_query = false;
-						char * schemaname = sess->client_myds->myconn->userinfo->schemaname;
-						if (qp && qp->digest) {
-							allowed_query = find_firewall_whitelist_rule(username, client_address, schemaname, flagIN, qp->digest);
+						if (qp && qp->digest && fw_cache.rules) {
+							allowed_query = fw_cache.rules->allowed(flagIN, qp->digest);
 						}
 						if (allowed_query == false) {
 							if (wus_status == WUS_PROTECTING) {
@@ -1692,7 +1771,6 @@ __exit_process_mysql_query:
 							ret->firewall_whitelist_mode = WUS_OFF;
 						}
 					}
-					pthread_mutex_unlock(&global_firewall_whitelist_mutex);
 					if (ret->firewall_whitelist_mode == WUS_DETECTING || ret->firewall_whitelist_mode == WUS_PROTECTING) {
 						char buf[32];
 						if (qp && qp->digest) {
@@ -1721,44 +1799,6 @@ __exit_process_mysql_query:
 	return ret;
 };
 
-template <typename QP_DERIVED>
-int Query_Processor<QP_DERIVED>::find_firewall_whitelist_user(char *username, char *client) {
-	int ret = WUS_NOT_FOUND;
-	string s = username;
-	s += rand_del;
-	s += client;
-	std::unordered_map<std::string, int>:: iterator it2;
-	it2 = global_firewall_whitelist_users.find(s);
-	if (it2 != global_firewall_whitelist_users.end()) {
-		ret = it2->second;
-		return ret;
-	}
-	s = username;
-	return ret;
-}
-
-template <typename QP_DERIVED>
-bool Query_Processor<QP_DERIVED>::find_firewall_whitelist_rule(char *username, char *client_address, char *schemaname, int flagIN, uint64_t digest) {
-	bool ret = false;
-	string s = username;
-	s += rand_del;
-	s += client_address;
-	s += rand_del;
-	s += schemaname;
-	s += rand_del;
-	s += to_string(flagIN);
-	std::unordered_map<std::string, void *>:: iterator it;
-	it = global_firewall_whitelist_rules.find(s);
-	if (it != global_firewall_whitelist_rules.end()) {
-		PtrArray *myptrarray = (PtrArray *)it->second;
-		void * found = bsearch(&digest, myptrarray->pdata, myptrarray->len, sizeof(unsigned long long), int_cmp);
-		if (found) {
-			ret = true;
-		}
-	}
-	return ret;
-}
-
 // this function is called by mysql_session to free the result generated by process_mysql_query()
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::delete_QP_out(Query_Processor_Output *o) {
@@ -1782,17 +1822,25 @@ void Query_Processor<QP_DERIVED>::update_query_processor_stats() {
 	proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 8, "Updating query rules statistics\n");
 	rdlock();
 	if (__sync_add_and_fetch(&version,0) == _thr_SQP_version) {
-		QP_rule_t *qr;
-		for (std::vector<QP_rule_t *>::iterator it=_thr_SQP_rules->begin(); it!=_thr_SQP_rules->end(); ++it) {
-			qr=*it;
-			if (qr->active && qr->hits) {
-				__sync_fetch_and_add(&qr->parent->hits,qr->hits);
-				qr->hits=0;
+		std::vector<QP_rule_t *>& thr_rules = _thr_SQP_compiled_rules->rules;
+		for (size_t i = 0; i < thr_rules.size(); i++) {
+			if (_thr_SQP_rules_hits[i]) {
+				__sync_fetch_and_add(&thr_rules[i]->parent->hits,_thr_SQP_rules_hits[i]);
+				_thr_SQP_rules_hits[i]=0;
 			}
 		}
 	}
 	wrunlock();
-	
+	if (_thr_SQP_digest_cache) {
+		if (_thr_SQP_digest_cache->hits) {
+			__sync_fetch_and_add(&query_digests_cache_hits, _thr_SQP_digest_cache->hits);
+			_thr_SQP_digest_cache->hits = 0;
+		}
+		if (_thr_SQP_digest_cache->misses) {
+			__sync_fetch_and_add(&query_digests_cache_misses, _thr_SQP_digest_cache->misses);
+			_thr_SQP_digest_cache->misses = 0;
+		}
+	}
 };
 
 template <typename QP_DERIVED>
@@ -1811,12 +1859,85 @@ void Query_Processor<QP_DERIVED>::query_parser_init(SQP_par_t *qp, const char *q
 		opts.groups_grouping_limit = GET_THREAD_VARIABLE(query_digests_groups_grouping_limit);
 		opts.keep_comment = GET_THREAD_VARIABLE(query_digests_keep_comment);
 		opts.max_query_length = GET_THREAD_VARIABLE(query_digests_max_query_length);
-
-		qp->digest_text=query_digest_and_first_comment_2(query, query_length, &qp->first_comment, 
-			((query_length < QUERY_DIGEST_BUF) ? qp->buf : NULL), &opts);
-		// the hash is computed only up to query_digests_max_digest_length bytes
-		const int digest_text_length=strnlen(qp->digest_text, GET_THREAD_VARIABLE(query_digests_max_digest_length));
-		qp->digest=SpookyHash::Hash64(qp->digest_text, digest_text_length, 0);
+		const int max_digest_length = GET_THREAD_VARIABLE(query_digests_max_digest_length);
+		// only the first 'query_digests_max_digest_length' bytes of the digest are hashed and stored in the
+		// stats, the tokenizer can stop there instead of consuming the rest of the query
+		if (GET_THREAD_VARIABLE(query_digests_stop_at_max_digest_length) && max_digest_length < opts.max_query_length) {
+			opts.max_query_length = max_digest_length;
+		}
+
+		// the per-thread digest cache is resized (and emptied) when query_digests_cache_size changes
+		const unsigned int cache_size = GET_THREAD_VARIABLE(query_digests_cache_size);
+		if (_thr_SQP_digest_cache && (cache_size == 0 || _thr_SQP_digest_cache->size() < cache_size || _thr_SQP_digest_cache->size() >= 2*cache_size)) {
+			__sync_fetch_and_add(&query_digests_cache_hits, _thr_SQP_digest_cache->hits);
+			__sync_fetch_and_add(&query_digests_cache_misses, _thr_SQP_digest_cache->misses);
+			delete _thr_SQP_digest_cache;
+			_thr_SQP_digest_cache = nullptr;
+		}
+		if (_thr_SQP_digest_cache == nullptr && cache_size) {
+			_thr_SQP_digest_cache = new QP_digest_cache(cache_size);
+		}
+		uint64_t cache_key1 = 0;
+		uint64_t cache_key2 = 0;
+		const QP_digest_cache::entry_t *ce = NULL;
+		const bool cacheable = (_thr_SQP_digest_cache && query_length <= QP_DIGEST_CACHE_MAX_QUERY_LENGTH);
+		if (cacheable) {
+			// all the options affecting the digest text and its hash are part of the key, hashed in full: packing
+			// them into shifted bit fields would let different settings share a key
+			const int opts_fields[] = {
+				opts.lowercase, opts.replace_null, opts.replace_number, opts.keep_comment, opts.grouping_limit,
+				opts.groups_grouping_limit, opts.max_query_length, max_digest_length
+			};
+			const uint64_t opts_seed = SpookyHash::Hash64(opts_fields, sizeof(opts_fields), 0);
+			QP_digest_cache::compute_key(query, query_length, opts_seed, &cache_key1, &cache_key2);
+			ce = _thr_SQP_digest_cache->lookup(cache_key1, cache_key2);
+		}
+		if (ce) {
+			if (ce->digest_text_length < QUERY_DIGEST_BUF) {
+				memcpy(qp->buf, ce->digest_text, ce->digest_text_length + 1);
+				qp->digest_text = qp->buf;
+			} else {
+				qp->digest_text = strdup(ce->digest_text);
+			}
+			if (ce->first_comment) {
+				qp->first_comment = strdup(ce->first_comment);
+			}
+			qp->digest = ce->digest;
+		} else {
+			if (query_length < QUERY_DIGEST_BUF) {
+				qp->digest_text=query_digest_and_first_comment_2(query, query_length, &qp->first_comment, qp->buf, &opts);
+			} else {
+				// large queries are parsed in the per-thread scratch buffer, and only the resulting digest is
+				// copied: most of them are reduced to a few bytes
+				size_t scratch_size = ((query_length < opts.max_query_length) ? query_length : opts.max_query_length) + 1;
+				if (scratch_size < QUERY_DIGEST_BUF) {
+					scratch_size = QUERY_DIGEST_BUF;
+				}
+				if (_thr_SQP_digest_scratch_size < scratch_size) {
+					free(_thr_SQP_digest_scratch);
+					_thr_SQP_digest_scratch = (char *)malloc(scratch_size);
+					_thr_SQP_digest_scratch_size = scratch_size;
+				}
+				char *res = query_digest_and_first_comment_2(query, query_length, &qp->first_comment, _thr_SQP_digest_scratch, &opts);
+				const size_t res_length = strlen(res);
+				// the tokenizer stops consuming the query once the digest fills the buffer
+				if (res_length >= (size_t)opts.max_query_length && query_length > opts.max_query_length) {
+					__sync_fetch_and_add(&query_digests_truncated, 1);
+				}
+				if (res_length < QUERY_DIGEST_BUF) {
+					qp->digest_text = qp->buf;
+				} else {
+					qp->digest_text = (char *)malloc(res_length + 1);
+				}
+				memcpy(qp->digest_text, res, res_length + 1);
+			}
+			// the hash is computed only up to query_digests_max_digest_length bytes
+			const int digest_text_length=strnlen(qp->digest_text, max_digest_length);
+			qp->digest=SpookyHash::Hash64(qp->digest_text, digest_text_length, 0);
+			if (cacheable) {
+				_thr_SQP_digest_cache->insert(cache_key1, cache_key2, qp->digest, qp->digest_text, qp->first_comment);
+			}
+		}
 #ifdef DEBUG
 		if (qp->first_comment && strlen(qp->first_comment)) {
 			proxy_debug(PROXY_DEBUG_MYSQL_QUERY_PROCESSOR, 5, "Comment in query = %s \n", qp->first_comment);
@@ -1882,13 +2003,24 @@ void Query_Processor<QP_DERIVED>::update_query_digest(uint64_t digest_total, uin
 		// found
 		qds=(QP_query_digest_stats *)it->second;
 		qds->add_time(t,n,rows_affected,rows_sent);
+		if (qds->histogram) {
+			qds->histogram->add(t);
+		}
 	} else {
 		char *dt = NULL;
 		if (GET_THREAD_VARIABLE(query_digests_normalize_digest_text)==false) {
 			dt = digest_text;
 		}
 		qds=new QP_query_digest_stats(ui->username, ui->schemaname, digest, dt, hid, client_addr, GET_THREAD_VARIABLE(query_digests_max_digest_length));
+		if constexpr (std::is_same_v<QP_DERIVED, MySQL_Query_Processor>) {
+			if (mysql_thread___query_digests_histograms_max > 0) {
+				qds->init_histogram(mysql_thread___query_digests_histograms_max);
+			}
+		}
 		qds->add_time(t,n, rows_affected,rows_sent);
+		if (qds->histogram) {
+			qds->histogram->add(t);
+		}
 		digest_umap.insert(std::make_pair(digest_total,(void *)qds));
 		if (GET_THREAD_VARIABLE(query_digests_normalize_digest_text)==true) {
 			const uint64_t dig = digest;
@@ -2051,140 +2183,6 @@ void Query_Processor<QP_DERIVED>::load_firewall_sqli_fingerprints(SQLite3_result
 	}
 }
 
-template <typename QP_DERIVED>
-void Query_Processor<QP_DERIVED>::load_firewall_users(SQLite3_result *resultset) {
-	unsigned long long tot_size = 0;
-	std::unordered_map<std::string, int>::iterator it;
-	for (it = global_firewall_whitelist_users.begin() ; it != global_firewall_whitelist_users.end(); ++it) {
-		it->second = WUS_NOT_FOUND;
-	}
-	// perform the inserts/updates
-	for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-		SQLite3_row *r=*it;
-		int active = atoi(r->fields[0]);
-		if (active == 0) {
-			continue;
-		}
-		char * username = r->fields[1];
-		char * client_address = r->fields[2];
-		char * mode = r->fields[3];
-		string s = username;
-		s += rand_del;
-		s += client_address;
-		std::unordered_map<std::string, int>:: iterator it2;
-		it2 = global_firewall_whitelist_users.find(s);
-		if (it2 != global_firewall_whitelist_users.end()) {
-			if (strcmp(mode,(char *)"DETECTING")==0) {
-				it2->second = WUS_DETECTING;
-			} else if (strcmp(mode,(char *)"PROTECTING")==0) {
-				it2->second = WUS_PROTECTING;
-			} else if (strcmp(mode,(char *)"OFF")==0) {
-				it2->second = WUS_OFF;
-			}
-		} else {
-			//whitelist_user_setting *wus = (whitelist_user_setting *)malloc(sizeof(whitelist_user_setting));
-			int m = WUS_OFF;
-			if (strcmp(mode,(char *)"DETECTING")==0) {
-				m = WUS_DETECTING;
-			} else if (strcmp(mode,(char *)"PROTECTING")==0) {
-				m = WUS_PROTECTING;
-			}
-			//wus->myptrarray = new PtrArray();
-			global_firewall_whitelist_users[s] = m;
-		}
-	}
-	// cleanup
-	it = global_firewall_whitelist_users.begin();
-	while (it != global_firewall_whitelist_users.end()) {
-		int m = it->second;
-		if (m != WUS_NOT_FOUND) {
-			tot_size += it->first.capacity();
-			tot_size += sizeof(m);
-			it++;
-		} else {
-			// remove the entry
-			it = global_firewall_whitelist_users.erase(it);
-		}
-	}
-	global_firewall_whitelist_users_map___size = tot_size;
-}
-
-template <typename QP_DERIVED>
-void Query_Processor<QP_DERIVED>::load_firewall_rules(SQLite3_result *resultset) {
-	unsigned long long tot_size = 0;
-	global_firewall_whitelist_rules_map___size = 0;
-	//size_t rand_del_size = strlen(rand_del);
-	int num_rows = resultset->rows_count;
-	std::unordered_map<std::string, void *>::iterator it;
-	if (num_rows == 0) {
-		// we must clean it completely
-		for (it = global_firewall_whitelist_rules.begin() ; it != global_firewall_whitelist_rules.end(); ++it) {
-			PtrArray * myptrarray = (PtrArray *)it->second;
-			delete myptrarray;
-		}
-		global_firewall_whitelist_rules.clear();
-		return;
-	}
-	// remove all the pointer array
-	for (it = global_firewall_whitelist_rules.begin() ; it != global_firewall_whitelist_rules.end(); ++it) {
-		PtrArray * myptrarray = (PtrArray *)it->second;
-		myptrarray->reset();
-	}
-	// perform the inserts
-	for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-		SQLite3_row *r=*it;
-		int active = atoi(r->fields[0]);
-		if (active == 0) {
-			continue;
-		}
-		char * username = r->fields[1];
-		char * client_address = r->fields[2];
-		char * schemaname = r->fields[3];
-		char * flagIN = r->fields[4];
-		char * digest_hex = r->fields[5];
-		unsigned long long digest_num = strtoull(digest_hex,NULL,0);
-		string s = username;
-		s += rand_del;
-		s += client_address;
-		s += rand_del;
-		s += schemaname;
-		s += rand_del;
-		s += flagIN;
-		std::unordered_map<std::string, void *>:: iterator it2;
-		it2 = global_firewall_whitelist_rules.find(s);
-		if (it2 != global_firewall_whitelist_rules.end()) {
-			PtrArray * myptrarray = (PtrArray *)it2->second;
-			myptrarray->add((void *)digest_num);
-		} else {
-			PtrArray * myptrarray = new PtrArray();
-			myptrarray->add((void *)digest_num);
-			global_firewall_whitelist_rules[s] = (void *)myptrarray;
-		}
-	}
-	// perform ordering and cleanup
-	it = global_firewall_whitelist_rules.begin();
-	while (it != global_firewall_whitelist_rules.end()) {
-		PtrArray * myptrarray = (PtrArray *)it->second;
-		if (myptrarray->len) {
-			// there are digests, sort them
-			qsort(myptrarray->pdata, myptrarray->len, sizeof(unsigned long long), int_cmp);
-			tot_size += it->first.capacity();
-			unsigned long long a = (myptrarray->size * sizeof(void *));
-			tot_size += a;
-			it++;
-		} else {
-			// remove the entry
-			delete myptrarray;
-			it = global_firewall_whitelist_rules.erase(it);
-		}
-	}
-	unsigned long long nsize = global_firewall_whitelist_rules.size();
-	unsigned long long oh = sizeof(std::string) + sizeof(PtrArray) + sizeof(PtrArray *);
-	nsize *= oh;
-	tot_size += nsize;
-	global_firewall_whitelist_rules_map___size = tot_size;
-}
-
 template <typename QP_DERIVED>
 void Query_Processor<QP_DERIVED>::save_query_rules(SQLite3_result *resultset) {
 	delete query_rules_resultset;
@@ -2240,26 +2238,15 @@ SQLite3_result* Query_Processor<QP_DERIVED>::load_fast_routing(const fast_routin
 	SQLite3_result* _rules_resultset = fast_routing_hashmap.rules_resultset;
 
 	if (_rules_fast_routing && _rules_resultset) {
-		unsigned int nt = 0;
-		if constexpr (std::is_same_v<QP_DERIVED,MySQL_Query_Processor>) {
-			nt = GloMTH->num_threads;
-		} else if constexpr (std::is_same_v<QP_DERIVED,PgSQL_Query_Processor>) {
-			nt = GloPTH->num_threads;
-		}
 		// Replace map structures, assumed to be previously reset
 		this->rules_fast_routing___keys_values = fast_routing_hashmap.rules_fast_routing___keys_values;
 		this->rules_fast_routing___keys_values___size = fast_routing_hashmap.rules_fast_routing___keys_values___size;
 		this->rules_fast_routing = _rules_fast_routing;
 		// Update global memory stats
 		rules_mem_used += rules_fast_routing___keys_values___size; // global
-		if (this->query_rules_fast_routing_algorithm == 1) {
-			rules_mem_used += rules_fast_routing___keys_values___size * nt; // per-thread
-		}
 		khint_t map_size = kh_size(_rules_fast_routing);
 		rules_mem_used += map_size * ((sizeof(int) + sizeof(char *) + 4 )); // not sure about memory overhead
-		if (this->query_rules_fast_routing_algorithm == 1) {
-			rules_mem_used += map_size * ((sizeof(int) + sizeof(char *) + 4 )) * nt; // not sure about memory overhead
-		}
+		// with 'query_rules_fast_routing_algorithm=1' the table shared by the threads is accounted by commit()
 	}
 
 	// Backup current resultset for later freeing
@@ -2350,10 +2337,16 @@ void Query_Processor<QP_DERIVED>::load_firewall(SQLite3_result *u, SQLite3_resul
 		global_firewall_whitelist_sqli_fingerprints_runtime = NULL;
 	}
 	global_firewall_whitelist_sqli_fingerprints_runtime = sf;
-	load_firewall_users(global_firewall_whitelist_users_runtime);
-	load_firewall_rules(global_firewall_whitelist_rules_runtime);
+	QP_firewall_whitelist* prev_firewall_whitelist = firewall_whitelist;
+	firewall_whitelist = new QP_firewall_whitelist(global_firewall_whitelist_users_runtime, global_firewall_whitelist_rules_runtime);
+	firewall_whitelist->version = __sync_add_and_fetch(&firewall_whitelist_version, 1);
+	global_firewall_whitelist_users_map___size = firewall_whitelist->get_users_memory_usage();
+	global_firewall_whitelist_rules_map___size = firewall_whitelist->get_rules_memory_usage();
 	load_firewall_sqli_fingerprints(global_firewall_whitelist_sqli_fingerprints_runtime);
 	pthread_mutex_unlock(&global_firewall_whitelist_mutex);
+	// sessions still referencing the previous whitelist release it when they resolve the new one, or when
+	// their thread drops the stale caches, see 'Base_Thread::release_stale_firewall_caches()'
+	prev_firewall_whitelist->release();
 	return;
 }
 
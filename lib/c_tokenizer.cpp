@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "c_tokenizer.h"
 
 extern __thread int  mysql_thread___query_digests_max_query_length;
@@ -133,6 +136,170 @@ static inline char is_hex_char(char c)
 	return 0;
 }
 
+// Vectorized pre-scan helpers
+// ===========================
+//
+// 'stage_1_parsing' consumes the query one char at a time. Inside runs of spaces, digits and string
+// literals bodies each char only updates the processing position, so these runs can be found 16/32 bytes
+// at a time and skipped in one step. Each helper returns the length of the run at the beginning of 's',
+// never reading past 's + len'. The implementation is selected at runtime based on the CPU features.
+
+static int span_space_scalar(const char* s, int len) {
+	int i = 0;
+	while (i < len && is_space_char(s[i])) { i++; }
+	return i;
+}
+
+static int span_digit_scalar(const char* s, int len) {
+	int i = 0;
+	while (i < len && is_digit_char(s[i])) { i++; }
+	return i;
+}
+
+static int span_not_2_scalar(const char* s, int len, char c1, char c2) {
+	int i = 0;
+	while (i < len && s[i] != c1 && s[i] != c2) { i++; }
+	return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SSE42_SPAN_MODE(m) (_SIDD_UBYTE_OPS | (m) | _SIDD_LEAST_SIGNIFICANT)
+
+__attribute__((target("sse4.2")))
+static int span_space_sse42(const char* s, int len) {
+	const __m128i set = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	int i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+		int idx = _mm_cmpestri(set, 4, v, 16, SSE42_SPAN_MODE(_SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY));
+		if (idx != 16) { return i + idx; }
+	}
+	return i + span_space_scalar(s + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+static int span_digit_sse42(const char* s, int len) {
+	const __m128i range = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	int i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+		int idx = _mm_cmpestri(range, 2, v, 16, SSE42_SPAN_MODE(_SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY));
+		if (idx != 16) { return i + idx; }
+	}
+	return i + span_digit_scalar(s + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+static int span_not_2_sse42(const char* s, int len, char c1, char c2) {
+	const __m128i set = _mm_setr_epi8(c1, c2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	int i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+		int idx = _mm_cmpestri(set, 2, v, 16, SSE42_SPAN_MODE(_SIDD_CMP_EQUAL_ANY));
+		if (idx != 16) { return i + idx; }
+	}
+	return i + span_not_2_scalar(s + i, len - i, c1, c2);
+}
+
+__attribute__((target("avx2")))
+static int span_space_avx2(const char* s, int len) {
+	int i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')))
+		);
+		unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+		if (mask) { return i + __builtin_ctz(mask); }
+	}
+	return i + span_space_scalar(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static int span_digit_avx2(const char* s, int len) {
+	int i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+		// '0'..'9' become -128..-119 after the offset, the only values lower than -118
+		__m256i off = _mm256_sub_epi8(v, _mm256_set1_epi8('0' + 128));
+		__m256i m = _mm256_cmpgt_epi8(_mm256_set1_epi8(-118), off);
+		unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+		if (mask) { return i + __builtin_ctz(mask); }
+	}
+	return i + span_digit_scalar(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static int span_not_2_avx2(const char* s, int len, char c1, char c2) {
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	int i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, v1), _mm256_cmpeq_epi8(v, v2));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+		if (mask) { return i + __builtin_ctz(mask); }
+	}
+	return i + span_not_2_scalar(s + i, len - i, c1, c2);
+}
+#endif /* __x86_64__ || __i386__ */
+
+typedef struct span_fns_t {
+	int (*span_space)(const char*, int);
+	int (*span_digit)(const char*, int);
+	int (*span_not_2)(const char*, int, char, char);
+} span_fns_t;
+
+static span_fns_t span_fns = { span_space_scalar, span_digit_scalar, span_not_2_scalar };
+
+static int get_max_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return TOKENIZER_SIMD_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2")) {
+		return TOKENIZER_SIMD_SSE42;
+	}
+#endif /* __x86_64__ || __i386__ */
+	return TOKENIZER_SIMD_NONE;
+}
+
+int query_digest_set_simd_level(int level) {
+	const int max_level = get_max_simd_level();
+	if (level < 0 || level > max_level) {
+		level = max_level;
+	}
+	span_fns = { span_space_scalar, span_digit_scalar, span_not_2_scalar };
+#if defined(__x86_64__) || defined(__i386__)
+	if (level == TOKENIZER_SIMD_SSE42) {
+		span_fns = { span_space_sse42, span_digit_sse42, span_not_2_sse42 };
+	} else if (level == TOKENIZER_SIMD_AVX2) {
+		span_fns = { span_space_avx2, span_digit_avx2, span_not_2_avx2 };
+	}
+#endif /* __x86_64__ || __i386__ */
+	return level;
+}
+
+// best available implementation, selected once at startup
+static const int simd_level_init __attribute__((unused)) = query_digest_set_simd_level(-1);
+
+// runs shorter than a vector are more common in regular queries, for those the scalar loop is cheaper
+#define SPAN_SIMD_MIN_LEN 16
+
+static inline int span_space(const char* s, int len) {
+	return len < SPAN_SIMD_MIN_LEN ? span_space_scalar(s, len) : span_fns.span_space(s, len);
+}
+
+static inline int span_digit(const char* s, int len) {
+	return len < SPAN_SIMD_MIN_LEN ? span_digit_scalar(s, len) : span_fns.span_digit(s, len);
+}
+
+static inline int span_not_2(const char* s, int len, char c1, char c2) {
+	return len < SPAN_SIMD_MIN_LEN ? span_not_2_scalar(s, len, c1, c2) : span_fns.span_not_2(s, len, c1, c2);
+}
+
 // between pointer, check string is number - need to be changed more functions
 // TODO: f-1 shouldn't be access if 'f' is the first position supplied, could lead to
 // buffer overflow. NOTE: This is now addressed by 'is_digit_string_2'.
@@ -1239,8 +1406,9 @@ void stage_1_parsing(shared_st* shared_st, stage_1_st* stage_1_st, const options
 
 				// ignore all the leading spaces
 				if (shared_st->res_cur_pos == shared_st->res_init_pos && is_space_char(*shared_st->q)) {
-					shared_st->q++;
-					shared_st->q_cur_pos++;
+					const int n = span_space(shared_st->q, shared_st->q_len - shared_st->q_cur_pos);
+					shared_st->q += n;
+					shared_st->q_cur_pos += n;
 					continue;
 				}
 
@@ -1264,8 +1432,16 @@ void stage_1_parsing(shared_st* shared_st, stage_1_st* stage_1_st, const options
 					shared_st->prev_char = ' ';
 					*shared_st->res_cur_pos = ' ';
 
-					shared_st->q++;
-					shared_st->q_cur_pos++;
+					// once a space precedes the current position the rest of the run only rewrites it, so it
+					// can be skipped at once, unless the loop would stop first
+					if (shared_st->res_cur_pos <= res_final_pos && is_space_char(*(shared_st->res_cur_pos-1))) {
+						const int n = span_space(shared_st->q, shared_st->q_len - shared_st->q_cur_pos);
+						shared_st->q += n;
+						shared_st->q_cur_pos += n;
+					} else {
+						shared_st->q++;
+						shared_st->q_cur_pos++;
+					}
 					continue;
 				}
 
@@ -1296,6 +1472,21 @@ void stage_1_parsing(shared_st* shared_st, stage_1_st* stage_1_st, const options
 					continue;
 				}
 			} else if (cur_st == st_literal_string) {
+				// skip the chars that can't either escape or close the literal; they are only consumed
+				if (literal_str_st->delim_num == 1) {
+					const int n = span_not_2(
+						shared_st->q, shared_st->q_len - shared_st->q_cur_pos, '\\', literal_str_st->delim_char
+					);
+					if (n > 0) {
+						if (shared_st->keep_prev_char == false || n > 1) {
+							shared_st->prev_char = *(shared_st->q + n - 1);
+						}
+						shared_st->keep_prev_char = false;
+						shared_st->q += n;
+						shared_st->q_cur_pos += n;
+						continue;
+					}
+				}
 				// NOTE: Not required to copy since spaces are not going to be processed here
 				shared_st->copy_next_char = 0;
 				cur_st = process_literal_string(shared_st, literal_str_st);
@@ -1304,6 +1495,23 @@ void stage_1_parsing(shared_st* shared_st, stage_1_st* stage_1_st, const options
 					continue;
 				}
 			} else if (cur_st == st_literal_number) {
+				// digits following the first one are just copied; the last char of the query and the end of
+				// the result buffer are left to 'process_literal_digit'
+				if (literal_digit_st->first_digit == 0 && shared_st->keep_prev_char == false) {
+					int max_len = shared_st->q_len - shared_st->q_cur_pos - 1;
+					if (max_len > res_final_pos - shared_st->res_cur_pos + 1) {
+						max_len = res_final_pos - shared_st->res_cur_pos + 1;
+					}
+					const int n = max_len > 0 ? span_digit(shared_st->q, max_len) : 0;
+					if (n > 0) {
+						memcpy(shared_st->res_cur_pos, shared_st->q, n);
+						shared_st->res_cur_pos += n;
+						shared_st->prev_char = *(shared_st->q + n - 1);
+						shared_st->q += n;
+						shared_st->q_cur_pos += n;
+						continue;
+					}
+				}
 				shared_st->copy_next_char = 1;
 				cur_st = process_literal_digit(shared_st, literal_digit_st, opts);
 				if (cur_st == st_no_mark_found) {
@@ -1,6 +1,10 @@
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 #include "gen_utils.h"
 
 
@@ -308,3 +312,41 @@ char* escape_string_single_quotes_and_backslashes(char* input, bool free_it) {
 	}
 	return output;
 }
+
+bool ticks_use_tsc = false;
+double ticks_ns_per_tick = 1.0;
+static unsigned long long ticks_overhead = 0;
+
+void ticks_calibrate() {
+	static std::once_flag calibrated;
+	std::call_once(calibrated, []() {
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+		// CPUID.80000007H:EDX[8]: invariant TSC, constant rate regardless of the P/C/T states of the cores
+		if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8))) {
+			struct timespec ts0, ts1;
+			clock_gettime(CLOCK_MONOTONIC, &ts0);
+			const unsigned long long tsc0 = __builtin_ia32_rdtsc();
+			usleep(2000);
+			clock_gettime(CLOCK_MONOTONIC, &ts1);
+			const unsigned long long tsc1 = __builtin_ia32_rdtsc();
+			const double ns = (ts1.tv_sec - ts0.tv_sec) * 1000000000.0 + (ts1.tv_nsec - ts0.tv_nsec);
+			if (tsc1 > tsc0 && ns > 0) {
+				ticks_ns_per_tick = ns / (tsc1 - tsc0);
+				ticks_use_tsc = true;
+			}
+		}
+#endif
+		const int loops = 1000;
+		unsigned long long last = 0;
+		const unsigned long long begin = ticks_time();
+		for (int i = 0; i < loops; i++) {
+			last = ticks_time();
+		}
+		ticks_overhead = ticks_to_ns(last - begin) / loops;
+	});
+}
+
+unsigned long long ticks_overhead_ns() {
+	return ticks_overhead;
+}
@@ -436,6 +436,7 @@ MySQL_Connection::MySQL_Connection() {
 	fd=-1;
 	status_flags=0;
 	last_time_used=0;
+	backend_query_start=0;
 
 	for (auto i = 0; i < SQL_NAME_LAST_HIGH_WM; i++) {
 		variables[i].value = NULL;
@@ -496,6 +497,8 @@ MySQL_Connection::~MySQL_Connection() {
 	if (local_stmts) {
 		delete local_stmts;
 	}
+	// the connection can be destroyed while a query is running (e.g. on timeout)
+	backend_query_ended();
 	if (mysql) {
 		// always decrease the counter
 		if (ret_mysql) {
@@ -2102,6 +2105,33 @@ bool MySQL_Connection::IsServerOffline() {
 	return ret;
 }
 
+void MySQL_Connection::backend_query_started() {
+	if (backend_query_start) {
+		// a retried query is already accounted, since its first attempt
+		return;
+	}
+	if (parent && parent->myhgc && parent->myhgc->get_load_balancing_algorithm() == 1) {
+		__sync_fetch_and_add(&parent->queries_in_flight,1);
+		backend_query_start = monotonic_time();
+	}
+}
+
+void MySQL_Connection::backend_query_ended() {
+	if (backend_query_start == 0) {
+		return;
+	}
+	unsigned long long t = monotonic_time() - backend_query_start;
+	backend_query_start = 0;
+	__sync_fetch_and_sub(&parent->queries_in_flight,1);
+	if (t > UINT_MAX) {
+		t = UINT_MAX;
+	}
+	// exponentially weighted moving average with alpha=1/8.
+	// It is updated without locking: losing an update from a concurrent thread is not relevant
+	unsigned int ewma = parent->query_latency_ewma_us;
+	parent->query_latency_ewma_us = (ewma == 0 ? t : ewma - (ewma >> 3) + (t >> 3));
+}
+
 /**
  * @brief Asynchronously execute a query on the MySQL connection.
  *
@@ -2160,6 +2190,7 @@ int MySQL_Connection::async_query(short event, char *stmt, unsigned long length,
 			}
 			if (stmt_meta==NULL)
 				set_query(stmt,length);
+			backend_query_started();
 			async_state_machine=ASYNC_QUERY_START;
 			if (_stmt) {
 				query.stmt=*_stmt;
@@ -2181,6 +2212,7 @@ int MySQL_Connection::async_query(short event, char *stmt, unsigned long length,
 	// That means after hander() was executed.
 	if (async_state_machine==ASYNC_QUERY_END) {
 		PROXY_TRACE2();
+		backend_query_ended();
 		compute_unknown_transaction_status();
 		if (mysql_errno(mysql)) {
 			return -1;
@@ -2190,6 +2222,7 @@ int MySQL_Connection::async_query(short event, char *stmt, unsigned long length,
 	}
 	if (async_state_machine==ASYNC_STMT_EXECUTE_END) {
 		PROXY_TRACE2();
+		backend_query_ended();
 		query.stmt_meta=NULL;
 		async_state_machine=ASYNC_QUERY_END;
 		compute_unknown_transaction_status();
@@ -2200,6 +2233,7 @@ int MySQL_Connection::async_query(short event, char *stmt, unsigned long length,
 		}
 	}
 	if (async_state_machine==ASYNC_STMT_PREPARE_SUCCESSFUL || async_state_machine==ASYNC_STMT_PREPARE_FAILED) {
+		backend_query_ended();
 		query.stmt_meta=NULL;
 		compute_unknown_transaction_status();
 		if (async_state_machine==ASYNC_STMT_PREPARE_FAILED) {
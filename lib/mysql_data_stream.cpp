@@ -249,6 +249,7 @@ MySQL_Data_Stream::MySQL_Data_Stream() {
 	resultset=NULL;
 	queue_init(queueIN,QUEUE_T_DEFAULT_SIZE);
 	queue_init(queueOUT,QUEUE_T_DEFAULT_SIZE);
+	writev_partial=0;
 	mybe=NULL;
 	active=1;
 	mypolls=NULL;
@@ -633,6 +634,78 @@ int MySQL_Data_Stream::read_from_net() {
 	return r;
 }
 
+/**
+ * @brief Returns whether the packets in 'PSarrayOUT' are written by 'write_to_net_writev()', instead of being
+ *   copied into 'queueOUT' by 'array2buffer()'.
+ * @details Only plain connections are eligible: TLS and compression need the whole payload in a buffer. The
+ *   path is entered only with an empty 'queueOUT', and left only after the first packet is completely sent.
+ */
+bool MySQL_Data_Stream::writev_enabled() {
+	if (writev_partial) return true; // the first packet must be completed through the same path
+	if (mysql_thread___use_writev == false) return false;
+	if (encrypted || sess == NULL || sess->session_type != PROXYSQL_SESSION_MYSQL || sess->mirror) return false;
+	// 'array2buffer()' changes 'DSS' and enables compression once these packets are queued
+	if (DSS == STATE_CLIENT_AUTH_OK) return false;
+	if (myconn == NULL || myconn->get_status(STATUS_MYSQL_CONNECTION_COMPRESSION)) return false;
+	return queue_data(queueOUT) == 0 && queueOUT.partial == 0;
+}
+
+/**
+ * @brief Writes the packets in 'PSarrayOUT' with a single 'sendmsg()', building the iovec directly from them.
+ * @details Up to 'MYDS_WRITEV_MAX_IOV' packets and about 'MYDS_WRITEV_MAX_BYTES' bytes are written per call.
+ *   Completely sent packets are removed from 'PSarrayOUT', while the bytes sent of a partially written one are
+ *   tracked in 'writev_partial'.
+ * @return The result of 'sendmsg()'.
+ */
+int MySQL_Data_Stream::write_to_net_writev() {
+	struct iovec iov[MYDS_WRITEV_MAX_IOV];
+	int iovcnt = 0;
+	size_t total = 0;
+	for (unsigned int i = 0; i < PSarrayOUT->len && iovcnt < MYDS_WRITEV_MAX_IOV && total < MYDS_WRITEV_MAX_BYTES; i++) {
+		PtrSize_t *pkt = PSarrayOUT->index(i);
+		const unsigned int offset = (i == 0 ? writev_partial : 0);
+		iov[iovcnt].iov_base = (unsigned char *)pkt->ptr + offset;
+		iov[iovcnt].iov_len = pkt->size - offset;
+		total += iov[iovcnt].iov_len;
+		iovcnt++;
+	}
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+#ifdef __APPLE__
+	int bytes_io = sendmsg(fd, &msg, 0);
+#else
+	int bytes_io = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#endif
+	proxy_debug(PROXY_DEBUG_NET, 7, "Session=%p, Datastream=%p: sendmsg() wrote %d bytes of %lu in FD %d\n", sess, this, bytes_io, total, fd);
+	if (bytes_io <= 0) {
+		return bytes_io;
+	}
+	size_t left = bytes_io;
+	unsigned int sent = 0;
+	while (left) {
+		PtrSize_t *pkt = PSarrayOUT->index(sent);
+		const size_t pkt_left = pkt->size - writev_partial;
+		if (left < pkt_left) {
+			writev_partial += left;
+			break;
+		}
+		left -= pkt_left;
+		writev_partial = 0;
+		add_to_data_packet_history_without_alloc(data_packets_history_OUT,pkt->ptr,pkt->size);
+		sent++;
+	}
+	if (sent) {
+		PSarrayOUT->remove_index_range(0,sent);
+		pkts_sent += sent;
+	}
+	if (sess && sess->thread) {
+		sess->thread->status_variables.stvar[st_var_writev_bytes_sent] += bytes_io;
+	}
+	return bytes_io;
+}
+
 int MySQL_Data_Stream::write_to_net() {
     int bytes_io=0;
 	int s = queue_data(queueOUT);
@@ -640,7 +713,8 @@ int MySQL_Data_Stream::write_to_net() {
 	if (encrypted) {
 		//proxy_info("Data in write buffer: %d bytes\n", s);
 	}
-	if (s==0) {
+	const bool use_writev = (s == 0 && PSarrayOUT->len && writev_enabled());
+	if (s==0 && use_writev == false) {
 		if (encrypted == false) {
 			return 0;
 		}
@@ -705,6 +779,8 @@ int MySQL_Data_Stream::write_to_net() {
 				}
 			}
 		}
+	} else if (use_writev) {
+		bytes_io = write_to_net_writev();
 	} else {
 #ifdef __APPLE__
 		bytes_io = send(fd, queue_r_ptr(queueOUT), s, 0);
@@ -728,7 +804,9 @@ int MySQL_Data_Stream::write_to_net() {
 			if (ssl_ret!=SSL_ERROR_WANT_READ && ssl_ret!=SSL_ERROR_WANT_WRITE) shut_soft();
 		}
 	} else {
-		queue_r(queueOUT, bytes_io);
+		if (use_writev == false) {
+			queue_r(queueOUT, bytes_io);
+		}
 		if (mypolls) mypolls->last_sent[poll_fds_idx]=sess->thread->curtime;
 		bytes_info.bytes_sent+=bytes_io;
 	}
@@ -863,7 +941,7 @@ int MySQL_Data_Stream::write_to_net_poll() {
 	}
 	proxy_debug(PROXY_DEBUG_NET,1,"Session=%p, DataStream=%p --\n", sess, this);
 	bool call_write_to_net = false;
-	if (queue_data(queueOUT)) {
+	if (queue_data(queueOUT) || (PSarrayOUT->len && writev_enabled())) {
 		call_write_to_net = true;
 	}
 	if (call_write_to_net == false) {
@@ -898,6 +976,41 @@ int MySQL_Data_Stream::read_pkts() {
 	return rc;
 }
 
+/**
+ * @brief Checks if a PROXY header from this client can be accepted, according to
+ *   'mysql-proxy_protocol_networks'. A warning is logged if not.
+ */
+bool MySQL_Data_Stream::proxy_protocol_accepted() {
+	bool accept_proxy = false; // by default, we do not accept a PROXY header
+	if (strcmp(mysql_thread___proxy_protocol_networks,"*") == 0) { // all networks are accepted
+		accept_proxy = true;
+	} else if (client_addr && sess && sess->thread) {
+		// the networks are compiled by the thread when the variable changes
+		accept_proxy = sess->thread->proxy_protocol_networks.match(client_addr);
+	}
+	if (accept_proxy == false && addr.addr) {
+		proxy_warning("Skipping PROXY header from IP %s because not matching mysql-proxy_protocol_networks. Skipping PROXY header\n", addr.addr);
+	}
+	return accept_proxy;
+}
+
+/**
+ * @brief Replaces the address of the client with the source address of a parsed PROXY header, keeping the
+ *   original one as 'proxy_address'.
+ */
+void MySQL_Data_Stream::apply_proxy_protocol_info(const ProxyProtocolInfo& ppi) {
+	PROXY_info = new ProxyProtocolInfo(ppi);
+	// we take a copy of old address/port
+	if (addr.addr) {
+		strncpy(PROXY_info->proxy_address, addr.addr, INET6_ADDRSTRLEN);
+		free(addr.addr);
+	}
+	PROXY_info->proxy_port = addr.port;
+	// we override old address/port
+	addr.addr = strdup(PROXY_info->source_address);
+	addr.port = PROXY_info->source_port;
+}
+
 int MySQL_Data_Stream::buffer2array() {
 	int ret=0;
 	bool fast_mode=sess->session_fast_forward;
@@ -978,6 +1091,45 @@ int MySQL_Data_Stream::buffer2array() {
 	} else {
 
 		if ((queueIN.pkt.size==0) && queue_data(queueIN)>=sizeof(mysql_hdr)) {
+			// check if this is a binary PROXY protocol header (v2)
+			if (
+				pkts_recv==0 &&
+				queueIN.tail == 0 &&
+				queueIN.head >= PROXY_PROTOCOL_V2_HDR_LEN &&
+				memcmp(queueIN.buffer, PROXY_PROTOCOL_V2_SIG, PROXY_PROTOCOL_V2_SIG_LEN) == 0
+			) {
+				const size_t b = ProxyProtocolInfo::getProxyProtocolV2HeaderLength((const unsigned char *)queueIN.buffer, queueIN.head);
+				if (b > queueIN.size) {
+					// the header can't fit in the buffer, set the connection unhealthy
+					if (sess) {
+						sess->set_unhealthy();
+					}
+					return 0;
+				}
+				if (queueIN.head < b) {
+					return 0; // wait for the rest of the header
+				}
+				queue_r(queueIN, b);
+
+				ProxyProtocolInfo ppi;
+				if (proxy_protocol_accepted() == true) {
+					if (ppi.parseProxyProtocolV2Header((const unsigned char *)queueIN.buffer, b)) {
+						// a LOCAL command carries no address, the connection keeps its own
+						if (ppi.source_address[0] != '\0') {
+							apply_proxy_protocol_info(ppi);
+						}
+					} else {
+						if (addr.addr) {
+							proxy_warning("Unable to parse PROXY v2 header from IP %s . Skipping PROXY header\n", addr.addr);
+						}
+					}
+				}
+
+				pkts_recv++;
+				queueIN.pkt.size=0;
+				queueIN.pkt.ptr=NULL;
+				return b;
+			}
 			// check if this is a PROXY protocol packet
 			if (
 				pkts_recv==0 && // checks if no packets have been received yet
@@ -1015,40 +1167,15 @@ int MySQL_Data_Stream::buffer2array() {
 					// note that parseProxyProtocolHeader() will read from the beginning of the buffer
 					queue_r(queueIN, b);
 
-					bool accept_proxy = false; // by default, we do not accept a PROXY header
-					const char * proxy_protocol_networks = mysql_thread___proxy_protocol_networks;
-
 					ProxyProtocolInfo ppi;
-					if (strcmp(proxy_protocol_networks,"*") == 0) { // all networks are accepted
-						accept_proxy = true;
-					} else {
-						if (client_addr) {
-							if (ppi.is_client_in_any_subnet(client_addr, proxy_protocol_networks) == true) {
-								accept_proxy = true;
-							}
-						}
-					}
-					if (accept_proxy == true) {
+					if (proxy_protocol_accepted() == true) {
 						if (ppi.parseProxyProtocolHeader((const char *)queueIN.buffer, b)) {
-							PROXY_info = new ProxyProtocolInfo(ppi);
-							// we take a copy of old address/port
-							if (addr.addr) {
-								strncpy(PROXY_info->proxy_address, addr.addr, INET6_ADDRSTRLEN);
-								free(addr.addr);
-							}
-							PROXY_info->proxy_port = addr.port;
-							// we override old address/port
-							addr.addr = strdup(PROXY_info->source_address);
-							addr.port = PROXY_info->source_port;
+							apply_proxy_protocol_info(ppi);
 						} else {
 							if (addr.addr) {
 								proxy_warning("Unable to parse PROXY header from IP %s . Skipping PROXY header\n", addr.addr);
 							}
 						}
-					} else { // the PROXY header was not accepted
-						if (addr.addr) {
-							proxy_warning("Skipping PROXY header from IP %s because not matching mysql-proxy_protocol_networks. Skipping PROXY header\n", addr.addr);
-						}
 					}
 
 
@@ -1304,6 +1431,9 @@ int MySQL_Data_Stream::array2buffer() {
 			goto __exit_array2buffer;
 		}
 	}
+	if (writev_enabled()) { // packets are sent directly from 'PSarrayOUT' by 'write_to_net_writev()'
+		goto __exit_array2buffer;
+	}
 	while (cont) {
 		//VALGRIND_DISABLE_ERROR_REPORTING;
 		if (queue_available(queueOUT)==0) {
@@ -1363,6 +1493,9 @@ int MySQL_Data_Stream::array2buffer() {
 		//VALGRIND_ENABLE_ERROR_REPORTING;
 		queue_w(queueOUT,b);
 		proxy_debug(PROXY_DEBUG_PKT_ARRAY, 5, "Session=%p . DataStream: %p -- Copied %d bytes into send buffer\n", sess, this, b);
+		if (sess && sess->thread) {
+			sess->thread->status_variables.stvar[st_var_send_buffer_copied_bytes] += b;
+		}
 		queueOUT.partial+=b;
 		ret=b;
 		if (queueOUT.partial==queueOUT.pkt.size) {
@@ -1577,12 +1710,13 @@ void MySQL_Data_Stream::get_client_myds_info_json(json& j) {
 	jc1["proxy_addr"]["address"] = ( proxy_addr.addr ? proxy_addr.addr : "" );
 	jc1["proxy_addr"]["port"] = proxy_addr.port;
 	if (PROXY_info != NULL) {
-		jc1["PROXY_V1"]["source_address"] = PROXY_info->source_address;
-		jc1["PROXY_V1"]["destination_address"] = PROXY_info->destination_address;
-		jc1["PROXY_V1"]["proxy_address"] = PROXY_info->proxy_address;
-		jc1["PROXY_V1"]["source_port"] = PROXY_info->source_port;
-		jc1["PROXY_V1"]["destination_port"] = PROXY_info->destination_port;
-		jc1["PROXY_V1"]["proxy_port"] = PROXY_info->proxy_port;
+		const char* proxy_key = PROXY_info->version == 2 ? "PROXY_V2" : "PROXY_V1";
+		jc1[proxy_key]["source_address"] = PROXY_info->source_address;
+		jc1[proxy_key]["destination_address"] = PROXY_info->destination_address;
+		jc1[proxy_key]["proxy_address"] = PROXY_info->proxy_address;
+		jc1[proxy_key]["source_port"] = PROXY_info->source_port;
+		jc1[proxy_key]["destination_port"] = PROXY_info->destination_port;
+		jc1[proxy_key]["proxy_port"] = PROXY_info->proxy_port;
 	}
 	jc1["encrypted"] = encrypted;
 	if (encrypted) {
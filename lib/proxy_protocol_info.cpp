@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
 
 static bool DEBUG_ProxyProtocolInfo = false;
 
@@ -43,6 +44,7 @@ bool ProxyProtocolInfo::parseProxyProtocolHeader(const char* packet, size_t pack
 
 		// Check if sscanf successfully parsed all fields
 		if (result == 4) {
+			version = 1;
 			return true; // Successful parsing
 		} else {
 			// Handle partial parsing or invalid format
@@ -53,6 +55,68 @@ bool ProxyProtocolInfo::parseProxyProtocolHeader(const char* packet, size_t pack
 	return false; // Invalid header format
 }
 
+size_t ProxyProtocolInfo::getProxyProtocolV2HeaderLength(const unsigned char* packet, size_t packet_length) {
+	if (packet_length < PROXY_PROTOCOL_V2_HDR_LEN || memcmp(packet, PROXY_PROTOCOL_V2_SIG, PROXY_PROTOCOL_V2_SIG_LEN) != 0) {
+		return 0;
+	}
+	const size_t addr_len = (packet[14] << 8) | packet[15];
+	return PROXY_PROTOCOL_V2_HDR_LEN + addr_len;
+}
+
+bool ProxyProtocolInfo::parseProxyProtocolV2Header(const unsigned char* packet, size_t packet_length) {
+	const size_t header_length = getProxyProtocolV2HeaderLength(packet, packet_length);
+	if (header_length == 0 || header_length > packet_length) {
+		return false; // Not a valid, or not a complete, PROXY protocol v2 header
+	}
+	const uint8_t ver_cmd = packet[12];
+	const uint8_t fam = packet[13];
+	const unsigned char* addr = packet + PROXY_PROTOCOL_V2_HDR_LEN;
+	const size_t addr_len = header_length - PROXY_PROTOCOL_V2_HDR_LEN;
+
+	if ((ver_cmd & 0xF0) != 0x20) {
+		return false; // Unsupported version
+	}
+	version = 2;
+	switch (ver_cmd & 0x0F) {
+		case 0x00: // LOCAL, the connection was established by the proxy itself
+			return true;
+		case 0x01: // PROXY
+			break;
+		default:
+			return false; // Unsupported command
+	}
+	// the address block is followed by optional TLVs, skipped
+	switch (fam) {
+		case 0x11: // TCP over IPv4
+			if (addr_len < 12) {
+				return false;
+			}
+			inet_ntop(AF_INET, addr, source_address, sizeof(source_address));
+			inet_ntop(AF_INET, addr + 4, destination_address, sizeof(destination_address));
+			source_port = (addr[8] << 8) | addr[9];
+			destination_port = (addr[10] << 8) | addr[11];
+			return true;
+		case 0x21: // TCP over IPv6
+			if (addr_len < 36) {
+				return false;
+			}
+			inet_ntop(AF_INET6, addr, source_address, sizeof(source_address));
+			inet_ntop(AF_INET6, addr + 16, destination_address, sizeof(destination_address));
+			source_port = (addr[32] << 8) | addr[33];
+			destination_port = (addr[34] << 8) | addr[35];
+			return true;
+		case 0x00: // UNSPEC
+		case 0x12: // UDP over IPv4
+		case 0x22: // UDP over IPv6
+		case 0x31: // UNIX stream
+		case 0x32: // UNIX datagram
+			// handled like LOCAL: no usable client address, the connection keeps its own
+			return true;
+		default:
+			return false; // Unsupported address family
+	}
+}
+
 /**
  * Checks if a client address is within a specified subnet.
  *
@@ -299,6 +363,77 @@ void ProxyProtocolInfo::run_tests() {
 		assert(is_valid_subnet_list(subnet_list3) == false);
 		assert(is_valid_subnet_list(subnet_list4) == false);
 	}
+	// the compiled networks match as 'is_client_in_any_subnet()'
+	{
+		const char* subnet_list = "10.0.0.0/8,192.168.1.0/24,192.168.0.0/24,172.16.14.1/32,2001:db8:0:1::/64,fe80::/10";
+		ProxyProtocol_Networks networks;
+		assert(networks.compile(subnet_list) == true);
+		const char* ipv4_addrs[] = { "10.1.2.3", "11.0.0.1", "192.168.0.255", "192.168.1.0", "192.168.2.1", "172.16.14.1", "172.16.14.2", "0.0.0.0" };
+		for (const char* ip : ipv4_addrs) {
+			sockaddr_in client_addr = create_ipv4_addr(ip);
+			assert(networks.match((sockaddr*)&client_addr) == is_client_in_any_subnet((sockaddr*)&client_addr, subnet_list));
+		}
+		const char* ipv6_addrs[] = { "2001:db8:0:1::1", "2001:db8:0:2::1", "fe80::1", "febf:ffff::1", "fec0::1", "::1" };
+		for (const char* ip : ipv6_addrs) {
+			sockaddr_in6 client_addr = create_ipv6_addr(ip);
+			assert(networks.match((sockaddr*)&client_addr) == is_client_in_any_subnet((sockaddr*)&client_addr, subnet_list));
+		}
+		assert(networks.compile("0.0.0.0/0") == true);
+		sockaddr_in client_v4 = create_ipv4_addr("255.255.255.255");
+		sockaddr_in6 client_v6 = create_ipv6_addr("2001:db8::1");
+		assert(networks.match((sockaddr*)&client_v4) == true);
+		assert(networks.match((sockaddr*)&client_v6) == false);
+		assert(networks.compile("*") == true);
+		assert(networks.match((sockaddr*)&client_v6) == true);
+		assert(networks.compile("") == true);
+		assert(networks.empty() == true);
+		assert(networks.compile("10.0.0.0/33,invalid") == false);
+		assert(networks.empty() == true);
+	}
+	// binary headers (v2)
+	{
+		const unsigned char hdr_v4[] = {
+			'\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x21, 0x11, 0, 12 + 7,
+			192, 168, 0, 1, 192, 168, 0, 11, 0xDC, 0x04, 0x01, 0xBB,
+			0x04, 0, 4, 'a', 'b', 'c', 'd' // NOOP TLV, skipped
+		};
+		ProxyProtocolInfo ppi;
+		assert(getProxyProtocolV2HeaderLength(hdr_v4, sizeof(hdr_v4)) == sizeof(hdr_v4));
+		assert(ppi.parseProxyProtocolV2Header(hdr_v4, sizeof(hdr_v4)) == true);
+		assert(strcmp(ppi.source_address, "192.168.0.1") == 0 && strcmp(ppi.destination_address, "192.168.0.11") == 0);
+		assert(ppi.source_port == 56324 && ppi.destination_port == 443 && ppi.version == 2);
+		assert(ppi.parseProxyProtocolV2Header(hdr_v4, sizeof(hdr_v4) - 1) == false);
+
+		unsigned char hdr_v6[PROXY_PROTOCOL_V2_HDR_LEN + 36] = {
+			'\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x21, 0x21, 0, 36
+		};
+		sockaddr_in6 src = create_ipv6_addr("fe80::d6ae:52ff:fecf:9876");
+		memcpy(hdr_v6 + PROXY_PROTOCOL_V2_HDR_LEN, src.sin6_addr.s6_addr, 16);
+		hdr_v6[PROXY_PROTOCOL_V2_HDR_LEN + 32] = 0xDC;
+		hdr_v6[PROXY_PROTOCOL_V2_HDR_LEN + 33] = 0x04;
+		ProxyProtocolInfo ppi6;
+		assert(ppi6.parseProxyProtocolV2Header(hdr_v6, sizeof(hdr_v6)) == true);
+		assert(strcmp(ppi6.source_address, "fe80::d6ae:52ff:fecf:9876") == 0 && ppi6.source_port == 56324);
+
+		const unsigned char hdr_local[] = { '\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x20, 0x00, 0, 0 };
+		ProxyProtocolInfo ppi_local;
+		assert(ppi_local.parseProxyProtocolV2Header(hdr_local, sizeof(hdr_local)) == true);
+		assert(ppi_local.source_address[0] == '\0');
+
+		// UNSPEC, UDP and UNIX families are accepted without an address
+		for (const unsigned char fam : { 0x00, 0x12, 0x22, 0x31, 0x32 }) {
+			const unsigned char hdr_noaddr[] = { '\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x21, fam, 0, 0 };
+			ProxyProtocolInfo ppi_noaddr;
+			assert(ppi_noaddr.parseProxyProtocolV2Header(hdr_noaddr, sizeof(hdr_noaddr)) == true);
+			assert(ppi_noaddr.source_address[0] == '\0');
+		}
+		const unsigned char hdr_bad_fam[] = { '\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x21, 0x41, 0, 0 };
+		assert(ppi_local.parseProxyProtocolV2Header(hdr_bad_fam, sizeof(hdr_bad_fam)) == false);
+
+		const unsigned char hdr_bad_ver[] = { '\r','\n','\r','\n',0,'\r','\n','Q','U','I','T','\n', 0x11, 0x11, 0, 0 };
+		assert(ppi_local.parseProxyProtocolV2Header(hdr_bad_ver, sizeof(hdr_bad_ver)) == false);
+		assert(getProxyProtocolV2HeaderLength((const unsigned char*)"PROXY TCP4 1.1.1.1", 18) == 0);
+	}
 }
 
 #endif // DEBUG
@@ -380,3 +515,141 @@ bool ProxyProtocolInfo::is_valid_subnet(const char* subnet) {
 
 	return true; // Valid subnet
 }
+
+/**
+ * @brief Parses a subnet in CIDR notation into the first and last address of its range.
+ * @return The address family of the subnet, or AF_UNSPEC if the subnet is invalid.
+ */
+template <typename T>
+static int parse_subnet_range(const char* subnet, T& first, T& last);
+
+template <>
+int parse_subnet_range(const char* subnet, uint32_t& first, uint32_t& last) {
+	char addr_str[INET6_ADDRSTRLEN];
+	unsigned int mask = 0;
+	struct in_addr v4;
+	if (sscanf(subnet, "%45[^/]/%u", addr_str, &mask) != 2 || mask > 32 || inet_pton(AF_INET, addr_str, &v4) != 1) {
+		return AF_UNSPEC;
+	}
+	const uint32_t hostmask = mask == 0 ? 0xFFFFFFFF : (mask == 32 ? 0 : (0xFFFFFFFF >> mask));
+	first = ntohl(v4.s_addr) & ~hostmask;
+	last = first | hostmask;
+	return AF_INET;
+}
+
+typedef unsigned __int128 pp_uint128_t;
+
+static pp_uint128_t in6_to_uint128(const unsigned char* addr) {
+	pp_uint128_t v = 0;
+	for (int i = 0; i < 16; i++) {
+		v = (v << 8) | addr[i];
+	}
+	return v;
+}
+
+template <>
+int parse_subnet_range(const char* subnet, pp_uint128_t& first, pp_uint128_t& last) {
+	char addr_str[INET6_ADDRSTRLEN];
+	unsigned int mask = 0;
+	struct in6_addr v6;
+	if (sscanf(subnet, "%45[^/]/%u", addr_str, &mask) != 2 || mask > 128 || inet_pton(AF_INET6, addr_str, &v6) != 1) {
+		return AF_UNSPEC;
+	}
+	const pp_uint128_t all = ~(pp_uint128_t)0;
+	const pp_uint128_t hostmask = mask == 0 ? all : (mask == 128 ? 0 : (all >> mask));
+	first = in6_to_uint128(v6.s6_addr) & ~hostmask;
+	last = first | hostmask;
+	return AF_INET6;
+}
+
+/**
+ * @brief Sorts the ranges and merges the overlapping and adjacent ones.
+ */
+template <typename T>
+static void merge_ranges(std::vector<std::pair<T, T>>& ranges) {
+	std::sort(ranges.begin(), ranges.end());
+	size_t j = 0;
+	for (size_t i = 1; i < ranges.size(); i++) {
+		if (ranges[j].second == (T)~(T)0 || ranges[i].first <= ranges[j].second + 1) {
+			ranges[j].second = std::max(ranges[j].second, ranges[i].second);
+		} else {
+			ranges[++j] = ranges[i];
+		}
+	}
+	if (ranges.empty() == false) {
+		ranges.resize(j + 1);
+	}
+}
+
+template <typename T>
+static bool in_ranges(const std::vector<std::pair<T, T>>& ranges, T addr) {
+	// first range starting after 'addr', the candidate is the previous one
+	auto it = std::upper_bound(
+		ranges.begin(), ranges.end(), addr, [] (T a, const std::pair<T, T>& r) { return a < r.first; }
+	);
+	if (it == ranges.begin()) {
+		return false;
+	}
+	--it;
+	return addr <= it->second;
+}
+
+bool ProxyProtocol_Networks::compile(const char* subnet_list) {
+	bool ret = true;
+	match_all = false;
+	ranges_v4.clear();
+	ranges_v6.clear();
+	if (subnet_list == nullptr || *subnet_list == '\0') {
+		return true;
+	}
+	if (strcmp(subnet_list, "*") == 0) {
+		match_all = true;
+		return true;
+	}
+	std::string list { subnet_list };
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		const std::string subnet { list.substr(start, end - start) };
+		start = end + 1;
+		if (subnet.empty()) {
+			continue;
+		}
+		if (strchr(subnet.c_str(), ':') != NULL) {
+			pp_uint128_t first, last;
+			if (parse_subnet_range(subnet.c_str(), first, last) == AF_INET6) {
+				ranges_v6.push_back({ first, last });
+			} else {
+				ret = false;
+			}
+		} else {
+			uint32_t first, last;
+			if (parse_subnet_range(subnet.c_str(), first, last) == AF_INET) {
+				ranges_v4.push_back({ first, last });
+			} else {
+				ret = false;
+			}
+		}
+	}
+	merge_ranges(ranges_v4);
+	merge_ranges(ranges_v6);
+	return ret;
+}
+
+bool ProxyProtocol_Networks::match(const struct sockaddr* addr) const {
+	if (match_all) {
+		return true;
+	}
+	if (addr == nullptr) {
+		return false;
+	}
+	if (addr->sa_family == AF_INET) {
+		return in_ranges(ranges_v4, (uint32_t)ntohl(((const struct sockaddr_in*)addr)->sin_addr.s_addr));
+	} else if (addr->sa_family == AF_INET6) {
+		return in_ranges(ranges_v6, in6_to_uint128(((const struct sockaddr_in6*)addr)->sin6_addr.s6_addr));
+	}
+	return false;
+}
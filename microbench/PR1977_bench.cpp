@@ -1,6 +1,14 @@
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
+#include <vector>
+
+static unsigned long long monotonic_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
 
 __thread unsigned int g_seed;
 
@@ -27,6 +35,93 @@ struct cpu_timer
 };
 
 
+// same selection as MyHGC::get_random_MySrvC() with 'load_balancing_algorithm=1'
+static unsigned int pick_weighted(unsigned int *weights, unsigned int *idx, int N, unsigned int sum) {
+	unsigned int k;
+	if (sum > 32768) {
+		k = rand() % sum;
+	} else {
+		k = fastrand() % sum;
+	}
+	k++;
+	unsigned int New_sum = 0;
+	for (int j=0; j<N; j++) {
+		New_sum += weights[idx[j]];
+		if (k <= New_sum) {
+			return j;
+		}
+	}
+	return N-1;
+}
+
+static unsigned int p2c(unsigned int *weights, unsigned int *in_flight, unsigned int *latency_us, unsigned int *idx, int N, unsigned int sum) {
+	unsigned int a = pick_weighted(weights, idx, N, sum);
+	unsigned int first = idx[a];
+	unsigned int sum2 = sum - weights[first];
+	if (sum2 == 0) {
+		return first;
+	}
+	idx[a] = idx[N-1];
+	idx[N-1] = first;
+	unsigned int second = idx[pick_weighted(weights, idx, N-1, sum2)];
+	double l1 = (double)(in_flight[first] + 1) * latency_us[first] / weights[first];
+	double l2 = (double)(in_flight[second] + 1) * latency_us[second] / weights[second];
+	return (l2 < l1 ? second : first);
+}
+
+// Simulates NSIM_QUERIES queries on N servers with equal weight, where server 0 is SLOW_FACTOR times slower.
+// A query sent to a server completes after the latency of the server. Reports the share of queries sent to the
+// slow server, and the average query latency.
+#define NSIM_QUERIES	1000000
+#define SLOW_FACTOR	10
+#define ARRIVAL_US	20
+
+static void simulate(int N, bool use_p2c) {
+	unsigned int weights[NSRV], in_flight[NSRV], latency_us[NSRV], idx[NSRV];
+	std::vector<unsigned long long> completions[NSRV];
+	unsigned int sent[NSRV];
+	unsigned int sum = 0;
+	for (int j=0; j<N; j++) {
+		weights[j] = 1000;
+		in_flight[j] = 0;
+		latency_us[j] = (j == 0 ? 1000 * SLOW_FACTOR : 1000);
+		sent[j] = 0;
+		sum += weights[j];
+	}
+	unsigned long long now = 0;
+	unsigned long long total_latency = 0;
+	for (int i=0; i<NSIM_QUERIES; i++) {
+		now += ARRIVAL_US;
+		for (int j=0; j<N; j++) {
+			// retire completed queries
+			std::vector<unsigned long long>& c = completions[j];
+			for (size_t q=0; q<c.size(); ) {
+				if (c[q] <= now) {
+					c[q] = c.back();
+					c.pop_back();
+					in_flight[j]--;
+				} else {
+					q++;
+				}
+			}
+			idx[j] = j;
+		}
+		unsigned int s;
+		if (use_p2c) {
+			s = p2c(weights, in_flight, latency_us, idx, N, sum);
+		} else {
+			s = idx[pick_weighted(weights, idx, N, sum)];
+		}
+		completions[s].push_back(now + latency_us[s]);
+		total_latency += latency_us[s];
+		in_flight[s]++;
+		sent[s]++;
+	}
+	fprintf(stderr, "  %-16s slow server received %5.2f%% of the queries (weight share %5.2f%%) , avg latency %6.1fus\n",
+		(use_p2c ? "power-of-two" : "weighted random"), 100.0 * sent[0] / NSIM_QUERIES, 100.0 / N,
+		(double)total_latency / NSIM_QUERIES);
+}
+
 int main(int argc, char** argv) {
 	unsigned int * usedConns = NULL;
 	unsigned int * weights = NULL;
@@ -120,5 +215,28 @@ int main(int argc, char** argv) {
 		}
 		std::cerr << "DOUBLE test ran in \t";
 	}
+	{
+		unsigned int in_flight[NSRV], latency_us[NSRV], idx[NSRV];
+		sum = 0;
+		for (int j=0; j<N; j++) {
+			in_flight[j] = usedConns[j] % 64;
+			latency_us[j] = 200 + rand() % 5000;
+			sum += weights[j];
+		}
+		cpu_timer c;
+		for (int i=0; i<NLOOP; i++) {
+			for (int j=0; j<N; j++) {
+				idx[j] = j;
+			}
+			unsigned int s = p2c(weights, in_flight, latency_us, idx, N, sum);
+			in_flight[s] = (in_flight[s] + 1) % 64;
+		}
+		std::cerr << "P2C test ran in \t";
+	}
+	}
+	for (int N=4; N<=NSRV; N+=4) {
+		std::cerr << "Simulation with " << N << " servers, 1 slow:" << std::endl;
+		simulate(N, false);
+		simulate(N, true);
 	}
 }
@@ -0,0 +1,175 @@
+/**
+ * @file c_tokenizer_bench.cpp
+ * @brief Throughput benchmark and equivalence check for the vectorized digest pre-scan.
+ * @details For every query (synthetic large queries, random queries and optionally the files passed as
+ *   arguments, e.g. the files in 'test/afl_digest_test/inputs/') the digest is computed with the scalar
+ *   implementation and with every SIMD implementation supported by the CPU. Digests must be
+ *   byte-identical, then the throughput of each implementation is reported.
+ *
+ *   Build from the repository root with:
+ *
+ *   g++ -O2 -std=c++17 -Iinclude microbench/c_tokenizer_bench.cpp lib/c_tokenizer.cpp -o c_tokenizer_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "c_tokenizer.h"
+
+__thread int mysql_thread___query_digests_max_query_length = 65000;
+__thread bool mysql_thread___query_digests_lowercase = false;
+__thread bool mysql_thread___query_digests_replace_null = true;
+__thread bool mysql_thread___query_digests_no_digits = false;
+__thread int mysql_thread___query_digests_grouping_limit = 3;
+__thread int mysql_thread___query_digests_groups_grouping_limit = 1;
+__thread int mysql_thread___query_digests_keep_comment = 0;
+
+#define NLOOP_BYTES	(512ULL*1024*1024)
+#define NRANDOM	200000
+
+static const char* level_names[] = { "scalar", "sse4.2", "avx2" };
+
+static unsigned long long monotonic_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void digest(const std::string& q, const options& opts) {
+	char buf[128];
+	char* cmnt = NULL;
+	char* res = query_digest_and_first_comment_2(q.c_str(), q.size(), &cmnt, q.size() < sizeof(buf) ? buf : NULL, &opts);
+	if (res != buf) {
+		free(res);
+	}
+	free(cmnt);
+}
+
+// The result buffer is zeroed in advance: the parser may look at positions of the buffer it hasn't written
+// yet, and the check must not depend on their previous content.
+static std::string checked_digest(const std::string& q, const options& opts) {
+	std::vector<char> buf(q.size() + 1, 0);
+	char* cmnt = NULL;
+	std::string r { query_digest_and_first_comment_2(q.c_str(), q.size(), &cmnt, buf.data(), &opts) };
+	free(cmnt);
+	return r;
+}
+
+static std::vector<std::string> gen_large_queries() {
+	std::vector<std::string> queries {};
+	std::string q { "INSERT INTO db.t1 (id, name, price, note) VALUES " };
+	for (int i = 0; q.size() < 256*1024; i++) {
+		q += (i ? ", (" : "(") + std::to_string(i*7919) + ", 'name_" + std::to_string(i) + " with some text', "
+			+ std::to_string(i) + ".99, \"it\\'s a \"\"quoted\"\" note\")";
+	}
+	queries.push_back(q + " ON DUPLICATE KEY UPDATE price = VALUES(price)");
+	q = "SELECT * FROM t1 WHERE id IN (";
+	for (int i = 0; q.size() < 128*1024; i++) {
+		q += (i ? ",    " : "") + std::to_string(1000000000 + i);
+	}
+	queries.push_back(q + ")");
+	q = "SELECT /* long string */ id FROM t1 WHERE data = '";
+	for (int i = 0; q.size() < 128*1024; i++) {
+		q += "lorem ipsum dolor sit amet, consectetur adipiscing elit ";
+	}
+	queries.push_back(q + "'");
+	q = "SELECT\n";
+	for (int i = 0; q.size() < 64*1024; i++) {
+		q += "    col" + std::to_string(i) + " ,\t\t\t\r\n                                ";
+	}
+	queries.push_back(q + " 1 FROM t1");
+	return queries;
+}
+
+static std::vector<std::string> gen_random_queries(int num) {
+	// alphabet biased towards the chars driving the parser state transitions
+	const char alphabet[] = "  \t\n\r0123456789'\"\\/*#-+.eExXnNuUlL(),;=abcSELECT";
+	std::vector<std::string> queries {};
+	srand(1);
+	for (int i = 0; i < num; i++) {
+		int len = 1 + rand() % 160;
+		std::string q {};
+		for (int j = 0; j < len; j++) {
+			// long runs of the same class, so that the vectorized paths are exercised too
+			if (rand() % 8 == 0) {
+				char c = "  0'x"[rand() % 5];
+				q += std::string(16 + rand() % 48, c == 'x' ? (char)('a' + rand() % 26) : c);
+			} else {
+				q += alphabet[rand() % (sizeof(alphabet) - 1)];
+			}
+		}
+		queries.push_back(q);
+	}
+	return queries;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> queries { gen_large_queries() };
+	const size_t num_large = queries.size();
+	for (int i = 1; i < argc; i++) {
+		std::ifstream f { argv[i] };
+		std::stringstream ss {};
+		ss << f.rdbuf();
+		queries.push_back(ss.str());
+	}
+	const std::vector<std::string> rnd { gen_random_queries(NRANDOM) };
+	queries.insert(queries.end(), rnd.begin(), rnd.end());
+
+	const int max_level = query_digest_set_simd_level(-1);
+	std::cerr << "Best SIMD level supported: " << level_names[max_level] << std::endl;
+
+	options opts_list[4] {};
+	for (int o = 0; o < 4; o++) {
+		opts_list[o].lowercase = o & 1;
+		opts_list[o].replace_null = true;
+		opts_list[o].replace_number = o & 2;
+		opts_list[o].keep_comment = o & 1;
+		opts_list[o].grouping_limit = 3;
+		opts_list[o].groups_grouping_limit = 1;
+		opts_list[o].max_query_length = (o & 2) ? 65000 : 1024*1024;
+	}
+
+	// equivalence check
+	unsigned long long mismatches = 0;
+	for (const options& opts : opts_list) {
+		for (const std::string& q : queries) {
+			query_digest_set_simd_level(TOKENIZER_SIMD_NONE);
+			const std::string exp { checked_digest(q, opts) };
+			for (int l = 1; l <= max_level; l++) {
+				query_digest_set_simd_level(l);
+				if (checked_digest(q, opts) != exp) {
+					if (mismatches++ < 10) {
+						std::cerr << "Mismatch with " << level_names[l] << " for query: " << q.substr(0, 256) << std::endl;
+					}
+				}
+			}
+		}
+	}
+	std::cerr << "Queries checked: " << queries.size() * 4 << " , mismatches: " << mismatches << std::endl;
+
+	// throughput
+	for (size_t i = 0; i < num_large; i++) {
+		const std::string& q = queries[i];
+		const unsigned long long nloop = NLOOP_BYTES / q.size();
+		std::cerr << "Query " << i << " , " << q.size() << " bytes , " << nloop << " loops:" << std::endl;
+		for (int l = 0; l <= max_level; l++) {
+			query_digest_set_simd_level(l);
+			unsigned long long begin = monotonic_time();
+			for (unsigned long long j = 0; j < nloop; j++) {
+				digest(q, opts_list[0]);
+			}
+			unsigned long long end = monotonic_time();
+			double secs = double(end - begin) / 1000000;
+			fprintf(stderr, "  %-8s %8.3f secs , %8.1f MB/s\n", level_names[l], secs, (nloop * q.size()) / secs / (1024*1024));
+		}
+	}
+
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
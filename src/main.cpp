@@ -944,7 +944,9 @@ void ProxySQL_Main_init_Auth_module() {
 	GloMyAuth->print_version();
 	GloPgAuth = new PgSQL_Authentication();
 	GloPgAuth->print_version();
-	GloAdmin->init_users();
+	if (GloAdmin->load_mysql_users_from_snapshot() == false) {
+		GloAdmin->init_users();
+	}
 	GloAdmin->init_pgsql_users();
 	//GloMyLdapAuth = create_MySQL_LDAP_Authentication();
 	if (GloMyLdapAuth) {
@@ -957,7 +959,9 @@ void ProxySQL_Main_init_Query_module() {
 	GloMyQPro->print_version();
 	GloPgQPro = new PgSQL_Query_Processor();
 	GloPgQPro->print_version();
-	GloAdmin->init_mysql_query_rules();
+	if (GloAdmin->load_mysql_query_rules_from_snapshot() == false) {
+		GloAdmin->init_mysql_query_rules();
+	}
 	GloAdmin->init_mysql_firewall();
 	GloAdmin->init_pgsql_query_rules();
 	GloAdmin->init_pgsql_firewall();
@@ -1558,6 +1562,9 @@ void ProxySQL_Main_init_phase3___start_all() {
 	// Load the config not previously loaded for these modules
 	GloAdmin->load_http_server();
 	GloAdmin->load_restapi_server();
+
+	// Modules loaded from the runtime snapshot are validated once ProxySQL is accepting traffic
+	GloAdmin->validate_runtime_snapshot();
 }
 
 
@@ -1571,6 +1578,9 @@ void ProxySQL_Main_init_phase4___shutdown() {
 		pthread_mutex_unlock(&GloVars.global.start_mutex);
 	}
 
+	if (GloAdmin) {
+		GloAdmin->save_runtime_snapshot();
+	}
 	ProxySQL_Main_shutdown_all_modules();
 #ifdef DEBUG
 	std::cerr << "Main init phase4 shutdown completed in ";
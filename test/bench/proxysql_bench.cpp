@@ -0,0 +1,907 @@
+/**
+ * @file proxysql_bench.cpp
+ * @brief End-to-end throughput and latency benchmark for ProxySQL.
+ * @details Drives a set of workloads against the MySQL interface of ProxySQL, from several threads, each one
+ *   multiplexing several connections with the non-blocking API of the MariaDB client library. For each
+ *   workload it reports, as a JSON document:
+ *   - The number of operations, errors and the operations per second.
+ *   - The latency percentiles (p50, p99, p999) and the maximum latency, in microseconds.
+ *   - The CPU time spent per operation by ProxySQL (when its pid is known) and by the client itself.
+ *
+ *   An operation is the unit measured for latency, and depends on the workload:
+ *   - 'point_select': a single primary key lookup.
+ *   - 'large_resultset': a range select returning '--large-rows' rows.
+ *   - 'prepared': a primary key lookup through a prepared statement, prepared once per connection.
+ *   - 'transaction': 'BEGIN', two primary key lookups and 'COMMIT'.
+ *   - 'connect': connection, a primary key lookup, and disconnection (connection churn).
+ *   - 'tls': a primary key lookup over a TLS connection.
+ *
+ *   With '--setup' the tool configures ProxySQL through its Admin interface, using the SQLite3 Server of
+ *   ProxySQL ('--sqlite3-server') as backend, and creates and populates the table used by the workloads.
+ *   SQLite3 Server doesn't implement the binary protocol, so the 'prepared' workload requires a MySQL
+ *   backend, supplied with '--backend'.
+ *
+ *   See 'run_bench.sh' for running the whole benchmark against a dedicated ProxySQL instance.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "mysql.h"
+
+using std::string;
+using std::vector;
+
+#define BENCH_TABLE "sbtest1"
+#define POINT_SELECT_QUERY "SELECT c FROM " BENCH_TABLE " WHERE id="
+
+struct bench_opts_t {
+	string host { "127.0.0.1" };
+	int port { 6033 };
+	string user { "bench" };
+	string password { "bench" };
+	string schema {};
+	string admin_host { "127.0.0.1" };
+	int admin_port { 6032 };
+	string admin_user { "admin" };
+	string admin_password { "admin" };
+	string backend {};
+	int hostgroup { 0 };
+	bool setup { false };
+	vector<string> workloads { "point_select", "large_resultset", "transaction", "connect", "tls" };
+	int threads { 4 };
+	int connections { 8 };
+	int duration { 10 };
+	int warmup { 2 };
+	int rows { 10000 };
+	int large_rows { 1000 };
+	int proxysql_pid { 0 };
+	string output {};
+};
+
+enum class workload_t { POINT_SELECT, LARGE_RESULTSET, PREPARED, TRANSACTION, CONNECT, TLS };
+
+static bool parse_workload(const string& name, workload_t& w) {
+	if (name == "point_select") { w = workload_t::POINT_SELECT; }
+	else if (name == "large_resultset") { w = workload_t::LARGE_RESULTSET; }
+	else if (name == "prepared") { w = workload_t::PREPARED; }
+	else if (name == "transaction") { w = workload_t::TRANSACTION; }
+	else if (name == "connect") { w = workload_t::CONNECT; }
+	else if (name == "tls") { w = workload_t::TLS; }
+	else { return false; }
+	return true;
+}
+
+static uint64_t monotonic_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+/**
+ * @brief Returns the CPU time (user + system) consumed by process 'pid', in microseconds, or -1 on error.
+ */
+static long long get_process_cpu_us(int pid) {
+	const string path { "/proc/" + std::to_string(pid) + "/stat" };
+	FILE* f = fopen(path.c_str(), "r");
+	if (f == NULL) {
+		return -1;
+	}
+	char buf[1024] = { 0 };
+	size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[len] = '\0';
+	// the process name may contain spaces, fields are counted after its closing parenthesis
+	const char* p = strrchr(buf, ')');
+	if (p == NULL) {
+		return -1;
+	}
+	unsigned long long utime = 0, stime = 0;
+	if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+		return -1;
+	}
+	const long ticks = sysconf(_SC_CLK_TCK);
+	return (utime + stime) * 1000000ULL / ticks;
+}
+
+static long long get_self_cpu_us() {
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return
+		ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec +
+		ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+}
+
+/******************************************************************************
+ * Workload execution
+ ******************************************************************************/
+
+struct thread_stats_t {
+	vector<uint64_t> latencies_ns {};
+	uint64_t errors { 0 };
+	string last_error {};
+};
+
+/**
+ * @brief State shared by the main thread and the workers of a workload run.
+ * @details Operations completed while 'recording' is set are accounted; workers stop starting new operations
+ *   once 'stop' is set.
+ */
+struct run_ctl_t {
+	std::atomic<bool> recording { false };
+	std::atomic<bool> stop { false };
+};
+
+enum class conn_state_t {
+	BEGIN_OP, CONNECT, CONNECT_WAIT, CONNECTED, PREPARE, PREPARE_WAIT, PREPARED,
+	NEXT_STEP, QUERY_WAIT, QUERY_DONE, STORE_WAIT, STORE_DONE, STMT_EXEC_WAIT, STMT_EXEC_DONE,
+	STMT_STORE_WAIT, STMT_STORE_DONE, OP_DONE, FINISHED
+};
+
+struct bench_conn_t {
+	MYSQL* mysql { NULL };
+	MYSQL* ret_mysql { NULL };
+	MYSQL_STMT* stmt { NULL };
+	MYSQL_RES* res { NULL };
+	MYSQL_BIND bind {};
+	int stmt_param { 0 };
+	int ret_int { 0 };
+	conn_state_t state { conn_state_t::BEGIN_OP };
+	int wait { 0 };
+	uint64_t wait_deadline_ns { 0 };
+	size_t step { 0 };
+	string query {};
+	uint64_t op_start_ns { 0 };
+};
+
+class bench_worker_t {
+	public:
+	bench_worker_t(const bench_opts_t& _opts, workload_t _w, run_ctl_t& _ctl, thread_stats_t& _stats) :
+		opts(_opts), w(_w), ctl(_ctl), stats(_stats), rnd(std::random_device {}())
+	{}
+	void run();
+	private:
+	int drive(bench_conn_t& c, int events);
+	void on_error(bench_conn_t& c, const char* err);
+	void close_conn(bench_conn_t& c);
+	size_t op_steps() const;
+	void build_query(bench_conn_t& c);
+	int random_id() { return std::uniform_int_distribution<int>(1, opts.rows)(rnd); }
+
+	const bench_opts_t& opts;
+	workload_t w;
+	run_ctl_t& ctl;
+	thread_stats_t& stats;
+	std::mt19937 rnd;
+};
+
+size_t bench_worker_t::op_steps() const {
+	return w == workload_t::TRANSACTION ? 4 : 1;
+}
+
+void bench_worker_t::build_query(bench_conn_t& c) {
+	switch (w) {
+		case workload_t::LARGE_RESULTSET: {
+			const int max_start = std::max(1, opts.rows - opts.large_rows);
+			const int start = std::uniform_int_distribution<int>(1, max_start)(rnd);
+			c.query = "SELECT id, k, c, pad FROM " BENCH_TABLE " WHERE id BETWEEN " + std::to_string(start) +
+				" AND " + std::to_string(start + opts.large_rows - 1);
+			break;
+		}
+		case workload_t::TRANSACTION:
+			if (c.step == 0) {
+				c.query = "BEGIN";
+			} else if (c.step == op_steps() - 1) {
+				c.query = "COMMIT";
+			} else {
+				c.query = POINT_SELECT_QUERY + std::to_string(random_id());
+			}
+			break;
+		default:
+			c.query = POINT_SELECT_QUERY + std::to_string(random_id());
+			break;
+	}
+}
+
+void bench_worker_t::close_conn(bench_conn_t& c) {
+	if (c.res) {
+		mysql_free_result(c.res);
+		c.res = NULL;
+	}
+	if (c.stmt) {
+		mysql_stmt_close(c.stmt);
+		c.stmt = NULL;
+	}
+	if (c.mysql) {
+		mysql_close(c.mysql);
+		c.mysql = NULL;
+	}
+}
+
+void bench_worker_t::on_error(bench_conn_t& c, const char* err) {
+	if (ctl.recording && !ctl.stop) {
+		stats.errors++;
+		stats.last_error = err;
+	}
+	close_conn(c);
+	// avoid spinning against an unavailable server
+	usleep(1000);
+	c.state = conn_state_t::BEGIN_OP;
+}
+
+/**
+ * @brief Advances the state machine of a connection until it has to wait for the network.
+ * @param events The 'MYSQL_WAIT_*' events that happened since the last call.
+ * @return The 'MYSQL_WAIT_*' events to wait for, or 0 once the connection is finished.
+ */
+int bench_worker_t::drive(bench_conn_t& c, int events) {
+	int status = 0;
+
+	for (;;) {
+		switch (c.state) {
+			case conn_state_t::BEGIN_OP:
+				if (ctl.stop) {
+					close_conn(c);
+					c.state = conn_state_t::FINISHED;
+					return 0;
+				}
+				c.step = 0;
+				c.op_start_ns = monotonic_ns();
+				c.state = c.mysql == NULL ? conn_state_t::CONNECT : conn_state_t::NEXT_STEP;
+				break;
+			case conn_state_t::CONNECT:
+				c.mysql = mysql_init(NULL);
+				mysql_options(c.mysql, MYSQL_OPT_NONBLOCK, 0);
+				if (w == workload_t::TLS) {
+					mysql_ssl_set(c.mysql, NULL, NULL, NULL, NULL, NULL);
+				}
+				status = mysql_real_connect_start(
+					&c.ret_mysql, c.mysql, opts.host.c_str(), opts.user.c_str(), opts.password.c_str(),
+					opts.schema.empty() ? NULL : opts.schema.c_str(), opts.port, NULL, 0
+				);
+				c.state = conn_state_t::CONNECT_WAIT;
+				if (status) { return status; }
+				c.state = conn_state_t::CONNECTED;
+				break;
+			case conn_state_t::CONNECT_WAIT:
+				status = mysql_real_connect_cont(&c.ret_mysql, c.mysql, events);
+				if (status) { return status; }
+				c.state = conn_state_t::CONNECTED;
+				break;
+			case conn_state_t::CONNECTED:
+				if (c.ret_mysql == NULL) {
+					on_error(c, mysql_error(c.mysql));
+					break;
+				}
+				if (w == workload_t::PREPARED) {
+					c.state = conn_state_t::PREPARE;
+				} else if (w == workload_t::CONNECT) {
+					c.state = conn_state_t::NEXT_STEP;
+				} else {
+					// connections are established outside of the measured operations
+					c.state = conn_state_t::BEGIN_OP;
+				}
+				break;
+			case conn_state_t::PREPARE: {
+				c.stmt = mysql_stmt_init(c.mysql);
+				const char* q = POINT_SELECT_QUERY "?";
+				status = mysql_stmt_prepare_start(&c.ret_int, c.stmt, q, strlen(q));
+				c.state = conn_state_t::PREPARE_WAIT;
+				if (status) { return status; }
+				c.state = conn_state_t::PREPARED;
+				break;
+			}
+			case conn_state_t::PREPARE_WAIT:
+				status = mysql_stmt_prepare_cont(&c.ret_int, c.stmt, events);
+				if (status) { return status; }
+				c.state = conn_state_t::PREPARED;
+				break;
+			case conn_state_t::PREPARED:
+				if (c.ret_int) {
+					on_error(c, mysql_stmt_error(c.stmt));
+					break;
+				}
+				memset(&c.bind, 0, sizeof(c.bind));
+				c.bind.buffer_type = MYSQL_TYPE_LONG;
+				c.bind.buffer = &c.stmt_param;
+				mysql_stmt_bind_param(c.stmt, &c.bind);
+				c.state = conn_state_t::BEGIN_OP;
+				break;
+			case conn_state_t::NEXT_STEP:
+				if (c.step == op_steps()) {
+					c.state = conn_state_t::OP_DONE;
+					break;
+				}
+				if (w == workload_t::PREPARED) {
+					c.stmt_param = random_id();
+					status = mysql_stmt_execute_start(&c.ret_int, c.stmt);
+					c.state = conn_state_t::STMT_EXEC_WAIT;
+					if (status) { return status; }
+					c.state = conn_state_t::STMT_EXEC_DONE;
+				} else {
+					build_query(c);
+					status = mysql_real_query_start(&c.ret_int, c.mysql, c.query.c_str(), c.query.size());
+					c.state = conn_state_t::QUERY_WAIT;
+					if (status) { return status; }
+					c.state = conn_state_t::QUERY_DONE;
+				}
+				break;
+			case conn_state_t::QUERY_WAIT:
+				status = mysql_real_query_cont(&c.ret_int, c.mysql, events);
+				if (status) { return status; }
+				c.state = conn_state_t::QUERY_DONE;
+				break;
+			case conn_state_t::QUERY_DONE:
+				if (c.ret_int) {
+					on_error(c, mysql_error(c.mysql));
+					break;
+				}
+				status = mysql_store_result_start(&c.res, c.mysql);
+				c.state = conn_state_t::STORE_WAIT;
+				if (status) { return status; }
+				c.state = conn_state_t::STORE_DONE;
+				break;
+			case conn_state_t::STORE_WAIT:
+				status = mysql_store_result_cont(&c.res, c.mysql, events);
+				if (status) { return status; }
+				c.state = conn_state_t::STORE_DONE;
+				break;
+			case conn_state_t::STORE_DONE:
+				if (c.res) {
+					mysql_free_result(c.res);
+					c.res = NULL;
+				} else if (mysql_field_count(c.mysql) != 0) {
+					on_error(c, mysql_error(c.mysql));
+					break;
+				}
+				c.step++;
+				c.state = conn_state_t::NEXT_STEP;
+				break;
+			case conn_state_t::STMT_EXEC_WAIT:
+				status = mysql_stmt_execute_cont(&c.ret_int, c.stmt, events);
+				if (status) { return status; }
+				c.state = conn_state_t::STMT_EXEC_DONE;
+				break;
+			case conn_state_t::STMT_EXEC_DONE:
+				if (c.ret_int) {
+					on_error(c, mysql_stmt_error(c.stmt));
+					break;
+				}
+				status = mysql_stmt_store_result_start(&c.ret_int, c.stmt);
+				c.state = conn_state_t::STMT_STORE_WAIT;
+				if (status) { return status; }
+				c.state = conn_state_t::STMT_STORE_DONE;
+				break;
+			case conn_state_t::STMT_STORE_WAIT:
+				status = mysql_stmt_store_result_cont(&c.ret_int, c.stmt, events);
+				if (status) { return status; }
+				c.state = conn_state_t::STMT_STORE_DONE;
+				break;
+			case conn_state_t::STMT_STORE_DONE:
+				if (c.ret_int) {
+					on_error(c, mysql_stmt_error(c.stmt));
+					break;
+				}
+				mysql_stmt_free_result(c.stmt);
+				c.step++;
+				c.state = conn_state_t::NEXT_STEP;
+				break;
+			case conn_state_t::OP_DONE:
+				if (ctl.recording && !ctl.stop) {
+					stats.latencies_ns.push_back(monotonic_ns() - c.op_start_ns);
+				}
+				if (w == workload_t::CONNECT) {
+					close_conn(c);
+				}
+				c.state = conn_state_t::BEGIN_OP;
+				break;
+			case conn_state_t::FINISHED:
+				return 0;
+		}
+	}
+}
+
+void bench_worker_t::run() {
+	vector<bench_conn_t> conns(opts.connections);
+	vector<struct pollfd> pfds(conns.size());
+	size_t active = conns.size();
+
+	for (bench_conn_t& c : conns) {
+		c.wait = drive(c, 0);
+	}
+
+	while (active) {
+		uint64_t now = monotonic_ns();
+		int timeout_ms = 100;
+		active = 0;
+
+		for (size_t i = 0; i < conns.size(); i++) {
+			bench_conn_t& c = conns[i];
+			pfds[i].fd = -1;
+			pfds[i].events = 0;
+			pfds[i].revents = 0;
+			if (c.state == conn_state_t::FINISHED) {
+				continue;
+			}
+			active++;
+			if (c.wait == 0) {
+				continue;
+			}
+			pfds[i].fd = mysql_get_socket(c.mysql);
+			if (c.wait & MYSQL_WAIT_READ) { pfds[i].events |= POLLIN; }
+			if (c.wait & MYSQL_WAIT_WRITE) { pfds[i].events |= POLLOUT; }
+			if (c.wait & MYSQL_WAIT_EXCEPT) { pfds[i].events |= POLLPRI; }
+			if (c.wait & MYSQL_WAIT_TIMEOUT) {
+				if (c.wait_deadline_ns == 0) {
+					c.wait_deadline_ns = now + mysql_get_timeout_value_ms(c.mysql) * 1000000ULL;
+				}
+				const int left_ms = c.wait_deadline_ns > now ? (c.wait_deadline_ns - now) / 1000000 : 0;
+				timeout_ms = std::min(timeout_ms, left_ms);
+			}
+		}
+		if (active == 0) {
+			break;
+		}
+
+		int rc = poll(pfds.data(), pfds.size(), timeout_ms);
+		if (rc < 0 && errno != EINTR) {
+			perror("poll");
+			break;
+		}
+
+		now = monotonic_ns();
+		for (size_t i = 0; i < conns.size(); i++) {
+			bench_conn_t& c = conns[i];
+			if (c.state == conn_state_t::FINISHED) {
+				continue;
+			}
+			int events = 0;
+			if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) { events |= MYSQL_WAIT_READ; }
+			if (pfds[i].revents & POLLOUT) { events |= MYSQL_WAIT_WRITE; }
+			if (pfds[i].revents & POLLPRI) { events |= MYSQL_WAIT_EXCEPT; }
+			if ((c.wait & MYSQL_WAIT_TIMEOUT) && events == 0 && now >= c.wait_deadline_ns) {
+				events |= MYSQL_WAIT_TIMEOUT;
+			}
+			if (events || c.wait == 0) {
+				c.wait_deadline_ns = 0;
+				c.wait = drive(c, events);
+			}
+		}
+	}
+
+	for (bench_conn_t& c : conns) {
+		close_conn(c);
+	}
+}
+
+/******************************************************************************
+ * Results
+ ******************************************************************************/
+
+struct workload_result_t {
+	string name {};
+	uint64_t ops { 0 };
+	uint64_t errors { 0 };
+	string last_error {};
+	double elapsed_s { 0 };
+	double p50_us { 0 };
+	double p99_us { 0 };
+	double p999_us { 0 };
+	double max_us { 0 };
+	double avg_us { 0 };
+	double proxysql_cpu_us_per_op { -1 };
+	double client_cpu_us_per_op { -1 };
+};
+
+static double percentile_us(const vector<uint64_t>& sorted, double p) {
+	if (sorted.empty()) {
+		return 0;
+	}
+	size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(idx, sorted.size() - 1)] / 1000.0;
+}
+
+static workload_result_t run_workload(const bench_opts_t& opts, const string& name, workload_t w) {
+	run_ctl_t ctl {};
+	vector<thread_stats_t> stats(opts.threads);
+	vector<std::thread> threads {};
+
+	for (int i = 0; i < opts.threads; i++) {
+		threads.emplace_back([&opts, w, &ctl, &stats, i] () {
+			bench_worker_t worker { opts, w, ctl, stats[i] };
+			worker.run();
+		});
+	}
+
+	sleep(opts.warmup);
+	const long long proxysql_cpu_start = opts.proxysql_pid ? get_process_cpu_us(opts.proxysql_pid) : -1;
+	const long long client_cpu_start = get_self_cpu_us();
+	const uint64_t start_ns = monotonic_ns();
+	ctl.recording = true;
+
+	sleep(opts.duration);
+
+	ctl.stop = true;
+	const uint64_t end_ns = monotonic_ns();
+	const long long proxysql_cpu_end = opts.proxysql_pid ? get_process_cpu_us(opts.proxysql_pid) : -1;
+	const long long client_cpu_end = get_self_cpu_us();
+
+	for (std::thread& t : threads) {
+		t.join();
+	}
+
+	workload_result_t res {};
+	res.name = name;
+	res.elapsed_s = (end_ns - start_ns) / 1e9;
+
+	vector<uint64_t> latencies {};
+	for (thread_stats_t& s : stats) {
+		latencies.insert(latencies.end(), s.latencies_ns.begin(), s.latencies_ns.end());
+		res.errors += s.errors;
+		if (!s.last_error.empty()) {
+			res.last_error = s.last_error;
+		}
+	}
+	std::sort(latencies.begin(), latencies.end());
+	res.ops = latencies.size();
+
+	if (res.ops) {
+		uint64_t total = 0;
+		for (uint64_t l : latencies) {
+			total += l;
+		}
+		res.avg_us = total / 1000.0 / res.ops;
+		res.p50_us = percentile_us(latencies, 0.50);
+		res.p99_us = percentile_us(latencies, 0.99);
+		res.p999_us = percentile_us(latencies, 0.999);
+		res.max_us = latencies.back() / 1000.0;
+		if (proxysql_cpu_start >= 0 && proxysql_cpu_end >= 0) {
+			res.proxysql_cpu_us_per_op = double(proxysql_cpu_end - proxysql_cpu_start) / res.ops;
+		}
+		res.client_cpu_us_per_op = double(client_cpu_end - client_cpu_start) / res.ops;
+	}
+
+	return res;
+}
+
+static string json_escape(const string& s) {
+	string r {};
+	for (const char c : s) {
+		if (c == '"' || c == '\\') {
+			r += '\\';
+			r += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			r += buf;
+		} else {
+			r += c;
+		}
+	}
+	return r;
+}
+
+static void print_results(FILE* out, const bench_opts_t& opts, const vector<workload_result_t>& results) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"config\": {\n");
+	fprintf(out, "    \"threads\": %d,\n", opts.threads);
+	fprintf(out, "    \"connections_per_thread\": %d,\n", opts.connections);
+	fprintf(out, "    \"duration_s\": %d,\n", opts.duration);
+	fprintf(out, "    \"warmup_s\": %d,\n", opts.warmup);
+	fprintf(out, "    \"rows\": %d,\n", opts.rows);
+	fprintf(out, "    \"large_rows\": %d\n", opts.large_rows);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"workloads\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const workload_result_t& r = results[i];
+		fprintf(out, "    {\n");
+		fprintf(out, "      \"name\": \"%s\",\n", json_escape(r.name).c_str());
+		fprintf(out, "      \"ops\": %lu,\n", r.ops);
+		fprintf(out, "      \"errors\": %lu,\n", r.errors);
+		fprintf(out, "      \"qps\": %.1f,\n", r.elapsed_s > 0 ? r.ops / r.elapsed_s : 0);
+		fprintf(out, "      \"latency_us\": { \"avg\": %.1f, \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f },\n",
+			r.avg_us, r.p50_us, r.p99_us, r.p999_us, r.max_us);
+		fprintf(out, "      \"cpu_us_per_op\": { ");
+		if (r.proxysql_cpu_us_per_op >= 0) {
+			fprintf(out, "\"proxysql\": %.2f, ", r.proxysql_cpu_us_per_op);
+		} else {
+			fprintf(out, "\"proxysql\": null, ");
+		}
+		if (r.client_cpu_us_per_op >= 0) {
+			fprintf(out, "\"client\": %.2f },\n", r.client_cpu_us_per_op);
+		} else {
+			fprintf(out, "\"client\": null },\n");
+		}
+		fprintf(out, "      \"last_error\": \"%s\"\n", json_escape(r.last_error).c_str());
+		fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "  ]\n");
+	fprintf(out, "}\n");
+}
+
+/******************************************************************************
+ * Setup
+ ******************************************************************************/
+
+static bool run_query(MYSQL* mysql, const string& q) {
+	if (mysql_query(mysql, q.c_str())) {
+		fprintf(stderr, "Query '%s' failed: %s\n", q.c_str(), mysql_error(mysql));
+		return false;
+	}
+	MYSQL_RES* res = mysql_store_result(mysql);
+	if (res) {
+		mysql_free_result(res);
+	}
+	return true;
+}
+
+/**
+ * @brief Configures ProxySQL to route the benchmark user to the backend, and populates the benchmark table.
+ * @details Without '--backend', the backend is the SQLite3 Server of ProxySQL, found in the variable
+ *   'sqliteserver-mysql_ifaces'.
+ */
+static bool setup(const bench_opts_t& opts) {
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(
+		admin, opts.admin_host.c_str(), opts.admin_user.c_str(), opts.admin_password.c_str(), NULL,
+		opts.admin_port, NULL, 0
+	)) {
+		fprintf(stderr, "Unable to connect to Admin: %s\n", mysql_error(admin));
+		mysql_close(admin);
+		return false;
+	}
+
+	string backend { opts.backend };
+	if (backend.empty()) {
+		if (mysql_query(admin, "SELECT variable_value FROM global_variables WHERE variable_name='sqliteserver-mysql_ifaces'")) {
+			fprintf(stderr, "Unable to get the SQLite3 Server interface: %s\n", mysql_error(admin));
+			mysql_close(admin);
+			return false;
+		}
+		MYSQL_RES* res = mysql_store_result(admin);
+		MYSQL_ROW row = mysql_fetch_row(res);
+		if (row && row[0]) {
+			backend = row[0];
+			// only the first interface is used
+			backend = backend.substr(0, backend.find(';'));
+		}
+		mysql_free_result(res);
+		if (backend.empty()) {
+			fprintf(stderr, "SQLite3 Server not enabled, start ProxySQL with '--sqlite3-server'\n");
+			mysql_close(admin);
+			return false;
+		}
+	}
+	const size_t colon = backend.rfind(':');
+	if (colon == string::npos) {
+		fprintf(stderr, "Invalid backend '%s', expected 'host:port'\n", backend.c_str());
+		mysql_close(admin);
+		return false;
+	}
+	const string b_host { backend.substr(0, colon) };
+	const string b_port { backend.substr(colon + 1) };
+	const string hg { std::to_string(opts.hostgroup) };
+
+	const vector<string> admin_queries {
+		"DELETE FROM mysql_users WHERE username='" + opts.user + "'",
+		"INSERT INTO mysql_users (username, password, default_hostgroup) VALUES ('" + opts.user + "', '" +
+			opts.password + "', " + hg + ")",
+		"DELETE FROM mysql_servers WHERE hostgroup_id=" + hg,
+		"INSERT INTO mysql_servers (hostgroup_id, hostname, port, max_connections) VALUES (" + hg + ", '" +
+			b_host + "', " + b_port + ", 10000)",
+		"LOAD MYSQL USERS TO RUNTIME",
+		"LOAD MYSQL SERVERS TO RUNTIME",
+	};
+	for (const string& q : admin_queries) {
+		if (run_query(admin, q) == false) {
+			mysql_close(admin);
+			return false;
+		}
+	}
+	mysql_close(admin);
+
+	MYSQL* mysql = mysql_init(NULL);
+	if (!mysql_real_connect(
+		mysql, opts.host.c_str(), opts.user.c_str(), opts.password.c_str(),
+		opts.schema.empty() ? NULL : opts.schema.c_str(), opts.port, NULL, 0
+	)) {
+		fprintf(stderr, "Unable to connect to ProxySQL: %s\n", mysql_error(mysql));
+		mysql_close(mysql);
+		return false;
+	}
+	bool ok =
+		run_query(mysql, "DROP TABLE IF EXISTS " BENCH_TABLE) &&
+		run_query(mysql,
+			"CREATE TABLE " BENCH_TABLE " (id INTEGER PRIMARY KEY, k INTEGER NOT NULL DEFAULT 0,"
+				" c CHAR(120) NOT NULL DEFAULT '', pad CHAR(60) NOT NULL DEFAULT '')"
+		) &&
+		run_query(mysql, "BEGIN");
+
+	std::mt19937 rnd { 1 };
+	for (int i = 1; ok && i <= opts.rows; ) {
+		string q { "INSERT INTO " BENCH_TABLE " (id, k, c, pad) VALUES " };
+		for (int j = 0; j < 1000 && i <= opts.rows; j++, i++) {
+			q += (j ? "," : "");
+			q += "(" + std::to_string(i) + "," + std::to_string(rnd() % opts.rows) + ",'" +
+				string(119, 'a' + rnd() % 26) + "','" + string(59, 'a' + rnd() % 26) + "')";
+		}
+		ok = run_query(mysql, q);
+	}
+	ok = ok && run_query(mysql, "COMMIT");
+	mysql_close(mysql);
+
+	return ok;
+}
+
+/******************************************************************************
+ * Main
+ ******************************************************************************/
+
+static void usage(const char* prog) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -h, --host HOST              ProxySQL MySQL interface host (default 127.0.0.1)\n"
+		"  -P, --port PORT              ProxySQL MySQL interface port (default 6033)\n"
+		"  -u, --user USER              Benchmark user (default bench)\n"
+		"  -p, --password PASS          Benchmark user password (default bench)\n"
+		"      --schema SCHEMA          Default schema (default none)\n"
+		"      --admin-host HOST        ProxySQL Admin host (default 127.0.0.1)\n"
+		"      --admin-port PORT        ProxySQL Admin port (default 6032)\n"
+		"      --admin-user USER        ProxySQL Admin user (default admin)\n"
+		"      --admin-password PASS    ProxySQL Admin password (default admin)\n"
+		"      --setup                  Configure ProxySQL and populate the benchmark table\n"
+		"      --backend HOST:PORT      Backend used by '--setup' (default: ProxySQL SQLite3 Server)\n"
+		"      --hostgroup HG           Hostgroup used by '--setup' (default 0)\n"
+		"  -w, --workloads LIST         Comma separated list of workloads (default point_select,\n"
+		"                               large_resultset,transaction,connect,tls). Also: prepared\n"
+		"  -t, --threads N              Client threads (default 4)\n"
+		"  -c, --connections N          Connections per thread (default 8)\n"
+		"  -d, --duration SECS          Measured duration per workload (default 10)\n"
+		"      --warmup SECS            Warmup per workload, not measured (default 2)\n"
+		"      --rows N                 Rows in the benchmark table (default 10000)\n"
+		"      --large-rows N           Rows per operation of 'large_resultset' (default 1000)\n"
+		"      --proxysql-pid PID       ProxySQL pid, to report its CPU time per operation\n"
+		"  -o, --output FILE            Write the JSON results to FILE instead of stdout\n",
+		prog
+	);
+}
+
+int main(int argc, char** argv) {
+	bench_opts_t opts {};
+
+	enum {
+		OPT_SCHEMA = 256, OPT_ADMIN_HOST, OPT_ADMIN_PORT, OPT_ADMIN_USER, OPT_ADMIN_PASSWORD, OPT_SETUP,
+		OPT_BACKEND, OPT_HOSTGROUP, OPT_WARMUP, OPT_ROWS, OPT_LARGE_ROWS, OPT_PROXYSQL_PID, OPT_HELP
+	};
+	static struct option long_opts[] = {
+		{ "host", required_argument, 0, 'h' },
+		{ "port", required_argument, 0, 'P' },
+		{ "user", required_argument, 0, 'u' },
+		{ "password", required_argument, 0, 'p' },
+		{ "schema", required_argument, 0, OPT_SCHEMA },
+		{ "admin-host", required_argument, 0, OPT_ADMIN_HOST },
+		{ "admin-port", required_argument, 0, OPT_ADMIN_PORT },
+		{ "admin-user", required_argument, 0, OPT_ADMIN_USER },
+		{ "admin-password", required_argument, 0, OPT_ADMIN_PASSWORD },
+		{ "setup", no_argument, 0, OPT_SETUP },
+		{ "backend", required_argument, 0, OPT_BACKEND },
+		{ "hostgroup", required_argument, 0, OPT_HOSTGROUP },
+		{ "workloads", required_argument, 0, 'w' },
+		{ "threads", required_argument, 0, 't' },
+		{ "connections", required_argument, 0, 'c' },
+		{ "duration", required_argument, 0, 'd' },
+		{ "warmup", required_argument, 0, OPT_WARMUP },
+		{ "rows", required_argument, 0, OPT_ROWS },
+		{ "large-rows", required_argument, 0, OPT_LARGE_ROWS },
+		{ "proxysql-pid", required_argument, 0, OPT_PROXYSQL_PID },
+		{ "output", required_argument, 0, 'o' },
+		{ "help", no_argument, 0, OPT_HELP },
+		{ 0, 0, 0, 0 }
+	};
+
+	int opt = 0;
+	while ((opt = getopt_long(argc, argv, "h:P:u:p:w:t:c:d:o:", long_opts, NULL)) != -1) {
+		switch (opt) {
+			case 'h': opts.host = optarg; break;
+			case 'P': opts.port = atoi(optarg); break;
+			case 'u': opts.user = optarg; break;
+			case 'p': opts.password = optarg; break;
+			case OPT_SCHEMA: opts.schema = optarg; break;
+			case OPT_ADMIN_HOST: opts.admin_host = optarg; break;
+			case OPT_ADMIN_PORT: opts.admin_port = atoi(optarg); break;
+			case OPT_ADMIN_USER: opts.admin_user = optarg; break;
+			case OPT_ADMIN_PASSWORD: opts.admin_password = optarg; break;
+			case OPT_SETUP: opts.setup = true; break;
+			case OPT_BACKEND: opts.backend = optarg; break;
+			case OPT_HOSTGROUP: opts.hostgroup = atoi(optarg); break;
+			case 'w': {
+				opts.workloads.clear();
+				string list { optarg };
+				size_t pos = 0;
+				while (pos <= list.size()) {
+					size_t next = list.find(',', pos);
+					if (next == string::npos) { next = list.size(); }
+					if (next > pos) { opts.workloads.push_back(list.substr(pos, next - pos)); }
+					pos = next + 1;
+				}
+				break;
+			}
+			case 't': opts.threads = atoi(optarg); break;
+			case 'c': opts.connections = atoi(optarg); break;
+			case 'd': opts.duration = atoi(optarg); break;
+			case OPT_WARMUP: opts.warmup = atoi(optarg); break;
+			case OPT_ROWS: opts.rows = atoi(optarg); break;
+			case OPT_LARGE_ROWS: opts.large_rows = atoi(optarg); break;
+			case OPT_PROXYSQL_PID: opts.proxysql_pid = atoi(optarg); break;
+			case 'o': opts.output = optarg; break;
+			default:
+				usage(argv[0]);
+				return opt == OPT_HELP ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (opts.threads < 1 || opts.connections < 1 || opts.duration < 1 || opts.warmup < 0 || opts.rows < 1 || opts.large_rows < 1) {
+		fprintf(stderr, "Invalid options\n");
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	vector<std::pair<string, workload_t>> workloads {};
+	for (const string& name : opts.workloads) {
+		workload_t w;
+		if (parse_workload(name, w) == false) {
+			fprintf(stderr, "Unknown workload '%s'\n", name.c_str());
+			return EXIT_FAILURE;
+		}
+		workloads.push_back({ name, w });
+	}
+
+	mysql_library_init(0, NULL, NULL);
+
+	if (opts.setup && setup(opts) == false) {
+		return EXIT_FAILURE;
+	}
+
+	vector<workload_result_t> results {};
+	for (const auto& w : workloads) {
+		fprintf(stderr, "Running workload '%s' for %ds (+%ds warmup)\n", w.first.c_str(), opts.duration, opts.warmup);
+		results.push_back(run_workload(opts, w.first, w.second));
+		const workload_result_t& r = results.back();
+		fprintf(stderr, "  ops: %lu  errors: %lu  p50: %.1fus  p99: %.1fus\n", r.ops, r.errors, r.p50_us, r.p99_us);
+	}
+
+	FILE* out = stdout;
+	if (!opts.output.empty()) {
+		out = fopen(opts.output.c_str(), "w");
+		if (out == NULL) {
+			fprintf(stderr, "Unable to open '%s': %s\n", opts.output.c_str(), strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+	print_results(out, opts, results);
+	if (out != stdout) {
+		fclose(out);
+	}
+
+	mysql_library_end();
+
+	// workloads with errors and no completed operation are considered failed
+	for (const workload_result_t& r : results) {
+		if (r.ops == 0) {
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
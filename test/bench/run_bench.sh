@@ -0,0 +1,77 @@
+#!/usr/bin/env bash
+#
+# Runs 'proxysql_bench' against a dedicated ProxySQL instance, using the SQLite3 Server of ProxySQL as
+# backend, so that no external service is required. The instance is started with a temporary datadir and
+# stopped at the end. All the arguments are passed to 'proxysql_bench', e.g.:
+#
+#   ./run_bench.sh --workloads point_select,tls --threads 8 --duration 30
+#
+# Environment:
+#   PROXYSQL          ProxySQL binary (default: ../../src/proxysql)
+#   BENCH_OUTPUT      JSON results file (default: ./bench_results.json)
+#   PROXYSQL_THREADS  'mysql-threads' of the instance (default: 4)
+#   ADMIN_PORT        Admin port of the instance (default: 16032)
+#   MYSQL_PORT        MySQL port of the instance (default: 16033)
+
+set -eu
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+PROXYSQL=${PROXYSQL:-$BENCH_DIR/../../src/proxysql}
+BENCH_OUTPUT=${BENCH_OUTPUT:-$BENCH_DIR/bench_results.json}
+PROXYSQL_THREADS=${PROXYSQL_THREADS:-4}
+ADMIN_PORT=${ADMIN_PORT:-16032}
+MYSQL_PORT=${MYSQL_PORT:-16033}
+
+if [ ! -x "$PROXYSQL" ]; then
+	echo "ProxySQL binary '$PROXYSQL' not found, build it first or set 'PROXYSQL'" >&2
+	exit 1
+fi
+
+DATADIR=$(mktemp -d /tmp/proxysql_bench.XXXXXX)
+PROXYSQL_PID=
+
+cleanup() {
+	if [ -n "$PROXYSQL_PID" ]; then
+		kill "$PROXYSQL_PID" 2>/dev/null || true
+		wait "$PROXYSQL_PID" 2>/dev/null || true
+	fi
+	rm -rf "$DATADIR"
+}
+trap cleanup EXIT
+
+cat > "$DATADIR/proxysql.cnf" <<EOF
+datadir="$DATADIR"
+admin_variables=
+{
+	admin_credentials="admin:admin"
+	mysql_ifaces="127.0.0.1:$ADMIN_PORT"
+}
+mysql_variables=
+{
+	threads=$PROXYSQL_THREADS
+	interfaces="127.0.0.1:$MYSQL_PORT"
+	monitor_enabled=false
+}
+EOF
+
+# '--sqlite3-server' enables the SQLite3 Server used as backend, monitoring isn't required
+"$PROXYSQL" -f -M --initial --no-version-check --sqlite3-server -c "$DATADIR/proxysql.cnf" -D "$DATADIR" \
+	> "$DATADIR/proxysql.out" 2>&1 &
+PROXYSQL_PID=$!
+
+for _ in $(seq 1 300); do
+	if (exec 3<>"/dev/tcp/127.0.0.1/$MYSQL_PORT") 2>/dev/null; then
+		break
+	fi
+	if ! kill -0 "$PROXYSQL_PID" 2>/dev/null; then
+		echo "ProxySQL exited during startup:" >&2
+		cat "$DATADIR/proxysql.out" >&2
+		exit 1
+	fi
+	sleep 0.1
+done
+
+"$BENCH_DIR/proxysql_bench" --setup --port "$MYSQL_PORT" --admin-port "$ADMIN_PORT" \
+	--proxysql-pid "$PROXYSQL_PID" --output "$BENCH_OUTPUT" "$@"
+
+echo "Results written to '$BENCH_OUTPUT'" >&2
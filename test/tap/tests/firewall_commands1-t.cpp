@@ -44,6 +44,8 @@ std::vector<std::string> queries = {
 	"PROXYSQLTEST 31 4",
 	"PROXYSQLTEST 31 4 1",
 	"PROXYSQLTEST 31 4 5",
+	"PROXYSQLTEST 31 5",
+	"PROXYSQLTEST 31 5 100",
 	"DELETE FROM history_mysql_query_digest",
 	"DELETE FROM mysql_firewall_whitelist_users",
 	"DELETE FROM mysql_firewall_whitelist_rules",
@@ -0,0 +1,144 @@
+ /**
+  * @file pgsql-bulk_data_rows-t.cpp
+  * @brief Checks that resultsets are returned unchanged when 'pgsql-bulk_data_rows' is enabled.
+  * @details With 'pgsql-bulk_data_rows' the consecutive DataRow messages received from the backend are copied
+  *   into the resultset as a single block. For each value of the variable, the test runs queries returning rows
+  *   of different sizes, some of them larger than the resultset buffer, and checks the number of rows and a
+  *   checksum of the values returned.
+  */
+
+#include <string>
+#include <sstream>
+#include "libpq-fe.h"
+#include "command_line.h"
+#include "tap.h"
+#include "utils.h"
+
+CommandLine cl;
+
+using PGConnPtr = std::unique_ptr<PGconn, decltype(&PQfinish)>;
+
+enum ConnType {
+    ADMIN,
+    BACKEND
+};
+
+PGConnPtr createNewConnection(ConnType conn_type, bool with_ssl) {
+
+    const char* host = (conn_type == BACKEND) ? cl.pgsql_host : cl.pgsql_admin_host;
+    int port = (conn_type == BACKEND) ? cl.pgsql_port : cl.pgsql_admin_port;
+    const char* username = (conn_type == BACKEND) ? cl.pgsql_username : cl.admin_username;
+    const char* password = (conn_type == BACKEND) ? cl.pgsql_password : cl.admin_password;
+
+    std::stringstream ss;
+
+    ss << "host=" << host << " port=" << port;
+    ss << " user=" << username << " password=" << password;
+    ss << (with_ssl ? " sslmode=require" : " sslmode=disable");
+
+    PGconn* conn = PQconnectdb(ss.str().c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        fprintf(stderr, "Connection failed to '%s': %s", (conn_type == BACKEND ? "Backend" : "Admin"), PQerrorMessage(conn));
+        PQfinish(conn);
+        return PGConnPtr(nullptr, &PQfinish);
+    }
+    return PGConnPtr(conn, &PQfinish);
+}
+
+bool executeQueries(PGconn* conn, const std::vector<std::string>& queries) {
+    for (const auto& query : queries) {
+        diag("Running: %s", query.c_str());
+        PGresult* res = PQexec(conn, query.c_str());
+        bool success = PQresultStatus(res) == PGRES_TUPLES_OK ||
+            PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!success) {
+            fprintf(stderr, "Failed to execute query '%s': %s",
+                query.c_str(), PQerrorMessage(conn));
+            PQclear(res);
+            return false;
+        }
+        PQclear(res);
+    }
+    return true;
+}
+
+struct test_query_t {
+    const char* query;
+    int exp_rows;
+};
+
+// every row is: id, text of variable length
+const std::vector<test_query_t> test_queries = {
+    { "SELECT i, md5(i::text) FROM generate_series(1, 200000) AS i", 200000 },
+    { "SELECT i, repeat('x', i % 100) FROM generate_series(1, 100000) AS i", 100000 },
+    { "SELECT i, repeat('y', 20000 + i) FROM generate_series(1, 200) AS i", 200 },
+    { "SELECT i, CASE WHEN i % 50 = 0 THEN repeat('z', 40000) ELSE NULL END FROM generate_series(1, 5000) AS i", 5000 }
+};
+
+// checksum of the values, independent of how they are framed by ProxySQL
+unsigned long long checksum(PGresult* res) {
+    unsigned long long sum = 0;
+    for (int i = 0; i < PQntuples(res); i++) {
+        sum += strtoull(PQgetvalue(res, i, 0), NULL, 10) * 31;
+        if (PQgetisnull(res, i, 1) == 0) {
+            const char* val = PQgetvalue(res, i, 1);
+            for (int j = 0; j < PQgetlength(res, i, 1); j++) {
+                sum = sum * 131 + (unsigned char)val[j];
+            }
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+
+    plan(test_queries.size() * 2);
+
+    if (cl.getEnv())
+        return exit_status();
+
+    PGConnPtr admin_conn = createNewConnection(ConnType::ADMIN, false);
+    PGConnPtr backend_conn = createNewConnection(ConnType::BACKEND, false);
+
+    if (!admin_conn || !backend_conn) {
+        BAIL_OUT("Error: failed to connect to the database in file %s, line %d\n", __FILE__, __LINE__);
+        return exit_status();
+    }
+
+    if (!executeQueries(admin_conn.get(), {
+        "DELETE FROM pgsql_query_rules",
+        "LOAD PGSQL QUERY RULES TO RUNTIME" }))
+        return exit_status();
+
+    // the reference values are collected with the per-row processing
+    std::vector<unsigned long long> exp_checksums {};
+    for (const std::string bulk : { "false", "true" }) {
+        if (!executeQueries(admin_conn.get(), {
+            "SET pgsql-bulk_data_rows=" + bulk,
+            "LOAD PGSQL VARIABLES TO RUNTIME" }))
+            return exit_status();
+
+        for (size_t i = 0; i < test_queries.size(); i++) {
+            PGresult* res = PQexec(backend_conn.get(), test_queries[i].query);
+            const int rows = PQresultStatus(res) == PGRES_TUPLES_OK ? PQntuples(res) : -1;
+            const unsigned long long sum = checksum(res);
+            PQclear(res);
+
+            if (bulk == "false") {
+                exp_checksums.push_back(sum);
+                ok(rows == test_queries[i].exp_rows, "Rows returned without bulk processing. Expected: %d. Actual: %d",
+                    test_queries[i].exp_rows, rows);
+            } else {
+                ok(rows == test_queries[i].exp_rows && sum == exp_checksums[i],
+                    "Same rows returned with bulk processing. Expected: %d. Actual: %d. Checksum match: %d",
+                    test_queries[i].exp_rows, rows, sum == exp_checksums[i]);
+            }
+        }
+    }
+
+    executeQueries(admin_conn.get(), {
+        "SET pgsql-bulk_data_rows=true",
+        "LOAD PGSQL VARIABLES TO RUNTIME" });
+
+    return exit_status();
+}
@@ -773,6 +773,60 @@ void testSTDIN_PERMANENT_FAST_FORWARD(PGconn* admin_conn, PGconn* conn, std::fst
     PQclear(PQgetResult(backend_conn.get()));
 }
 
+unsigned long long getCopyInStat(PGconn* admin_conn, const char* name) {
+    const std::string query = std::string("SELECT Variable_Value FROM stats_pgsql_global WHERE Variable_Name='") + name + "'";
+    PGresult* res = PQexec(admin_conn, query.c_str());
+    unsigned long long value = 0;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+        value = strtoull(PQgetvalue(res, 0, 0), NULL, 10);
+    } else {
+        diag("Failed to execute query `%s`: %s", query.c_str(), PQerrorMessage(admin_conn));
+    }
+    PQclear(res);
+    return value;
+}
+
+/**
+ * @brief Tests a COPY IN made of many small CopyData messages.
+ *
+ * Small messages are coalesced by ProxySQL before being sent to the backend. This test checks that all
+ * the rows are inserted, and that the 'Copy_In_rows' and 'Copy_In_bytes' counters in 'stats_pgsql_global'
+ * are updated accordingly.
+ *
+ * @param admin_conn The connection to the admin database.
+ * @param conn The connection to the target database.
+ * @param f_proxysql_log The log file stream for ProxySQL logs.
+ */
+void testSTDIN_MANY_ROWS(PGconn* admin_conn, PGconn* conn, std::fstream& f_proxysql_log) {
+    const unsigned int num_rows = 100000;
+    const unsigned long long rows_before = getCopyInStat(admin_conn, "Copy_In_rows");
+    const unsigned long long bytes_before = getCopyInStat(admin_conn, "Copy_In_bytes");
+
+    if (!executeQueries(conn, { "COPY copy_in_test(column1,column2,column3,column4,column5) FROM STDIN (FORMAT TEXT)" }))
+        return;
+
+    bool success = true;
+    unsigned long long bytes_sent = 0;
+    for (unsigned int i = 0; i < num_rows && success; i++) {
+        const std::string row = std::to_string(i) + "\tRow " + std::to_string(i) + "\t" + std::to_string(i % 1000) + ".50\tt\t2024-01-01\n";
+        success = sendCopyData(conn, row.c_str(), row.size(), (i == num_rows - 1));
+        bytes_sent += row.size();
+    }
+
+    PGresult* res = PQgetResult(conn);
+    const int row_count = atoi(PQcmdTuples(res));
+    ok(success && PQresultStatus(res) == PGRES_COMMAND_OK && row_count == num_rows,
+        "Total rows inserted: %d. Expected: %u. %s", row_count, num_rows, PQerrorMessage(conn));
+    PQclear(res);
+    // consume the final NULL result
+    PQclear(PQgetResult(conn));
+
+    const unsigned long long rows = getCopyInStat(admin_conn, "Copy_In_rows") - rows_before;
+    const unsigned long long bytes = getCopyInStat(admin_conn, "Copy_In_bytes") - bytes_before;
+    ok(rows == num_rows, "Copy_In_rows should be increased by the rows inserted. Expected: %u. Actual: %llu", num_rows, rows);
+    ok(bytes == bytes_sent, "Copy_In_bytes should be increased by the data sent. Expected: %llu. Actual: %llu", bytes_sent, bytes);
+}
+
 std::vector<std::pair<std::string, void (*)(PGconn*, PGconn*, std::fstream& f_proxysql_log)>> tests = {
     { "COPY ... FROM STDIN Text Format", testSTDIN_TEXT_FORMAT },
     { "COPY ... FROM STDIN Binary Format", testSTDIN_TEXT_BINARY },
@@ -781,6 +835,7 @@ std::vector<std::pair<std::string, void (*)(PGconn*, PGconn*, std::fstream& f_pr
     { "COPY ... FROM STDIN Transaction Error", testSTDIN_TRANSACTION_ERROR },
     { "COPY ... FROM STDIN File", testSTDIN_FILE },
     { "COPY ... FROM STDIN Multistatement", testSTDIN_MULTISTATEMENT },
+    { "COPY ... FROM STDIN Many Rows", testSTDIN_MANY_ROWS },
     { "COPY ... FROM STDIN Permanent Fast Forward", testSTDIN_PERMANENT_FAST_FORWARD }
 };
 
@@ -851,7 +906,7 @@ void execute_tests(bool with_ssl, bool diff_conn) {
 
 int main(int argc, char** argv) {
 
-    plan(46 * 2); // Total number of tests planned
+    plan(49 * 2); // Total number of tests planned
 
     if (cl.getEnv())
         return exit_status();
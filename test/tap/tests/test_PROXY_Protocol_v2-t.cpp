@@ -0,0 +1,169 @@
+/**
+ * @file test_PROXY_Protocol_v2-t.cpp
+ * @brief Checks the binary PROXY protocol header (v2), and the matching of 'mysql-proxy_protocol_networks'.
+ * @details The test connects sending binary PROXY headers, and verifies through 'PROXYSQL INTERNAL SESSION' that:
+ *   - TCP over IPv4 and IPv6 headers, including TLVs, override the client address ('PROXY_V2').
+ *   - A 'LOCAL' header is accepted, without overriding the client address.
+ *   - 'PROXY' headers with an unspecified, UDP or UNIX address family are accepted like 'LOCAL'.
+ *   - Headers are only accepted from clients in 'mysql-proxy_protocol_networks', for both v1 and v2 headers.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <arpa/inet.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+#include "json.hpp"
+
+using std::string;
+using std::vector;
+using namespace nlohmann;
+
+const char V2_SIG[] = "\r\n\r\n\0\r\nQUIT\n";
+
+string build_v2_header(unsigned char cmd, unsigned char fam, const vector<unsigned char>& addrs) {
+	string hdr { V2_SIG, 12 };
+	hdr += (char)(0x20 | cmd);
+	hdr += (char)fam;
+	hdr += (char)(addrs.size() >> 8);
+	hdr += (char)(addrs.size() & 0xFF);
+	hdr.append(addrs.begin(), addrs.end());
+	return hdr;
+}
+
+string build_v2_tcp4_header() {
+	vector<unsigned char> addrs { 192, 168, 0, 1, 192, 168, 0, 11, 0xDC, 0x04, 0x01, 0xBB };
+	// a NOOP TLV, to be skipped
+	vector<unsigned char> tlv { 0x04, 0x00, 0x03, 'a', 'b', 'c' };
+	addrs.insert(addrs.end(), tlv.begin(), tlv.end());
+	return build_v2_header(0x01, 0x11, addrs);
+}
+
+string build_v2_tcp6_header() {
+	vector<unsigned char> addrs(36, 0);
+	inet_pton(AF_INET6, "fe80::d6ae:52ff:fecf:9876", addrs.data());
+	inet_pton(AF_INET6, "fe80::d6ae:52aa:fecf:1234", addrs.data() + 16);
+	addrs[32] = 0xDC; addrs[33] = 0x04; addrs[34] = 0x01; addrs[35] = 0xBB;
+	return build_v2_header(0x01, 0x21, addrs);
+}
+
+/**
+ * @brief Connects sending 'hdr' as PROXY header, and returns the 'PROXY_V1'/'PROXY_V2' info of the session.
+ * @return False if the connection failed.
+ */
+bool connect_with_header(const CommandLine& cl, const string& hdr, json& j_v1, json& j_v2) {
+	MYSQL* proxy = mysql_init(NULL);
+	mysql_optionsv(proxy, MARIADB_OPT_PROXY_HEADER, hdr.data(), hdr.size());
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxy));
+		mysql_close(proxy);
+		return false;
+	}
+	if (mysql_query(proxy, "PROXYSQL INTERNAL SESSION")) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxy));
+		mysql_close(proxy);
+		return false;
+	}
+	MYSQL_RES* res = mysql_store_result(proxy);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	json j_status = json::parse(row[0]);
+	mysql_free_result(res);
+	mysql_close(proxy);
+
+	j_v1 = json {};
+	j_v2 = json {};
+	if (j_status.contains("client")) {
+		if (j_status["client"].contains("PROXY_V1")) j_v1 = j_status["client"]["PROXY_V1"];
+		if (j_status["client"].contains("PROXY_V2")) j_v2 = j_status["client"]["PROXY_V2"];
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(11);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const string hdr_v1 { "PROXY TCP4 192.168.0.1 192.168.0.11 56324 443\r\n" };
+	const string hdr_v2_tcp4 { build_v2_tcp4_header() };
+	const string hdr_v2_tcp6 { build_v2_tcp6_header() };
+	const string hdr_v2_local { build_v2_header(0x00, 0x00, {}) };
+	const string hdr_v2_unspec { build_v2_header(0x01, 0x00, {}) };
+	const string hdr_v2_udp4 {
+		build_v2_header(0x01, 0x12, { 192, 168, 0, 1, 192, 168, 0, 11, 0xDC, 0x04, 0x01, 0xBB })
+	};
+	// source and destination paths, 108 bytes each
+	vector<unsigned char> unix_paths(216, 0);
+	const string unix_path { "/tmp/proxysql_test.sock" };
+	std::copy(unix_path.begin(), unix_path.end(), unix_paths.begin());
+	const string hdr_v2_unix { build_v2_header(0x01, 0x31, unix_paths) };
+	json j_v1 {};
+	json j_v2 {};
+
+	MYSQL_QUERY_T(admin, "SET mysql-proxy_protocol_networks='*'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	bool rc = connect_with_header(cl, hdr_v2_tcp4, j_v1, j_v2);
+	ok(
+		rc && j_v2.value("source_address", "") == "192.168.0.1" && j_v2.value("source_port", 0) == 56324
+			&& j_v2.value("destination_port", 0) == 443,
+		"IPv4 v2 header accepted   PROXY_V2:'%s'", j_v2.dump().c_str()
+	);
+	rc = connect_with_header(cl, hdr_v2_tcp6, j_v1, j_v2);
+	ok(
+		rc && j_v2.value("source_address", "") == "fe80::d6ae:52ff:fecf:9876" && j_v2.value("source_port", 0) == 56324,
+		"IPv6 v2 header accepted   PROXY_V2:'%s'", j_v2.dump().c_str()
+	);
+	rc = connect_with_header(cl, hdr_v2_local, j_v1, j_v2);
+	ok(rc && j_v1.is_null() && j_v2.is_null(), "LOCAL v2 header accepted, without overriding the address");
+	rc = connect_with_header(cl, hdr_v2_unspec, j_v1, j_v2);
+	ok(rc && j_v1.is_null() && j_v2.is_null(), "UNSPEC v2 header accepted, without overriding the address");
+	rc = connect_with_header(cl, hdr_v2_udp4, j_v1, j_v2);
+	ok(rc && j_v1.is_null() && j_v2.is_null(), "UDP v2 header accepted, without overriding the address");
+	rc = connect_with_header(cl, hdr_v2_unix, j_v1, j_v2);
+	ok(rc && j_v1.is_null() && j_v2.is_null(), "UNIX v2 header accepted, without overriding the address");
+
+	// all the networks, through the compiled networks instead of '*'
+	MYSQL_QUERY_T(admin, "SET mysql-proxy_protocol_networks='0.0.0.0/0,::/0'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	rc = connect_with_header(cl, hdr_v2_tcp4, j_v1, j_v2);
+	ok(rc && j_v2.value("source_address", "") == "192.168.0.1", "v2 header accepted from a matching network");
+	rc = connect_with_header(cl, hdr_v1, j_v1, j_v2);
+	ok(rc && j_v1.value("source_address", "") == "192.168.0.1", "v1 header accepted from a matching network");
+
+	// documentation only networks (RFC 5737 and RFC 3849), not matching the client
+	MYSQL_QUERY_T(admin, "SET mysql-proxy_protocol_networks='192.0.2.0/24,2001:db8::/32'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	rc = connect_with_header(cl, hdr_v2_tcp4, j_v1, j_v2);
+	ok(rc && j_v2.is_null(), "v2 header skipped from a not matching network");
+	rc = connect_with_header(cl, hdr_v1, j_v1, j_v2);
+	ok(rc && j_v1.is_null(), "v1 header skipped from a not matching network");
+
+	MYSQL_QUERY_T(admin, "SET mysql-proxy_protocol_networks=''");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	rc = connect_with_header(cl, hdr_v2_tcp4, j_v1, j_v2);
+	ok(rc && j_v2.is_null(), "v2 header skipped with 'mysql-proxy_protocol_networks' empty");
+
+	mysql_close(admin);
+
+	return exit_status();
+}
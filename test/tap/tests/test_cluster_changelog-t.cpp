@@ -0,0 +1,148 @@
+/**
+ * @file test_cluster_changelog-t.cpp
+ * @brief Checks the changes served to Cluster peers for 'mysql_query_rules' and 'mysql_users'.
+ * @details Cluster peers fetch only the rows changed since the checksum they hold, when it's present in the
+ *   changelog of the node they sync from. This test, on a single node:
+ *   - Loads a change to the query rules and to the users, and checks the changes returned since the
+ *     previous checksum: the deleted and inserted rows.
+ *   - Checks that an unknown checksum returns an error, so that peers fall back to fetch the whole tables.
+ *   - Checks that 'admin-cluster_changelog_max_rows=0' disables the changelog.
+ */
+
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int RULE_ID = 9911;
+const char* USERNAME = "changelog_user";
+
+string get_checksum(MYSQL* admin, const string& name) {
+	const string q { "SELECT checksum FROM runtime_checksums_values WHERE name='" + name + "'" };
+	if (mysql_query(admin, q.c_str())) {
+		diag("Query failed: %s", mysql_error(admin));
+		return "";
+	}
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string checksum { row && row[0] ? row[0] : "" };
+	mysql_free_result(res);
+	return checksum;
+}
+
+/**
+ * @brief Fetches the changes since 'checksum', returning the 'op' and 'tbl' columns and the first field of
+ *   every row, or an error.
+ */
+int get_changes(MYSQL* admin, const string& module, const string& checksum, vector<string>& changes) {
+	const string q { "PROXY_SELECT CHANGES FROM " + module + " SINCE '" + checksum + "'" };
+	changes.clear();
+	if (mysql_query(admin, q.c_str())) {
+		diag("Query '%s' failed: %s", q.c_str(), mysql_error(admin));
+		return mysql_errno(admin);
+	}
+	MYSQL_RES* res = mysql_store_result(admin);
+	while (MYSQL_ROW row = mysql_fetch_row(res)) {
+		changes.push_back(string { row[0] } + ":" + row[1] + ":" + (row[2] ? row[2] : "NULL"));
+	}
+	mysql_free_result(res);
+	return 0;
+}
+
+string join(const vector<string>& v) {
+	string s {};
+	for (const string& e : v) {
+		s += (s.empty() ? "" : " ") + e;
+	}
+	return s;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(6);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const string rule_id { std::to_string(RULE_ID) };
+	MYSQL_QUERY_T(admin, "SET admin-cluster_changelog_max_rows=100000");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + rule_id).c_str());
+	MYSQL_QUERY_T(admin, (string { "DELETE FROM mysql_users WHERE username='" } + USERNAME + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+
+	vector<string> changes {};
+
+	// query rules: one rule inserted, then updated
+	const string qr_checksum_1 { get_checksum(admin, "mysql_query_rules") };
+	MYSQL_QUERY_T(admin,
+		("INSERT INTO mysql_query_rules (rule_id, active, match_digest, apply) VALUES (" + rule_id + ", 1, '^SELECT changelog', 0)").c_str()
+	);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, ("UPDATE mysql_query_rules SET apply=1 WHERE rule_id=" + rule_id).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+
+	int rc = get_changes(admin, "mysql_query_rules", qr_checksum_1, changes);
+	const string exp_qr_changes { "I:0:" + rule_id + " D:0:" + rule_id + " I:0:" + rule_id };
+	ok(rc == 0 && join(changes) == exp_qr_changes,
+		"Query rules changes since the first checksum   exp:'%s' act:'%s'", exp_qr_changes.c_str(), join(changes).c_str());
+
+	// users: one user inserted, as frontend and backend
+	const string users_checksum_1 { get_checksum(admin, "mysql_users") };
+	MYSQL_QUERY_T(admin,
+		(string { "INSERT INTO mysql_users (username, password, default_hostgroup) VALUES ('" } + USERNAME + "', 'pass', 0)").c_str()
+	);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+
+	rc = get_changes(admin, "mysql_users", users_checksum_1, changes);
+	const string exp_users_changes { string { "I:0:" } + USERNAME };
+	ok(rc == 0 && join(changes) == exp_users_changes,
+		"Users changes since the previous checksum   exp:'%s' act:'%s'", exp_users_changes.c_str(), join(changes).c_str());
+
+	// reloading without changes doesn't break the chain
+	MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+	rc = get_changes(admin, "mysql_users", users_checksum_1, changes);
+	ok(rc == 0 && join(changes) == exp_users_changes,
+		"Users changes unaffected by a reload without changes   act:'%s'", join(changes).c_str());
+
+	rc = get_changes(admin, "mysql_query_rules", "0x0123456789ABCDEF", changes);
+	ok(rc != 0, "Changes since an unknown checksum return an error   errno:%d", rc);
+
+	// the changes are discarded when the changelog is disabled
+	MYSQL_QUERY_T(admin, "SET admin-cluster_changelog_max_rows=0");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	rc = get_changes(admin, "mysql_query_rules", qr_checksum_1, changes);
+	ok(rc != 0, "Changes not available with 'admin-cluster_changelog_max_rows=0'   errno:%d", rc);
+
+	MYSQL_QUERY_T(admin, "SET admin-cluster_changelog_max_rows=100000");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	const string qr_checksum_2 { get_checksum(admin, "mysql_query_rules") };
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + rule_id).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	rc = get_changes(admin, "mysql_query_rules", qr_checksum_2, changes);
+	const string exp_qr_del { "D:0:" + rule_id };
+	ok(rc == 0 && join(changes) == exp_qr_del,
+		"Query rules changes recorded again once re-enabled   exp:'%s' act:'%s'", exp_qr_del.c_str(), join(changes).c_str());
+
+	MYSQL_QUERY_T(admin, (string { "DELETE FROM mysql_users WHERE username='" } + USERNAME + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
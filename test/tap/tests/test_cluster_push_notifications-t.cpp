@@ -0,0 +1,84 @@
+/**
+ * @file test_cluster_push_notifications-t.cpp
+ * @brief Checks the admin side of the Cluster push notifications ('PROXYSQL CLUSTER_NOTIFY').
+ * @details Nodes notify their peers of configuration changes on the connection of their monitor threads,
+ *   after identifying themselves with 'PROXYSQL CLUSTER_NODE_UUID'. This test, on a single node:
+ *   - Checks that a notification received before 'PROXYSQL CLUSTER_NODE_UUID' is rejected.
+ *   - Checks that a notification received after 'PROXYSQL CLUSTER_NODE_UUID' is accepted.
+ *   - Checks the range of 'admin-cluster_push_fanout'.
+ *   - Checks that 'stats_proxysql_servers_metrics' reports the push and convergence metrics.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const char* NODE_UUID = "2ec0fbb5-8f4d-4b8c-a0a1-0c6f1b5b7d11";
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	int rc = mysql_query(admin, "PROXYSQL CLUSTER_NOTIFY");
+	ok(rc != 0, "Notification rejected before 'PROXYSQL CLUSTER_NODE_UUID'   err:'%s'", mysql_error(admin));
+
+	MYSQL* node = mysql_init(NULL);
+	if (!mysql_real_connect(node, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(node));
+		return exit_status();
+	}
+	const string q_uuid {
+		string { "PROXYSQL CLUSTER_NODE_UUID " } + NODE_UUID + " 127.0.0.1:" + std::to_string(cl.admin_port)
+	};
+	MYSQL_QUERY_T(node, q_uuid.c_str());
+	rc = mysql_query(node, "PROXYSQL CLUSTER_NOTIFY");
+	ok(rc == 0, "Notification accepted after 'PROXYSQL CLUSTER_NODE_UUID'   err:'%s'", mysql_error(node));
+	mysql_close(node);
+
+	rc = mysql_query(admin, "SET admin-cluster_push_fanout=0");
+	const string q_fanout {
+		"SELECT variable_value FROM global_variables WHERE variable_name='admin-cluster_push_fanout'"
+	};
+	const ext_val_t<int64_t> fanout { mysql_query_ext_val(admin, q_fanout, int64_t(-1)) };
+	ok(fanout.err == 0 && fanout.val >= 1, "Fanout '0' is rejected   fanout:%ld", fanout.val);
+
+	MYSQL_QUERY_T(admin, "SET admin-cluster_push_notifications='true'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	const string q_push {
+		"SELECT variable_value FROM runtime_global_variables WHERE variable_name='admin-cluster_push_notifications'"
+	};
+	const ext_val_t<string> push { mysql_query_ext_val(admin, q_push, string {}) };
+	ok(push.err == 0 && push.val == "true", "Push notifications enabled at runtime   val:'%s'", push.val.c_str());
+
+	rc = mysql_query(admin,
+		"SELECT hostname, port, Push_Notifications_sent, Push_Notifications_received, Last_Sync_Lag_ms,"
+			" Last_Sync_Age_s FROM stats_proxysql_servers_metrics"
+	);
+	if (rc == 0) {
+		mysql_free_result(mysql_store_result(admin));
+	}
+	ok(rc == 0, "Push and convergence metrics present in 'stats_proxysql_servers_metrics'   err:'%s'", mysql_error(admin));
+
+	MYSQL_QUERY_T(admin, "SET admin-cluster_push_notifications='false'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
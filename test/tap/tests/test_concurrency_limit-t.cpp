@@ -0,0 +1,181 @@
+/**
+ * @file test_concurrency_limit-t.cpp
+ * @brief Checks the concurrency limits set by the query rules attribute 'max_concurrency' and by the users
+ *   attribute 'max_concurrent_queries'.
+ * @details A query rule limits 'SELECT SLEEP()' queries to 2 concurrent executions, while the user has a limit
+ *   high enough not to be hit. The test checks that:
+ *   - Concurrent queries over the limit are queued and all complete, taking at least the serialized time.
+ *   - The queries of the same user not matching the rule are not queued while others wait for the rule limit.
+ *   - With 'mysql-concurrency_limit_queue_timeout_ms=0' the queries over the limit are rejected.
+ *   - The counters 'Concurrency_limit_queued' and 'Concurrency_limit_rejected' are updated.
+ *   - Without the rule, the user attribute 'max_concurrent_queries' limits the queries the same way.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int RULE_ID = 49;
+const int MAX_CONCURRENCY = 2;
+const int USER_MAX_CONCURRENCY = 100;
+const int NUM_CLIENTS = 6;
+const int NUM_UNLIMITED = 10;
+const char QUERY[] = "SELECT /* test_concurrency_limit */ SLEEP(0.5)";
+const char USER_QUERY[] = "SELECT /* user limit */ SLEEP(0.5)";
+
+uint64_t get_global_status(MYSQL* admin, const char* name) {
+	const ext_val_t<uint64_t> val {
+		mysql_query_ext_val(admin,
+			string("SELECT variable_value FROM stats_mysql_global WHERE variable_name='") + name + "'", uint64_t(0))
+	};
+	if (val.err) {
+		const string err { get_ext_val_err(admin, val) };
+		diag("Fetching '%s' failed   err:'%s'", name, err.c_str());
+	}
+	return val.val;
+}
+
+/**
+ * @brief Runs 'query' from NUM_CLIENTS concurrent connections, returns the number of failed queries.
+ */
+int run_concurrent_queries(const CommandLine& cl, const char* query = QUERY) {
+	std::atomic<int> failures { 0 };
+	std::vector<std::thread> clients {};
+	for (int i = 0; i < NUM_CLIENTS; i++) {
+		clients.push_back(std::thread([&cl, &failures, query]() {
+			MYSQL* proxy = mysql_init(NULL);
+			if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+				diag("Connection failed: %s", mysql_error(proxy));
+				failures++;
+				mysql_close(proxy);
+				return;
+			}
+			if (mysql_query(proxy, query)) {
+				diag("Query failed   errno:%d error:'%s'", mysql_errno(proxy), mysql_error(proxy));
+				failures++;
+			} else {
+				mysql_free_result(mysql_store_result(proxy));
+			}
+			mysql_close(proxy);
+		}));
+	}
+	for (std::thread& c : clients) {
+		c.join();
+	}
+	return failures;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(7);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin,
+		("INSERT INTO mysql_query_rules (rule_id,active,match_pattern,attributes,apply) VALUES (" +
+		std::to_string(RULE_ID) + ",1,'test_concurrency_limit','{\"max_concurrency\":" +
+		std::to_string(MAX_CONCURRENCY) + "}',1)").c_str()
+	);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SET mysql-concurrency_limit_queue_timeout_ms=5000");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	const string user_filter { " WHERE username='" + string(cl.username) + "'" };
+	const ext_val_t<string> user_attributes {
+		mysql_query_ext_val(admin, "SELECT attributes FROM mysql_users" + user_filter + " LIMIT 1", string())
+	};
+	const auto set_user_limit = [&] (int limit) -> int {
+		MYSQL_QUERY_T(admin,
+			("UPDATE mysql_users SET attributes='{\"max_concurrent_queries\":" + std::to_string(limit) + "}'" +
+			user_filter).c_str()
+		);
+		MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+		return EXIT_SUCCESS;
+	};
+	if (set_user_limit(USER_MAX_CONCURRENCY)) {
+		return exit_status();
+	}
+
+	// queries over the limit are queued, while the other queries of the user are not
+	uint64_t queued = get_global_status(admin, "Concurrency_limit_queued");
+	const unsigned long long start = monotonic_time();
+	std::thread unlimited_client([&cl]() {
+		usleep(100 * 1000);
+		MYSQL* proxy = mysql_init(NULL);
+		if (mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			for (int i = 0; i < NUM_UNLIMITED; i++) {
+				if (mysql_query(proxy, "SELECT 1") == 0) {
+					mysql_free_result(mysql_store_result(proxy));
+				}
+			}
+		}
+		mysql_close(proxy);
+	});
+	int failures = run_concurrent_queries(cl);
+	unlimited_client.join();
+	const unsigned long long elapsed_ms = (monotonic_time() - start) / 1000;
+	queued = get_global_status(admin, "Concurrency_limit_queued") - queued;
+	const unsigned long long min_ms = (NUM_CLIENTS / MAX_CONCURRENCY) * 500;
+	ok(failures == 0 && elapsed_ms >= min_ms,
+		"Queued queries completed, serialized by the limit   failures:%d elapsed:%llums min:%llums",
+		failures, elapsed_ms, min_ms);
+	ok(queued >= NUM_CLIENTS - MAX_CONCURRENCY, "Queries over the limit queued   queued:%lu", queued);
+	ok(queued <= NUM_CLIENTS - MAX_CONCURRENCY, "Queries not matching the rule not queued   queued:%lu", queued);
+
+	// without queueing, queries over the limit are rejected
+	MYSQL_QUERY_T(admin, "SET mysql-concurrency_limit_queue_timeout_ms=0");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	uint64_t rejected = get_global_status(admin, "Concurrency_limit_rejected");
+	failures = run_concurrent_queries(cl);
+	rejected = get_global_status(admin, "Concurrency_limit_rejected") - rejected;
+	ok(failures > 0 && failures <= NUM_CLIENTS - MAX_CONCURRENCY,
+		"Queries over the limit rejected   failures:%d", failures);
+	ok(rejected == (uint64_t)failures, "Rejections counted   rejected:%lu", rejected);
+
+	// the limit of the user, without the rule
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SET mysql-concurrency_limit_queue_timeout_ms=5000");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	if (set_user_limit(MAX_CONCURRENCY)) {
+		return exit_status();
+	}
+	{
+		uint64_t queued = get_global_status(admin, "Concurrency_limit_queued");
+		const unsigned long long start = monotonic_time();
+		const int failures = run_concurrent_queries(cl, USER_QUERY);
+		const unsigned long long elapsed_ms = (monotonic_time() - start) / 1000;
+		queued = get_global_status(admin, "Concurrency_limit_queued") - queued;
+		ok(failures == 0 && elapsed_ms >= min_ms && queued == NUM_CLIENTS - MAX_CONCURRENCY,
+			"Queries over 'max_concurrent_queries' queued and serialized   failures:%d elapsed:%llums min:%llums"
+			" queued:%lu", failures, elapsed_ms, min_ms, queued);
+	}
+
+	MYSQL_QUERY_T(admin,
+		("UPDATE mysql_users SET attributes='" + user_attributes.val + "'" + user_filter).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL USERS TO RUNTIME");
+
+	mysql_close(admin);
+
+	return exit_status();
+}
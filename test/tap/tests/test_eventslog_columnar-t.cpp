@@ -0,0 +1,155 @@
+/**
+ * @file test_eventslog_columnar-t.cpp
+ * @brief Checks the columnar format of the events log ('mysql-eventslog_format=3').
+ * @details Logs a few queries with the columnar format, rotates the file with 'PROXYSQL FLUSH LOGS', and
+ *   reads the closed file back with the reader of 'eventslog_columnar.h' checking that:
+ *   - The file was completed with the block index.
+ *   - All the queries were logged, with the expected username and digest.
+ *
+ *   The digests are only computed with 'mysql-query_digests', enabled for the test and restored.
+ */
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+#include "eventslog_columnar.h"
+
+using std::string;
+using namespace eventslog_columnar;
+
+const char LOG_FILENAME[] = "logcolumnar.log";
+const int NUM_QUERIES = 10;
+
+/**
+ * @brief Returns the highest id of the files '<LOG_FILENAME>.<id>' in 'datadir', 0 if there are none.
+ */
+unsigned int get_last_log_id(const char *datadir) {
+	unsigned int max_id = 0;
+	const size_t prefix_len = strlen(LOG_FILENAME);
+	DIR *dir = opendir(datadir);
+	if (dir == NULL) {
+		return 0;
+	}
+	struct dirent *ent = NULL;
+	while ((ent = readdir(dir)) != NULL) {
+		if (strncmp(ent->d_name, LOG_FILENAME, prefix_len) == 0 && ent->d_name[prefix_len] == '.') {
+			unsigned int id = strtoul(ent->d_name + prefix_len + 1, NULL, 10);
+			if (id > max_id) {
+				max_id = id;
+			}
+		}
+	}
+	closedir(dir);
+	return max_id;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	const char *datadir = getenv("REGULAR_INFRA_DATADIR");
+	if (datadir == NULL) {
+		diag("ERROR: Missing REGULAR_INFRA_DATADIR");
+		return -1;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const ext_val_t<string> query_digests {
+		mysql_query_ext_val(admin,
+			"SELECT variable_value FROM global_variables WHERE variable_name='mysql-query_digests'", string("true"))
+	};
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests='true'");
+	MYSQL_QUERY_T(admin, (string("SET mysql-eventslog_filename='") + LOG_FILENAME + "'").c_str());
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_default_log=1");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_format=3");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	const unsigned int log_id = get_last_log_id(datadir);
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		MYSQL_QUERY_T(proxy, ("SELECT /* test_eventslog_columnar */ " + std::to_string(i)).c_str());
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	// closes the file, writing the pending block and the block index
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+
+	char f_path[PATH_MAX];
+	snprintf(f_path, sizeof(f_path), "%s/%s.%08u", datadir, LOG_FILENAME, log_id);
+	diag("Reading file %s", f_path);
+
+	Reader reader {};
+	string err {};
+	bool opened = reader.open(f_path, err);
+	ok(opened, "File in columnar format   err:'%s'", err.c_str());
+	ok(reader.indexed, "File completed with the block index   blocks:%lu", reader.get_blocks().size());
+
+	int logged = 0;
+	int user_mismatch = 0;
+	uint64_t digest = 0;
+	int digest_mismatch = 0;
+	for (const block_info_t& info : reader.get_blocks()) {
+		Block blk {};
+		column_data_t queries {};
+		column_data_t users {};
+		column_data_t digests {};
+		if (!reader.read_block(info, blk) || !blk.column("query", queries) || !blk.column("username", users) ||
+			!blk.column("digest", digests)
+		) {
+			diag("Failed to read block at offset %lu", info.offset);
+			continue;
+		}
+		for (uint32_t r = 0; r < blk.info.rows; r++) {
+			if (queries.strs[r].find("test_eventslog_columnar") == string::npos) {
+				continue;
+			}
+			logged++;
+			if (users.strs[r] != cl.username) {
+				user_mismatch++;
+			}
+			if (digest == 0) {
+				digest = digests.ints[r];
+			} else if (digests.ints[r] != digest) {
+				digest_mismatch++;
+			}
+		}
+	}
+	ok(logged == NUM_QUERIES && user_mismatch == 0, "Logged queries with the client username   exp:%d act:%d mismatches:%d",
+		NUM_QUERIES, logged, user_mismatch);
+	ok(digest != 0 && digest_mismatch == 0, "Logged queries with the same digest   digest:0x%016lX mismatches:%d",
+		digest, digest_mismatch);
+
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_format=1");
+	MYSQL_QUERY_T(admin, ("SET mysql-query_digests='" + query_digests.val + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
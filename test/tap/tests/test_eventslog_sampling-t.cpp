@@ -0,0 +1,153 @@
+/**
+ * @file test_eventslog_sampling-t.cpp
+ * @brief Checks the sampling of the events log: 'mysql-eventslog_sample_rate', 'mysql-eventslog_digest_rate_limit'
+ *   and 'mysql-eventslog_slow_query_threshold'.
+ * @details With 'mysql-eventslog_default_log=1' and the JSON format, the test checks that:
+ *   - A burst of queries with the same digest is capped to the rate limit.
+ *   - With a sample rate of 1-in-1000000, a burst of queries is (almost certainly) not logged.
+ *   - A query slower than the threshold is logged regardless of the sample rate.
+ */
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const char LOG_FILENAME[] = "logsampling.log";
+const int NUM_QUERIES = 50;
+const int RATE_LIMIT = 5;
+
+/**
+ * @brief Returns the highest id of the files '<LOG_FILENAME>.<id>' in 'datadir', 0 if there are none.
+ */
+unsigned int get_last_log_id(const char *datadir) {
+	unsigned int max_id = 0;
+	const size_t prefix_len = strlen(LOG_FILENAME);
+	DIR *dir = opendir(datadir);
+	if (dir == NULL) {
+		return 0;
+	}
+	struct dirent *ent = NULL;
+	while ((ent = readdir(dir)) != NULL) {
+		if (strncmp(ent->d_name, LOG_FILENAME, prefix_len) == 0 && ent->d_name[prefix_len] == '.') {
+			unsigned int id = strtoul(ent->d_name + prefix_len + 1, NULL, 10);
+			if (id > max_id) {
+				max_id = id;
+			}
+		}
+	}
+	closedir(dir);
+	return max_id;
+}
+
+/**
+ * @brief Returns the number of lines of events log 'log_id' containing 'marker', or -1 if it can't be read.
+ */
+int count_logged(const char *datadir, unsigned int log_id, const char *marker) {
+	char f_path[PATH_MAX];
+	snprintf(f_path, sizeof(f_path), "%s/%s.%08u", datadir, LOG_FILENAME, log_id);
+	std::ifstream querylog(f_path);
+	if (querylog.is_open() == false) {
+		diag("Failed to open file %s", f_path);
+		return -1;
+	}
+	int count = 0;
+	string line {};
+	while (getline(querylog, line)) {
+		if (line.find(marker) != string::npos) {
+			count++;
+		}
+	}
+	return count;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	const char *datadir = getenv("REGULAR_INFRA_DATADIR");
+	if (datadir == NULL) {
+		diag("ERROR: Missing REGULAR_INFRA_DATADIR");
+		return -1;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, (string("SET mysql-eventslog_filename='") + LOG_FILENAME + "'").c_str());
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_default_log=1");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_format=2");
+	MYSQL_QUERY_T(admin, ("SET mysql-eventslog_digest_rate_limit=" + std::to_string(RATE_LIMIT)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	// a burst of queries with the same digest, capped to the rate limit
+	unsigned int log_id = get_last_log_id(datadir);
+	const unsigned long long start = monotonic_time();
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		MYSQL_QUERY_T(proxy, ("SELECT /* test_eventslog_rate_limit */ " + std::to_string(i)).c_str());
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	const unsigned long long elapsed_s = (monotonic_time() - start) / 1000000;
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+	int logged = count_logged(datadir, log_id, "test_eventslog_rate_limit");
+	int max_logged = RATE_LIMIT * (elapsed_s + 2);
+	ok(logged > 0 && logged <= max_logged, "Burst capped by 'eventslog_digest_rate_limit'   logged:%d max:%d", logged, max_logged);
+
+	// 1-in-1000000 sampling, and slow queries logged regardless of it
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_digest_rate_limit=0");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_sample_rate=1000000");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_slow_query_threshold=100");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+
+	log_id = get_last_log_id(datadir);
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		MYSQL_QUERY_T(proxy, ("SELECT /* test_eventslog_sample_rate */ " + std::to_string(i)).c_str());
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	MYSQL_QUERY_T(proxy, "SELECT /* test_eventslog_slow_query */ SLEEP(0.3)");
+	mysql_free_result(mysql_store_result(proxy));
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH LOGS");
+
+	logged = count_logged(datadir, log_id, "test_eventslog_sample_rate");
+	ok(logged >= 0 && logged <= 1, "Queries sampled by 'eventslog_sample_rate'   logged:%d", logged);
+	logged = count_logged(datadir, log_id, "test_eventslog_slow_query");
+	ok(logged == 1, "Slow query logged despite the sample rate   logged:%d", logged);
+
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_sample_rate=1");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_slow_query_threshold=0");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_default_log=0");
+	MYSQL_QUERY_T(admin, "SET mysql-eventslog_format=1");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
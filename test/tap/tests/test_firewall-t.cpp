@@ -17,7 +17,7 @@ int main(int argc, char** argv) {
 	if(cl.getEnv())
 		return exit_status();
 
-	plan(7);
+	plan(9);
 	diag("Testing firewall whitelist functionality");
 
 	MYSQL* mysqladmin = mysql_init(NULL);
@@ -139,6 +139,33 @@ int main(int argc, char** argv) {
 		ok(false, "Query should be allowed by firewall, but it is blocked after active=1 update");
 	}
 
+	// A new whitelist is seen by the next query of an existing session, also after the session was idle long
+	// enough for its thread to drop the previous whitelist cached by the session
+	MYSQL_QUERY(mysqladmin, "update mysql_firewall_whitelist_users set mode='OFF'");
+	MYSQL_QUERY(mysqladmin, "load mysql firewall to runtime");
+	sleep(2);
+
+	if (!mysql_query(mysql, "select @@version")) {
+		ok(true, "Query is allowed by the new whitelist in the existing session after mode='OFF'");
+		result = mysql_store_result(mysql);
+		mysql_free_result(result);
+	}
+	else {
+		ok(false, "Query should be allowed by the new whitelist, but it is blocked   err:'%s'", mysql_error(mysql));
+	}
+
+	MYSQL_QUERY(mysqladmin, "update mysql_firewall_whitelist_users set mode='PROTECTING'");
+	MYSQL_QUERY(mysqladmin, "load mysql firewall to runtime");
+
+	if (mysql_query(mysql, "select @@version")) {
+		ok(mysql_errno(mysql) == 1148, "Query is blocked by the new whitelist in the existing session after mode='PROTECTING'");
+	}
+	else {
+		ok(false, "Query should be blocked by the new whitelist, but it is allowed");
+		result = mysql_store_result(mysql);
+		mysql_free_result(result);
+	}
+
 	// Cleanup firewall rules
 	MYSQL_QUERY(mysqladmin, "load mysql firewall from disk");
 	MYSQL_QUERY(mysqladmin, "load mysql firewall to runtime");
@@ -0,0 +1,160 @@
+/**
+ * @file test_gtid_read_your_writes-t.cpp
+ * @brief Checks the read-your-writes routing of 'mysql-gtid_read_your_writes'.
+ * @details A query rule sends the reads of the test table to the reader hostgroup (1). After each INSERT,
+ *   executed in the default hostgroup of the user (the writer), the read must see the written row. The rule
+ *   uses 'match_pattern', so the test doesn't depend on 'mysql-query_digests'. The constraint only applies to
+ *   the reader hostgroup paired with the writer hostgroup, the test is skipped if they aren't paired.
+ *   When no server of the reader hostgroup has GTID tracking ('gtid_port'), the GTID of the write can never be
+ *   found there: the read must be sent to the writer immediately, without waiting for
+ *   'mysql-gtid_read_your_writes_timeout_ms'. This is checked through '@@server_id', the latency of the reads
+ *   and the counters 'GTID_read_your_writes_delayed' and 'GTID_read_your_writes_fallback'.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_WRITES = 20;
+const int RULE_ID = 48;
+const int READER_HG = 1;
+const int TIMEOUT_MS = 2000;
+const char* SELECT_QUERY = "SELECT COUNT(*), @@server_id FROM test.gtid_read_your_writes";
+
+uint64_t get_global_stat(MYSQL* admin, const string& name) {
+	const ext_val_t<uint64_t> val {
+		mysql_query_ext_val(admin,
+			("SELECT variable_value FROM stats_mysql_global WHERE variable_name='" + name + "'").c_str(), uint64_t(0))
+	};
+	return val.val;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-gtid_read_your_writes='true'");
+	MYSQL_QUERY_T(admin, ("SET mysql-gtid_read_your_writes_timeout_ms=" + std::to_string(TIMEOUT_MS)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin,
+		("INSERT INTO mysql_query_rules (rule_id,active,match_pattern,destination_hostgroup,apply) VALUES (" +
+		std::to_string(RULE_ID) + ",1,'^SELECT COUNT\\(\\*\\), @@server_id FROM test.gtid_read_your_writes'," +
+		std::to_string(READER_HG) + ",1)").c_str()
+	);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+
+	const ext_val_t<uint64_t> tracked_readers {
+		mysql_query_ext_val(admin,
+			("SELECT COUNT(*) FROM runtime_mysql_servers WHERE status='ONLINE' AND gtid_port>0 AND hostgroup_id=" +
+			std::to_string(READER_HG)).c_str(), uint64_t(0))
+	};
+
+	const ext_val_t<uint64_t> paired {
+		mysql_query_ext_val(admin,
+			("SELECT COUNT(*) FROM runtime_mysql_replication_hostgroups WHERE reader_hostgroup=" +
+			std::to_string(READER_HG) + " AND writer_hostgroup=(SELECT default_hostgroup FROM runtime_mysql_users"
+			" WHERE username='" + string(cl.username) + "' LIMIT 1)").c_str(), uint64_t(0))
+	};
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	// queries not matching the rule are executed in the hostgroup of the writes
+	const ext_val_t<uint64_t> writer_id { mysql_query_ext_val(proxy, "SELECT @@server_id", uint64_t(0)) };
+	const ext_val_t<string> gtid_mode { mysql_query_ext_val(proxy, "SELECT @@gtid_mode", string()) };
+	if (writer_id.err || gtid_mode.err || gtid_mode.val != "ON") {
+		skip(4, "GTIDs are not enabled on the writer   gtid_mode:'%s'", gtid_mode.str.c_str());
+		goto cleanup;
+	}
+	if (paired.val == 0) {
+		skip(4, "Hostgroup %d isn't the reader hostgroup of the default hostgroup of the user", READER_HG);
+		goto cleanup;
+	}
+
+	MYSQL_QUERY_T(proxy, "CREATE DATABASE IF NOT EXISTS test");
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.gtid_read_your_writes");
+	MYSQL_QUERY_T(proxy, "CREATE TABLE test.gtid_read_your_writes (id INT AUTO_INCREMENT PRIMARY KEY, v INT)");
+
+	{
+		const uint64_t delayed_before = get_global_stat(admin, "GTID_read_your_writes_delayed");
+		const uint64_t fallback_before = get_global_stat(admin, "GTID_read_your_writes_fallback");
+
+		int not_visible = 0;
+		int on_writer = 0;
+		unsigned long long max_read_us = 0;
+		for (int i = 0; i < NUM_WRITES; i++) {
+			MYSQL_QUERY_T(proxy, ("INSERT INTO test.gtid_read_your_writes (v) VALUES (" + std::to_string(i) + ")").c_str());
+
+			const unsigned long long start = monotonic_time();
+			MYSQL_QUERY_T(proxy, SELECT_QUERY);
+			MYSQL_RES* res = mysql_store_result(proxy);
+			MYSQL_ROW row = res ? mysql_fetch_row(res) : NULL;
+			const unsigned long long read_us = monotonic_time() - start;
+			if (read_us > max_read_us) {
+				max_read_us = read_us;
+			}
+
+			const uint64_t rows = (row && row[0]) ? std::stoull(row[0]) : 0;
+			const uint64_t server_id = (row && row[1]) ? std::stoull(row[1]) : 0;
+			if (rows != uint64_t(i + 1)) {
+				diag("Write not visible   expected:%d rows:%lu server_id:%lu", i + 1, rows, server_id);
+				not_visible++;
+			}
+			if (server_id == writer_id.val) {
+				on_writer++;
+			}
+			mysql_free_result(res);
+		}
+		ok(not_visible == 0, "Every read saw the previous write of the session   not_visible:%d", not_visible);
+
+		const uint64_t delayed = get_global_stat(admin, "GTID_read_your_writes_delayed") - delayed_before;
+		const uint64_t fallback = get_global_stat(admin, "GTID_read_your_writes_fallback") - fallback_before;
+
+		if (tracked_readers.val) {
+			skip(3, "The reader hostgroup has GTID tracking, the reads can be served by the readers   tracked:%lu",
+				tracked_readers.val);
+		} else {
+			ok(on_writer == NUM_WRITES, "Reads routed to the writer   writer_id:%lu on_writer:%d expected:%d",
+				writer_id.val, on_writer, NUM_WRITES);
+			ok(max_read_us < (unsigned long long)TIMEOUT_MS * 1000 / 2,
+				"Reads not delayed by the GTID wait   max_read_us:%llu timeout_ms:%d", max_read_us, TIMEOUT_MS);
+			ok(delayed == 0 && fallback == uint64_t(NUM_WRITES),
+				"Immediate fallbacks reported   delayed:%lu fallback:%lu expected:%d", delayed, fallback, NUM_WRITES);
+		}
+	}
+
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.gtid_read_your_writes");
+
+cleanup:
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SET mysql-gtid_read_your_writes='false'");
+	MYSQL_QUERY_T(admin, "SET mysql-gtid_read_your_writes_timeout_ms=1000");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_multiplex_affinity-t.cpp
+ * @brief Checks the learning of the per digest connection affinity: 'mysql-multiplex_affinity_learning'.
+ * @details With 'mysql-auto_increment_delay_multiplex=1' and 'mysql-multiplex_affinity_min_samples=5', the
+ *   test checks that (learning is per digest, 'mysql-query_digests' is enabled for the test; the original values
+ *   of the modified variables are restored):
+ *   - An INSERT generating an auto increment id, never followed by 'LAST_INSERT_ID()', stops pinning the
+ *     connection once learned: 'Multiplex_affinity_released' increases.
+ *   - An INSERT followed by a query using 'LAST_INSERT_ID()' on the backend is counted in
+ *     'Multiplex_affinity_repinned', and the digest is pinned again.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int MIN_SAMPLES = 5;
+
+uint64_t get_global_status(MYSQL* admin, const char* name) {
+	const ext_val_t<uint64_t> val {
+		mysql_query_ext_val(admin,
+			string("SELECT variable_value FROM stats_mysql_global WHERE variable_name='") + name + "'", uint64_t(0))
+	};
+	if (val.err) {
+		const string err { get_ext_val_err(admin, val) };
+		diag("Fetching '%s' failed   err:'%s'", name, err.c_str());
+	}
+	return val.val;
+}
+
+string get_global_variable(MYSQL* admin, const char* name, const string& def) {
+	const ext_val_t<string> val {
+		mysql_query_ext_val(admin,
+			string("SELECT variable_value FROM global_variables WHERE variable_name='") + name + "'", def)
+	};
+	return val.val;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const string query_digests { get_global_variable(admin, "mysql-query_digests", "true") };
+	const string delay_multiplex { get_global_variable(admin, "mysql-auto_increment_delay_multiplex", "5") };
+	const string affinity_learning { get_global_variable(admin, "mysql-multiplex_affinity_learning", "false") };
+	const string affinity_min_samples { get_global_variable(admin, "mysql-multiplex_affinity_min_samples", "100") };
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests='true'");
+	MYSQL_QUERY_T(admin, "SET mysql-auto_increment_delay_multiplex=1");
+	MYSQL_QUERY_T(admin, "SET mysql-multiplex_affinity_learning='true'");
+	MYSQL_QUERY_T(admin, ("SET mysql-multiplex_affinity_min_samples=" + std::to_string(MIN_SAMPLES)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(proxy, "CREATE DATABASE IF NOT EXISTS test");
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.multiplex_affinity");
+	MYSQL_QUERY_T(proxy, "CREATE TABLE test.multiplex_affinity (id INT AUTO_INCREMENT PRIMARY KEY, v INT)");
+
+	// each INSERT opens a window of one statement, the following SELECT doesn't depend on the connection
+	const uint64_t released_before = get_global_status(admin, "Multiplex_affinity_released");
+	for (int i = 0; i < MIN_SAMPLES * 2; i++) {
+		MYSQL_QUERY_T(proxy, ("INSERT INTO test.multiplex_affinity (v) VALUES (" + std::to_string(i) + ")").c_str());
+		MYSQL_QUERY_T(proxy, "SELECT 1");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	const uint64_t released = get_global_status(admin, "Multiplex_affinity_released") - released_before;
+	ok(released >= MIN_SAMPLES - 1, "Connection released after the INSERTs once learned   released:%lu", released);
+
+	// a query using LAST_INSERT_ID() on the backend forces a re-pin
+	const uint64_t repinned_before = get_global_status(admin, "Multiplex_affinity_repinned");
+	MYSQL_QUERY_T(proxy, "INSERT INTO test.multiplex_affinity (v) VALUES (0)");
+	MYSQL_QUERY_T(proxy, "SELECT LAST_INSERT_ID() + 0");
+	mysql_free_result(mysql_store_result(proxy));
+	const uint64_t repinned = get_global_status(admin, "Multiplex_affinity_repinned") - repinned_before;
+	ok(repinned == 1, "Dependent query counted as a re-pin   repinned:%lu", repinned);
+
+	// the digest is pinned again
+	const uint64_t released_after = get_global_status(admin, "Multiplex_affinity_released");
+	MYSQL_QUERY_T(proxy, "INSERT INTO test.multiplex_affinity (v) VALUES (0)");
+	MYSQL_QUERY_T(proxy, "SELECT 1");
+	mysql_free_result(mysql_store_result(proxy));
+	const uint64_t released_again = get_global_status(admin, "Multiplex_affinity_released") - released_after;
+	ok(released_again == 0, "Connection pinned again after the re-pin   released:%lu", released_again);
+
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.multiplex_affinity");
+	MYSQL_QUERY_T(admin, ("SET mysql-multiplex_affinity_learning='" + affinity_learning + "'").c_str());
+	MYSQL_QUERY_T(admin, ("SET mysql-multiplex_affinity_min_samples=" + affinity_min_samples).c_str());
+	MYSQL_QUERY_T(admin, ("SET mysql-auto_increment_delay_multiplex=" + delay_multiplex).c_str());
+	MYSQL_QUERY_T(admin, ("SET mysql-query_digests='" + query_digests + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
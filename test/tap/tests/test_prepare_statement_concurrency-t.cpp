@@ -0,0 +1,176 @@
+/**
+ * @file test_prepare_statement_concurrency-t.cpp
+ * @brief Checks the global prepared statements cache under concurrent prepare/execute/close.
+ * @details Several client threads prepare, execute and close a mix of shared and per-thread statements at
+ *   the same time. Once all the clients disconnect, the client reference counts reported by
+ *   'stats_mysql_global' and 'stats_mysql_prepared_statements_info' must be back to zero, and the
+ *   number of cached statements must match the number of distinct statements prepared.
+ *   A second phase lowers 'mysql-max_stmts_cache' to its minimum and prepares many distinct statements, some
+ *   shared between the threads, for a few seconds: the background purge runs while statements are prepared
+ *   and closed, and every statement must still execute.
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "proxysql_utils.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_THREADS = 8;
+const int NUM_ITERATIONS = 200;
+const int NUM_SHARED_STMTS = 10;
+const int NUM_PRIVATE_STMTS = 10;
+const int PURGE_PHASE_SECS = 5;
+const int NUM_PURGE_STMTS = 400;
+
+std::atomic<int> failures { 0 };
+
+/**
+ * @brief Prepares, executes and closes statements until 'iterations' are done or, if 'iterations' is -1, for
+ *   PURGE_PHASE_SECS seconds with statements distinct enough to exceed 'mysql-max_stmts_cache'.
+ */
+void stmt_worker(const CommandLine& cl, int thread_id, int iterations) {
+	MYSQL* proxysql = mysql_init(NULL);
+	if (!mysql_real_connect(proxysql, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxysql));
+		failures++;
+		return;
+	}
+	const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(PURGE_PHASE_SECS);
+	for (int i = 0; iterations == -1 ? std::chrono::steady_clock::now() < end : i < iterations; i++) {
+		string query {};
+		if (iterations == -1) {
+			if (i % 2 == 0) {
+				query = "SELECT /* purge shared */ " + std::to_string(i % NUM_PURGE_STMTS);
+			} else {
+				query = "SELECT /* purge thread " + std::to_string(thread_id) + " */ " + std::to_string(i % NUM_PURGE_STMTS);
+			}
+		} else if (i % 2 == 0) {
+			query = "SELECT /* shared */ " + std::to_string(i % NUM_SHARED_STMTS);
+		} else {
+			query = "SELECT /* thread " + std::to_string(thread_id) + " */ " + std::to_string(i % NUM_PRIVATE_STMTS);
+		}
+		MYSQL_STMT* stmt = mysql_stmt_init(proxysql);
+		if (stmt == NULL) {
+			failures++;
+			break;
+		}
+		if (mysql_stmt_prepare(stmt, query.c_str(), query.size())) {
+			diag("mysql_stmt_prepare failed for '%s': %s", query.c_str(), mysql_stmt_error(stmt));
+			failures++;
+			mysql_stmt_close(stmt);
+			break;
+		}
+		if (mysql_stmt_execute(stmt) || mysql_stmt_store_result(stmt)) {
+			diag("mysql_stmt_execute failed for '%s': %s", query.c_str(), mysql_stmt_error(stmt));
+			failures++;
+			mysql_stmt_close(stmt);
+			break;
+		}
+		mysql_stmt_free_result(stmt);
+		mysql_stmt_close(stmt);
+	}
+	mysql_close(proxysql);
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(7);
+
+	MYSQL* proxysql_admin = mysql_init(NULL);
+	if (!mysql_real_connect(proxysql_admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxysql_admin));
+		return exit_status();
+	}
+
+	std::vector<std::thread> workers {};
+	for (int i = 0; i < NUM_THREADS; i++) {
+		workers.push_back(std::thread(stmt_worker, std::ref(cl), i, NUM_ITERATIONS));
+	}
+	for (std::thread& w : workers) {
+		w.join();
+	}
+	ok(failures == 0, "All the prepared statements were executed successfully   failures:%d", failures.load());
+
+	const ext_val_t<uint64_t> client_total {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT variable_value FROM stats_mysql_global WHERE variable_name='Stmt_Client_Active_Total'", uint64_t(0))
+	};
+	ok(client_total.err == 0 && client_total.val == 0,
+		"No client references left after disconnect   Stmt_Client_Active_Total:%lu", client_total.val);
+
+	const ext_val_t<uint64_t> info_refs {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT IFNULL(SUM(ref_count_client),0) FROM stats_mysql_prepared_statements_info"
+			" WHERE query LIKE 'SELECT /* shared */%' OR query LIKE 'SELECT /* thread%'", uint64_t(0))
+	};
+	ok(info_refs.err == 0 && info_refs.val == 0,
+		"'stats_mysql_prepared_statements_info' reports no client references   ref_count_client:%lu", info_refs.val);
+
+	const ext_val_t<uint64_t> num_stmts {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT COUNT(*) FROM stats_mysql_prepared_statements_info"
+			" WHERE query LIKE 'SELECT /* shared */%' OR query LIKE 'SELECT /* thread%'", uint64_t(0))
+	};
+	// statements can be purged once unused, but never duplicated
+	uint64_t max_stmts = NUM_SHARED_STMTS + NUM_THREADS * NUM_PRIVATE_STMTS;
+	ok(num_stmts.err == 0 && num_stmts.val <= max_stmts,
+		"Each distinct statement is cached at most once   cached:%lu max:%lu", num_stmts.val, max_stmts);
+
+	// purge running concurrently with prepare and close
+	const ext_val_t<string> max_stmts_cache {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT variable_value FROM global_variables WHERE variable_name='mysql-max_stmts_cache'", string("10000"))
+	};
+	MYSQL_QUERY_T(proxysql_admin, "SET mysql-max_stmts_cache=128");
+	MYSQL_QUERY_T(proxysql_admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	const ext_val_t<uint64_t> purged_before {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT variable_value FROM stats_mysql_global WHERE variable_name='Stmt_Purged'", uint64_t(0))
+	};
+
+	failures = 0;
+	workers.clear();
+	for (int i = 0; i < NUM_THREADS; i++) {
+		workers.push_back(std::thread(stmt_worker, std::ref(cl), i, -1));
+	}
+	for (std::thread& w : workers) {
+		w.join();
+	}
+	ok(failures == 0, "All the prepared statements were executed during the purge   failures:%d", failures.load());
+
+	const ext_val_t<uint64_t> purged_after {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT variable_value FROM stats_mysql_global WHERE variable_name='Stmt_Purged'", uint64_t(0))
+	};
+	ok(purged_after.err == 0 && purged_after.val > purged_before.val,
+		"Unused statements purged while in use   before:%lu after:%lu", purged_before.val, purged_after.val);
+
+	const ext_val_t<uint64_t> client_total_purge {
+		mysql_query_ext_val(proxysql_admin,
+			"SELECT variable_value FROM stats_mysql_global WHERE variable_name='Stmt_Client_Active_Total'", uint64_t(0))
+	};
+	ok(client_total_purge.err == 0 && client_total_purge.val == 0,
+		"No client references left after the purge phase   Stmt_Client_Active_Total:%lu", client_total_purge.val);
+
+	MYSQL_QUERY_T(proxysql_admin, ("SET mysql-max_stmts_cache=" + max_stmts_cache.val).c_str());
+	MYSQL_QUERY_T(proxysql_admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxysql_admin);
+
+	return exit_status();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_query_cache_table_index-t.cpp
+ * @brief Unit test for the table index of 'query_cache_table_invalidation' ('QC_table_index').
+ * @details The cached entries are simulated by a set of keys. The test checks that:
+ *   - An entry isn't cached if one of its tables was invalidated after the query started, indexed or not, and
+ *     that the invalidation returns the keys of the entries read from the table.
+ *   - A write to a table not in the index only affects the tables sharing its epoch slot, not the whole shard.
+ *   - The sweep bounds the number of indexed tables when entries expire, and keeps the invalidations of the
+ *     erased tables.
+ *   - 'clear()' empties the index, keeping the invalidations.
+ */
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "tap.h"
+
+#include "QC_table_index.h"
+
+using std::set;
+using std::vector;
+
+// tables in the same shard and in different epoch slots
+const uint64_t TABLE_A = 0;
+const uint64_t TABLE_B = QUERY_CACHE_TABLE_INDEX_SHARDS;
+// added to a table hash, gives a table in the same shard and epoch slot
+const uint64_t SAME_SLOT = QUERY_CACHE_TABLE_INDEX_SHARDS * QUERY_CACHE_TABLE_EPOCH_SLOTS;
+const uint64_t NUM_TABLES = 5000;
+
+int main(int argc, char** argv) {
+	plan(4);
+
+	set<uint64_t> entries {};
+	QC_table_index index([&entries] (uint64_t k) { return entries.count(k) != 0; });
+
+	{
+		bool ok_unindexed = false, ok_indexed = false, ok_keys = false, ok_after = false;
+		uint64_t epoch = index.get_epoch();
+		vector<uint64_t> keys {};
+		index.invalidate(1, keys);
+		ok_unindexed = index.track(1, { { 1, epoch } }) == false && keys.empty();
+
+		epoch = index.get_epoch();
+		entries.insert(2);
+		index.track(2, { { 2, epoch } });
+		index.invalidate(2, keys);
+		ok_keys = keys == vector<uint64_t> { 2 };
+		entries.insert(3);
+		ok_indexed = index.track(3, { { 2, epoch } }) == false;
+		ok_after = index.track(3, { { 2, index.get_epoch() } });
+		ok(ok_unindexed && ok_indexed && ok_keys && ok_after,
+			"Invalidations after the query started prevent caching   unindexed:%d indexed:%d keys:%d after:%d",
+			ok_unindexed, ok_indexed, ok_keys, ok_after);
+	}
+
+	{
+		const uint64_t epoch = index.get_epoch();
+		vector<uint64_t> keys {};
+		index.invalidate(TABLE_B, keys);
+		entries.insert(4);
+		const bool other_slot = index.track(4, { { TABLE_A, epoch } });
+		entries.insert(5);
+		const bool same_slot = index.track(5, { { TABLE_B + SAME_SLOT, epoch } });
+		ok(other_slot && same_slot == false,
+			"Unindexed writes only affect their epoch slot   other_slot:%d same_slot:%d", other_slot, same_slot);
+	}
+
+	{
+		// 'TABLE_LIVE' keeps an entry, 'TABLE_EXPIRED' is invalidated and then loses its only entry
+		const uint64_t TABLE_LIVE = 7 * QUERY_CACHE_TABLE_INDEX_SHARDS;
+		const uint64_t TABLE_EXPIRED = 9 * QUERY_CACHE_TABLE_INDEX_SHARDS;
+		const uint64_t epoch = index.get_epoch();
+		vector<uint64_t> keys {};
+		entries.insert(100);
+		entries.insert(101);
+		index.track(100, { { TABLE_LIVE, epoch } });
+		index.track(101, { { TABLE_EXPIRED, epoch } });
+		index.invalidate(TABLE_EXPIRED, keys);
+		entries.erase(101);
+
+		size_t failed = 0, max_size = 0;
+		for (uint64_t i = 0; i < NUM_TABLES; i++) {
+			const uint64_t key = 1000 + i;
+			entries.insert(key);
+			if (index.track(key, { { (1000 + i) * QUERY_CACHE_TABLE_INDEX_SHARDS, index.get_epoch() } }) == false) {
+				failed++;
+			}
+			entries.erase(key);
+			max_size = std::max(max_size, index.size());
+		}
+		keys.clear();
+		index.invalidate(TABLE_LIVE, keys);
+		const bool live_kept = keys == vector<uint64_t> { 100 };
+		const bool expired_kept = index.track(102, { { TABLE_EXPIRED, epoch } }) == false;
+		ok(failed == 0 && max_size <= 1024 + 16 && live_kept && expired_kept,
+			"Sweep bounds the index and keeps the invalidations   failed:%lu max_size:%lu live:%d expired:%d",
+			failed, max_size, live_kept, expired_kept);
+	}
+
+	{
+		const uint64_t epoch = index.get_epoch();
+		vector<uint64_t> keys {};
+		entries.insert(200);
+		index.track(200, { { 5, epoch } });
+		index.invalidate(5, keys);
+		index.clear();
+		const size_t size = index.size();
+		const bool kept = index.track(201, { { 5, epoch } }) == false;
+		const bool after = index.track(201, { { 5, index.get_epoch() } });
+		ok(size == 0 && kept && after, "Clear empties the index and keeps the invalidations   size:%lu kept:%d after:%d",
+			size, kept, after);
+	}
+
+	return exit_status();
+}
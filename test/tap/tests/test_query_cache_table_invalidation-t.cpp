@@ -0,0 +1,126 @@
+/**
+ * @file test_query_cache_table_invalidation-t.cpp
+ * @brief Checks the invalidation of Query Cache entries by table of 'mysql-query_cache_table_invalidation'.
+ * @details A query rule caches the reads of the test table with a long 'cache_ttl'. Repeated reads must be
+ *   served by the Query Cache, while a read following a write on the table through ProxySQL must see the
+ *   written value. A write done inside a transaction must be visible to other sessions once committed.
+ *   The test also checks the counter 'Query_Cache_Invalidated'. The rule matches on the digest, so
+ *   'mysql-query_digests' is enabled for the test and restored.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_WRITES = 20;
+const int RULE_ID = 50;
+const char* SELECT_QUERY = "SELECT v FROM test.qc_table_invalidation WHERE id=1";
+
+uint64_t get_global_stat(MYSQL* admin, const string& name) {
+	const ext_val_t<uint64_t> val {
+		mysql_query_ext_val(admin,
+			("SELECT variable_value FROM stats_mysql_global WHERE variable_name='" + name + "'").c_str(), uint64_t(0))
+	};
+	return val.val;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const ext_val_t<string> query_digests {
+		mysql_query_ext_val(admin,
+			"SELECT variable_value FROM global_variables WHERE variable_name='mysql-query_digests'", string("true"))
+	};
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests='true'");
+	MYSQL_QUERY_T(admin, "SET mysql-query_cache_table_invalidation='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin,
+		("INSERT INTO mysql_query_rules (rule_id,active,match_digest,cache_ttl,apply) VALUES (" +
+		std::to_string(RULE_ID) + ",1,'^SELECT v FROM test.qc_table_invalidation',600000,1)").c_str()
+	);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "PROXYSQL FLUSH QUERY CACHE");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+	MYSQL* proxy2 = mysql_init(NULL);
+	if (!mysql_real_connect(proxy2, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy2));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(proxy, "CREATE DATABASE IF NOT EXISTS test");
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.qc_table_invalidation");
+	MYSQL_QUERY_T(proxy, "CREATE TABLE test.qc_table_invalidation (id INT PRIMARY KEY, v INT)");
+	MYSQL_QUERY_T(proxy, "INSERT INTO test.qc_table_invalidation VALUES (1, 0)");
+
+	// repeated reads without writes are served by the Query Cache
+	const uint64_t get_ok_before = get_global_stat(admin, "Query_Cache_count_GET_OK");
+	for (int i = 0; i < 5; i++) {
+		const ext_val_t<uint64_t> v { mysql_query_ext_val(proxy, SELECT_QUERY, uint64_t(0)) };
+		if (v.err) {
+			diag("Read failed   err:%d", v.err);
+		}
+	}
+	const uint64_t get_ok_after = get_global_stat(admin, "Query_Cache_count_GET_OK");
+	ok(get_ok_after - get_ok_before >= 4, "Reads without writes served by the Query Cache   hits:%lu",
+		get_ok_after - get_ok_before);
+
+	int stale = 0;
+	for (int i = 1; i <= NUM_WRITES; i++) {
+		MYSQL_QUERY_T(proxy, ("UPDATE test.qc_table_invalidation SET v=" + std::to_string(i) + " WHERE id=1").c_str());
+		const ext_val_t<uint64_t> v { mysql_query_ext_val(proxy2, SELECT_QUERY, uint64_t(0)) };
+		if (v.err || v.val != uint64_t(i)) {
+			diag("Stale read   expected:%d v:%lu err:%d", i, v.val, v.err);
+			stale++;
+		}
+	}
+	ok(stale == 0, "Every read saw the previous write   stale:%d", stale);
+
+	// the entry cached while the transaction is open must be dropped at commit
+	MYSQL_QUERY_T(proxy, "BEGIN");
+	MYSQL_QUERY_T(proxy, "UPDATE test.qc_table_invalidation SET v=1000 WHERE id=1");
+	const ext_val_t<uint64_t> before_commit { mysql_query_ext_val(proxy2, SELECT_QUERY, uint64_t(0)) };
+	MYSQL_QUERY_T(proxy, "COMMIT");
+	const ext_val_t<uint64_t> after_commit { mysql_query_ext_val(proxy2, SELECT_QUERY, uint64_t(0)) };
+	ok(before_commit.err == 0 && after_commit.err == 0 && after_commit.val == 1000,
+		"Write in a transaction visible after commit   before:%lu after:%lu", before_commit.val, after_commit.val);
+
+	const uint64_t invalidated = get_global_stat(admin, "Query_Cache_Invalidated");
+	ok(invalidated >= NUM_WRITES, "Invalidations reported   Query_Cache_Invalidated:%lu", invalidated);
+
+	MYSQL_QUERY_T(proxy, "DROP TABLE IF EXISTS test.qc_table_invalidation");
+	MYSQL_QUERY_T(admin, ("DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)).c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SET mysql-query_cache_table_invalidation='false'");
+	MYSQL_QUERY_T(admin, ("SET mysql-query_digests='" + query_digests.val + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy2);
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file test_query_digest_histogram_merge-t.cpp
+ * @brief Unit test for the merge of the latency histograms of 'QP_query_digest_stats' entries.
+ * @details Entries are filled the way 'update_query_digest()' does, one sample per execution, and then merged
+ *   with 'QP_query_digest_stats::merge()', as done when the auxiliary digest maps are folded back into the main
+ *   map. The test checks that every execution is counted exactly once in the merged histogram, including when
+ *   the merged entry holds a single execution.
+ */
+
+#include <vector>
+
+#include "query_processor.h"
+#include "tap.h"
+
+using std::vector;
+
+QP_query_digest_stats* new_entry(const vector<unsigned long long>& times) {
+	QP_query_digest_stats* qds = new QP_query_digest_stats("user", "schema", 1, "SELECT ?", 0, "", 2048);
+	qds->init_histogram(100);
+	unsigned long long n = 1;
+	for (const unsigned long long t : times) {
+		qds->add_time(t, n++, 0, 1);
+		if (qds->histogram) {
+			qds->histogram->add(t);
+		}
+	}
+	return qds;
+}
+
+uint64_t buckets_total(const Digest_Latency_Histogram* h) {
+	uint64_t total = 0;
+	for (int i = 0; i < Digest_Latency_Histogram::BUCKETS; i++) {
+		total += h->bucket_count(i);
+	}
+	return total;
+}
+
+int main(int argc, char** argv) {
+	plan(6);
+
+	{
+		QP_query_digest_stats* dst = new_entry({ 100, 200, 300, 4000 });
+		QP_query_digest_stats* src = new_entry({ 150 });
+		const uint64_t expected = dst->count_star + src->count_star;
+
+		dst->merge(src);
+		delete src;
+
+		ok(dst->count_star == expected, "Merged count_star   expected:%lu count_star:%u", expected, dst->count_star);
+		ok(
+			dst->histogram && dst->histogram->count() == expected,
+			"Single execution entry counted once in the histogram   expected:%lu count:%lu",
+			expected, dst->histogram ? dst->histogram->count() : 0
+		);
+		ok(
+			dst->histogram && buckets_total(dst->histogram) == expected,
+			"Buckets total matches the executions   expected:%lu buckets:%lu",
+			expected, dst->histogram ? buckets_total(dst->histogram) : 0
+		);
+		delete dst;
+	}
+
+	{
+		QP_query_digest_stats* dst = new_entry({ 10, 20 });
+		QP_query_digest_stats* src = new_entry({ 30, 40, 50 });
+		const uint64_t expected = dst->count_star + src->count_star;
+
+		dst->merge(src);
+		delete src;
+
+		ok(dst->count_star == expected, "Merged count_star   expected:%lu count_star:%u", expected, dst->count_star);
+		ok(
+			dst->histogram && buckets_total(dst->histogram) == expected,
+			"Buckets total matches the executions   expected:%lu buckets:%lu",
+			expected, dst->histogram ? buckets_total(dst->histogram) : 0
+		);
+		ok(
+			dst->histogram && dst->histogram->max() == 50,
+			"Merged histogram max   max:%lu", dst->histogram ? dst->histogram->max() : 0
+		);
+		delete dst;
+	}
+
+	return exit_status();
+}
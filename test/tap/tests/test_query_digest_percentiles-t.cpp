@@ -0,0 +1,132 @@
+/**
+ * @file test_query_digest_percentiles-t.cpp
+ * @brief Checks the latency percentiles of 'stats_mysql_query_digest' ('mysql-query_digests_histograms_max').
+ * @details The test:
+ *   - Checks that with 'mysql-query_digests_histograms_max' set to '0' no digest reports percentiles.
+ *   - Enables the histograms, runs a number of queries through ProxySQL, and checks that their digest reports
+ *     'p50_time', 'p95_time' and 'p99_time'.
+ *   - Checks the consistency of the reported percentiles with 'min_time' and 'max_time'.
+ *   - Checks that the number of digests with percentiles is capped by 'mysql-query_digests_histograms_max'.
+ *
+ *   The digests are only collected with 'mysql-query_digests', enabled for the test and restored.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_QUERIES = 100;
+const int NUM_DIGESTS = 10;
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const ext_val_t<string> query_digests {
+		mysql_query_ext_val(admin,
+			"SELECT variable_value FROM global_variables WHERE variable_name='mysql-query_digests'", string("true"))
+	};
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests='true'");
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_histograms_max=0");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	mysql_free_result(mysql_store_result(admin));
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	for (int i = 0; i < 10; i++) {
+		MYSQL_QUERY_T(proxy, "SELECT 1");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+
+	const string q_with_percentiles {
+		"SELECT COUNT(*) FROM stats_mysql_query_digest WHERE p50_time IS NOT NULL"
+	};
+	ext_val_t<int> with_percentiles { mysql_query_ext_val(admin, q_with_percentiles, -1) };
+	ok(
+		with_percentiles.err == 0 && with_percentiles.val == 0,
+		"No percentiles reported with the histograms disabled   digests:%d", with_percentiles.val
+	);
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_histograms_max=10000");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	mysql_free_result(mysql_store_result(admin));
+
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		MYSQL_QUERY_T(proxy, "SELECT 1");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+
+	const string q_digest {
+		"SELECT count_star FROM stats_mysql_query_digest WHERE digest_text='SELECT ?' AND p50_time IS NOT NULL"
+			" AND p95_time IS NOT NULL AND p99_time IS NOT NULL"
+	};
+	ext_val_t<int> count_star { mysql_query_ext_val(admin, q_digest, -1) };
+	ok(
+		count_star.err == 0 && count_star.val == NUM_QUERIES,
+		"Percentiles reported for the digest   exp_count:%d act_count:%d", NUM_QUERIES, count_star.val
+	);
+
+	const string q_inconsistent {
+		"SELECT COUNT(*) FROM stats_mysql_query_digest WHERE p50_time IS NOT NULL AND"
+			" NOT (p50_time <= p95_time AND p95_time <= p99_time AND p99_time <= max_time AND min_time <= p99_time)"
+	};
+	ext_val_t<int> inconsistent { mysql_query_ext_val(admin, q_inconsistent, -1) };
+	ok(inconsistent.err == 0 && inconsistent.val == 0, "Percentiles are consistent   inconsistent_digests:%d", inconsistent.val);
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_histograms_max=1");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	mysql_free_result(mysql_store_result(admin));
+
+	for (int i = 0; i < NUM_DIGESTS; i++) {
+		// a different alias per query produces different digests
+		const string query { "SELECT 1 AS c" + std::to_string(i) };
+		MYSQL_QUERY_T(proxy, query.c_str());
+		mysql_free_result(mysql_store_result(proxy));
+	}
+
+	with_percentiles = mysql_query_ext_val(admin, q_with_percentiles, -1);
+	ok(
+		with_percentiles.err == 0 && with_percentiles.val == 1,
+		"Digests with percentiles capped by 'mysql-query_digests_histograms_max'   exp:1 act:%d", with_percentiles.val
+	);
+
+	const string q_total { "SELECT COUNT(*) FROM stats_mysql_query_digest WHERE digest_text LIKE 'SELECT ? AS c%'" };
+	ext_val_t<int> total { mysql_query_ext_val(admin, q_total, -1) };
+	ok(
+		total.err == 0 && total.val >= NUM_DIGESTS,
+		"Digests beyond the cap are still tracked   exp:>=%d act:%d", NUM_DIGESTS, total.val
+	);
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_histograms_max=10000");
+	MYSQL_QUERY_T(admin, ("SET mysql-query_digests='" + query_digests.val + "'").c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_query_digests_cache-t.cpp
+ * @brief Checks the per-thread digest cache enabled by 'mysql-query_digests_cache_size'.
+ * @details The same set of queries is executed with the cache disabled and enabled. The digests computed in
+ *   both cases must be identical, and repeated queries must be reported as hits in 'stats_mysql_global'.
+ */
+
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "proxysql_utils.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int NUM_REPETITIONS = 50;
+
+const vector<string> queries {
+	"SELECT 1",
+	"SELECT /* cache_test */ 2",
+	"SELECT   1,  'abc' ,NULL  FROM   DUAL WHERE 1 IN (1,2,3,4,5,6)",
+	"SELECT /* first */ 1 /* second */",
+};
+
+uint64_t get_global_stat(MYSQL* admin, const string& name) {
+	const string q { "SELECT variable_value FROM stats_mysql_global WHERE variable_name='" + name + "'" };
+	const ext_val_t<uint64_t> val { mysql_query_ext_val(admin, q, uint64_t(0)) };
+	return val.err == 0 ? val.val : 0;
+}
+
+vector<string> get_digests(MYSQL* admin) {
+	vector<string> res {};
+	if (mysql_query(admin,
+		"SELECT digest, digest_text FROM stats_mysql_query_digest WHERE digest_text LIKE 'SELECT %' ORDER BY digest")) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(admin));
+		return res;
+	}
+	MYSQL_RES* myres = mysql_store_result(admin);
+	MYSQL_ROW row = nullptr;
+	while ((row = mysql_fetch_row(myres))) {
+		res.push_back(string { row[0] } + " " + string { row[1] });
+	}
+	mysql_free_result(myres);
+	return res;
+}
+
+int run_queries(const CommandLine& cl) {
+	MYSQL* proxysql = mysql_init(NULL);
+	if (!mysql_real_connect(proxysql, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxysql));
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < NUM_REPETITIONS; i++) {
+		for (const string& q : queries) {
+			if (mysql_query(proxysql, q.c_str())) {
+				diag("Query '%s' failed: %s", q.c_str(), mysql_error(proxysql));
+				mysql_close(proxysql);
+				return EXIT_FAILURE;
+			}
+			mysql_free_result(mysql_store_result(proxysql));
+		}
+	}
+	mysql_close(proxysql);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests=1");
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_cache_size=0");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	if (run_queries(cl)) {
+		return exit_status();
+	}
+	const vector<string> digests_nocache { get_digests(admin) };
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_cache_size=1024");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	const uint64_t hits_before = get_global_stat(admin, "query_digests_cache_hits");
+	if (run_queries(cl)) {
+		return exit_status();
+	}
+	const vector<string> digests_cache { get_digests(admin) };
+
+	ok(digests_nocache.size() > 0, "Digests were collected   num_digests:%ld", digests_nocache.size());
+	ok(digests_nocache == digests_cache,
+		"Digests are identical with and without the cache   nocache:%ld cache:%ld",
+		digests_nocache.size(), digests_cache.size());
+
+	// the counters are flushed by the worker threads once per second
+	sleep(2);
+	const uint64_t hits_after = get_global_stat(admin, "query_digests_cache_hits");
+	ok(hits_after > hits_before, "Repeated queries hit the digest cache   before:%lu after:%lu", hits_before, hits_after);
+
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES FROM DISK");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_query_digests_stop_at_max_digest_length-t.cpp
+ * @brief Checks 'mysql-query_digests_stop_at_max_digest_length' and the 'query_digests_truncated' counter.
+ * @details A query whose digest is longer than 'mysql-query_digests_max_digest_length' is executed with the
+ *   option disabled and enabled. The digest computation must be reported as truncated only when the option
+ *   is enabled, and the query must be tracked in 'stats_mysql_query_digest' in both cases.
+ */
+
+#include <string>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "proxysql_utils.h"
+#include "utils.h"
+
+using std::string;
+
+uint64_t get_global_stat(MYSQL* admin, const string& name) {
+	const string q { "SELECT variable_value FROM stats_mysql_global WHERE variable_name='" + name + "'" };
+	const ext_val_t<uint64_t> val { mysql_query_ext_val(admin, q, uint64_t(0)) };
+	return val.err == 0 ? val.val : 0;
+}
+
+string get_digest(MYSQL* admin) {
+	const ext_val_t<string> val {
+		mysql_query_ext_val(admin,
+			"SELECT digest || ' ' || digest_text FROM stats_mysql_query_digest WHERE digest_text LIKE 'SELECT ? AS c%'",
+			string {})
+	};
+	return val.err == 0 ? val.val : string {};
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+	MYSQL* proxysql = mysql_init(NULL);
+	if (!mysql_real_connect(proxysql, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxysql));
+		return exit_status();
+	}
+
+	// every column alias is kept in the digest, making it longer than 'query_digests_max_digest_length'
+	string query { "SELECT 1 AS c0" };
+	for (int i = 1; i < 2000; i++) {
+		query += ", " + std::to_string(i) + " AS c" + std::to_string(i);
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests=1");
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_max_digest_length=2048");
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_cache_size=0");
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_stop_at_max_digest_length=0");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	const uint64_t truncated_before = get_global_stat(admin, "query_digests_truncated");
+	MYSQL_QUERY_T(proxysql, query.c_str());
+	mysql_free_result(mysql_store_result(proxysql));
+	const string digest_full { get_digest(admin) };
+	const uint64_t truncated_full = get_global_stat(admin, "query_digests_truncated");
+
+	MYSQL_QUERY_T(admin, "SET mysql-query_digests_stop_at_max_digest_length=1");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY_T(admin, "SELECT * FROM stats_mysql_query_digest_reset");
+	MYSQL_QUERY_T(proxysql, query.c_str());
+	mysql_free_result(mysql_store_result(proxysql));
+	const string digest_stop { get_digest(admin) };
+	const uint64_t truncated_after = get_global_stat(admin, "query_digests_truncated");
+
+	ok(digest_full.size() > 0, "Digest found with the option disabled   len:%ld", digest_full.size());
+	ok(truncated_full == truncated_before,
+		"The digest computation wasn't truncated with the option disabled   before:%lu after:%lu",
+		truncated_before, truncated_full);
+	ok(digest_stop.size() > 0, "Digest found with the option enabled   len:%ld", digest_stop.size());
+	ok(truncated_after == truncated_full + 1,
+		"The digest computation was reported as truncated   before:%lu after:%lu", truncated_full, truncated_after);
+
+	mysql_close(proxysql);
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES FROM DISK");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
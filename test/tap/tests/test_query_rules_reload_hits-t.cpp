@@ -0,0 +1,113 @@
+/**
+ * @file test_query_rules_reload_hits-t.cpp
+ * @brief Checks query rules hits while rules are reloaded under traffic.
+ * @details Worker threads share the compiled query rules and count hits separately. This test:
+ *   - Runs queries from several clients while 'LOAD MYSQL QUERY RULES TO RUNTIME' is executed in a loop, and
+ *     checks that no query fails.
+ *   - Runs a known number of queries matching a rule, without reloads, and checks that the hits reported in
+ *     'stats_mysql_query_rules' match the number of queries.
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "proxysql_utils.h"
+#include "utils.h"
+
+using std::string;
+
+const int RULE_ID = 9901;
+const int NUM_CLIENTS = 4;
+const int NUM_QUERIES = 500;
+const int NUM_RELOADS = 50;
+
+std::atomic<int> failures { 0 };
+
+void client_worker(const CommandLine& cl, int num_queries) {
+	MYSQL* proxysql = mysql_init(NULL);
+	if (!mysql_real_connect(proxysql, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxysql));
+		failures++;
+		return;
+	}
+	for (int i = 0; i < num_queries; i++) {
+		if (mysql_query(proxysql, "SELECT 1 AS reload_hits_test")) {
+			diag("Query failed: %s", mysql_error(proxysql));
+			failures++;
+			break;
+		}
+		mysql_free_result(mysql_store_result(proxysql));
+	}
+	mysql_close(proxysql);
+}
+
+int run_clients(const CommandLine& cl, int num_queries) {
+	std::vector<std::thread> clients {};
+	for (int i = 0; i < NUM_CLIENTS; i++) {
+		clients.push_back(std::thread(client_worker, std::ref(cl), num_queries));
+	}
+	for (std::thread& c : clients) {
+		c.join();
+	}
+	return failures.load();
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(2);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const string del_rule { "DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID) };
+	MYSQL_QUERY_T(admin, del_rule.c_str());
+	const string ins_rule {
+		"INSERT INTO mysql_query_rules (rule_id, active, match_digest, apply) VALUES ("
+			+ std::to_string(RULE_ID) + ", 1, '^SELECT \\? AS reload_hits_test$', 0)"
+	};
+	MYSQL_QUERY_T(admin, ins_rule.c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+
+	// reload the rules while the clients are running
+	std::thread clients(run_clients, std::ref(cl), NUM_QUERIES);
+	for (int i = 0; i < NUM_RELOADS; i++) {
+		MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+		usleep(10 * 1000);
+	}
+	clients.join();
+	ok(failures == 0, "No query failed while rules were reloaded   failures:%d", failures.load());
+
+	// hits are reset by a reload: count them on a fresh copy of the rules
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	run_clients(cl, NUM_QUERIES);
+	// the hits are flushed by the worker threads once per second
+	sleep(2);
+
+	const string q_hits {
+		"SELECT hits FROM stats_mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID)
+	};
+	const ext_val_t<uint64_t> hits { mysql_query_ext_val(admin, q_hits, uint64_t(0)) };
+	const uint64_t exp_hits = NUM_CLIENTS * NUM_QUERIES;
+	ok(hits.err == 0 && hits.val == exp_hits, "Rule hits match the executed queries   exp:%lu act:%lu", exp_hits, hits.val);
+
+	MYSQL_QUERY_T(admin, del_rule.c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
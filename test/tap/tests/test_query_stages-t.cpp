@@ -0,0 +1,108 @@
+/**
+ * @file test_query_stages-t.cpp
+ * @brief Checks the per stage query latency breakdown ('mysql-stats_time_query_stages').
+ * @details The test:
+ *   - Checks that no stage is recorded while the variable is disabled.
+ *   - Enables the variable, runs a number of queries through ProxySQL, and checks that 'stats_mysql_query_stages'
+ *     accounts them in the 'total' stage, and in the stages every query goes through.
+ *   - Checks the consistency of the reported percentiles.
+ *   - Checks that the overhead of the timestamps is reported in 'stats_mysql_global'.
+ */
+
+#include <string>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_QUERIES = 100;
+
+int get_stage_count(MYSQL* admin, const string& stage) {
+	const string q_count { "SELECT count_star FROM stats_mysql_query_stages WHERE stage='" + stage + "'" };
+	ext_val_t<int> count { mysql_query_ext_val(admin, q_count, -1) };
+	return count.err == 0 ? count.val : -1;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(6);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-stats_time_query_stages='false'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+
+	const int total_before = get_stage_count(admin, "total");
+	for (int i = 0; i < 10; i++) {
+		MYSQL_QUERY_T(proxy, "SELECT 1");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	ok(
+		total_before != -1 && get_stage_count(admin, "total") == total_before,
+		"No stage recorded with 'mysql-stats_time_query_stages' disabled   count:%d", total_before
+	);
+
+	MYSQL_QUERY_T(admin, "SET mysql-stats_time_query_stages='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	const int digest_before = get_stage_count(admin, "digest");
+	const int backend_before = get_stage_count(admin, "backend");
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		MYSQL_QUERY_T(proxy, "SELECT 1");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+
+	const int total_after = get_stage_count(admin, "total");
+	ok(
+		total_after - total_before >= NUM_QUERIES,
+		"Queries accounted in the 'total' stage   exp:>=%d act:%d", NUM_QUERIES, total_after - total_before
+	);
+	ok(
+		get_stage_count(admin, "digest") - digest_before >= NUM_QUERIES,
+		"Queries accounted in the 'digest' stage"
+	);
+	ok(
+		get_stage_count(admin, "backend") - backend_before >= NUM_QUERIES,
+		"Queries accounted in the 'backend' stage"
+	);
+
+	const string q_percentiles {
+		"SELECT COUNT(*) FROM stats_mysql_query_stages WHERE count_star > 0 AND"
+			" NOT (p50_ns <= p90_ns AND p90_ns <= p95_ns AND p95_ns <= p99_ns AND p99_ns <= p999_ns AND p999_ns <= max_ns)"
+	};
+	ext_val_t<int> inconsistent { mysql_query_ext_val(admin, q_percentiles, -1) };
+	ok(inconsistent.err == 0 && inconsistent.val == 0, "Percentiles are consistent   inconsistent_stages:%d", inconsistent.val);
+
+	const string q_overhead {
+		"SELECT variable_value FROM stats_mysql_global WHERE variable_name='Query_Stages_timer_overhead_ns'"
+	};
+	ext_val_t<string> overhead { mysql_query_ext_val(admin, q_overhead, string {}) };
+	ok(overhead.err == 0 && !overhead.val.empty(), "Timestamps overhead reported   val:'%s'", overhead.val.c_str());
+
+	MYSQL_QUERY_T(admin, "SET mysql-stats_time_query_stages='false'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
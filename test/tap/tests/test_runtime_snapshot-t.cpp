@@ -0,0 +1,182 @@
+/**
+ * @file test_runtime_snapshot-t.cpp
+ * @brief Checks the admin side of the runtime snapshot ('admin-runtime_snapshot').
+ * @details With 'admin-runtime_snapshot' enabled, 'SAVE MYSQL USERS TO DISK' and 'SAVE MYSQL QUERY RULES TO
+ *   DISK' write the runtime snapshot used to speed up the next startup. This test:
+ *   - Checks that the variable only accepts boolean values.
+ *   - Checks that both 'SAVE' commands succeed with the snapshot enabled.
+ *   - Checks that the runtime checksums aren't affected by the snapshot being written.
+ *   - Round trip: changes the query rules, saves them and reads the snapshot back from the datadir
+ *     ('REGULAR_INFRA_DATADIR'), checking that its sections match the runtime tables and checksums, before
+ *     and after the change is reverted.
+ */
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+#include "ProxySQL_Snapshot.hpp"
+#include "sqlite3db.h"
+
+using std::string;
+using std::vector;
+
+const int RULE_ID = 36;
+const char RULE_COMMENT[] = "test_runtime_snapshot";
+
+/**
+ * @brief Returns the section 'name' of 'sections', or NULL.
+ */
+const ProxySQL_Snapshot::section_t* find_section(const vector<ProxySQL_Snapshot::section_t>& sections, const char* name) {
+	for (const ProxySQL_Snapshot::section_t& section : sections) {
+		if (section.name == name) {
+			return &section;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Returns the number of rows of 'rs' whose column 'col' is 'val'.
+ */
+int count_rows(const SQLite3_result* rs, const char* col, const char* val) {
+	int idx = -1;
+	for (int i = 0; i < rs->columns; i++) {
+		if (strcasecmp(rs->column_definition[i]->name, col) == 0) {
+			idx = i;
+		}
+	}
+	int count = 0;
+	for (const SQLite3_row* row : rs->rows) {
+		if (idx >= 0 && row->fields[idx] && strcmp(row->fields[idx], val) == 0) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief Saves the users and query rules, reads back the snapshot and checks it against the runtime tables.
+ * @param rule_rows The expected number of rows of the test rule in the snapshot.
+ */
+int check_round_trip(MYSQL* admin, const string& path, int rule_rows) {
+	MYSQL_QUERY_T(admin, "SAVE MYSQL USERS TO DISK");
+	MYSQL_QUERY_T(admin, "SAVE MYSQL QUERY RULES TO DISK");
+
+	const ext_val_t<string> users_checksum {
+		mysql_query_ext_val(admin, "SELECT checksum FROM runtime_checksums_values WHERE name='mysql_users'", string {})
+	};
+	const ext_val_t<string> rules_checksum {
+		mysql_query_ext_val(admin, "SELECT checksum FROM runtime_checksums_values WHERE name='mysql_query_rules'", string {})
+	};
+	const ext_val_t<int> runtime_rules {
+		mysql_query_ext_val(admin, "SELECT COUNT(*) FROM runtime_mysql_query_rules", -1)
+	};
+
+	vector<ProxySQL_Snapshot::section_t> sections {};
+	string err {};
+	const bool read = ProxySQL_Snapshot::read(path, sections, err);
+	const ProxySQL_Snapshot::section_t* users = find_section(sections, "mysql_users");
+	const ProxySQL_Snapshot::section_t* rules = find_section(sections, "mysql_query_rules");
+
+	ok(
+		read && users && rules && users->checksum == users_checksum.val && rules->checksum == rules_checksum.val,
+		"Snapshot read back with the runtime checksums   err:'%s' users:'%s' rules:'%s'",
+		err.c_str(), users_checksum.val.c_str(), rules_checksum.val.c_str()
+	);
+	const int snapshot_rules = (rules && rules->resultsets.size() == 2) ? rules->resultsets[0]->rows.size() : -1;
+	const int snapshot_rule = (snapshot_rules >= 0) ? count_rows(rules->resultsets[0], "comment", RULE_COMMENT) : -1;
+	ok(
+		snapshot_rules == runtime_rules.val && snapshot_rule == rule_rows,
+		"Snapshot query rules match 'runtime_mysql_query_rules'   runtime:%d snapshot:%d rule:%d exp_rule:%d",
+		runtime_rules.val, snapshot_rules, snapshot_rule, rule_rows
+	);
+
+	ProxySQL_Snapshot::free_sections(sections);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(9);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, "SET admin-runtime_snapshot='false'");
+	mysql_query(admin, "SET admin-runtime_snapshot='invalid'");
+	const string q_snapshot {
+		"SELECT variable_value FROM global_variables WHERE variable_name='admin-runtime_snapshot'"
+	};
+	ext_val_t<string> snapshot { mysql_query_ext_val(admin, q_snapshot, string {}) };
+	ok(snapshot.err == 0 && snapshot.val == "false", "Invalid value is rejected   val:'%s'", snapshot.val.c_str());
+
+	MYSQL_QUERY_T(admin, "SET admin-runtime_snapshot='true'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	const string q_rt_snapshot {
+		"SELECT variable_value FROM runtime_global_variables WHERE variable_name='admin-runtime_snapshot'"
+	};
+	snapshot = mysql_query_ext_val(admin, q_rt_snapshot, string {});
+	ok(snapshot.err == 0 && snapshot.val == "true", "Runtime snapshot enabled at runtime   val:'%s'", snapshot.val.c_str());
+
+	const string q_checksums {
+		"SELECT GROUP_CONCAT(checksum) FROM runtime_checksums_values WHERE name IN ('mysql_users','mysql_query_rules')"
+	};
+	const ext_val_t<string> checksums_before { mysql_query_ext_val(admin, q_checksums, string {}) };
+
+	int rc = mysql_query(admin, "SAVE MYSQL USERS TO DISK");
+	ok(rc == 0, "'SAVE MYSQL USERS TO DISK' succeeds with the snapshot enabled   err:'%s'", mysql_error(admin));
+	rc = mysql_query(admin, "SAVE MYSQL QUERY RULES TO DISK");
+	ok(rc == 0, "'SAVE MYSQL QUERY RULES TO DISK' succeeds with the snapshot enabled   err:'%s'", mysql_error(admin));
+
+	const ext_val_t<string> checksums_after { mysql_query_ext_val(admin, q_checksums, string {}) };
+	ok(
+		checksums_before.err == 0 && checksums_after.err == 0 && checksums_before.val == checksums_after.val,
+		"Runtime checksums unchanged by the snapshot   before:'%s' after:'%s'",
+		checksums_before.val.c_str(), checksums_after.val.c_str()
+	);
+
+	const char* datadir = getenv("REGULAR_INFRA_DATADIR");
+	if (datadir == NULL) {
+		skip(4, "Missing REGULAR_INFRA_DATADIR, the snapshot can't be read back");
+	} else {
+		const string path { string(datadir) + "/proxysql_runtime.snapshot" };
+		const string delete_rule { "DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(RULE_ID) };
+
+		MYSQL_QUERY_T(admin, delete_rule.c_str());
+		MYSQL_QUERY_T(admin,
+			("INSERT INTO mysql_query_rules (rule_id,active,match_pattern,comment,apply) VALUES (" +
+			std::to_string(RULE_ID) + ",1,'^SELECT test_runtime_snapshot','" + RULE_COMMENT + "',0)").c_str()
+		);
+		MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+		if (check_round_trip(admin, path, 1)) {
+			return exit_status();
+		}
+
+		MYSQL_QUERY_T(admin, delete_rule.c_str());
+		MYSQL_QUERY_T(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+		if (check_round_trip(admin, path, 0)) {
+			return exit_status();
+		}
+	}
+
+	MYSQL_QUERY_T(admin, "SET admin-runtime_snapshot='false'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
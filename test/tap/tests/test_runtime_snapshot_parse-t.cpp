@@ -0,0 +1,193 @@
+/**
+ * @file test_runtime_snapshot_parse-t.cpp
+ * @brief Unit test for the serialization and parsing of the runtime snapshot ('ProxySQL_Snapshot').
+ * @details A few sections are serialized, written and read back, checking that names, checksums, epochs and
+ *   resultsets (including NULL and empty fields) survive the round trip. Then the test checks that the reader
+ *   rejects as a whole, leaving no sections behind:
+ *   - Files truncated at any length.
+ *   - Files with any single bit flipped, caught by the trailer.
+ *   - Payloads truncated at any length, or followed by extra bytes, with a valid trailer, caught by the parser.
+ *   - An unknown format version, with a valid trailer.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "tap.h"
+
+#include "ProxySQL_Snapshot.hpp"
+#include "sqlite3db.h"
+#include "SpookyV2.h"
+
+using std::string;
+using std::vector;
+
+const size_t TRAILER_LEN = 2 * sizeof(uint64_t);
+
+SQLite3_result* new_resultset(int columns, int rows) {
+	SQLite3_result* rs = new SQLite3_result(columns);
+	for (int c = 0; c < columns; c++) {
+		rs->add_column_definition(SQLITE_TEXT, ("col_" + std::to_string(c)).c_str());
+	}
+	vector<string> values(columns);
+	vector<const char*> fields(columns);
+	for (int r = 0; r < rows; r++) {
+		for (int c = 0; c < columns; c++) {
+			values[c] = "row_" + std::to_string(r) + "_col_" + std::to_string(c);
+			fields[c] = values[c].c_str();
+		}
+		// a NULL and an empty field in every row
+		fields[r % columns] = NULL;
+		fields[(r + 1) % columns] = "";
+		rs->add_row(&fields[0]);
+	}
+	return rs;
+}
+
+bool same_resultset(const SQLite3_result* a, const SQLite3_result* b) {
+	if (a->columns != b->columns || a->rows.size() != b->rows.size()) {
+		return false;
+	}
+	for (int c = 0; c < a->columns; c++) {
+		if (strcmp(a->column_definition[c]->name, b->column_definition[c]->name) != 0) {
+			return false;
+		}
+	}
+	for (size_t r = 0; r < a->rows.size(); r++) {
+		for (int c = 0; c < a->columns; c++) {
+			const char* fa = a->rows[r]->fields[c];
+			const char* fb = b->rows[r]->fields[c];
+			if ((fa == NULL) != (fb == NULL) || (fa && strcmp(fa, fb) != 0)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool same_sections(const vector<ProxySQL_Snapshot::section_t>& a, const vector<ProxySQL_Snapshot::section_t>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t s = 0; s < a.size(); s++) {
+		if (
+			a[s].name != b[s].name || a[s].checksum != b[s].checksum || a[s].epoch != b[s].epoch ||
+			a[s].resultsets.size() != b[s].resultsets.size()
+		) {
+			return false;
+		}
+		for (size_t r = 0; r < a[s].resultsets.size(); r++) {
+			if (same_resultset(a[s].resultsets[r], b[s].resultsets[r]) == false) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool write_file(const string& path, const string& buf) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (f == NULL) {
+		return false;
+	}
+	const bool ret = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+	fclose(f);
+	return ret;
+}
+
+/**
+ * @brief Returns 'payload' followed by a valid trailer, as written by 'ProxySQL_Snapshot::serialize()'.
+ */
+string with_trailer(const string& payload) {
+	uint64_t hash1 = 0, hash2 = 0;
+	SpookyHash::Hash128(payload.data(), payload.size(), &hash1, &hash2);
+	string buf { payload };
+	buf.append(reinterpret_cast<const char*>(&hash1), sizeof(hash1));
+	buf.append(reinterpret_cast<const char*>(&hash2), sizeof(hash2));
+	return buf;
+}
+
+/**
+ * @brief Writes 'buf' to 'path' and reads it back, returns true if the snapshot is rejected with no sections.
+ */
+bool rejected(const string& path, const string& buf, string& err) {
+	vector<ProxySQL_Snapshot::section_t> sections {};
+	err.clear();
+	if (write_file(path, buf) == false) {
+		err = "unable to write " + path;
+		return false;
+	}
+	const bool read = ProxySQL_Snapshot::read(path, sections, err);
+	const bool empty = sections.empty();
+	ProxySQL_Snapshot::free_sections(sections);
+	return read == false && empty;
+}
+
+int main(int argc, char** argv) {
+	plan(6);
+
+	vector<ProxySQL_Snapshot::section_t> sections {
+		{ "mysql_users", "0x0123456789ABCDEF", 1700000000, { new_resultset(13, 2) } },
+		{ "mysql_query_rules", "0xFEDCBA9876543210", 1700000001, { new_resultset(34, 3), new_resultset(5, 0) } },
+	};
+	const string buf { ProxySQL_Snapshot::serialize(sections) };
+	const string path { "/tmp/test_runtime_snapshot_parse-" + std::to_string(getpid()) + ".snapshot" };
+
+	{
+		vector<ProxySQL_Snapshot::section_t> read_sections {};
+		string err {};
+		const bool written = ProxySQL_Snapshot::write(path, buf, err);
+		const bool read = written && ProxySQL_Snapshot::read(path, read_sections, err);
+		ok(read && same_sections(sections, read_sections), "Sections read back unchanged   size:%lu err:'%s'",
+			buf.size(), err.c_str());
+		ProxySQL_Snapshot::free_sections(read_sections);
+	}
+
+	string err {};
+	int accepted = 0;
+	for (size_t len = 0; len < buf.size(); len++) {
+		if (rejected(path, buf.substr(0, len), err) == false) {
+			diag("Truncated file accepted   len:%lu err:'%s'", len, err.c_str());
+			accepted++;
+		}
+	}
+	ok(accepted == 0, "Truncated files rejected   lengths:%lu accepted:%d", buf.size(), accepted);
+
+	accepted = 0;
+	for (size_t pos = 0; pos < buf.size() * 8; pos++) {
+		string corrupt { buf };
+		corrupt[pos / 8] ^= (1 << (pos % 8));
+		if (rejected(path, corrupt, err) == false) {
+			diag("Corrupt file accepted   byte:%lu bit:%lu err:'%s'", pos / 8, pos % 8, err.c_str());
+			accepted++;
+		}
+	}
+	ok(accepted == 0, "Files with a flipped bit rejected   bits:%lu accepted:%d", buf.size() * 8, accepted);
+
+	const string payload { buf.substr(0, buf.size() - TRAILER_LEN) };
+	accepted = 0;
+	for (size_t len = 0; len < payload.size(); len++) {
+		if (rejected(path, with_trailer(payload.substr(0, len)), err) == false) {
+			diag("Truncated payload accepted   len:%lu err:'%s'", len, err.c_str());
+			accepted++;
+		}
+	}
+	ok(accepted == 0, "Truncated payloads with a valid trailer rejected   lengths:%lu accepted:%d",
+		payload.size(), accepted);
+
+	const bool extra = rejected(path, with_trailer(payload + "extra"), err);
+	ok(extra && err.find("malformed") != string::npos, "Payload with extra bytes rejected   err:'%s'", err.c_str());
+
+	string bad_version { payload };
+	bad_version[8] ^= 0x7F;
+	const bool version = rejected(path, with_trailer(bad_version), err);
+	ok(version && err.find("version") != string::npos, "Unknown version rejected   err:'%s'", err.c_str());
+
+	unlink(path.c_str());
+	ProxySQL_Snapshot::free_sections(sections);
+
+	return exit_status();
+}
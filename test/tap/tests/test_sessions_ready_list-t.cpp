@@ -0,0 +1,135 @@
+/**
+ * @file test_sessions_ready_list-t.cpp
+ * @brief Checks the processing of the sessions through the ready list ('mysql-sessions_ready_list').
+ * @details With the ready list enabled, the worker threads only process the sessions with pending work, and the
+ *   timeouts are driven by a timer wheel. The test checks that:
+ *   - Queries are served on many concurrent connections, including idle ones being resumed.
+ *   - Disabling the ready list at runtime doesn't affect the existing connections.
+ *   - Connections in use aren't closed by 'mysql-wait_timeout'.
+ *   - 'mysql-wait_timeout' still closes idle connections.
+ */
+
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int NUM_CONNS = 50;
+const int WAIT_TIMEOUT_MS = 2000;
+
+MYSQL* create_proxy_conn(const CommandLine& cl) {
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxy));
+		mysql_close(proxy);
+		return NULL;
+	}
+	return proxy;
+}
+
+bool run_select(MYSQL* proxy) {
+	if (mysql_query(proxy, "SELECT 1")) {
+		return false;
+	}
+	mysql_free_result(mysql_store_result(proxy));
+	return true;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const string q_wait_timeout {
+		"SELECT variable_value FROM global_variables WHERE variable_name='mysql-wait_timeout'"
+	};
+	ext_val_t<string> wait_timeout { mysql_query_ext_val(admin, q_wait_timeout, string {}) };
+	if (wait_timeout.err) {
+		fprintf(stderr, "File %s, line %d, Error: failed to fetch 'mysql-wait_timeout'\n", __FILE__, __LINE__);
+		return exit_status();
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-sessions_ready_list='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	vector<MYSQL*> conns {};
+	for (int i = 0; i < NUM_CONNS; i++) {
+		MYSQL* proxy = create_proxy_conn(cl);
+		if (proxy == NULL) {
+			return exit_status();
+		}
+		conns.push_back(proxy);
+	}
+	int served = 0;
+	for (int round = 0; round < 3; round++) {
+		for (MYSQL* proxy : conns) {
+			served += run_select(proxy);
+		}
+		usleep(200 * 1000);
+	}
+	ok(served == NUM_CONNS * 3, "Queries served on concurrent connections   exp:%d act:%d", NUM_CONNS * 3, served);
+
+	MYSQL_QUERY_T(admin, "SET mysql-sessions_ready_list='false'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	served = 0;
+	for (MYSQL* proxy : conns) {
+		served += run_select(proxy);
+	}
+	ok(served == NUM_CONNS, "Existing connections served after disabling the ready list   exp:%d act:%d", NUM_CONNS, served);
+
+	for (MYSQL* proxy : conns) {
+		mysql_close(proxy);
+	}
+
+	MYSQL_QUERY_T(admin, "SET mysql-sessions_ready_list='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	const string q_set_timeout { "SET mysql-wait_timeout=" + std::to_string(WAIT_TIMEOUT_MS) };
+	MYSQL_QUERY_T(admin, q_set_timeout.c_str());
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* idle = create_proxy_conn(cl);
+	MYSQL* busy = create_proxy_conn(cl);
+	if (idle == NULL || busy == NULL) {
+		return exit_status();
+	}
+	bool busy_ok = true;
+	// keep one connection in use for twice the timeout, while the other one stays idle
+	for (int i = 0; i < WAIT_TIMEOUT_MS * 2 / 250; i++) {
+		busy_ok = busy_ok && run_select(busy);
+		usleep(250 * 1000);
+	}
+	ok(busy_ok, "Connection in use not closed by 'mysql-wait_timeout'");
+	// give the thread the time to run the timer of the idle session
+	sleep(2);
+	ok(run_select(idle) == false, "Idle connection closed by 'mysql-wait_timeout'   err:'%s'", mysql_error(idle));
+	mysql_close(idle);
+	mysql_close(busy);
+
+	const string q_restore_timeout { "SET mysql-wait_timeout=" + wait_timeout.val };
+	MYSQL_QUERY_T(admin, q_restore_timeout.c_str());
+	MYSQL_QUERY_T(admin, "SET mysql-sessions_ready_list='false'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
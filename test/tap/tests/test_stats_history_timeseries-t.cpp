@@ -0,0 +1,92 @@
+/**
+ * @file test_stats_history_timeseries-t.cpp
+ * @brief Checks the time series store of 'stats_history' ('admin-stats_history_timeseries').
+ * @details With the time series store enabled, the samples of 'system_cpu' are appended to the store instead of
+ *   the SQLite table, and the table is rewritten from the store when queried. The test checks that:
+ *   - The samples collected while the store is enabled are visible through 'stats_history.system_cpu'.
+ *   - New samples keep showing up in the table, queried again.
+ *   - The rows written before the store was enabled, older than its samples, are not removed.
+ *   - The rows older than the retention of the table (7 days) are removed, as without the store.
+ *   - Disabling the store at runtime resumes the inserts into the SQLite table.
+ */
+
+#include <string>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+/**
+ * @brief Returns the number of rows of 'stats_history.system_cpu' with a timestamp not older than 'since', or -1.
+ */
+int count_system_cpu(MYSQL* admin, time_t since) {
+	const string q { "SELECT COUNT(*) FROM stats_history.system_cpu WHERE timestamp >= " + std::to_string(since) };
+	ext_val_t<int> count { mysql_query_ext_val(admin, q, -1) };
+	if (count.err) {
+		diag("File %s, line %d, Error: failed to query 'stats_history.system_cpu'", __FILE__, __LINE__);
+		return -1;
+	}
+	return count.val;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	const time_t start = time(NULL);
+	const time_t kept_ts = start - 3600;
+
+	// a row older than any sample of the store, as if written before the store was enabled, and a row older than
+	// the retention of the table
+	MYSQL_QUERY_T(admin, ("INSERT OR REPLACE INTO stats_history.system_cpu VALUES (" + std::to_string(kept_ts) + ", 0, 0)").c_str());
+	MYSQL_QUERY_T(admin, "INSERT OR REPLACE INTO stats_history.system_cpu VALUES (1000, 0, 0)");
+
+	MYSQL_QUERY_T(admin, "SET admin-stats_system_cpu=1");
+	MYSQL_QUERY_T(admin, "SET admin-stats_history_timeseries='true'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+
+	sleep(5);
+	int rows = count_system_cpu(admin, start);
+	ok(rows > 0, "Samples collected in the time series store visible in 'system_cpu'   rows:%d", rows);
+
+	sleep(3);
+	int new_rows = count_system_cpu(admin, start);
+	ok(new_rows > rows, "New samples visible in 'system_cpu'   prev:%d act:%d", rows, new_rows);
+
+	const int old_rows = count_system_cpu(admin, kept_ts) - count_system_cpu(admin, kept_ts + 1);
+	ok(old_rows == 1, "Rows older than the store kept in 'system_cpu'   rows:%d", old_rows);
+
+	const int expired_rows = count_system_cpu(admin, 1000) - count_system_cpu(admin, 1001);
+	ok(expired_rows == 0, "Rows older than the retention removed from 'system_cpu'   rows:%d", expired_rows);
+
+	MYSQL_QUERY_T(admin, "SET admin-stats_history_timeseries='false'");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	const time_t disabled = time(NULL) + 1;
+
+	sleep(3);
+	rows = count_system_cpu(admin, disabled);
+	ok(rows > 0, "Samples inserted into 'system_cpu' with the time series store disabled   rows:%d", rows);
+
+	MYSQL_QUERY_T(admin, ("DELETE FROM stats_history.system_cpu WHERE timestamp IN (1000, " + std::to_string(kept_ts) + ")").c_str());
+	MYSQL_QUERY_T(admin, "SET admin-stats_system_cpu=60");
+	MYSQL_QUERY_T(admin, "LOAD ADMIN VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test_use_writev-t.cpp
+ * @brief Checks the scatter-gather output path of the client connections ('mysql-use_writev').
+ * @details The same resultset is fetched with 'mysql-use_writev' enabled and disabled. The test checks that:
+ *   - Both paths deliver identical resultsets.
+ *   - With 'mysql-use_writev' enabled the bytes are accounted in 'Writev_bytes_sent', without copies into the
+ *     send buffer ('Send_buffer_copied_bytes').
+ *   - With 'mysql-use_writev' disabled the bytes are copied into the send buffer instead.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unistd.h>
+
+#include "mysql.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const char* BIG_QUERY { "SELECT a.*, b.* FROM test.sbtest1 a JOIN test.sbtest1 b" };
+// smaller than the size of the resultset, but large enough to ignore the traffic of other queries
+const int64_t MIN_BYTES = 1024 * 1024;
+
+int64_t get_global_status(MYSQL* admin, const string& name) {
+	const string q { "SELECT variable_value FROM stats_mysql_global WHERE variable_name='" + name + "'" };
+	ext_val_t<int64_t> val { mysql_query_ext_val(admin, q, int64_t(-1)) };
+	return val.err == 0 ? val.val : -1;
+}
+
+/**
+ * @brief Fetches 'BIG_QUERY' through a new connection, returning a FNV-1a hash of the resultset.
+ */
+uint64_t fetch_resultset(const CommandLine& cl, uint64_t& rows) {
+	uint64_t hash = 14695981039346656037ULL;
+	rows = 0;
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxy));
+		return 0;
+	}
+	if (mysql_query(proxy, BIG_QUERY)) {
+		diag("File %s, line %d, Error: %s", __FILE__, __LINE__, mysql_error(proxy));
+		mysql_close(proxy);
+		return 0;
+	}
+	MYSQL_RES* res = mysql_use_result(proxy);
+	MYSQL_ROW row;
+	const unsigned int num_fields = mysql_num_fields(res);
+	while ((row = mysql_fetch_row(res))) {
+		unsigned long* lengths = mysql_fetch_lengths(res);
+		for (unsigned int i = 0; i < num_fields; i++) {
+			for (unsigned long j = 0; j < lengths[i]; j++) {
+				hash = (hash ^ (unsigned char)row[i][j]) * 1099511628211ULL;
+			}
+		}
+		rows++;
+	}
+	mysql_free_result(res);
+	mysql_close(proxy);
+	return hash;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return -1;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return exit_status();
+	}
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return exit_status();
+	}
+	if (create_table_test_sbtest1(100, proxy)) {
+		fprintf(stderr, "File %s, line %d, Error: create_table_test_sbtest1() failed\n", __FILE__, __LINE__);
+		return exit_status();
+	}
+	mysql_close(proxy);
+	diag("Waiting few seconds for replication...");
+	sleep(2);
+
+	MYSQL_QUERY_T(admin, "SET mysql-use_writev='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	int64_t copied_before = get_global_status(admin, "Send_buffer_copied_bytes");
+	int64_t writev_before = get_global_status(admin, "Writev_bytes_sent");
+	uint64_t rows_writev = 0;
+	const uint64_t hash_writev = fetch_resultset(cl, rows_writev);
+	int64_t copied_after = get_global_status(admin, "Send_buffer_copied_bytes");
+	int64_t writev_after = get_global_status(admin, "Writev_bytes_sent");
+
+	ok(
+		writev_after - writev_before >= MIN_BYTES,
+		"Resultset sent through 'writev'   writev_bytes:%ld", writev_after - writev_before
+	);
+	ok(
+		copied_after - copied_before < MIN_BYTES,
+		"Resultset not copied into the send buffer   copied_bytes:%ld", copied_after - copied_before
+	);
+
+	MYSQL_QUERY_T(admin, "SET mysql-use_writev='false'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	copied_before = get_global_status(admin, "Send_buffer_copied_bytes");
+	writev_before = get_global_status(admin, "Writev_bytes_sent");
+	uint64_t rows_copy = 0;
+	const uint64_t hash_copy = fetch_resultset(cl, rows_copy);
+	copied_after = get_global_status(admin, "Send_buffer_copied_bytes");
+	writev_after = get_global_status(admin, "Writev_bytes_sent");
+
+	ok(
+		copied_after - copied_before >= MIN_BYTES,
+		"Resultset copied into the send buffer   copied_bytes:%ld", copied_after - copied_before
+	);
+	ok(
+		writev_after - writev_before < MIN_BYTES,
+		"Resultset not sent through 'writev'   writev_bytes:%ld", writev_after - writev_before
+	);
+	ok(
+		rows_writev > 0 && rows_writev == rows_copy && hash_writev == hash_copy,
+		"Identical resultsets from both paths   rows:%lu/%lu hash:%lu/%lu",
+		rows_writev, rows_copy, hash_writev, hash_copy
+	);
+
+	MYSQL_QUERY_T(admin, "SET mysql-use_writev='true'");
+	MYSQL_QUERY_T(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,334 @@
+/**
+ * @file eventslog_columnar_reader.cpp
+ * @brief Converts events log files written with 'mysql-eventslog_format=3' (columnar) into JSON or CSV.
+ * @details The JSON output has the same keys as the files written with 'mysql-eventslog_format=2'.
+ *   Filters are applied before decoding the rows:
+ *   - '--from' / '--to' skip whole blocks using the block index (or the block headers, if the file wasn't
+ *     closed), without reading their payload.
+ *   - '--user' / '--digest' decompress only the column they filter on, and the remaining columns of a block
+ *     are decompressed only if at least one of its rows matches.
+ *
+ *   Usage:
+ *   @code
+ *   eventslog_columnar_reader [--json|--csv] [--from TIME] [--to TIME] [--user USERNAME] [--digest DIGEST] FILE...
+ *   @endcode
+ *   TIME is either microseconds since epoch, or 'YYYY-MM-DD HH:MM:SS' in local time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "eventslog_columnar.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+using namespace eventslog_columnar;
+
+// values of 'enum log_event_type' logged by 'MySQL_Logger::log_request()'
+#define PROXYSQL_COM_STMT_EXECUTE 16
+#define PROXYSQL_COM_STMT_PREPARE 17
+
+struct options_t {
+	bool csv = false;
+	uint64_t from = 0;
+	uint64_t to = UINT64_MAX;
+	const char *user = NULL;
+	bool have_digest = false;
+	uint64_t digest = 0;
+	std::vector<const char *> files {};
+};
+
+static void usage(const char *prog) {
+	fprintf(stderr, "Usage: %s [--json|--csv] [--from TIME] [--to TIME] [--user USERNAME] [--digest DIGEST] FILE...\n", prog);
+	fprintf(stderr, "  TIME is microseconds since epoch, or 'YYYY-MM-DD HH:MM:SS' in local time\n");
+}
+
+static bool parse_time(const char *s, uint64_t& us) {
+	char *end = NULL;
+	const unsigned long long v = strtoull(s, &end, 10);
+	if (end != s && *end == '\0') {
+		us = v;
+		return true;
+	}
+	struct tm tm_info;
+	memset(&tm_info, 0, sizeof(tm_info));
+	const char *rest = strptime(s, "%Y-%m-%d %H:%M:%S", &tm_info);
+	if (rest == NULL || *rest != '\0') {
+		return false;
+	}
+	tm_info.tm_isdst = -1;
+	const time_t t = mktime(&tm_info);
+	if (t < 0) {
+		return false;
+	}
+	us = (uint64_t)t * 1000000;
+	return true;
+}
+
+static std::string format_time(uint64_t us) {
+	time_t timer = us / 1000 / 1000;
+	struct tm* tm_info = localtime(&timer);
+	char buffer1[36];
+	char buffer2[64];
+	strftime(buffer1, 32, "%Y-%m-%d %H:%M:%S", tm_info);
+	snprintf(buffer2, sizeof(buffer2), "%s.%06u", buffer1, (unsigned)(us % 1000000));
+	return buffer2;
+}
+
+static const char * event_name(uint64_t et) {
+	switch (et) {
+		case PROXYSQL_COM_STMT_EXECUTE:
+			return "COM_STMT_EXECUTE";
+		case PROXYSQL_COM_STMT_PREPARE:
+			return "COM_STMT_PREPARE";
+		default:
+			return "COM_QUERY";
+	}
+}
+
+static std::string csv_field(const std::string& s) {
+	if (s.find_first_of(",\"\r\n") == std::string::npos) {
+		return s;
+	}
+	std::string r { "\"" };
+	for (char c : s) {
+		if (c == '"') r += '"';
+		r += c;
+	}
+	r += '"';
+	return r;
+}
+
+static const char * csv_header =
+	"hostgroup_id,thread_id,event,username,schemaname,client,server,rows_affected,last_insert_id,rows_sent,"
+	"last_gtid,query,starttime_timestamp_us,starttime,endtime_timestamp_us,endtime,duration_us,digest,client_stmt_id";
+
+/**
+ * @brief Decoded columns of a block, indexed by 'column_id'.
+ */
+struct block_columns_t {
+	std::vector<column_data_t> cols = std::vector<column_data_t>(COL__END);
+	std::vector<bool> loaded = std::vector<bool>(COL__END, false);
+
+	/**
+	 * @brief Decodes column 'c' if not done yet. Columns missing from the block, written by a version not
+	 *   knowing them, are filled with zeros / empty strings.
+	 */
+	bool load(const Block& blk, column_id c) {
+		if (loaded[c]) return true;
+		column_data_t& d = cols[c];
+		if (blk.column(columns_defs[c].name, d) == false) {
+			d.type = columns_defs[c].type;
+			d.ints.assign(blk.info.rows, 0);
+			d.strs.assign(blk.info.rows, std::string {});
+		}
+		if (d.type != columns_defs[c].type) {
+			return false;
+		}
+		if (d.type == COL_TYPE_INT) {
+			d.strs.assign(blk.info.rows, std::string {});
+		} else {
+			d.ints.assign(blk.info.rows, 0);
+		}
+		loaded[c] = true;
+		return true;
+	}
+	uint64_t i(column_id c, size_t r) const { return cols[c].ints[r]; }
+	const std::string& s(column_id c, size_t r) const { return cols[c].strs[r]; }
+};
+
+static void print_row(const options_t& opts, const block_columns_t& bc, size_t r) {
+	const uint64_t flags = bc.i(COL_FLAGS, r);
+	const uint64_t et = bc.i(COL_EVENT, r);
+	const int64_t hid = (int64_t)bc.i(COL_HOSTGROUP_ID, r);
+	const uint64_t start_time = bc.i(COL_START_TIME, r);
+	const uint64_t end_time = bc.i(COL_END_TIME, r);
+	char digest_hex[20];
+	snprintf(digest_hex, sizeof(digest_hex), "0x%016llX", (unsigned long long)bc.i(COL_DIGEST, r));
+	const bool have_stmt_id = (et == PROXYSQL_COM_STMT_PREPARE || et == PROXYSQL_COM_STMT_EXECUTE);
+
+	if (opts.csv) {
+		std::string line {};
+		line += std::to_string(hid < 0 ? -1 : hid) + ",";
+		line += std::to_string(bc.i(COL_THREAD_ID, r)) + ",";
+		line += std::string(event_name(et)) + ",";
+		line += csv_field(bc.s(COL_USERNAME, r)) + ",";
+		line += csv_field(bc.s(COL_SCHEMANAME, r)) + ",";
+		line += csv_field(bc.s(COL_CLIENT, r)) + ",";
+		line += csv_field(bc.s(COL_SERVER, r)) + ",";
+		line += (flags & ROW_HAVE_ROWS_AFFECTED ? std::to_string(bc.i(COL_ROWS_AFFECTED, r)) : "") + ",";
+		line += (flags & ROW_HAVE_ROWS_AFFECTED ? std::to_string(bc.i(COL_LAST_INSERT_ID, r)) : "") + ",";
+		line += (flags & ROW_HAVE_ROWS_SENT ? std::to_string(bc.i(COL_ROWS_SENT, r)) : "") + ",";
+		line += csv_field(bc.s(COL_LAST_GTID, r)) + ",";
+		line += csv_field(bc.s(COL_QUERY, r)) + ",";
+		line += std::to_string(start_time) + "," + format_time(start_time) + ",";
+		line += std::to_string(end_time) + "," + format_time(end_time) + ",";
+		line += std::to_string(end_time - start_time) + ",";
+		line += std::string(digest_hex) + ",";
+		line += (have_stmt_id ? std::to_string(bc.i(COL_CLIENT_STMT_ID, r)) : "");
+		std::cout << line << '\n';
+		return;
+	}
+
+	json j = {};
+	j["hostgroup_id"] = hid < 0 ? -1 : hid;
+	j["thread_id"] = bc.i(COL_THREAD_ID, r);
+	j["event"] = event_name(et);
+	j["username"] = bc.s(COL_USERNAME, r);
+	j["schemaname"] = bc.s(COL_SCHEMANAME, r);
+	j["client"] = bc.s(COL_CLIENT, r);
+	if (flags & ROW_HAVE_SERVER) {
+		j["server"] = bc.s(COL_SERVER, r);
+	}
+	if (flags & ROW_HAVE_ROWS_AFFECTED) {
+		j["rows_affected"] = bc.i(COL_ROWS_AFFECTED, r);
+		if (bc.i(COL_LAST_INSERT_ID, r) != 0) {
+			j["last_insert_id"] = bc.i(COL_LAST_INSERT_ID, r);
+		}
+	}
+	if (flags & ROW_HAVE_ROWS_SENT) {
+		j["rows_sent"] = bc.i(COL_ROWS_SENT, r);
+	}
+	if (flags & ROW_HAVE_GTID) {
+		j["last_gtid"] = bc.s(COL_LAST_GTID, r);
+	}
+	j["query"] = bc.s(COL_QUERY, r);
+	j["starttime_timestamp_us"] = start_time;
+	j["starttime"] = format_time(start_time);
+	j["endtime_timestamp_us"] = end_time;
+	j["endtime"] = format_time(end_time);
+	j["duration_us"] = end_time - start_time;
+	j["digest"] = digest_hex;
+	if (have_stmt_id) {
+		j["client_stmt_id"] = bc.i(COL_CLIENT_STMT_ID, r);
+	}
+	std::cout << j.dump(-1, ' ', false, json::error_handler_t::replace) << '\n';
+}
+
+/**
+ * @brief Prints the rows of 'path' matching the filters.
+ * @return The number of blocks that couldn't be read, or -1 if the file couldn't be opened.
+ */
+static int process_file(const options_t& opts, const char *path) {
+	Reader reader {};
+	std::string err {};
+	if (reader.open(path, err) == false) {
+		fprintf(stderr, "%s\n", err.c_str());
+		return -1;
+	}
+	int errors = 0;
+	for (const block_info_t& info : reader.get_blocks()) {
+		if (info.max_start_time < opts.from || info.min_start_time > opts.to) {
+			continue;
+		}
+		Block blk {};
+		block_columns_t bc {};
+		if (reader.read_block(info, blk) == false || bc.load(blk, COL_START_TIME) == false) {
+			fprintf(stderr, "%s: malformed block at offset %llu\n", path, (unsigned long long)info.offset);
+			errors++;
+			continue;
+		}
+		std::vector<size_t> matches {};
+		for (size_t r = 0; r < blk.info.rows; r++) {
+			const uint64_t st = bc.i(COL_START_TIME, r);
+			if (st >= opts.from && st <= opts.to) {
+				matches.push_back(r);
+			}
+		}
+		if (opts.user && matches.empty() == false) {
+			if (bc.load(blk, COL_USERNAME) == false) {
+				errors++;
+				continue;
+			}
+			std::vector<size_t> m {};
+			for (size_t r : matches) {
+				if (bc.s(COL_USERNAME, r) == opts.user) m.push_back(r);
+			}
+			matches.swap(m);
+		}
+		if (opts.have_digest && matches.empty() == false) {
+			if (bc.load(blk, COL_DIGEST) == false) {
+				errors++;
+				continue;
+			}
+			std::vector<size_t> m {};
+			for (size_t r : matches) {
+				if (bc.i(COL_DIGEST, r) == opts.digest) m.push_back(r);
+			}
+			matches.swap(m);
+		}
+		if (matches.empty()) {
+			continue;
+		}
+		bool loaded = true;
+		for (int c = 0; c < COL__END && loaded; c++) {
+			loaded = bc.load(blk, (column_id)c);
+		}
+		if (loaded == false) {
+			fprintf(stderr, "%s: malformed column in block at offset %llu\n", path, (unsigned long long)info.offset);
+			errors++;
+			continue;
+		}
+		for (size_t r : matches) {
+			print_row(opts, bc, r);
+		}
+	}
+	return errors;
+}
+
+int main(int argc, char **argv) {
+	options_t opts {};
+	for (int i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		const bool has_val = (i + 1 < argc);
+		if (strcmp(a, "--json") == 0) {
+			opts.csv = false;
+		} else if (strcmp(a, "--csv") == 0) {
+			opts.csv = true;
+		} else if (strcmp(a, "--from") == 0 && has_val) {
+			if (parse_time(argv[++i], opts.from) == false) {
+				fprintf(stderr, "Invalid time '%s'\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		} else if (strcmp(a, "--to") == 0 && has_val) {
+			if (parse_time(argv[++i], opts.to) == false) {
+				fprintf(stderr, "Invalid time '%s'\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		} else if (strcmp(a, "--user") == 0 && has_val) {
+			opts.user = argv[++i];
+		} else if (strcmp(a, "--digest") == 0 && has_val) {
+			char *end = NULL;
+			opts.digest = strtoull(argv[++i], &end, 0);
+			if (end == argv[i] || *end != '\0') {
+				fprintf(stderr, "Invalid digest '%s'\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+			opts.have_digest = true;
+		} else if (strcmp(a, "--help") == 0 || a[0] == '-') {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		} else {
+			opts.files.push_back(a);
+		}
+	}
+	if (opts.files.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (opts.csv) {
+		std::cout << csv_header << '\n';
+	}
+	int rc = EXIT_SUCCESS;
+	for (const char *f : opts.files) {
+		if (process_file(opts, f) != 0) {
+			rc = EXIT_FAILURE;
+		}
+	}
+	return rc;
+}